@@ -54,10 +54,14 @@ bool CryptoOptions::operator==(const CryptoOptions& other) const {
       bool enable_gcm_crypto_suites;
       bool enable_aes128_sha1_32_crypto_cipher;
       bool enable_encrypted_rtp_header_extensions;
+      bool enable_batching;
     } srtp;
     struct SFrame {
       bool require_frame_encryption;
     } sframe;
+    struct Dtls {
+      bool enable_session_resumption;
+    } dtls;
   };
   static_assert(sizeof(data_being_tested_for_equality) == sizeof(*this),
                 "Did you add something to CryptoOptions and forget to "
@@ -68,8 +72,10 @@ bool CryptoOptions::operator==(const CryptoOptions& other) const {
              other.srtp.enable_aes128_sha1_32_crypto_cipher &&
          srtp.enable_encrypted_rtp_header_extensions ==
              other.srtp.enable_encrypted_rtp_header_extensions &&
+         srtp.enable_batching == other.srtp.enable_batching &&
          sframe.require_frame_encryption ==
-             other.sframe.require_frame_encryption;
+             other.sframe.require_frame_encryption &&
+         dtls.enable_session_resumption == other.dtls.enable_session_resumption;
 }
 
 bool CryptoOptions::operator!=(const CryptoOptions& other) const {
@@ -52,6 +52,12 @@ struct RTC_EXPORT CryptoOptions {
     // If set to true, encrypted RTP header extensions as defined in RFC 6904
     // will be negotiated. They will only be used if both peers support them.
     bool enable_encrypted_rtp_header_extensions = false;
+
+    // If set to true, RTP packets sent or received during one iteration of
+    // the network thread are protected or unprotected together as a batch,
+    // which saves per-packet call overhead at high packet rates. RTP packets
+    // are then handed on at the end of the iteration instead of immediately.
+    bool enable_batching = false;
   } srtp;
 
   // Options to be used when the FrameEncryptor / FrameDecryptor APIs are used.
@@ -61,6 +67,15 @@ struct RTC_EXPORT CryptoOptions {
     // FrameDecryptor attached to them before they are able to receive packets.
     bool require_frame_encryption = false;
   } sframe;
+
+  // DTLS related options.
+  struct Dtls {
+    // If set to true, a DTLS association may resume the session of an earlier
+    // association with the same remote certificate fingerprint, which saves
+    // a round trip and the public key operations of a full handshake. It will
+    // only be used if both peers enable it.
+    bool enable_session_resumption = false;
+  } dtls;
 };
 
 }  // namespace webrtc
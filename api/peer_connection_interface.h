@@ -302,6 +302,13 @@ class RTC_EXPORT PeerConnectionInterface : public rtc::RefCountInterface {
     bool dscp() const { return media_config.enable_dscp; }
     void set_dscp(bool enable) { media_config.enable_dscp = enable; }
 
+    bool kernel_receive_timestamps() const {
+      return media_config.enable_kernel_receive_timestamps;
+    }
+    void set_kernel_receive_timestamps(bool enable) {
+      media_config.enable_kernel_receive_timestamps = enable;
+    }
+
     bool cpu_adaptation() const {
       return media_config.video.enable_cpu_adaptation;
     }
@@ -1299,6 +1306,12 @@ struct RTC_EXPORT PeerConnectionFactoryDependencies final {
 
   // Optional dependencies
   rtc::Thread* network_thread = nullptr;
+  // More network threads to spread PeerConnections over. Each PeerConnection
+  // that uses the factory's own port allocator is pinned to one of
+  // |network_thread| and these, picked round-robin, and does all its socket
+  // I/O, ICE, DTLS and SRTP work there. PeerConnections created with an
+  // injected allocator or packet socket factory always use |network_thread|.
+  std::vector<rtc::Thread*> additional_network_threads;
   rtc::Thread* worker_thread = nullptr;
   rtc::Thread* signaling_thread = nullptr;
   std::unique_ptr<TaskQueueFactory> task_queue_factory;
@@ -1310,6 +1323,10 @@ struct RTC_EXPORT PeerConnectionFactoryDependencies final {
       network_state_predictor_factory;
   std::unique_ptr<NetworkControllerFactoryInterface> network_controller_factory;
   std::unique_ptr<MediaTransportFactory> media_transport_factory;
+  // If set, PeerConnections created without a certificate generator take
+  // their certificates from this pool when it has one ready, rather than
+  // generating them while the offer or answer is created.
+  rtc::scoped_refptr<rtc::RTCCertificatePool> certificate_pool;
 };
 
 // PeerConnectionFactoryInterface is the factory interface used for creating
@@ -1434,6 +1451,14 @@ class PeerConnectionFactoryInterface : public rtc::RefCountInterface {
   // Stops logging the AEC dump.
   virtual void StopAecDump() = 0;
 
+  // Returns RTCThreadCpuStats with the CPU time each thread owned by WebRTC
+  // used since the factory was created. The threads are shared by all
+  // PeerConnections of the process, so these stats are only available here
+  // and never in PeerConnection reports. Returns null if not implemented.
+  virtual rtc::scoped_refptr<const RTCStatsReport> GetThreadCpuStats() {
+    return nullptr;
+  }
+
  protected:
   // Dtor and ctor protected as objects shouldn't be created or deleted via
   // this interface.
@@ -601,6 +601,28 @@ class RTC_EXPORT RTCTransportStats final : public RTCStats {
   RTCStatsMember<uint32_t> selected_candidate_pair_changes;
 };
 
+// Non-standard. The CPU time of a thread owned by WebRTC, see
+// rtc::GetThreadCpuUsage(). Only produced by
+// PeerConnectionFactoryInterface::GetThreadCpuStats(), for every running
+// thread, and once per thread name for the threads of that name that have
+// exited.
+class RTC_EXPORT RTCThreadCpuStats final : public RTCStats {
+ public:
+  WEBRTC_RTCSTATS_DECL();
+
+  RTCThreadCpuStats(const std::string& id, int64_t timestamp_us);
+  RTCThreadCpuStats(std::string&& id, int64_t timestamp_us);
+  RTCThreadCpuStats(const RTCThreadCpuStats& other);
+  ~RTCThreadCpuStats() override;
+
+  RTCNonStandardStatsMember<std::string> thread_name;
+  // The operating system id of the thread. Undefined for exited threads.
+  RTCNonStandardStatsMember<uint64_t> thread_id;
+  RTCNonStandardStatsMember<bool> exited;
+  // In seconds, since the factory was created.
+  RTCNonStandardStatsMember<double> cpu_time;
+};
+
 }  // namespace webrtc
 
 #endif  // API_STATS_RTCSTATS_OBJECTS_H_
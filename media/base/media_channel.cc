@@ -16,9 +16,12 @@ VideoOptions::VideoOptions() = default;
 VideoOptions::~VideoOptions() = default;
 
 MediaChannel::MediaChannel(const MediaConfig& config)
-    : enable_dscp_(config.enable_dscp) {}
+    : enable_dscp_(config.enable_dscp),
+      enable_kernel_receive_timestamps_(
+          config.enable_kernel_receive_timestamps) {}
 
-MediaChannel::MediaChannel() : enable_dscp_(false) {}
+MediaChannel::MediaChannel()
+    : enable_dscp_(false), enable_kernel_receive_timestamps_(false) {}
 
 MediaChannel::~MediaChannel() {}
 
@@ -29,6 +32,10 @@ void MediaChannel::SetInterface(
   network_interface_ = iface;
   media_transport_config_ = media_transport_config;
   UpdateDscp();
+  if (enable_kernel_receive_timestamps_) {
+    SetOption(NetworkInterface::ST_RTP, rtc::Socket::OPT_RECV_TIMESTAMP, 1);
+    SetOption(NetworkInterface::ST_RTCP, rtc::Socket::OPT_RECV_TIMESTAMP, 1);
+  }
 }
 
 int MediaChannel::GetRtpSendTimeExtnId() const {
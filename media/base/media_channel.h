@@ -330,6 +330,7 @@ class MediaChannel : public sigslot::has_slots<> {
   }
 
   const bool enable_dscp_;
+  const bool enable_kernel_receive_timestamps_;
   // |network_interface_| can be accessed from the worker_thread and
   // from any MediaEngine threads. This critical section is to protect accessing
   // of network_interface_ object.
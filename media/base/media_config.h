@@ -20,6 +20,11 @@ struct MediaConfig {
   // PeerConnection constraint 'googDscp'.
   bool enable_dscp = false;
 
+  // Timestamp incoming RTP/RTCP packets in the kernel (SO_TIMESTAMPNS) rather
+  // than when the network thread reads them, so that network thread queueing
+  // does not show up as delay jitter in bandwidth estimation.
+  bool enable_kernel_receive_timestamps = false;
+
   // Video-specific config.
   struct Video {
     // Enable WebRTC CPU Overuse Detection. This flag comes from the
@@ -66,6 +71,8 @@ struct MediaConfig {
 
   bool operator==(const MediaConfig& o) const {
     return enable_dscp == o.enable_dscp &&
+           enable_kernel_receive_timestamps ==
+               o.enable_kernel_receive_timestamps &&
            video.enable_cpu_adaptation == o.video.enable_cpu_adaptation &&
            video.suspend_below_min_bitrate ==
                o.video.suspend_below_min_bitrate &&
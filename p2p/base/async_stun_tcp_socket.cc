@@ -71,16 +71,14 @@ int AsyncStunTCPSocket::Send(const void* pv,
   if (cb != expected_pkt_len)
     return -1;
 
-  AppendToOutBuffer(pv, cb);
-
   RTC_DCHECK(pad_bytes < 4);
-  char padding[4] = {0};
-  AppendToOutBuffer(padding, pad_bytes);
-
-  int res = FlushOutBuffer();
+  static const char kPadding[4] = {0};
+  const rtc::SendSegment segments[] = {
+      {static_cast<const char*>(pv), cb},
+      {kPadding, static_cast<size_t>(pad_bytes)}};
+  int res = SendPacket(segments, pad_bytes > 0 ? 2 : 1);
   if (res <= 0) {
     // drop packet if we made no progress
-    ClearOutBuffer();
     return res;
   }
 
@@ -103,26 +101,33 @@ void AsyncStunTCPSocket::ProcessInput(char* data, size_t* len) {
   // |         Channel Number        |            Length             |
   // +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 
+  // The packets are signaled where they are; only an incomplete one at the
+  // end is moved to the front, once.
+  size_t processed = 0;
   while (true) {
+    size_t remaining = *len - processed;
     // We need at least 4 bytes to read the STUN or ChannelData packet length.
-    if (*len < kPacketLenOffset + kPacketLenSize)
-      return;
+    if (remaining < kPacketLenOffset + kPacketLenSize)
+      break;
 
     int pad_bytes;
-    size_t expected_pkt_len = GetExpectedLength(data, *len, &pad_bytes);
+    size_t expected_pkt_len =
+        GetExpectedLength(data + processed, remaining, &pad_bytes);
     size_t actual_length = expected_pkt_len + pad_bytes;
 
-    if (*len < actual_length) {
-      return;
+    if (remaining < actual_length) {
+      break;
     }
 
-    SignalReadPacket(this, data, expected_pkt_len, remote_addr,
+    SignalReadPacket(this, data + processed, expected_pkt_len, remote_addr,
                      rtc::TimeMicros());
 
-    *len -= actual_length;
-    if (*len > 0) {
-      memmove(data, data + actual_length, *len);
-    }
+    processed += actual_length;
+  }
+
+  *len -= processed;
+  if (processed > 0 && *len > 0) {
+    memmove(data, data + processed, *len);
   }
 }
 
@@ -50,12 +50,24 @@ AsyncPacketSocket* BasicPacketSocketFactory::CreateUdpSocket(
   if (!socket) {
     return NULL;
   }
+  if (udp_reuse_port_enabled_ &&
+      socket->SetOption(Socket::OPT_REUSEPORT, 1) != 0) {
+    RTC_LOG(LS_WARNING) << "Failed to set SO_REUSEPORT, error "
+                        << socket->GetError();
+  }
   if (BindSocket(socket, address, min_port, max_port) < 0) {
     RTC_LOG(LS_ERROR) << "UDP bind failed with error " << socket->GetError();
     delete socket;
     return NULL;
   }
-  return new AsyncUDPSocket(socket);
+  AsyncUDPSocket* udp_socket = new AsyncUDPSocket(socket);
+  if (udp_recv_batch_size_ > 1) {
+    udp_socket->SetRecvBatchSize(udp_recv_batch_size_);
+  }
+  if (udp_send_batching_enabled_) {
+    udp_socket->SetSendBatchingEnabled(true);
+  }
+  return udp_socket;
 }
 
 AsyncPacketSocket* BasicPacketSocketFactory::CreateServerTcpSocket(
@@ -189,6 +201,8 @@ AsyncPacketSocket* BasicPacketSocketFactory::CreateClientTcpSocket(
 }
 
 AsyncResolverInterface* BasicPacketSocketFactory::CreateAsyncResolver() {
+  if (async_resolver_factory_)
+    return async_resolver_factory_->Create();
   return new AsyncResolver();
 }
 
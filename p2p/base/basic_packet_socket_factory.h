@@ -11,8 +11,11 @@
 #ifndef P2P_BASE_BASIC_PACKET_SOCKET_FACTORY_H_
 #define P2P_BASE_BASIC_PACKET_SOCKET_FACTORY_H_
 
+#include <stddef.h>
+
 #include <string>
 
+#include "api/async_resolver_factory.h"
 #include "api/packet_socket_factory.h"
 
 namespace rtc {
@@ -44,6 +47,36 @@ class BasicPacketSocketFactory : public PacketSocketFactory {
 
   AsyncResolverInterface* CreateAsyncResolver() override;
 
+  // Makes CreateAsyncResolver() create the resolvers, such as those of the
+  // STUN and TURN server addresses, with |factory| instead of creating an
+  // AsyncResolver, which uses a thread per lookup. A
+  // webrtc::PooledAsyncResolverFactory lets these lookups share a cache.
+  // |factory| is not owned and must outlive this object.
+  void set_async_resolver_factory(webrtc::AsyncResolverFactory* factory) {
+    async_resolver_factory_ = factory;
+  }
+
+  // Sets the number of datagrams UDP sockets created by this factory read per
+  // read event. See AsyncUDPSocket::SetRecvBatchSize().
+  void set_udp_recv_batch_size(size_t size) { udp_recv_batch_size_ = size; }
+
+  // Enables send batching on UDP sockets created by this factory. See
+  // AsyncUDPSocket::SetSendBatchingEnabled().
+  void set_udp_send_batching_enabled(bool enabled) {
+    udp_send_batching_enabled_ = enabled;
+  }
+
+  // Sets SO_REUSEPORT on UDP sockets created by this factory before binding
+  // them. Sockets of several factories, typically one per network thread,
+  // can then bind the same port, and the kernel spreads incoming datagrams
+  // across them by source address. Only useful with a fixed port (min_port ==
+  // max_port), and only when any of those sockets can handle any peer, as in
+  // ShardedTurnServer. Do not use it for ICE endpoints: the datagrams of one
+  // session would end up on another session's socket.
+  void set_udp_reuse_port_enabled(bool enabled) {
+    udp_reuse_port_enabled_ = enabled;
+  }
+
  private:
   int BindSocket(AsyncSocket* socket,
                  const SocketAddress& local_address,
@@ -54,6 +87,10 @@ class BasicPacketSocketFactory : public PacketSocketFactory {
 
   Thread* thread_;
   SocketFactory* socket_factory_;
+  webrtc::AsyncResolverFactory* async_resolver_factory_ = nullptr;
+  size_t udp_recv_batch_size_ = 1;
+  bool udp_send_batching_enabled_ = false;
+  bool udp_reuse_port_enabled_ = false;
 };
 
 }  // namespace rtc
@@ -13,6 +13,7 @@
 #include <math.h>
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -119,6 +120,32 @@ webrtc::IceCandidateNetworkType ConvertNetworkType(rtc::AdapterType type) {
   return webrtc::IceCandidateNetworkType::kUnknown;
 }
 
+// Returns the number of bytes that |str| has allocated, which is zero when the
+// characters fit in the string itself.
+size_t StringHeapBytes(const std::string& str) {
+  const char* begin = reinterpret_cast<const char*>(&str);
+  std::less<const char*> less;
+  if (!less(str.data(), begin) && less(str.data(), begin + sizeof(str)))
+    return 0;
+  return str.capacity() + 1;
+}
+
+size_t CandidateHeapBytes(const cricket::Candidate& candidate) {
+  return StringHeapBytes(candidate.id()) +
+         StringHeapBytes(candidate.protocol()) +
+         StringHeapBytes(candidate.relay_protocol()) +
+         StringHeapBytes(candidate.address().hostname()) +
+         StringHeapBytes(candidate.username()) +
+         StringHeapBytes(candidate.password()) +
+         StringHeapBytes(candidate.type()) +
+         StringHeapBytes(candidate.network_name()) +
+         StringHeapBytes(candidate.foundation()) +
+         StringHeapBytes(candidate.related_address().hostname()) +
+         StringHeapBytes(candidate.tcptype()) +
+         StringHeapBytes(candidate.transport_name()) +
+         StringHeapBytes(candidate.url());
+}
+
 // When we don't have any RTT data, we have to pick something reasonable.  We
 // use a large value just in case the connection is really slow.
 const int DEFAULT_RTT = 3000;  // 3 seconds
@@ -138,6 +165,9 @@ const int RTT_RATIO = 3;  // 3 : 1
 
 constexpr int64_t kMinExtraPingDelayMs = 100;
 
+// Number of pings the ping history keeps room for after a response.
+constexpr size_t kRetainedPingHistorySize = 4;
+
 }  // namespace
 
 namespace cricket {
@@ -216,7 +246,8 @@ void ConnectionRequest::Prepare(StunMessage* request) {
       STUN_ATTR_PRIORITY, prflx_priority));
 
   // Adding Message Integrity attribute.
-  request->AddMessageIntegrity(connection_->remote_candidate().password());
+  request->AddMessageIntegrity(connection_->port()->GetRemotePasswordHmac(
+      connection_->remote_candidate().password()));
   // Adding Fingerprint.
   request->AddFingerprint();
 }
@@ -454,8 +485,9 @@ void Connection::OnReadPacket(const char* data,
       // id's match.
       case STUN_BINDING_RESPONSE:
       case STUN_BINDING_ERROR_RESPONSE:
-        if (msg->ValidateMessageIntegrity(data, size,
-                                          remote_candidate().password())) {
+        if (msg->ValidateMessageIntegrity(
+                data, size,
+                port_->GetRemotePasswordHmac(remote_candidate().password()))) {
           requests_.CheckResponse(msg.get());
         }
         // Otherwise silently discard the response message.
@@ -736,7 +768,15 @@ void Connection::ReceivedPingResponse(
   total_round_trip_time_ms_ += rtt;
   current_round_trip_time_ms_ = static_cast<uint32_t>(rtt);
 
-  pings_since_last_response_.clear();
+  // Most connections have at most a few pings outstanding once they get
+  // responses. Keep the room for those, but give back the memory of a history
+  // that grew while checking.
+  if (pings_since_last_response_.capacity() > kRetainedPingHistorySize) {
+    std::vector<SentPing>().swap(pings_since_last_response_);
+    pings_since_last_response_.reserve(kRetainedPingHistorySize);
+  } else {
+    pings_since_last_response_.clear();
+  }
   last_ping_response_received_ = rtc::TimeMillis();
   UpdateReceiving(last_ping_response_received_);
   set_write_state(STATE_WRITABLE);
@@ -1013,24 +1053,46 @@ int64_t Connection::last_received() const {
 }
 
 ConnectionInfo Connection::stats() {
-  stats_.recv_bytes_second = round(recv_rate_tracker_.ComputeRate());
-  stats_.recv_total_bytes = recv_rate_tracker_.TotalSampleCount();
-  stats_.sent_bytes_second = round(send_rate_tracker_.ComputeRate());
-  stats_.sent_total_bytes = send_rate_tracker_.TotalSampleCount();
-  stats_.receiving = receiving_;
-  stats_.writable = write_state_ == STATE_WRITABLE;
-  stats_.timeout = write_state_ == STATE_WRITE_TIMEOUT;
-  stats_.new_connection = !reported_;
-  stats_.rtt = rtt_;
-  stats_.key = this;
-  stats_.state = state_;
-  stats_.priority = priority();
-  stats_.nominated = nominated();
-  stats_.total_round_trip_time_ms = total_round_trip_time_ms_;
-  stats_.current_round_trip_time_ms = current_round_trip_time_ms_;
-  stats_.local_candidate = local_candidate();
-  stats_.remote_candidate = remote_candidate();
-  return stats_;
+  ConnectionInfo stats;
+  stats.sent_discarded_packets = stats_.sent_discarded_packets;
+  stats.sent_total_packets = stats_.sent_total_packets;
+  stats.sent_ping_requests_total = stats_.sent_ping_requests_total;
+  stats.sent_ping_requests_before_first_response =
+      stats_.sent_ping_requests_before_first_response;
+  stats.sent_ping_responses = stats_.sent_ping_responses;
+  stats.recv_ping_requests = stats_.recv_ping_requests;
+  stats.recv_ping_responses = stats_.recv_ping_responses;
+  stats.recv_bytes_second = round(recv_rate_tracker_.ComputeRate());
+  stats.recv_total_bytes = recv_rate_tracker_.TotalSampleCount();
+  stats.sent_bytes_second = round(send_rate_tracker_.ComputeRate());
+  stats.sent_total_bytes = send_rate_tracker_.TotalSampleCount();
+  stats.receiving = receiving_;
+  stats.writable = write_state_ == STATE_WRITABLE;
+  stats.timeout = write_state_ == STATE_WRITE_TIMEOUT;
+  stats.new_connection = !reported_;
+  stats.rtt = rtt_;
+  stats.key = this;
+  stats.state = state_;
+  stats.priority = priority();
+  stats.nominated = nominated();
+  stats.total_round_trip_time_ms = total_round_trip_time_ms_;
+  stats.current_round_trip_time_ms = current_round_trip_time_ms_;
+  stats.local_candidate = local_candidate();
+  stats.remote_candidate = remote_candidate();
+  return stats;
+}
+
+size_t Connection::EstimateMemoryUsage() const {
+  size_t bytes = sizeof(*this) + CandidateHeapBytes(remote_candidate_);
+  bytes += pings_since_last_response_.capacity() * sizeof(SentPing);
+  for (const SentPing& ping : pings_since_last_response_)
+    bytes += StringHeapBytes(ping.id);
+  if (last_ping_id_received_)
+    bytes += StringHeapBytes(*last_ping_id_received_);
+  bytes += requests_.EstimateMemoryUsage();
+  bytes += recv_rate_tracker_.AllocatedBytes();
+  bytes += send_rate_tracker_.AllocatedBytes();
+  return bytes;
 }
 
 void Connection::MaybeUpdateLocalCandidate(ConnectionRequest* request,
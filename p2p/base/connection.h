@@ -134,6 +134,12 @@ class Connection : public CandidatePairInterface,
   // populated (default value false).
   ConnectionInfo stats();
 
+  // Estimates the number of bytes used by this connection, including what it
+  // has allocated itself, such as the remote candidate, the ping history, the
+  // outstanding STUN requests and the rate tracking. The local candidate and
+  // the HMAC of the remote password belong to the port and are not counted.
+  size_t EstimateMemoryUsage() const;
+
   sigslot::signal1<Connection*> SignalStateChange;
 
   // Sent when the connection has decided that it is no longer of value.  It
@@ -335,7 +341,19 @@ class Connection : public CandidatePairInterface,
   size_t local_candidate_index_;
   Candidate remote_candidate_;
 
-  ConnectionInfo stats_;
+  // The counters reported in |ConnectionInfo|. The rest of the stats are
+  // filled in by stats(), so they are not stored with every connection.
+  struct Counters {
+    size_t sent_discarded_packets = 0;
+    size_t sent_total_packets = 0;
+    size_t sent_ping_requests_total = 0;
+    size_t sent_ping_requests_before_first_response = 0;
+    size_t sent_ping_responses = 0;
+    size_t recv_ping_requests = 0;
+    size_t recv_ping_responses = 0;
+  };
+
+  Counters stats_;
   rtc::RateTracker recv_rate_tracker_;
   rtc::RateTracker send_rate_tracker_;
 
@@ -27,6 +27,7 @@
 #include "rtc_base/ssl_stream_adapter.h"
 #include "rtc_base/stream.h"
 #include "rtc_base/thread.h"
+#include "system_wrappers/include/metrics.h"
 
 namespace cricket {
 
@@ -340,6 +341,9 @@ bool DtlsTransport::SetupDtls() {
   dtls_->SetIdentity(local_certificate_->identity()->GetReference());
   dtls_->SetMode(rtc::SSL_MODE_DTLS);
   dtls_->SetMaxProtocolVersion(ssl_max_version_);
+  if (crypto_options_.dtls.enable_session_resumption) {
+    dtls_->EnableSessionResumption();
+  }
   dtls_->SetServerRole(*dtls_role_);
   dtls_->SignalEvent.connect(this, &DtlsTransport::OnDtlsEvent);
   dtls_->SignalSSLHandshakeError.connect(this,
@@ -619,6 +623,28 @@ void DtlsTransport::OnReadyToSend(rtc::PacketTransportInternal* transport) {
   }
 }
 
+void DtlsTransport::ReportHandshakeStats() {
+  rtc::SSLHandshakeStats stats;
+  if (!dtls_->GetHandshakeStats(&stats)) {
+    return;
+  }
+  RTC_LOG(LS_INFO) << ToString() << ": DTLS handshake "
+                   << (stats.resumed ? "resumed" : "full")
+                   << ", flights=" << stats.flights_sent
+                   << ", retransmissions=" << stats.retransmissions
+                   << ", duration=" << stats.duration_ms
+                   << " ms, cpu_time=" << stats.cpu_time_us << " us";
+  RTC_HISTOGRAM_BOOLEAN("WebRTC.PeerConnection.Dtls.SessionResumed",
+                        stats.resumed);
+  RTC_HISTOGRAM_COUNTS_100(
+      "WebRTC.PeerConnection.Dtls.HandshakeRetransmissions",
+      stats.retransmissions);
+  RTC_HISTOGRAM_COUNTS_10000("WebRTC.PeerConnection.Dtls.HandshakeDurationMs",
+                             stats.duration_ms);
+  RTC_HISTOGRAM_COUNTS_100000("WebRTC.PeerConnection.Dtls.HandshakeCpuTimeUs",
+                              stats.cpu_time_us);
+}
+
 void DtlsTransport::OnDtlsEvent(rtc::StreamInterface* dtls, int sig, int err) {
   RTC_DCHECK_RUN_ON(&thread_checker_);
   RTC_DCHECK(dtls == dtls_.get());
@@ -630,6 +656,7 @@ void DtlsTransport::OnDtlsEvent(rtc::StreamInterface* dtls, int sig, int err) {
       // sure we don't accidentally frob the state if it's closed.
       set_dtls_state(DTLS_TRANSPORT_CONNECTED);
       set_writable(true);
+      ReportHandshakeStats();
     }
   }
   if (sig & rtc::SE_READ) {
@@ -212,6 +212,8 @@ class DtlsTransport : public DtlsTransportInternal {
   bool HandleDtlsPacket(const char* data, size_t size);
   void OnDtlsHandshakeError(rtc::SSLHandshakeError error);
   void ConfigureHandshakeTimeout();
+  // Logs the statistics of the completed handshake and records them in UMA.
+  void ReportHandshakeStats();
 
   void set_receiving(bool receiving);
   void set_writable(bool writable);
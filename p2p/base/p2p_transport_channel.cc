@@ -10,6 +10,7 @@
 
 #include "p2p/base/p2p_transport_channel.h"
 
+#include <algorithm>
 #include <iterator>
 #include <memory>
 #include <set>
@@ -97,6 +98,24 @@ uint32_t GetWeakPingIntervalInFieldTrial() {
   return cricket::WEAK_PING_INTERVAL;
 }
 
+// Sorts |connections| stably, like std::stable_sort(), but is cheap when they
+// are still sorted from the previous time except for a few connections, since
+// it only moves the connections that are out of order. Each of them is moved
+// after the connections that rank the same or better before it.
+template <typename Less>
+void ResortConnections(std::vector<cricket::Connection*>* connections,
+                       Less less) {
+  if (connections->size() < 2) {
+    return;
+  }
+  auto begin = connections->begin();
+  for (auto it = begin + 1; it != connections->end(); ++it) {
+    if (less(*it, *(it - 1))) {
+      std::rotate(std::upper_bound(begin, it - 1, *it, less), it, it + 1);
+    }
+  }
+}
+
 }  // unnamed namespace
 
 namespace cricket {
@@ -1549,6 +1568,24 @@ bool P2PTransportChannel::GetStats(IceTransportStats* ice_transport_stats) {
   return true;
 }
 
+size_t P2PTransportChannel::EstimateConnectionMemoryUsage() const {
+  RTC_DCHECK_RUN_ON(network_thread_);
+  // A node of a std::set holds the value and three pointers, and its color.
+  const size_t kSetNodeBytes = sizeof(Connection*) + 4 * sizeof(void*);
+  size_t bytes = connections_.capacity() * sizeof(Connection*);
+  bytes += (pinged_connections_.size() + unpinged_connections_.size()) *
+           kSetNodeBytes;
+  // The HMACs of the remote passwords are shared by the connections of a
+  // port, so they are counted once per port.
+  std::set<const Port*> ports;
+  for (const Connection* connection : connections_) {
+    bytes += connection->EstimateMemoryUsage();
+    if (ports.insert(connection->port()).second)
+      bytes += connection->port()->EstimateRemotePasswordHmacMemoryUsage();
+  }
+  return bytes;
+}
+
 absl::optional<rtc::NetworkRoute> P2PTransportChannel::network_route() const {
   RTC_DCHECK_RUN_ON(network_thread_);
   return network_route_;
@@ -1835,9 +1872,10 @@ void P2PTransportChannel::SortConnectionsAndUpdateState(
   // that amongst equal preference, writable connections, this will choose the
   // one whose estimated latency is lowest.  So it is the only one that we
   // need to consider switching to.
-  // TODO(honghaiz): Don't sort;  Just use std::max_element in the right places.
-  absl::c_stable_sort(
-      connections_, [this](const Connection* a, const Connection* b) {
+  // Usually only a few connections have changed since the last sort, so the
+  // ranking is updated from the previous order instead of sorted from scratch.
+  ResortConnections(
+      &connections_, [this](const Connection* a, const Connection* b) {
         int cmp = CompareConnections(a, b, absl::nullopt, nullptr);
         if (cmp != 0) {
           return cmp > 0;
@@ -1846,10 +1884,14 @@ void P2PTransportChannel::SortConnectionsAndUpdateState(
         return a->rtt() < b->rtt();
       });
 
-  RTC_LOG(LS_VERBOSE) << "Sorting " << connections_.size()
-                      << " available connections";
-  for (size_t i = 0; i < connections_.size(); ++i) {
-    RTC_LOG(LS_VERBOSE) << connections_[i]->ToString();
+  // The arguments of a log statement are evaluated even when it is not
+  // logged, and describing every connection is expensive.
+  if (!rtc::LogMessage::IsNoop(rtc::LS_VERBOSE)) {
+    RTC_LOG(LS_VERBOSE) << "Sorting " << connections_.size()
+                        << " available connections";
+    for (size_t i = 0; i < connections_.size(); ++i) {
+      RTC_LOG(LS_VERBOSE) << connections_[i]->ToString();
+    }
   }
 
   Connection* top_connection =
@@ -2323,34 +2365,28 @@ Connection* P2PTransportChannel::FindNextPingableConnection() {
             pinged_connections_.size() + unpinged_connections_.size());
   // If there are unpinged and pingable connections, only ping those.
   // Otherwise, treat everything as unpinged.
-  // TODO(honghaiz): Instead of adding two separate vectors, we can add a state
-  // "pinged" to filter out unpinged connections.
-  if (absl::c_none_of(unpinged_connections_, [this, now](Connection* conn) {
-        return this->IsPingable(conn, now);
-      })) {
-    unpinged_connections_.insert(pinged_connections_.begin(),
-                                 pinged_connections_.end());
-    pinged_connections_.clear();
-  }
-
-  // Among un-pinged pingable connections, "more pingable" takes precedence.
-  std::vector<Connection*> pingable_connections;
-  absl::c_copy_if(
-      unpinged_connections_, std::back_inserter(pingable_connections),
-      [this, now](Connection* conn) { return IsPingable(conn, now); });
-  auto iter = absl::c_max_element(pingable_connections,
-                                  [this](Connection* conn1, Connection* conn2) {
-                                    // Some implementations of max_element
-                                    // compare an element with itself.
-                                    if (conn1 == conn2) {
-                                      return false;
-                                    }
-                                    return MorePingable(conn1, conn2) == conn2;
-                                  });
-  if (iter != pingable_connections.end()) {
-    return *iter;
+  // Among them, "more pingable" takes precedence. |connections_| is walked in
+  // ranking order, so that a tie goes to the better ranked connection without
+  // looking it up.
+  Connection* unpinged_conn = nullptr;
+  Connection* pinged_conn = nullptr;
+  for (Connection* conn : connections_) {
+    if (!IsPingable(conn, now)) {
+      continue;
+    }
+    Connection*& best =
+        unpinged_connections_.count(conn) ? unpinged_conn : pinged_conn;
+    if (!best || MorePingable(best, conn) == conn) {
+      best = conn;
+    }
   }
-  return nullptr;
+  if (unpinged_conn) {
+    return unpinged_conn;
+  }
+  unpinged_connections_.insert(pinged_connections_.begin(),
+                               pinged_connections_.end());
+  pinged_connections_.clear();
+  return pinged_conn;
 }
 
 void P2PTransportChannel::MarkConnectionPinged(Connection* conn) {
@@ -2662,10 +2698,8 @@ Connection* P2PTransportChannel::MorePingable(Connection* conn1,
   }
 
   // During the initial state when nothing has been pinged yet, return the first
-  // one in the ordered |connections_|.
-  return *(absl::c_find_if(connections_, [conn1, conn2](Connection* conn) {
-    return conn == conn1 || conn == conn2;
-  }));
+  // one in the ordered |connections_|, which the caller passes as |conn1|.
+  return conn1;
 }
 
 void P2PTransportChannel::SetWritable(bool writable) {
@@ -139,6 +139,10 @@ class RTC_EXPORT P2PTransportChannel : public IceTransportInternal {
   bool GetStats(IceTransportStats* ice_transport_stats) override;
   absl::optional<int> GetRttEstimate() override;
   const Connection* selected_connection() const override;
+
+  // Estimates the number of bytes used by the connections of this channel and
+  // the state the channel keeps for each of them.
+  size_t EstimateConnectionMemoryUsage() const;
   absl::optional<const CandidatePair> GetSelectedCandidatePair() const override;
 
   // TODO(honghaiz): Remove this method once the reference of it in
@@ -370,7 +374,7 @@ class RTC_EXPORT P2PTransportChannel : public IceTransportInternal {
 
   Connection* FindOldestConnectionNeedingTriggeredCheck(int64_t now);
   // Between |conn1| and |conn2|, this function returns the one which should
-  // be pinged first.
+  // be pinged first. |conn1| must rank before |conn2| in |connections_|.
   Connection* MorePingable(Connection* conn1, Connection* conn2);
   // Select the connection which is Relay/Relay. If both of them are,
   // UDP relay protocol takes precedence.
@@ -39,6 +39,7 @@
 #include "rtc_base/socket_address.h"
 #include "rtc_base/ssl_adapter.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_base/virtual_socket_server.h"
 #include "system_wrappers/include/metrics.h"
 #include "test/field_trial.h"
@@ -3451,6 +3452,38 @@ TEST_F(P2PTransportChannelPingTest, TestAllConnectionsPingedSufficiently) {
       kDefaultTimeout);
 }
 
+TEST_F(P2PTransportChannelPingTest, TestConnectionMemoryUsage) {
+  FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  P2PTransportChannel ch("connection memory", 1, &pa);
+  PrepareChannel(&ch);
+  ch.MaybeStartGathering();
+  EXPECT_EQ(0u, ch.EstimateConnectionMemoryUsage());
+  ch.AddRemoteCandidate(CreateUdpCandidate(LOCAL_PORT_TYPE, "1.1.1.1", 1, 1));
+  ch.AddRemoteCandidate(CreateUdpCandidate(LOCAL_PORT_TYPE, "2.2.2.2", 2, 2));
+
+  Connection* conn1 = WaitForConnectionTo(&ch, "1.1.1.1", 1);
+  Connection* conn2 = WaitForConnectionTo(&ch, "2.2.2.2", 2);
+  ASSERT_TRUE(conn1 != nullptr);
+  ASSERT_TRUE(conn2 != nullptr);
+  EXPECT_GE(conn1->EstimateMemoryUsage(), sizeof(Connection));
+  EXPECT_GE(ch.EstimateConnectionMemoryUsage(),
+            conn1->EstimateMemoryUsage() + conn2->EstimateMemoryUsage());
+
+  // Every ping adds its STUN request and grows the ping history until it
+  // gets a response.
+  conn1->ReceivedPingResponse(LOW_RTT, "id");
+  size_t conn1_bytes = conn1->EstimateMemoryUsage();
+  conn1->Ping(rtc::TimeMillis());
+  EXPECT_GT(conn1->EstimateMemoryUsage(), conn1_bytes);
+  // A response keeps the room for a few pings in the history, but gives back
+  // the memory of a longer one.
+  for (int i = 0; i < 10; ++i)
+    conn1->Ping(rtc::TimeMillis());
+  size_t pinged_bytes = conn1->EstimateMemoryUsage();
+  conn1->ReceivedPingResponse(LOW_RTT, "id");
+  EXPECT_LT(conn1->EstimateMemoryUsage(), pinged_bytes);
+}
+
 // Verify that the connections are pinged at the right time.
 TEST_F(P2PTransportChannelPingTest, TestStunPingIntervals) {
   rtc::ScopedFakeClock clock;
@@ -4556,6 +4589,60 @@ TEST_F(P2PTransportChannelPingTest, TestMaxOutstandingPingsFieldTrial) {
   EXPECT_EQ(nullptr, ch.FindNextPingableConnection());
 }
 
+// Measures ranking and ping scheduling with many candidate pairs. Disabled
+// since it only logs the results.
+TEST_F(P2PTransportChannelPingTest, DISABLED_RankAndPingManyConnections) {
+  static const int kNumConnections = 600;
+  static const int kNumPings = 2000;
+  rtc::ScopedFakeClock clock;
+  FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  P2PTransportChannel ch("many connections", 1, &pa);
+  PrepareChannel(&ch);
+  // The controlled side does not prune before nomination, so that all the
+  // connections stay pingable.
+  ch.SetIceRole(ICEROLE_CONTROLLED);
+  ch.MaybeStartGathering();
+  EXPECT_TRUE_SIMULATED_WAIT(GetPort(&ch) != nullptr, kDefaultTimeout, clock);
+
+  // Every remote candidate re-ranks the connections.
+  int64_t start_us = rtc::SystemTimeNanos() / rtc::kNumNanosecsPerMicrosec;
+  for (int i = 0; i < kNumConnections; ++i) {
+    ch.AddRemoteCandidate(
+        CreateUdpCandidate(LOCAL_PORT_TYPE, "1.1.1.1", 1000 + i, i + 1));
+    rtc::Thread::Current()->ProcessMessages(0);
+  }
+  int64_t add_us =
+      rtc::SystemTimeNanos() / rtc::kNumNanosecsPerMicrosec - start_us;
+  ASSERT_EQ(static_cast<size_t>(kNumConnections), ch.connections().size());
+
+  // Nothing has been pinged yet, so that the unpinged connections tie.
+  start_us = rtc::SystemTimeNanos() / rtc::kNumNanosecsPerMicrosec;
+  for (int i = 0; i < kNumPings; ++i) {
+    EXPECT_NE(nullptr, FindNextPingableConnectionAndPingIt(&ch));
+  }
+  int64_t ping_us =
+      rtc::SystemTimeNanos() / rtc::kNumNanosecsPerMicrosec - start_us;
+
+  // Connections becoming writable one by one, lowest priority first, each
+  // move a single connection up the ranking.
+  std::vector<Connection*> connections = ch.connections();
+  start_us = rtc::SystemTimeNanos() / rtc::kNumNanosecsPerMicrosec;
+  for (auto it = connections.rbegin(); it != connections.rend(); ++it) {
+    (*it)->ReceivedPingResponse(LOW_RTT, "id");
+    rtc::Thread::Current()->ProcessMessages(0);
+    FindNextPingableConnectionAndPingIt(&ch);
+  }
+  int64_t writable_us =
+      rtc::SystemTimeNanos() / rtc::kNumNanosecsPerMicrosec - start_us;
+  EXPECT_EQ(connections.front(), ch.selected_connection());
+
+  RTC_LOG(LS_WARNING) << kNumConnections << " connections: "
+                      << add_us / kNumConnections << " us per added candidate, "
+                      << ping_us / kNumPings << " us per ping scheduled, "
+                      << writable_us / kNumConnections
+                      << " us per connection becoming writable";
+}
+
 class P2PTransportChannelMostLikelyToWorkFirstTest
     : public P2PTransportChannelPingTest {
  public:
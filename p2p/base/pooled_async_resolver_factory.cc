@@ -0,0 +1,246 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/pooled_async_resolver_factory.h"
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/location.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/net_helpers.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/socket_address.h"
+#include "rtc_base/time_utils.h"
+
+namespace webrtc {
+
+namespace {
+
+// The part of a PooledAsyncResolver that the pool may still hold after the
+// resolver is destroyed.
+struct ResolveRequest : public rtc::RefCountInterface {
+  rtc::Thread* thread = nullptr;
+  rtc::CriticalSection crit;
+  // Cleared when the resolver is destroyed, after which nothing is posted to
+  // |thread|.
+  bool active RTC_GUARDED_BY(crit) = true;
+  int error = -1;
+  std::vector<rtc::IPAddress> addresses;
+};
+
+class PooledAsyncResolver : public rtc::AsyncResolverInterface {
+ public:
+  explicit PooledAsyncResolver(rtc::scoped_refptr<DnsResolverPool> pool)
+      : pool_(std::move(pool)),
+        request_(new rtc::RefCountedObject<ResolveRequest>()) {}
+
+  ~PooledAsyncResolver() override {
+    rtc::CritScope lock(&request_->crit);
+    request_->active = false;
+  }
+
+  void Start(const rtc::SocketAddress& addr) override {
+    RTC_DCHECK(!request_->thread);
+    addr_ = addr;
+    request_->thread = rtc::Thread::Current();
+    RTC_DCHECK(request_->thread);
+    rtc::scoped_refptr<ResolveRequest> request = request_;
+    // |this| is only used on |thread|, where it is destroyed, so the posted
+    // task can tell whether it is still alive.
+    pool_->Resolve(
+        addr.hostname(), addr.family(),
+        [this, request](int error,
+                        const std::vector<rtc::IPAddress>& addresses) {
+          rtc::CritScope lock(&request->crit);
+          if (!request->active)
+            return;
+          request->error = error;
+          request->addresses = addresses;
+          request->thread->PostTask(RTC_FROM_HERE, [this, request] {
+            bool active;
+            {
+              rtc::CritScope lock(&request->crit);
+              active = request->active;
+            }
+            if (active)
+              OnResolved();
+          });
+        });
+  }
+
+  bool GetResolvedAddress(int family, rtc::SocketAddress* addr) const override {
+    if (!done_ || request_->error != 0)
+      return false;
+    for (const rtc::IPAddress& ip : request_->addresses) {
+      if (ip.family() == family) {
+        *addr = addr_;
+        addr->SetResolvedIP(ip);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int GetError() const override { return done_ ? request_->error : -1; }
+
+  void Destroy(bool wait) override { delete this; }
+
+ private:
+  void OnResolved() {
+    done_ = true;
+    SignalDone(this);
+  }
+
+  const rtc::scoped_refptr<DnsResolverPool> pool_;
+  const rtc::scoped_refptr<ResolveRequest> request_;
+  rtc::SocketAddress addr_;
+  bool done_ = false;
+};
+
+}  // namespace
+
+rtc::scoped_refptr<DnsResolverPool> DnsResolverPool::Create(
+    const Config& config) {
+  return new rtc::RefCountedObject<DnsResolverPool>(config);
+}
+
+DnsResolverPool::DnsResolverPool(const Config& config) : config_(config) {
+  RTC_DCHECK_GT(config_.num_threads, 0);
+  for (size_t i = 0; i < std::max<size_t>(config_.num_threads, 1); ++i) {
+    std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+    thread->SetName("DnsResolverPool", this);
+    thread->Start();
+    threads_.push_back(std::move(thread));
+  }
+}
+
+DnsResolverPool::~DnsResolverPool() {
+  // Waits for the running lookups. The queued ones are dropped along with
+  // their callbacks.
+  for (auto& thread : threads_)
+    thread->Stop();
+}
+
+void DnsResolverPool::Resolve(const std::string& hostname,
+                              int family,
+                              Callback callback) {
+  Key key(hostname, family);
+  int error;
+  std::vector<rtc::IPAddress> addresses;
+  {
+    rtc::CritScope lock(&crit_);
+    auto cached = cache_.find(key);
+    if (cached != cache_.end() &&
+        cached->second.expiry_ms > rtc::TimeMillis()) {
+      ++stats_.cache_hits;
+      error = cached->second.error;
+      addresses = cached->second.addresses;
+    } else {
+      std::vector<Callback>& callbacks = pending_[key];
+      callbacks.push_back(std::move(callback));
+      if (callbacks.size() > 1) {
+        ++stats_.coalesced;
+        return;
+      }
+      ++stats_.lookups;
+      queue_.push_back(std::move(key));
+      // Each task resolves whichever name is queued first, so a slow lookup
+      // does not hold up the names queued behind it on the same thread.
+      rtc::Thread* thread = threads_[next_thread_++ % threads_.size()].get();
+      thread->PostTask(RTC_FROM_HERE, [this] { ResolveNext(); });
+      return;
+    }
+  }
+  callback(error, addresses);
+}
+
+void DnsResolverPool::ClearCache() {
+  rtc::CritScope lock(&crit_);
+  cache_.clear();
+}
+
+DnsResolverPool::Stats DnsResolverPool::GetStats() const {
+  rtc::CritScope lock(&crit_);
+  return stats_;
+}
+
+void DnsResolverPool::ResolveNext() {
+  Key key;
+  {
+    rtc::CritScope lock(&crit_);
+    RTC_DCHECK(!queue_.empty());
+    key = std::move(queue_.front());
+    queue_.pop_front();
+  }
+  std::vector<rtc::IPAddress> addresses;
+  int error = config_.resolve_function
+                  ? config_.resolve_function(key.first, key.second, &addresses)
+                  : rtc::ResolveHostname(key.first, key.second, &addresses);
+  if (error != 0) {
+    RTC_LOG(LS_INFO) << "Failed to resolve " << key.first << ", error "
+                     << error;
+  }
+  std::vector<Callback> callbacks;
+  {
+    rtc::CritScope lock(&crit_);
+    AddToCache(key, error, addresses);
+    auto it = pending_.find(key);
+    RTC_DCHECK(it != pending_.end());
+    callbacks = std::move(it->second);
+    pending_.erase(it);
+  }
+  for (Callback& callback : callbacks)
+    callback(error, addresses);
+}
+
+void DnsResolverPool::AddToCache(const Key& key,
+                                 int error,
+                                 const std::vector<rtc::IPAddress>& addresses) {
+  int64_t now = rtc::TimeMillis();
+  bool found = error == 0 && !addresses.empty();
+  int64_t ttl_ms = found ? config_.positive_ttl_ms : config_.negative_ttl_ms;
+  if (ttl_ms <= 0 || config_.max_cache_entries == 0)
+    return;
+  if (cache_.size() >= config_.max_cache_entries && !cache_.count(key)) {
+    for (auto it = cache_.begin(); it != cache_.end();) {
+      if (it->second.expiry_ms <= now)
+        it = cache_.erase(it);
+      else
+        ++it;
+    }
+  }
+  if (cache_.size() >= config_.max_cache_entries && !cache_.count(key)) {
+    cache_.erase(std::min_element(
+        cache_.begin(), cache_.end(),
+        [](const std::pair<const Key, CacheEntry>& a,
+           const std::pair<const Key, CacheEntry>& b) {
+          return a.second.expiry_ms < b.second.expiry_ms;
+        }));
+  }
+  CacheEntry& entry = cache_[key];
+  entry.error = error;
+  entry.addresses = addresses;
+  entry.expiry_ms = now + ttl_ms;
+}
+
+PooledAsyncResolverFactory::PooledAsyncResolverFactory(
+    rtc::scoped_refptr<DnsResolverPool> pool)
+    : pool_(std::move(pool)) {
+  RTC_DCHECK(pool_);
+}
+
+PooledAsyncResolverFactory::~PooledAsyncResolverFactory() = default;
+
+rtc::AsyncResolverInterface* PooledAsyncResolverFactory::Create() {
+  return new PooledAsyncResolver(pool_);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,133 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef P2P_BASE_POOLED_ASYNC_RESOLVER_FACTORY_H_
+#define P2P_BASE_POOLED_ASYNC_RESOLVER_FACTORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "api/async_resolver_factory.h"
+#include "api/scoped_refptr.h"
+#include "rtc_base/async_resolver_interface.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/ip_address.h"
+#include "rtc_base/ref_count.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Resolves hostnames on a fixed set of threads, instead of on a new thread
+// per lookup like rtc::AsyncResolver does. Results, failures included, are
+// cached for a bounded time, and concurrent lookups of the same name share
+// one resolution. Thread safe.
+class DnsResolverPool : public rtc::RefCountInterface {
+ public:
+  using ResolveFunction = std::function<int(const std::string& hostname,
+                                            int family,
+                                            std::vector<rtc::IPAddress>*)>;
+  using Callback =
+      std::function<void(int error, const std::vector<rtc::IPAddress>&)>;
+
+  struct Config {
+    size_t num_threads = 2;
+    // How long successful and failed lookups are cached.
+    int64_t positive_ttl_ms = 5 * 60 * 1000;
+    int64_t negative_ttl_ms = 10 * 1000;
+    size_t max_cache_entries = 256;
+    // Performs the lookups. rtc::ResolveHostname() if not set.
+    ResolveFunction resolve_function;
+  };
+
+  struct Stats {
+    // Lookups that were performed.
+    int lookups = 0;
+    // Requests answered from the cache.
+    int cache_hits = 0;
+    // Requests that joined a lookup in progress.
+    int coalesced = 0;
+  };
+
+  static rtc::scoped_refptr<DnsResolverPool> Create(const Config& config);
+
+  // Resolves |hostname| for |family| and calls |callback| with the result,
+  // either on the calling thread before returning, if the result is cached,
+  // or later on one of the threads of the pool.
+  void Resolve(const std::string& hostname, int family, Callback callback);
+
+  // Drops the cached results. Lookups in progress are not affected.
+  void ClearCache();
+
+  Stats GetStats() const;
+
+ protected:
+  explicit DnsResolverPool(const Config& config);
+  ~DnsResolverPool() override;
+
+ private:
+  using Key = std::pair<std::string, int>;
+
+  struct CacheEntry {
+    int error = 0;
+    std::vector<rtc::IPAddress> addresses;
+    int64_t expiry_ms = 0;
+  };
+
+  // Resolves the oldest queued name. Runs on the threads of the pool.
+  void ResolveNext();
+  void AddToCache(const Key& key,
+                  int error,
+                  const std::vector<rtc::IPAddress>& addresses)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  const Config config_;
+  rtc::CriticalSection crit_;
+  std::map<Key, CacheEntry> cache_ RTC_GUARDED_BY(crit_);
+  // The callbacks waiting for each queued or running lookup.
+  std::map<Key, std::vector<Callback>> pending_ RTC_GUARDED_BY(crit_);
+  std::deque<Key> queue_ RTC_GUARDED_BY(crit_);
+  size_t next_thread_ RTC_GUARDED_BY(crit_) = 0;
+  Stats stats_ RTC_GUARDED_BY(crit_);
+  std::vector<std::unique_ptr<rtc::Thread>> threads_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(DnsResolverPool);
+};
+
+// Creates resolvers that use a DnsResolverPool. Each PeerConnection takes
+// ownership of its AsyncResolverFactory, so to share the cache across
+// PeerConnections, give each one a factory of its own for the same pool.
+// The pool is kept alive while resolvers it created exist.
+class PooledAsyncResolverFactory : public AsyncResolverFactory {
+ public:
+  explicit PooledAsyncResolverFactory(
+      rtc::scoped_refptr<DnsResolverPool> pool);
+  ~PooledAsyncResolverFactory() override;
+
+  // The resolvers must be started and destroyed on the same thread, which
+  // gets their SignalDone.
+  rtc::AsyncResolverInterface* Create() override;
+
+ private:
+  const rtc::scoped_refptr<DnsResolverPool> pool_;
+};
+
+}  // namespace webrtc
+
+#endif  // P2P_BASE_POOLED_ASYNC_RESOLVER_FACTORY_H_
@@ -0,0 +1,264 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "p2p/base/pooled_async_resolver_factory.h"
+
+#include <atomic>
+#include <memory>
+
+#include "api/units/time_delta.h"
+#include "p2p/base/basic_async_resolver_factory.h"
+#include "rtc_base/event.h"
+#include "rtc_base/fake_clock.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/socket_address.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+namespace {
+
+const int kTimeout = 10000;
+const char kHostname[] = "stun.example.com";
+const char kUnknownHostname[] = "unknown.example.com";
+
+}  // namespace
+
+class PooledAsyncResolverFactoryTest : public ::testing::Test,
+                                       public sigslot::has_slots<> {
+ protected:
+  PooledAsyncResolverFactoryTest() {
+    config_.resolve_function = [this](const std::string& hostname,
+                                      int family,
+                                      std::vector<rtc::IPAddress>* addresses) {
+      ++lookups_;
+      if (block_lookups_) {
+        lookup_started_.Set();
+        release_lookups_.Wait(rtc::Event::kForever);
+      }
+      if (hostname != kHostname)
+        return -1;
+      addresses->push_back(rtc::IPAddress(0x01020304));
+      return 0;
+    };
+  }
+
+  void CreateFactory() {
+    pool_ = DnsResolverPool::Create(config_);
+    factory_ = std::make_unique<PooledAsyncResolverFactory>(pool_);
+  }
+
+  rtc::AsyncResolverInterface* StartResolver(const std::string& hostname) {
+    return StartResolver(factory_.get(), hostname);
+  }
+
+  rtc::AsyncResolverInterface* StartResolver(AsyncResolverFactory* factory,
+                                             const std::string& hostname) {
+    rtc::AsyncResolverInterface* resolver = factory->Create();
+    resolver->SignalDone.connect(this,
+                                 &PooledAsyncResolverFactoryTest::OnDone);
+    resolver->Start(rtc::SocketAddress(hostname, 3478));
+    return resolver;
+  }
+
+  void OnDone(rtc::AsyncResolverInterface* resolver) {
+    EXPECT_TRUE(main_thread_.IsCurrent());
+    ++done_;
+  }
+
+  rtc::AutoThread main_thread_;
+  DnsResolverPool::Config config_;
+  rtc::scoped_refptr<DnsResolverPool> pool_;
+  std::unique_ptr<PooledAsyncResolverFactory> factory_;
+  std::atomic<int> lookups_{0};
+  bool block_lookups_ = false;
+  rtc::Event lookup_started_;
+  rtc::Event release_lookups_{/*manual_reset=*/true,
+                              /*initially_signaled=*/false};
+  int done_ = 0;
+};
+
+TEST_F(PooledAsyncResolverFactoryTest, ResolvesAndSignalsOnCallingThread) {
+  CreateFactory();
+  rtc::AsyncResolverInterface* resolver = StartResolver(kHostname);
+  EXPECT_EQ_WAIT(1, done_, kTimeout);
+  EXPECT_EQ(0, resolver->GetError());
+  rtc::SocketAddress address;
+  ASSERT_TRUE(resolver->GetResolvedAddress(AF_INET, &address));
+  EXPECT_EQ(rtc::SocketAddress(rtc::IPAddress(0x01020304), 3478), address);
+  EXPECT_EQ(kHostname, address.hostname());
+  EXPECT_FALSE(resolver->GetResolvedAddress(AF_INET6, &address));
+  resolver->Destroy(false);
+}
+
+TEST_F(PooledAsyncResolverFactoryTest, ReportsFailure) {
+  CreateFactory();
+  rtc::AsyncResolverInterface* resolver = StartResolver(kUnknownHostname);
+  EXPECT_EQ_WAIT(1, done_, kTimeout);
+  EXPECT_NE(0, resolver->GetError());
+  rtc::SocketAddress address;
+  EXPECT_FALSE(resolver->GetResolvedAddress(AF_INET, &address));
+  resolver->Destroy(false);
+}
+
+TEST_F(PooledAsyncResolverFactoryTest, CachesResultsUntilTheyExpire) {
+  rtc::ScopedFakeClock clock;
+  config_.positive_ttl_ms = 60000;
+  config_.negative_ttl_ms = 1000;
+  CreateFactory();
+  std::vector<rtc::AsyncResolverInterface*> resolvers;
+  resolvers.push_back(StartResolver(kHostname));
+  resolvers.push_back(StartResolver(kUnknownHostname));
+  EXPECT_EQ_SIMULATED_WAIT(2, done_, kTimeout, clock);
+  EXPECT_EQ(2, lookups_);
+
+  // Both results are cached, but are still signaled asynchronously.
+  resolvers.push_back(StartResolver(kHostname));
+  resolvers.push_back(StartResolver(kUnknownHostname));
+  EXPECT_EQ(2, done_);
+  EXPECT_EQ_SIMULATED_WAIT(4, done_, kTimeout, clock);
+  EXPECT_EQ(2, lookups_);
+  EXPECT_EQ(0, resolvers[2]->GetError());
+  EXPECT_NE(0, resolvers[3]->GetError());
+  EXPECT_EQ(2, pool_->GetStats().cache_hits);
+
+  // Failures are cached for a shorter time.
+  clock.AdvanceTime(TimeDelta::ms(config_.negative_ttl_ms));
+  resolvers.push_back(StartResolver(kHostname));
+  resolvers.push_back(StartResolver(kUnknownHostname));
+  EXPECT_EQ_SIMULATED_WAIT(6, done_, kTimeout, clock);
+  EXPECT_EQ(3, lookups_);
+
+  clock.AdvanceTime(TimeDelta::ms(config_.positive_ttl_ms));
+  resolvers.push_back(StartResolver(kHostname));
+  EXPECT_EQ_SIMULATED_WAIT(7, done_, kTimeout, clock);
+  EXPECT_EQ(4, lookups_);
+  EXPECT_EQ(0, resolvers[6]->GetError());
+
+  for (rtc::AsyncResolverInterface* resolver : resolvers)
+    resolver->Destroy(false);
+}
+
+TEST_F(PooledAsyncResolverFactoryTest, CacheIsSharedAcrossFactories) {
+  CreateFactory();
+  PooledAsyncResolverFactory other_factory(pool_);
+  rtc::AsyncResolverInterface* resolver = StartResolver(kHostname);
+  EXPECT_EQ_WAIT(1, done_, kTimeout);
+  resolver->Destroy(false);
+
+  resolver = StartResolver(&other_factory, kHostname);
+  EXPECT_EQ_WAIT(2, done_, kTimeout);
+  EXPECT_EQ(0, resolver->GetError());
+  EXPECT_EQ(1, lookups_);
+  resolver->Destroy(false);
+}
+
+TEST_F(PooledAsyncResolverFactoryTest, CoalescesConcurrentLookups) {
+  block_lookups_ = true;
+  CreateFactory();
+  std::vector<rtc::AsyncResolverInterface*> resolvers;
+  resolvers.push_back(StartResolver(kHostname));
+  ASSERT_TRUE(lookup_started_.Wait(kTimeout));
+  resolvers.push_back(StartResolver(kHostname));
+  resolvers.push_back(StartResolver(kHostname));
+  release_lookups_.Set();
+  EXPECT_EQ_WAIT(3, done_, kTimeout);
+  EXPECT_EQ(1, lookups_);
+  EXPECT_EQ(2, pool_->GetStats().coalesced);
+  for (rtc::AsyncResolverInterface* resolver : resolvers) {
+    EXPECT_EQ(0, resolver->GetError());
+    resolver->Destroy(false);
+  }
+}
+
+TEST_F(PooledAsyncResolverFactoryTest, LookupsDoNotWaitForSlowerOnes) {
+  // The unknown name blocks one of the two threads until the end.
+  config_.num_threads = 2;
+  config_.resolve_function = [this](const std::string& hostname,
+                                    int family,
+                                    std::vector<rtc::IPAddress>* addresses) {
+    if (hostname != kHostname) {
+      lookup_started_.Set();
+      release_lookups_.Wait(rtc::Event::kForever);
+      return -1;
+    }
+    addresses->push_back(rtc::IPAddress(0x01020304));
+    return 0;
+  };
+  CreateFactory();
+  rtc::AsyncResolverInterface* slow = StartResolver(kUnknownHostname);
+  ASSERT_TRUE(lookup_started_.Wait(kTimeout));
+  rtc::AsyncResolverInterface* fast = StartResolver(kHostname);
+  EXPECT_EQ_WAIT(1, done_, kTimeout);
+  EXPECT_EQ(0, fast->GetError());
+  release_lookups_.Set();
+  EXPECT_EQ_WAIT(2, done_, kTimeout);
+  slow->Destroy(false);
+  fast->Destroy(false);
+}
+
+TEST_F(PooledAsyncResolverFactoryTest, DestroyBeforeDone) {
+  block_lookups_ = true;
+  CreateFactory();
+  rtc::AsyncResolverInterface* destroyed = StartResolver(kHostname);
+  ASSERT_TRUE(lookup_started_.Wait(kTimeout));
+  rtc::AsyncResolverInterface* resolver = StartResolver(kHostname);
+  destroyed->Destroy(false);
+  release_lookups_.Set();
+  EXPECT_EQ_WAIT(1, done_, kTimeout);
+  EXPECT_EQ(0, resolver->GetError());
+  // The pool outlives the factory while a resolver uses it.
+  factory_.reset();
+  pool_ = nullptr;
+  resolver->Destroy(false);
+  main_thread_.ProcessMessages(0);
+  EXPECT_EQ(1, done_);
+}
+
+// Compares the time it takes to resolve a name one after another with a thread
+// per lookup, with a pool and with a pool that caches.
+TEST_F(PooledAsyncResolverFactoryTest, DISABLED_ResolveLocalhost) {
+  const int kLookups = 200;
+  config_.resolve_function = nullptr;
+  config_.positive_ttl_ms = 0;
+  config_.negative_ttl_ms = 0;
+  CreateFactory();
+  BasicAsyncResolverFactory basic_factory;
+  DnsResolverPool::Config caching_config;
+  PooledAsyncResolverFactory caching_factory(
+      DnsResolverPool::Create(caching_config));
+  struct {
+    const char* name;
+    AsyncResolverFactory* factory;
+  } factories[] = {{"AsyncResolver", &basic_factory},
+                   {"DnsResolverPool", factory_.get()},
+                   {"DnsResolverPool with cache", &caching_factory}};
+  for (const auto& factory : factories) {
+    done_ = 0;
+    int64_t start_us = rtc::TimeMicros();
+    for (int i = 0; i < kLookups; ++i) {
+      rtc::AsyncResolverInterface* resolver =
+          StartResolver(factory.factory, "localhost");
+      while (done_ == i)
+        main_thread_.ProcessMessages(0);
+      resolver->Destroy(false);
+    }
+    RTC_LOG(LS_WARNING) << factory.name << ": "
+                        << static_cast<double>(rtc::TimeMicros() - start_us) /
+                               kLookups
+                        << " us per lookup";
+  }
+}
+
+}  // namespace webrtc
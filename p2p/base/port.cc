@@ -13,6 +13,7 @@
 #include <math.h>
 
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -483,7 +484,8 @@ bool Port::GetStunMessage(const char* data,
     }
 
     // If ICE, and the MESSAGE-INTEGRITY is bad, fail with a 401 Unauthorized
-    if (!stun_msg->ValidateMessageIntegrity(data, size, password_)) {
+    if (!stun_msg->ValidateMessageIntegrity(data, size,
+                                            password_hmac_.Get(password_))) {
       RTC_LOG(LS_ERROR) << ToString()
                         << ": Received STUN request with bad M-I from "
                         << addr.ToSensitiveString()
@@ -696,7 +698,7 @@ void Port::SendBindingResponse(StunMessage* request,
 
   response.AddAttribute(std::make_unique<StunXorAddressAttribute>(
       STUN_ATTR_XOR_MAPPED_ADDRESS, addr));
-  response.AddMessageIntegrity(password_);
+  response.AddMessageIntegrity(password_hmac_.Get(password_));
   response.AddFingerprint();
 
   // Send the response message.
@@ -750,7 +752,7 @@ void Port::SendBindingErrorResponse(StunMessage* request,
   // because we don't have enough information to determine the shared secret.
   if (error_code != STUN_ERROR_BAD_REQUEST &&
       error_code != STUN_ERROR_UNAUTHORIZED)
-    response.AddMessageIntegrity(password_);
+    response.AddMessageIntegrity(password_hmac_.Get(password_));
   response.AddFingerprint();
 
   // Send the response message.
@@ -830,6 +832,30 @@ void Port::EnablePortPackets() {
   enable_port_packets_ = true;
 }
 
+rtc::Hmac* Port::GetRemotePasswordHmac(const std::string& password) {
+  std::unique_ptr<rtc::Hmac>& hmac = remote_password_hmacs_[password];
+  if (!hmac) {
+    hmac = std::make_unique<rtc::Hmac>(rtc::DIGEST_SHA_1, password.data(),
+                                       password.size());
+  }
+  return hmac.get();
+}
+
+size_t Port::EstimateRemotePasswordHmacMemoryUsage() const {
+  // An HMAC keeps three digests. With OpenSSL, each of them is an EVP_MD_CTX
+  // with the SHA-1 state behind it, about 180 bytes.
+  const size_t kHmacBytes = sizeof(rtc::Hmac) + 3 * 180;
+  // A node of a std::map holds the value and three pointers, and its color.
+  const size_t kMapNodeBytes =
+      sizeof(decltype(remote_password_hmacs_)::value_type) + 4 * sizeof(void*);
+  size_t bytes = 0;
+  for (const auto& kv : remote_password_hmacs_) {
+    // ICE passwords are too long to be stored inside the string.
+    bytes += kMapNodeBytes + kv.first.capacity() + 1 + kHmacBytes;
+  }
+  return bytes;
+}
+
 void Port::OnConnectionDestroyed(Connection* conn) {
   AddressMap::iterator iter =
       connections_.find(conn->remote_candidate().address());
@@ -837,6 +863,17 @@ void Port::OnConnectionDestroyed(Connection* conn) {
   connections_.erase(iter);
   HandleConnectionDestroyed(conn);
 
+  // Release the HMACs of remote passwords that no connection uses any more.
+  for (auto it = remote_password_hmacs_.begin();
+       it != remote_password_hmacs_.end();) {
+    const std::string& password = it->first;
+    bool in_use = absl::c_any_of(
+        connections_, [&password](const AddressMap::value_type& kv) {
+          return kv.second->remote_candidate().password() == password;
+        });
+    it = in_use ? std::next(it) : remote_password_hmacs_.erase(it);
+  }
+
   // Ports time out after all connections fail if it is not marked as
   // "keep alive until pruned."
   // Note: If a new connection is added after this message is posted, but it
@@ -274,6 +274,17 @@ class Port : public PortInterface,
   // Returns the connection to the given address or NULL if none exists.
   Connection* GetConnection(const rtc::SocketAddress& remote_addr) override;
 
+  // Returns the HMAC that signs and validates the STUN messages exchanged
+  // with remote candidates using the ICE |password|. It is created on first
+  // use and shared by all connections of this port with the same remote
+  // password, and released once none of them is left.
+  rtc::Hmac* GetRemotePasswordHmac(const std::string& password);
+  size_t remote_password_hmac_count() const {
+    return remote_password_hmacs_.size();
+  }
+  // Estimates the number of bytes used by these HMACs.
+  size_t EstimateRemotePasswordHmacMemoryUsage() const;
+
   // Called each time a connection is created.
   sigslot::signal2<Port*, Connection*> SignalConnectionCreated;
 
@@ -470,8 +481,12 @@ class Port : public PortInterface,
   // username_fragment().
   std::string ice_username_fragment_;
   std::string password_;
+  // Signs and validates the STUN messages that use |password_|.
+  StunHmacCache password_hmac_;
   std::vector<Candidate> candidates_;
   AddressMap connections_;
+  // The HMACs of the remote passwords used by |connections_|.
+  std::map<std::string, std::unique_ptr<rtc::Hmac>> remote_password_hmacs_;
   int timeout_delay_;
   bool enable_port_packets_;
   IceRole ice_role_;
@@ -1876,6 +1876,43 @@ TEST_F(PortTest, TestNomination) {
   EXPECT_EQ(rconn->nominated(), rconn->stats().nominated);
 }
 
+TEST_F(PortTest, TestConnectionsShareRemotePasswordHmac) {
+  auto lport = CreateTestPort(kLocalAddr1, "lfrag", "lpass");
+  auto rport = CreateTestPort(kLocalAddr2, "rfrag", "rpass");
+  lport->SetIceRole(cricket::ICEROLE_CONTROLLING);
+  lport->SetIceTiebreaker(kTiebreaker1);
+  lport->PrepareAddress();
+  rport->PrepareAddress();
+  ASSERT_FALSE(rport->Candidates().empty());
+
+  Candidate remote1 = rport->Candidates()[0];
+  Candidate remote2 = remote1;
+  remote2.set_address(SocketAddress(kLocalAddr2.ipaddr(), 5000));
+  Candidate remote3 = remote1;
+  remote3.set_address(SocketAddress(kLocalAddr2.ipaddr(), 5001));
+  remote3.set_password("rpass2");
+  Connection* conn1 = lport->CreateConnection(remote1, Port::ORIGIN_MESSAGE);
+  Connection* conn2 = lport->CreateConnection(remote2, Port::ORIGIN_MESSAGE);
+  Connection* conn3 = lport->CreateConnection(remote3, Port::ORIGIN_MESSAGE);
+  EXPECT_EQ(0u, lport->remote_password_hmac_count());
+
+  // The HMAC is created by the first ping and shared by connections with
+  // the same remote password.
+  conn1->Ping(0);
+  conn2->Ping(0);
+  EXPECT_EQ(1u, lport->remote_password_hmac_count());
+  conn3->Ping(0);
+  EXPECT_EQ(2u, lport->remote_password_hmac_count());
+
+  conn3->Destroy();
+  EXPECT_EQ_WAIT(1u, lport->remote_password_hmac_count(), kDefaultTimeout);
+  conn1->Destroy();
+  EXPECT_EQ_WAIT(1u, lport->connections().size(), kDefaultTimeout);
+  EXPECT_EQ(1u, lport->remote_password_hmac_count());
+  conn2->Destroy();
+  EXPECT_EQ_WAIT(0u, lport->remote_password_hmac_count(), kDefaultTimeout);
+}
+
 TEST_F(PortTest, TestRoundTripTime) {
   rtc::ScopedFakeClock clock;
 
@@ -98,6 +98,11 @@ const uint32_t DEFAULT_SND_BUF_SIZE = 90 * 1024;
 // 24 |                             data                              |
 //    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
 //
+// When FLAG_SACK is set, the data starts with the selective acknowledgement
+// blocks: one byte with the number of blocks, followed by the left and right
+// edge of each block as 32-bit sequence numbers. This is only sent to peers
+// that have sent TCP_OPT_SACK_PERMITTED in their connect message.
+//
 //////////////////////////////////////////////////////////////////////
 
 #define PSEUDO_KEEPALIVE 0
@@ -114,6 +119,7 @@ const uint32_t DEF_ACK_DELAY = 100;  // 100 milliseconds
 
 const uint8_t FLAG_CTL = 0x02;
 const uint8_t FLAG_RST = 0x04;
+const uint8_t FLAG_SACK = 0x08;
 
 const uint8_t CTL_CONNECT = 0;
 
@@ -122,6 +128,12 @@ const uint8_t TCP_OPT_EOL = 0;        // End of list.
 const uint8_t TCP_OPT_NOOP = 1;       // No-op.
 const uint8_t TCP_OPT_MSS = 2;        // Maximum segment size.
 const uint8_t TCP_OPT_WND_SCALE = 3;  // Window scale factor.
+const uint8_t TCP_OPT_SACK_PERMITTED = 4;  // Selective acknowledgement.
+
+// Selective acknowledgement blocks sent with one segment, and their size.
+const uint32_t MAX_SACK_BLOCKS = 4;
+const uint32_t SACK_BLOCK_SIZE = 8;
+const uint32_t MAX_SACK_SIZE = 1 + MAX_SACK_BLOCKS * SACK_BLOCK_SIZE;
 
 const long DEFAULT_TIMEOUT =
     4000;  // If there are no pending clocks, wake up every 4 seconds
@@ -245,6 +257,12 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32_t conv)
 
   m_dup_acks = 0;
   m_recover = 0;
+  m_rto_recovery = false;
+  m_had_loss = false;
+  m_rlist_last_seq = 0;
+
+  m_sack_enabled = false;
+  m_sack_high = m_sack_rexmit = 0;
 
   m_ts_recent = m_ts_lastack = 0;
 
@@ -254,6 +272,7 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32_t conv)
   m_use_nagling = true;
   m_ack_delay = DEF_ACK_DELAY;
   m_support_wnd_scale = true;
+  m_support_sack = true;
 }
 
 PseudoTcp::~PseudoTcp() {}
@@ -307,6 +326,17 @@ void PseudoTcp::NotifyClock(uint32_t now) {
       // RTC_LOG(LS_INFO) << "m_ssthresh: " << m_ssthresh << "  nInFlight: " <<
       // nInFlight << "  m_mss: " << m_mss;
       m_cwnd = m_mss;
+      m_had_loss = true;
+
+      // With selective acknowledgements, the holes after the retransmitted
+      // segment are known, so recover them as the acks come in rather than
+      // waiting for a timeout for each of them.
+      if (m_sack_enabled) {
+        m_dup_acks = 3;
+        m_recover = m_snd_nxt;
+        m_sack_rexmit = m_slist.front().seq + 1;
+        m_rto_recovery = true;
+      }
 
       // Back off retransmit timer.  Note: the limit is lower when connecting.
       uint32_t rto_limit = (m_state < TCP_ESTABLISHED) ? DEF_RTO : MAX_RTO;
@@ -516,24 +546,36 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32_t seq,
 
   uint32_t now = Now();
 
-  std::unique_ptr<uint8_t[]> buffer(new uint8_t[MAX_PACKET]);
-  long_to_bytes(m_conv, buffer.get());
-  long_to_bytes(seq, buffer.get() + 4);
-  long_to_bytes(m_rcv_nxt, buffer.get() + 8);
+  // ACK packets, which may carry selective acknowledgement blocks, are built
+  // on the stack. Packets with payload get a buffer of just the right size.
+  uint8_t ack_buffer[HEADER_SIZE + MAX_SACK_SIZE];
+  std::unique_ptr<uint8_t[]> data_buffer;
+  uint8_t* buffer = ack_buffer;
+  uint32_t sack_len = 0;
+  if (len) {
+    data_buffer.reset(new uint8_t[HEADER_SIZE + len]);
+    buffer = data_buffer.get();
+  } else if (m_sack_enabled && !m_rlist.empty()) {
+    flags |= FLAG_SACK;
+    sack_len = writeSackBlocks(buffer + HEADER_SIZE);
+  }
+
+  long_to_bytes(m_conv, buffer);
+  long_to_bytes(seq, buffer + 4);
+  long_to_bytes(m_rcv_nxt, buffer + 8);
   buffer[12] = 0;
   buffer[13] = flags;
-  short_to_bytes(static_cast<uint16_t>(m_rcv_wnd >> m_rwnd_scale),
-                 buffer.get() + 14);
+  short_to_bytes(static_cast<uint16_t>(m_rcv_wnd >> m_rwnd_scale), buffer + 14);
 
   // Timestamp computations
-  long_to_bytes(now, buffer.get() + 16);
-  long_to_bytes(m_ts_recent, buffer.get() + 20);
+  long_to_bytes(now, buffer + 16);
+  long_to_bytes(m_ts_recent, buffer + 20);
   m_ts_lastack = m_rcv_nxt;
 
   if (len) {
     size_t bytes_read = 0;
     rtc::StreamResult result =
-        m_sbuf.ReadOffset(buffer.get() + HEADER_SIZE, len, offset, &bytes_read);
+        m_sbuf.ReadOffset(buffer + HEADER_SIZE, len, offset, &bytes_read);
     RTC_DCHECK(result == rtc::SR_SUCCESS);
     RTC_DCHECK(static_cast<uint32_t>(bytes_read) == len);
   }
@@ -549,7 +591,7 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32_t seq,
 #endif  // _DEBUGMSG
 
   IPseudoTcpNotify::WriteResult wres = m_notify->TcpWritePacket(
-      this, reinterpret_cast<char*>(buffer.get()), len + HEADER_SIZE);
+      this, reinterpret_cast<char*>(buffer), len + sack_len + HEADER_SIZE);
   // Note: When len is 0, this is an ACK packet.  We don't read the return value
   // for those, and thus we won't retry.  So go ahead and treat the packet as a
   // success (basically simulate as if it were dropped), which will prevent our
@@ -584,6 +626,20 @@ bool PseudoTcp::parse(const uint8_t* buffer, uint32_t size) {
   seg.data = reinterpret_cast<const char*>(buffer) + HEADER_SIZE;
   seg.len = size - HEADER_SIZE;
 
+  seg.sack_blocks = nullptr;
+  seg.sack_block_count = 0;
+  if (seg.flags & FLAG_SACK) {
+    if (seg.len == 0)
+      return false;
+    uint32_t sack_len = 1 + buffer[HEADER_SIZE] * SACK_BLOCK_SIZE;
+    if (seg.len < sack_len)
+      return false;
+    seg.sack_block_count = buffer[HEADER_SIZE];
+    seg.sack_blocks = seg.data + 1;
+    seg.data += sack_len;
+    seg.len -= sack_len;
+  }
+
 #if _DEBUGMSG >= _DBG_VERBOSE
   RTC_LOG(LS_INFO) << "--> <CONV=" << seg.conv
                    << "><FLG=" << static_cast<unsigned>(seg.flags)
@@ -704,6 +760,10 @@ bool PseudoTcp::process(Segment& seg) {
     m_ts_recent = seg.tsval;
   }
 
+  if (m_sack_enabled) {
+    applySackBlocks(seg);
+  }
+
   // Check if this is a valuable ack
   if ((seg.ack > m_snd_una) && (seg.ack <= m_snd_nxt)) {
     // Calculate round-trip time
@@ -732,7 +792,7 @@ bool PseudoTcp::process(Segment& seg) {
       }
     }
 
-    m_snd_wnd = static_cast<uint32_t>(seg.wnd) << m_swnd_scale;
+    updateSendWindow(seg.wnd);
 
     uint32_t nAcked = seg.ack - m_snd_una;
     m_snd_una = seg.ack;
@@ -744,6 +804,7 @@ bool PseudoTcp::process(Segment& seg) {
     for (uint32_t nFree = nAcked; nFree > 0;) {
       RTC_DCHECK(!m_slist.empty());
       if (nFree < m_slist.front().len) {
+        m_slist.front().seq += nFree;
         m_slist.front().len -= nFree;
         nFree = 0;
       } else {
@@ -757,21 +818,48 @@ bool PseudoTcp::process(Segment& seg) {
 
     if (m_dup_acks >= 3) {
       if (m_snd_una >= m_recover) {  // NewReno
-        uint32_t nInFlight = m_snd_nxt - m_snd_una;
-        m_cwnd = std::min(m_ssthresh, nInFlight + m_mss);  // (Fast Retransmit)
+        // After a timeout the window was already collapsed and has been
+        // growing by slow start since, so there is nothing to deflate.
+        if (!m_rto_recovery) {
+          uint32_t nInFlight = m_snd_nxt - m_snd_una;
+          m_cwnd =
+              std::min(m_ssthresh, nInFlight + m_mss);  // (Fast Retransmit)
+        }
 #if _DEBUGMSG >= _DBG_NORMAL
         RTC_LOG(LS_INFO) << "exit recovery";
 #endif  // _DEBUGMSG
         m_dup_acks = 0;
+        m_rto_recovery = false;
       } else {
 #if _DEBUGMSG >= _DBG_NORMAL
         RTC_LOG(LS_INFO) << "recovery retransmit";
 #endif  // _DEBUGMSG
-        if (!transmit(m_slist.begin(), now)) {
-          closedown(ECONNABORTED);
-          return false;
+        if (m_sack_enabled && m_slist.front().seq < m_sack_rexmit) {
+          // The first segment has been retransmitted during this recovery
+          // already, so fill the next hole instead.
+          bool error = false;
+          retransmitSackHole(now, &error);
+          if (error) {
+            closedown(ECONNABORTED);
+            return false;
+          }
+        } else {
+          if (!transmit(m_slist.begin(), now)) {
+            closedown(ECONNABORTED);
+            return false;
+          }
+          m_sack_rexmit = std::max(m_sack_rexmit, m_slist.front().seq + 1);
+        }
+        if (m_rto_recovery) {
+          // The window restarted from one segment, so open it up again.
+          if (m_cwnd < m_ssthresh) {
+            m_cwnd += m_mss;
+          } else {
+            m_cwnd += std::max<uint32_t>(1, m_mss * m_mss / m_cwnd);
+          }
+        } else {
+          m_cwnd += m_mss - std::min(nAcked, m_cwnd);
         }
-        m_cwnd += m_mss - std::min(nAcked, m_cwnd);
       }
     } else {
       m_dup_acks = 0;
@@ -785,13 +873,16 @@ bool PseudoTcp::process(Segment& seg) {
   } else if (seg.ack == m_snd_una) {
     // !?! Note, tcp says don't do this... but otherwise how does a closed
     // window become open?
-    m_snd_wnd = static_cast<uint32_t>(seg.wnd) << m_swnd_scale;
+    updateSendWindow(seg.wnd);
 
     // Check duplicate acks
     if (seg.len > 0) {
       // it's a dup ack, but with a data payload, so don't modify m_dup_acks
     } else if (m_snd_una != m_snd_nxt) {
-      m_dup_acks += 1;
+      // A large window can see more duplicate acks than fit in |m_dup_acks|.
+      if (m_dup_acks < UINT8_MAX) {
+        m_dup_acks += 1;
+      }
       if (m_dup_acks == 3) {  // (Fast Retransmit)
 #if _DEBUGMSG >= _DBG_NORMAL
         RTC_LOG(LS_INFO) << "enter recovery";
@@ -802,13 +893,31 @@ bool PseudoTcp::process(Segment& seg) {
           return false;
         }
         m_recover = m_snd_nxt;
+        m_sack_rexmit = m_slist.front().seq + 1;
+        m_rto_recovery = false;
+        m_had_loss = true;
+        if (m_sack_enabled) {
+          // Give the retransmission a full timeout to be acknowledged.
+          m_rto_base = now;
+        }
         uint32_t nInFlight = m_snd_nxt - m_snd_una;
         m_ssthresh = std::max(nInFlight / 2, 2 * m_mss);
         // RTC_LOG(LS_INFO) << "m_ssthresh: " << m_ssthresh << "  nInFlight: "
         // << nInFlight << "  m_mss: " << m_mss;
         m_cwnd = m_ssthresh + 3 * m_mss;
       } else if (m_dup_acks > 3) {
-        m_cwnd += m_mss;
+        // Every further duplicate ack means that a segment has left the
+        // network. Use that to fill the next hole the peer has reported, or
+        // else to send new data.
+        bool error = false;
+        bool retransmitted = m_sack_enabled && retransmitSackHole(now, &error);
+        if (error) {
+          closedown(ECONNABORTED);
+          return false;
+        }
+        if (!retransmitted) {
+          m_cwnd += m_mss;
+        }
       }
     } else {
       m_dup_acks = 0;
@@ -954,6 +1063,7 @@ bool PseudoTcp::process(Segment& seg) {
           ++it;
         }
         m_rlist.insert(it, rseg);
+        m_rlist_last_seq = rseg.seq;
       }
     }
     if (bRecover) {
@@ -990,7 +1100,7 @@ bool PseudoTcp::process(Segment& seg) {
   return true;
 }
 
-bool PseudoTcp::transmit(const SList::iterator& seg, uint32_t now) {
+bool PseudoTcp::transmit(SList::iterator seg, uint32_t now) {
   if (seg->xmit >= ((m_state == TCP_ESTABLISHED) ? 15 : 30)) {
     RTC_LOG_F(LS_VERBOSE) << "too many retransmits";
     return false;
@@ -1042,8 +1152,10 @@ bool PseudoTcp::transmit(const SList::iterator& seg, uint32_t now) {
     subseg.xmit = seg->xmit;
     seg->len = nTransmit;
 
-    SList::iterator next = seg;
-    m_slist.insert(++next, subseg);
+    // Inserting into |m_slist| invalidates |seg|, so find it again after.
+    SList::difference_type index = seg - m_slist.begin();
+    m_slist.insert(seg + 1, subseg);
+    seg = m_slist.begin() + index;
   }
 
   if (seg->xmit == 0) {
@@ -1128,19 +1240,20 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
       return;
     }
 
-    // Find the next segment to transmit
-    SList::iterator it = m_slist.begin();
-    while (it->xmit > 0) {
-      ++it;
-      RTC_DCHECK(it != m_slist.end());
-    }
-    SList::iterator seg = it;
+    // Find the next segment to transmit. Segments are transmitted in order,
+    // so the ones that have been transmitted come first.
+    SList::iterator seg =
+        std::partition_point(m_slist.begin(), m_slist.end(),
+                             [](const SSegment& s) { return s.xmit > 0; });
+    RTC_DCHECK(seg != m_slist.end());
 
     // If the segment is too large, break it into two
     if (seg->len > nAvailable) {
       SSegment subseg(seg->seq + nAvailable, seg->len - nAvailable, seg->bCtrl);
       seg->len = nAvailable;
-      m_slist.insert(++it, subseg);
+      SList::difference_type index = seg - m_slist.begin();
+      m_slist.insert(seg + 1, subseg);
+      seg = m_slist.begin() + index;
     }
 
     if (!transmit(seg, now)) {
@@ -1189,6 +1302,18 @@ void PseudoTcp::disableWindowScale() {
   m_support_wnd_scale = false;
 }
 
+void PseudoTcp::disableSack() {
+  m_support_sack = false;
+}
+
+bool PseudoTcp::isSackEnabled() const {
+  return m_sack_enabled;
+}
+
+uint32_t PseudoTcp::sackHigh() const {
+  return m_sack_high;
+}
+
 void PseudoTcp::queueConnectMessage() {
   rtc::ByteBufferWriter buf(rtc::ByteBuffer::ORDER_NETWORK);
 
@@ -1198,6 +1323,10 @@ void PseudoTcp::queueConnectMessage() {
     buf.WriteUInt8(1);
     buf.WriteUInt8(m_rwnd_scale);
   }
+  if (m_support_sack) {
+    buf.WriteUInt8(TCP_OPT_SACK_PERMITTED);
+    buf.WriteUInt8(0);
+  }
   m_snd_wnd = static_cast<uint32_t>(buf.Length());
   queue(buf.Data(), static_cast<uint32_t>(buf.Length()), true);
 }
@@ -1246,6 +1375,11 @@ void PseudoTcp::parseOptions(const char* data, uint32_t len) {
       m_swnd_scale = 0;
     }
   }
+
+  // Selective acknowledgements are used only if both sides support them.
+  m_sack_enabled =
+      m_support_sack && options_specified.find(TCP_OPT_SACK_PERMITTED) !=
+                            options_specified.end();
 }
 
 void PseudoTcp::applyOption(char kind, const char* data, uint32_t len) {
@@ -1267,6 +1401,96 @@ void PseudoTcp::applyWindowScaleOption(uint8_t scale_factor) {
   m_swnd_scale = scale_factor;
 }
 
+void PseudoTcp::updateSendWindow(uint16_t wnd) {
+  m_snd_wnd = static_cast<uint32_t>(wnd) << m_swnd_scale;
+  // Until the first loss, slow start may grow the congestion window up to
+  // what the peer can receive, rather than stopping at the size of our own
+  // receive buffer.
+  if (!m_had_loss) {
+    m_ssthresh = std::max(m_ssthresh, m_snd_wnd);
+  }
+}
+
+uint32_t PseudoTcp::writeSackBlocks(uint8_t* buffer) const {
+  // Out-of-order segments that overlap or touch are reported as one block.
+  // Slot 0 is for the block with the most recently received segment, which
+  // goes first as RFC 2018 asks. The others follow in order.
+  uint32_t starts[MAX_SACK_BLOCKS];
+  uint32_t ends[MAX_SACK_BLOCKS];
+  uint32_t count = 1;
+  bool found_last = false;
+  for (RList::const_iterator it = m_rlist.begin(); it != m_rlist.end();) {
+    uint32_t start = it->seq;
+    uint32_t end = it->seq + it->len;
+    for (++it; (it != m_rlist.end()) && (it->seq <= end); ++it) {
+      end = std::max(end, it->seq + it->len);
+    }
+    if (!found_last && (start <= m_rlist_last_seq) &&
+        (m_rlist_last_seq < end)) {
+      starts[0] = start;
+      ends[0] = end;
+      found_last = true;
+    } else if (count < MAX_SACK_BLOCKS) {
+      starts[count] = start;
+      ends[count] = end;
+      ++count;
+    }
+  }
+
+  uint32_t first = found_last ? 0 : 1;
+  buffer[0] = static_cast<uint8_t>(count - first);
+  uint8_t* block = buffer + 1;
+  for (uint32_t i = first; i < count; ++i) {
+    rtc::SetBE32(block, starts[i]);
+    rtc::SetBE32(block + 4, ends[i]);
+    block += SACK_BLOCK_SIZE;
+  }
+  return static_cast<uint32_t>(block - buffer);
+}
+
+void PseudoTcp::applySackBlocks(const Segment& seg) {
+  for (uint32_t i = 0; i < seg.sack_block_count; ++i) {
+    const char* block = seg.sack_blocks + i * SACK_BLOCK_SIZE;
+    uint32_t start = rtc::GetBE32(block);
+    uint32_t end = rtc::GetBE32(block + 4);
+    if ((start >= end) || (start < m_snd_una) || (end > m_snd_nxt)) {
+      continue;
+    }
+    m_sack_high = std::max(m_sack_high, end);
+    SList::iterator it = std::lower_bound(
+        m_slist.begin(), m_slist.end(), start,
+        [](const SSegment& s, uint32_t seq) { return s.seq < seq; });
+    for (; (it != m_slist.end()) && (it->seq + it->len <= end); ++it) {
+      if (it->xmit > 0) {
+        it->bSacked = true;
+      }
+    }
+  }
+}
+
+bool PseudoTcp::retransmitSackHole(uint32_t now, bool* error) {
+  *error = false;
+  SList::iterator it = std::lower_bound(
+      m_slist.begin(), m_slist.end(), m_sack_rexmit,
+      [](const SSegment& s, uint32_t seq) { return s.seq < seq; });
+  for (; (it != m_slist.end()) && (it->seq < m_sack_high) && (it->xmit > 0);
+       ++it) {
+    if (it->bSacked) {
+      continue;
+    }
+#if _DEBUGMSG >= _DBG_NORMAL
+    RTC_LOG(LS_INFO) << "sack retransmit " << it->seq;
+#endif  // _DEBUGMSG
+    m_sack_rexmit = it->seq + 1;
+    if (!transmit(it, now)) {
+      *error = true;
+      return false;
+    }
+    return true;
+  }
+  return false;
+}
+
 void PseudoTcp::resizeSendBuffer(uint32_t new_size) {
   m_sbuf_len = new_size;
   m_sbuf.SetCapacity(new_size);
@@ -14,7 +14,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <list>
+#include <deque>
 
 #include "rtc_base/memory/fifo_buffer.h"
 #include "rtc_base/system/rtc_export.h"
@@ -125,17 +125,25 @@ class RTC_EXPORT PseudoTcp {
     const char* data;
     uint32_t len;
     uint32_t tsval, tsecr;
+    // Selective acknowledgement blocks, as pairs of 32-bit sequence numbers
+    // in network order.
+    const char* sack_blocks;
+    uint32_t sack_block_count;
   };
 
   struct SSegment {
     SSegment(uint32_t s, uint32_t l, bool c)
-        : seq(s), len(l), /*tstamp(0),*/ xmit(0), bCtrl(c) {}
+        : seq(s), len(l), /*tstamp(0),*/ xmit(0), bCtrl(c), bSacked(false) {}
     uint32_t seq, len;
     // uint32_t tstamp;
     uint8_t xmit;
     bool bCtrl;
+    // Whether the peer has selectively acknowledged this segment.
+    bool bSacked;
   };
-  typedef std::list<SSegment> SList;
+  // Segments are added at the back and acknowledged from the front, so a
+  // deque keeps them in a few blocks instead of allocating each one.
+  typedef std::deque<SSegment> SList;
 
   struct RSegment {
     uint32_t seq, len;
@@ -164,7 +172,7 @@ class RTC_EXPORT PseudoTcp {
   bool clock_check(uint32_t now, long& nTimeout);
 
   bool process(Segment& seg);
-  bool transmit(const SList::iterator& seg, uint32_t now);
+  bool transmit(SList::iterator seg, uint32_t now);
 
   void adjustMTU();
 
@@ -176,6 +184,16 @@ class RTC_EXPORT PseudoTcp {
   // support for testing backward compatibility.
   void disableWindowScale();
 
+  // This method is only used in tests, to disable selective acknowledgement
+  // support for testing backward compatibility.
+  void disableSack();
+
+  // These methods are only used in tests, to query whether selective
+  // acknowledgement was negotiated and the highest sequence number the peer
+  // has selectively acknowledged.
+  bool isSackEnabled() const;
+  uint32_t sackHigh() const;
+
  private:
   // Queue the connect message with TCP options.
   void queueConnectMessage();
@@ -189,6 +207,23 @@ class RTC_EXPORT PseudoTcp {
   // Apply window scale option.
   void applyWindowScaleOption(uint8_t scale_factor);
 
+  // Update the send window from the window field of a received segment.
+  void updateSendWindow(uint16_t wnd);
+
+  // Write the blocks of out-of-order data in |m_rlist| to |buffer|, which
+  // must have room for MAX_SACK_BLOCKS blocks. Returns the number of bytes
+  // written.
+  uint32_t writeSackBlocks(uint8_t* buffer) const;
+
+  // Mark the segments covered by the blocks of |seg| as selectively
+  // acknowledged.
+  void applySackBlocks(const Segment& seg);
+
+  // During recovery, retransmit the first segment that the peer is known to
+  // be missing and that has not been retransmitted yet. Returns false if
+  // there is no such segment. Sets |error| if the transmission failed.
+  bool retransmitSackHole(uint32_t now, bool* error);
+
   // Resize the send buffer with |new_size| in bytes.
   void resizeSendBuffer(uint32_t new_size);
 
@@ -207,8 +242,10 @@ class RTC_EXPORT PseudoTcp {
   uint32_t m_lasttraffic;
 
   // Incoming data
-  typedef std::list<RSegment> RList;
+  typedef std::deque<RSegment> RList;
   RList m_rlist;
+  // The sequence number of the last segment added to |m_rlist|.
+  uint32_t m_rlist_last_seq;
   uint32_t m_rbuf_len, m_rcv_nxt, m_rcv_wnd, m_lastrecv;
   uint8_t m_rwnd_scale;  // Window scale factor.
   rtc::FifoBuffer m_rbuf;
@@ -235,6 +272,20 @@ class RTC_EXPORT PseudoTcp {
   uint8_t m_dup_acks;
   uint32_t m_recover;
   uint32_t m_t_ack;
+  // Whether the current recovery was entered by a retransmit timeout rather
+  // than by duplicate acks. The congestion window then starts from one
+  // segment and grows by slow start instead of being deflated.
+  bool m_rto_recovery;
+  // Whether a loss has been detected. Until then, slow start may grow the
+  // congestion window up to the window offered by the peer.
+  bool m_had_loss;
+
+  // Selective acknowledgement (RFC 2018). |m_sack_high| is the highest
+  // sequence number selectively acknowledged by the peer, and
+  // |m_sack_rexmit| is where the search for the next segment to retransmit
+  // during recovery continues.
+  bool m_sack_enabled;
+  uint32_t m_sack_high, m_sack_rexmit;
 
   // Configuration options
   bool m_use_nagling;
@@ -243,6 +294,10 @@ class RTC_EXPORT PseudoTcp {
   // This is used by unit tests to test backward compatibility of
   // PseudoTcp implementations that don't support window scaling.
   bool m_support_wnd_scale;
+
+  // This is used by unit tests to test backward compatibility of
+  // PseudoTcp implementations that don't support selective acknowledgement.
+  bool m_support_sack;
 };
 
 }  // namespace cricket
@@ -14,9 +14,16 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "api/units/time_delta.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_order.h"
+#include "rtc_base/fake_clock.h"
 #include "rtc_base/gunit.h"
 #include "rtc_base/helpers.h"
 #include "rtc_base/location.h"
@@ -24,8 +31,10 @@
 #include "rtc_base/memory_stream.h"
 #include "rtc_base/message_handler.h"
 #include "rtc_base/message_queue.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
 #include "rtc_base/thread.h"
 #include "rtc_base/time_utils.h"
+#include "rtc_base/virtual_socket_server.h"
 #include "test/gtest.h"
 
 using cricket::PseudoTcp;
@@ -42,6 +51,12 @@ class PseudoTcpForTest : public cricket::PseudoTcp {
   bool isReceiveBufferFull() const { return PseudoTcp::isReceiveBufferFull(); }
 
   void disableWindowScale() { PseudoTcp::disableWindowScale(); }
+
+  void disableSack() { PseudoTcp::disableSack(); }
+
+  bool isSackEnabled() const { return PseudoTcp::isSackEnabled(); }
+
+  uint32_t sackHigh() const { return PseudoTcp::sackHigh(); }
 };
 
 class PseudoTcpTestBase : public ::testing::Test,
@@ -102,6 +117,8 @@ class PseudoTcpTestBase : public ::testing::Test,
   }
   void DisableRemoteWindowScale() { remote_.disableWindowScale(); }
   void DisableLocalWindowScale() { local_.disableWindowScale(); }
+  void DisableRemoteSack() { remote_.disableSack(); }
+  void DisableLocalSack() { local_.disableSack(); }
 
  protected:
   int Connect() {
@@ -702,6 +719,36 @@ TEST_F(PseudoTcpTest, TestSendWithDelayAndOptAckDelayOff) {
   TestTransfer(100000);  // less data so test runs faster
 }
 
+// Test sending data with 10% packet loss to a receiver that doesn't support
+// selective acknowledgement.
+TEST_F(PseudoTcpTest, TestSendWithLossRemoteNoSack) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  DisableRemoteSack();
+  TestTransfer(100000);
+}
+
+// Test sending data with 10% packet loss from a sender that doesn't support
+// selective acknowledgement.
+TEST_F(PseudoTcpTest, TestSendWithLossLocalNoSack) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  DisableLocalSack();
+  TestTransfer(100000);
+}
+
+// Test recovering from several losses within a large window.
+TEST_F(PseudoTcpTest, TestSendWithLossAndLargeWindow) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetRemoteOptRcvBuf(1000000);
+  SetLocalOptRcvBuf(1000000);
+  SetLoss(5);
+  TestTransfer(1000000);
+}
+
 // Test a large receive buffer with a sender that doesn't support scaling.
 TEST_F(PseudoTcpTest, TestSendRemoteNoWindowScale) {
   SetLocalMtu(1500);
@@ -880,3 +927,337 @@ TEST_F(PseudoTcpTest, TestSendWithMismatchedMtus) {
   TestTransfer(1000000);
 }
 */
+
+// Transfers data between two PseudoTcp endpoints whose packets go through UDP
+// sockets of a VirtualSocketServer, in simulated time.
+class PseudoTcpVirtualNetworkTest : public ::testing::Test {
+ protected:
+  class Endpoint : public cricket::IPseudoTcpNotify,
+                   public rtc::MessageHandler,
+                   public sigslot::has_slots<> {
+   public:
+    Endpoint(rtc::SocketFactory* factory, const rtc::SocketAddress& address)
+        : tcp_(this, 1),
+          socket_(rtc::AsyncUDPSocket::Create(factory, address)) {
+      socket_->SignalReadPacket.connect(this, &Endpoint::OnReadPacket);
+      tcp_.NotifyMTU(1500);
+    }
+    ~Endpoint() override { rtc::Thread::Current()->Clear(this); }
+
+    PseudoTcpForTest* tcp() { return &tcp_; }
+    rtc::SocketAddress address() const { return socket_->GetLocalAddress(); }
+    void set_remote_address(const rtc::SocketAddress& address) {
+      remote_address_ = address;
+    }
+    void set_bytes_to_send(size_t bytes) { bytes_to_send_ = bytes; }
+    size_t bytes_received() const { return bytes_received_; }
+
+    void UpdateClock() {
+      long interval = 0;  // NOLINT
+      tcp_.GetNextClock(PseudoTcp::Now(), interval);
+      interval = std::max<int>(interval, 0L);
+      rtc::Thread::Current()->Clear(this);
+      rtc::Thread::Current()->PostDelayed(RTC_FROM_HERE, interval, this);
+    }
+
+   private:
+    void OnTcpOpen(PseudoTcp* tcp) override { OnTcpWriteable(tcp); }
+    void OnTcpReadable(PseudoTcp* tcp) override {
+      char block[kBlockSize];
+      int read;
+      while ((read = tcp_.Recv(block, sizeof(block))) > 0)
+        bytes_received_ += read;
+    }
+    void OnTcpWriteable(PseudoTcp* tcp) override {
+      char block[kBlockSize] = {0};
+      while (bytes_to_send_ > 0) {
+        int sent = tcp_.Send(block, std::min(sizeof(block), bytes_to_send_));
+        if (sent <= 0)
+          break;
+        bytes_to_send_ -= sent;
+      }
+    }
+    void OnTcpClosed(PseudoTcp* tcp, uint32_t error) override {}
+    WriteResult TcpWritePacket(PseudoTcp* tcp,
+                               const char* buffer,
+                               size_t len) override {
+      if (socket_->SendTo(buffer, len, remote_address_, rtc::PacketOptions()) <
+          0) {
+        return WR_FAIL;
+      }
+      return WR_SUCCESS;
+    }
+    void OnMessage(rtc::Message* message) override {
+      tcp_.NotifyClock(PseudoTcp::Now());
+      UpdateClock();
+    }
+    void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                      const char* data,
+                      size_t size,
+                      const rtc::SocketAddress& remote_address,
+                      const int64_t& packet_time_us) {
+      tcp_.NotifyPacket(data, size);
+      UpdateClock();
+    }
+
+    PseudoTcpForTest tcp_;
+    std::unique_ptr<rtc::AsyncPacketSocket> socket_;
+    rtc::SocketAddress remote_address_;
+    size_t bytes_to_send_ = 0;
+    size_t bytes_received_ = 0;
+  };
+
+  // Returns how long it takes, in simulated milliseconds, to transfer |size|
+  // bytes over a path with the given one-way delay and random loss, or -1 if
+  // the transfer does not finish within |timeout_ms|.
+  int64_t TransferTime(int delay_ms,
+                       int loss_percent,
+                       bool use_sack,
+                       size_t size,
+                       int timeout_ms) {
+    rtc::VirtualSocketServer vss(&clock_);
+    rtc::AutoSocketServerThread thread(&vss);
+    vss.set_delay_mean(delay_ms);
+    vss.UpdateDelayDistribution();
+    vss.set_drop_probability(loss_percent / 100.0);
+    // Let the receive window, rather than the virtual network, limit the
+    // amount of data in flight.
+    vss.set_network_capacity(16 * 1024 * 1024);
+
+    Endpoint sender(&vss, rtc::SocketAddress("1.1.1.1", 0));
+    Endpoint receiver(&vss, rtc::SocketAddress("2.2.2.2", 0));
+    sender.set_remote_address(receiver.address());
+    receiver.set_remote_address(sender.address());
+    sender.tcp()->SetOption(PseudoTcp::OPT_SNDBUF, 2 * kWindowSize);
+    receiver.tcp()->SetOption(PseudoTcp::OPT_RCVBUF, kWindowSize);
+    if (!use_sack) {
+      sender.tcp()->disableSack();
+      receiver.tcp()->disableSack();
+    }
+
+    int64_t start = rtc::TimeMillis();
+    sender.set_bytes_to_send(size);
+    EXPECT_EQ(0, sender.tcp()->Connect());
+    sender.UpdateClock();
+    receiver.UpdateClock();
+    SIMULATED_WAIT(receiver.bytes_received() == size, timeout_ms, clock_);
+    if (receiver.bytes_received() != size)
+      return -1;
+    return rtc::TimeMillis() - start;
+  }
+
+  static const uint32_t kWindowSize = 1024 * 1024;
+  rtc::ScopedFakeClock clock_;
+};
+
+// Reports the throughput of a bulk transfer for a sweep of delays and loss
+// rates, with and without selective acknowledgements. Losses are random, so
+// each case is the average of several transfers.
+TEST_F(PseudoTcpVirtualNetworkTest, DISABLED_ThroughputSweep) {
+  const size_t kSize = 4 * 1024 * 1024;
+  const int kRuns = 5;
+  for (int delay_ms : {10, 50, 100}) {
+    for (int loss_percent : {0, 1, 3}) {
+      for (bool use_sack : {false, true}) {
+        int64_t total_ms = 0;
+        for (int i = 0; i < kRuns; ++i) {
+          int64_t elapsed_ms =
+              TransferTime(delay_ms, loss_percent, use_sack, kSize, 600000);
+          ASSERT_GT(elapsed_ms, 0);
+          total_ms += elapsed_ms;
+        }
+        RTC_LOG(LS_INFO) << "Delay " << delay_ms << " ms, loss "
+                         << loss_percent << "%, SACK "
+                         << (use_sack ? "on" : "off") << ": "
+                         << kRuns * kSize * 8 / total_ms << " kbps";
+      }
+    }
+  }
+}
+
+// Runs two PseudoTcp endpoints against each other in simulated time. Packets
+// are passed between them directly, so that individual segments can be
+// inspected and dropped.
+class PseudoTcpSackTest : public ::testing::Test,
+                          public cricket::IPseudoTcpNotify {
+ protected:
+  // Header layout and flags, as defined in pseudo_tcp.cc.
+  static const size_t kHeaderSize = 24;
+  static const uint8_t kFlagCtl = 0x02;
+  static const uint8_t kFlagSack = 0x08;
+
+  PseudoTcpSackTest() : local_(this, 1), remote_(this, 1) {
+    // Keep the timestamps in the packets non-zero.
+    clock_.AdvanceTime(webrtc::TimeDelta::seconds(1));
+    local_.NotifyMTU(1500);
+    remote_.NotifyMTU(1500);
+    local_.SetOption(PseudoTcp::OPT_ACKDELAY, 0);
+    remote_.SetOption(PseudoTcp::OPT_ACKDELAY, 0);
+  }
+
+  void Connect() {
+    ASSERT_EQ(0, local_.Connect());
+    Deliver();
+    ASSERT_TRUE(have_connected_);
+  }
+
+  // Writes |size| bytes to |local_|.
+  void Send(size_t size) {
+    std::vector<char> data(size);
+    ASSERT_EQ(static_cast<int>(size), local_.Send(data.data(), size));
+    bytes_sent_ += size;
+  }
+
+  // Delivers the queued packets, and advances the clock whenever none are
+  // left, until everything sent has been received and acknowledged.
+  void Deliver() {
+    for (int i = 0; i < 100; ++i) {
+      while (!packets_.empty()) {
+        Packet packet = std::move(packets_.front());
+        packets_.pop_front();
+        packet.to->NotifyPacket(packet.data.data(), packet.data.size());
+        if (packet.to == &local_ && sack_high_ == 0 &&
+            (packet.data[13] & kFlagSack)) {
+          // Remember the first block the receiver reports, and what the
+          // sender made of it.
+          ASSERT_GE(packet.data.size(), kHeaderSize + 9);
+          EXPECT_EQ(1, packet.data[kHeaderSize]);
+          sack_start_ = rtc::GetBE32(&packet.data[kHeaderSize + 1]);
+          sack_end_ = rtc::GetBE32(&packet.data[kHeaderSize + 5]);
+          sack_high_ = local_.sackHigh();
+        }
+      }
+      if (bytes_received_ == bytes_sent_ && local_.GetBytesInFlight() == 0)
+        return;
+      clock_.AdvanceTime(webrtc::TimeDelta::ms(100));
+      local_.NotifyClock(PseudoTcp::Now());
+      remote_.NotifyClock(PseudoTcp::Now());
+    }
+  }
+
+  // Returns the number of data segments that |local_| has sent more than
+  // once.
+  int RetransmittedSegments() const {
+    int count = 0;
+    for (const auto& transmissions : transmissions_) {
+      if (transmissions.second > 1)
+        ++count;
+    }
+    return count;
+  }
+
+  void OnTcpOpen(PseudoTcp* tcp) override {
+    if (tcp == &local_)
+      have_connected_ = true;
+  }
+  void OnTcpReadable(PseudoTcp* tcp) override {
+    char block[kBlockSize];
+    int read;
+    while ((read = tcp->Recv(block, sizeof(block))) > 0)
+      bytes_received_ += read;
+  }
+  void OnTcpWriteable(PseudoTcp* tcp) override {}
+  void OnTcpClosed(PseudoTcp* tcp, uint32_t error) override {}
+  WriteResult TcpWritePacket(PseudoTcp* tcp,
+                             const char* buffer,
+                             size_t len) override {
+    if (tcp == &local_ && len > kHeaderSize && !(buffer[13] & kFlagCtl)) {
+      uint32_t seq = rtc::GetBE32(buffer + 4);
+      ++transmissions_[seq];
+      if (drop_all_data_ || ++data_segments_ == drop_segment_) {
+        dropped_seq_ = seq;
+        return WR_SUCCESS;
+      }
+    }
+    packets_.push_back(
+        {tcp == &local_ ? &remote_ : &local_, std::string(buffer, len)});
+    return WR_SUCCESS;
+  }
+
+  struct Packet {
+    PseudoTcpForTest* to;
+    std::string data;
+  };
+
+  rtc::ScopedFakeClock clock_;
+  PseudoTcpForTest local_;
+  PseudoTcpForTest remote_;
+  std::deque<Packet> packets_;
+  bool have_connected_ = false;
+  size_t bytes_sent_ = 0;
+  size_t bytes_received_ = 0;
+  // The first transmission of the |drop_segment_|th data segment is lost,
+  // as is every data segment while |drop_all_data_| is set.
+  int drop_segment_ = 0;
+  bool drop_all_data_ = false;
+  int data_segments_ = 0;
+  uint32_t dropped_seq_ = 0;
+  // Number of transmissions of each data segment, by sequence number.
+  std::map<uint32_t, int> transmissions_;
+  uint32_t sack_start_ = 0;
+  uint32_t sack_end_ = 0;
+  uint32_t sack_high_ = 0;
+};
+
+// Test that a single lost segment is reported with a SACK block, and that it
+// is the only segment retransmitted.
+TEST_F(PseudoTcpSackTest, TestSingleLossRetransmittedOnce) {
+  Connect();
+  EXPECT_TRUE(local_.isSackEnabled());
+  EXPECT_TRUE(remote_.isSackEnabled());
+
+  drop_segment_ = 3;
+  Send(20000);
+  Deliver();
+  EXPECT_EQ(bytes_sent_, bytes_received_);
+
+  // The segments after the lost one are selectively acknowledged, and the
+  // sender takes the block over from the ack.
+  ASSERT_NE(0u, sack_high_);
+  EXPECT_LT(dropped_seq_, sack_start_);
+  EXPECT_LT(sack_start_, sack_end_);
+  EXPECT_EQ(sack_end_, sack_high_);
+
+  EXPECT_EQ(2, transmissions_[dropped_seq_]);
+  EXPECT_EQ(1, RetransmittedSegments());
+}
+
+// Test that without SACK support on one side, none is negotiated.
+TEST_F(PseudoTcpSackTest, TestSackNotNegotiated) {
+  remote_.disableSack();
+  Connect();
+  EXPECT_FALSE(local_.isSackEnabled());
+  EXPECT_FALSE(remote_.isSackEnabled());
+
+  drop_segment_ = 3;
+  Send(20000);
+  Deliver();
+  EXPECT_EQ(bytes_sent_, bytes_received_);
+  EXPECT_EQ(0u, sack_high_);
+}
+
+// Test that the congestion window grows again by slow start while the
+// segments lost before a retransmit timeout are being recovered.
+TEST_F(PseudoTcpSackTest, TestCongestionWindowGrowsAfterTimeout) {
+  Connect();
+  // Open up the congestion window first.
+  Send(20000);
+  Deliver();
+
+  // Lose a whole window of data.
+  drop_all_data_ = true;
+  Send(20000);
+  ASSERT_TRUE(packets_.empty());
+  drop_all_data_ = false;
+
+  for (int i = 0; i < 100 && packets_.empty(); ++i) {
+    clock_.AdvanceTime(webrtc::TimeDelta::ms(100));
+    local_.NotifyClock(PseudoTcp::Now());
+  }
+  ASSERT_EQ(1u, packets_.size());
+  uint32_t cwnd_after_timeout = local_.GetCongestionWindow();
+
+  Deliver();
+  EXPECT_EQ(bytes_sent_, bytes_received_);
+  EXPECT_GE(local_.GetCongestionWindow(), 4 * cwnd_after_timeout);
+}
@@ -182,6 +182,13 @@ const StunUInt16ListAttribute* StunMessage::GetUnknownAttributes() const {
 bool StunMessage::ValidateMessageIntegrity(const char* data,
                                            size_t size,
                                            const std::string& password) {
+  rtc::Hmac hmac(rtc::DIGEST_SHA_1, password.c_str(), password.size());
+  return ValidateMessageIntegrity(data, size, &hmac);
+}
+
+bool StunMessage::ValidateMessageIntegrity(const char* data,
+                                           size_t size,
+                                           rtc::Hmac* hmac) {
   // Verifying the size of the message.
   if ((size % 4) != 0 || size < kStunHeaderSize) {
     return false;
@@ -226,35 +233,33 @@ bool StunMessage::ValidateMessageIntegrity(const char* data,
 
   // Getting length of the message to calculate Message Integrity.
   size_t mi_pos = current_pos;
-  std::unique_ptr<char[]> temp_data(new char[current_pos]);
-  memcpy(temp_data.get(), data, current_pos);
-  if (size > mi_pos + kStunAttributeHeaderSize + kStunMessageIntegritySize) {
-    // Stun message has other attributes after message integrity.
-    // Adjust the length parameter in stun message to calculate HMAC.
-    size_t extra_offset =
-        size - (mi_pos + kStunAttributeHeaderSize + kStunMessageIntegritySize);
-    size_t new_adjusted_len = size - extra_offset - kStunHeaderSize;
-
-    // Writing new length of the STUN message @ Message Length in temp buffer.
-    //      0                   1                   2                   3
-    //      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-    //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //     |0 0|     STUN Message Type     |         Message Length        |
-    //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    rtc::SetBE16(temp_data.get() + 2, static_cast<uint16_t>(new_adjusted_len));
-  }
-
-  char hmac[kStunMessageIntegritySize];
-  size_t ret =
-      rtc::ComputeHmac(rtc::DIGEST_SHA_1, password.c_str(), password.size(),
-                       temp_data.get(), mi_pos, hmac, sizeof(hmac));
-  RTC_DCHECK(ret == sizeof(hmac));
-  if (ret != sizeof(hmac))
+  // The HMAC covers the message up to the MESSAGE-INTEGRITY attribute, with a
+  // message length that ends the message after the attribute. It differs
+  // from the length in the header if there are attributes after it, so the
+  // header is hashed with the adjusted length rather than copied and
+  // patched.
+  //      0                   1                   2                   3
+  //      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  //     |0 0|     STUN Message Type     |         Message Length        |
+  //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  size_t adjusted_len = mi_pos + kStunAttributeHeaderSize +
+                        kStunMessageIntegritySize - kStunHeaderSize;
+  char length_field[2];
+  rtc::SetBE16(length_field, static_cast<uint16_t>(adjusted_len));
+  hmac->Update(data, 2);
+  hmac->Update(length_field, sizeof(length_field));
+  hmac->Update(data + 4, mi_pos - 4);
+
+  char computed[kStunMessageIntegritySize];
+  size_t ret = hmac->Finish(computed, sizeof(computed));
+  RTC_DCHECK(ret == sizeof(computed));
+  if (ret != sizeof(computed))
     return false;
 
   // Comparing the calculated HMAC with the one present in the message.
-  return memcmp(data + current_pos + kStunAttributeHeaderSize, hmac,
-                sizeof(hmac)) == 0;
+  return memcmp(data + current_pos + kStunAttributeHeaderSize, computed,
+                sizeof(computed)) == 0;
 }
 
 bool StunMessage::AddMessageIntegrity(const std::string& password) {
@@ -262,6 +267,11 @@ bool StunMessage::AddMessageIntegrity(const std::string& password) {
 }
 
 bool StunMessage::AddMessageIntegrity(const char* key, size_t keylen) {
+  rtc::Hmac hmac(rtc::DIGEST_SHA_1, key, keylen);
+  return AddMessageIntegrity(&hmac);
+}
+
+bool StunMessage::AddMessageIntegrity(rtc::Hmac* hmac) {
   // Add the attribute with a dummy value. Since this is a known attribute, it
   // can't fail.
   auto msg_integrity_attr_ptr = std::make_unique<StunByteStringAttribute>(
@@ -276,18 +286,18 @@ bool StunMessage::AddMessageIntegrity(const char* key, size_t keylen) {
 
   int msg_len_for_hmac = static_cast<int>(
       buf.Length() - kStunAttributeHeaderSize - msg_integrity_attr->length());
-  char hmac[kStunMessageIntegritySize];
-  size_t ret = rtc::ComputeHmac(rtc::DIGEST_SHA_1, key, keylen, buf.Data(),
-                                msg_len_for_hmac, hmac, sizeof(hmac));
-  RTC_DCHECK(ret == sizeof(hmac));
-  if (ret != sizeof(hmac)) {
+  char computed[kStunMessageIntegritySize];
+  size_t ret = hmac->Compute(buf.Data(), msg_len_for_hmac, computed,
+                             sizeof(computed));
+  RTC_DCHECK(ret == sizeof(computed));
+  if (ret != sizeof(computed)) {
     RTC_LOG(LS_ERROR) << "HMAC computation failed. Message-Integrity "
                          "has dummy value.";
     return false;
   }
 
   // Insert correct HMAC into the attribute.
-  msg_integrity_attr->CopyBytes(hmac, sizeof(hmac));
+  msg_integrity_attr->CopyBytes(computed, sizeof(computed));
   return true;
 }
 
@@ -343,6 +353,19 @@ bool StunMessage::AddFingerprint() {
   return true;
 }
 
+StunHmacCache::StunHmacCache() = default;
+
+StunHmacCache::~StunHmacCache() = default;
+
+rtc::Hmac* StunHmacCache::Get(const std::string& password) {
+  if (!hmac_ || password != password_) {
+    password_ = password;
+    hmac_ = std::make_unique<rtc::Hmac>(rtc::DIGEST_SHA_1, password.data(),
+                                        password.size());
+  }
+  return hmac_.get();
+}
+
 bool StunMessage::Read(ByteBufferReader* buf) {
   if (!buf->ReadUInt16(&type_))
     return false;
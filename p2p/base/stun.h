@@ -23,6 +23,7 @@
 
 #include "rtc_base/byte_buffer.h"
 #include "rtc_base/ip_address.h"
+#include "rtc_base/message_digest.h"
 #include "rtc_base/socket_address.h"
 
 namespace cricket {
@@ -179,9 +180,15 @@ class StunMessage {
   static bool ValidateMessageIntegrity(const char* data,
                                        size_t size,
                                        const std::string& password);
+  // Like the previous function, but uses |hmac|, an HMAC-SHA1 keyed with the
+  // password.
+  static bool ValidateMessageIntegrity(const char* data,
+                                       size_t size,
+                                       rtc::Hmac* hmac);
   // Adds a MESSAGE-INTEGRITY attribute that is valid for the current message.
   bool AddMessageIntegrity(const std::string& password);
   bool AddMessageIntegrity(const char* key, size_t keylen);
+  bool AddMessageIntegrity(rtc::Hmac* hmac);
 
   // Verifies that a given buffer is STUN by checking for a correct FINGERPRINT.
   static bool ValidateFingerprint(const char* data, size_t size);
@@ -221,6 +228,23 @@ class StunMessage {
   uint32_t stun_magic_cookie_;
 };
 
+// Keeps the HMAC-SHA1 used for MESSAGE-INTEGRITY with one password, so that
+// the HMAC key is not set up again for every message sent or validated with
+// the same password.
+class StunHmacCache {
+ public:
+  StunHmacCache();
+  ~StunHmacCache();
+
+  // Returns the HMAC keyed with |password|. The HMAC is only recreated if
+  // |password| differs from the one of the previous call.
+  rtc::Hmac* Get(const std::string& password);
+
+ private:
+  std::string password_;
+  std::unique_ptr<rtc::Hmac> hmac_;
+};
+
 // Base class for all STUN/TURN attributes.
 class StunAttribute {
  public:
@@ -115,6 +115,20 @@ void StunRequestManager::Clear() {
   }
 }
 
+size_t StunRequestManager::EstimateMemoryUsage() const {
+  // A node of a std::map holds the value and three pointers, and its color.
+  const size_t kMapNodeBytes =
+      sizeof(RequestMap::value_type) + 4 * sizeof(void*);
+  size_t bytes = 0;
+  for (const auto& kv : requests_) {
+    // The encoded size of the attributes stands in for the attribute objects
+    // of the message.
+    bytes += kMapNodeBytes + sizeof(StunRequest) + sizeof(StunMessage) +
+             kv.second->msg()->length();
+  }
+  return bytes;
+}
+
 bool StunRequestManager::CheckResponse(StunMessage* msg) {
   RequestMap::iterator iter = requests_.find(msg->transaction_id());
   if (iter == requests_.end()) {
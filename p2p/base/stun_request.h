@@ -68,6 +68,10 @@ class StunRequestManager {
 
   bool empty() { return requests_.empty(); }
 
+  // Estimates the number of bytes used by the outstanding requests and their
+  // STUN messages.
+  size_t EstimateMemoryUsage() const;
+
   // Set the Origin header for outgoing stun messages.
   void set_origin(const std::string& origin) { origin_ = origin; }
 
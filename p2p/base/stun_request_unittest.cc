@@ -106,6 +106,19 @@ TEST_F(StunRequestTest, TestSuccess) {
   delete res;
 }
 
+TEST_F(StunRequestTest, TestEstimateMemoryUsage) {
+  EXPECT_EQ(0u, manager_.EstimateMemoryUsage());
+  StunMessage* req = CreateStunMessage(STUN_BINDING_REQUEST, NULL);
+  manager_.Send(new StunRequestThunker(req, this));
+  EXPECT_GE(manager_.EstimateMemoryUsage(),
+            sizeof(StunRequest) + sizeof(StunMessage));
+
+  StunMessage* res = CreateStunMessage(STUN_BINDING_RESPONSE, req);
+  EXPECT_TRUE(manager_.CheckResponse(res));
+  EXPECT_EQ(0u, manager_.EstimateMemoryUsage());
+  delete res;
+}
+
 // Test handling of an error binding response.
 TEST_F(StunRequestTest, TestError) {
   StunMessage* req = CreateStunMessage(STUN_BINDING_REQUEST, NULL);
@@ -12,6 +12,7 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -19,7 +20,9 @@
 #include "rtc_base/arraysize.h"
 #include "rtc_base/byte_buffer.h"
 #include "rtc_base/byte_order.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/socket_address.h"
+#include "rtc_base/time_utils.h"
 #include "test/gtest.h"
 
 namespace cricket {
@@ -1271,6 +1274,89 @@ TEST_F(StunTest, AddMessageIntegrity) {
       kRfc5769SampleMsgPassword));
 }
 
+TEST_F(StunTest, MessageIntegrityWithCachedHmac) {
+  StunHmacCache cache;
+  rtc::Hmac* hmac = cache.Get(kRfc5769SampleMsgPassword);
+  EXPECT_EQ(hmac, cache.Get(kRfc5769SampleMsgPassword));
+
+  char buf[sizeof(kRfc5769SampleRequest)];
+  memcpy(buf, kRfc5769SampleRequest, sizeof(kRfc5769SampleRequest));
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(StunMessage::ValidateMessageIntegrity(buf, sizeof(buf), hmac));
+    EXPECT_TRUE(StunMessage::ValidateMessageIntegrity(
+        reinterpret_cast<const char*>(kRfc5769SampleResponse),
+        sizeof(kRfc5769SampleResponse), hmac));
+    // A failed validation does not affect the next one.
+    buf[kStunHeaderSize] ^= 0x01;
+    EXPECT_FALSE(StunMessage::ValidateMessageIntegrity(buf, sizeof(buf), hmac));
+    buf[kStunHeaderSize] ^= 0x01;
+  }
+  EXPECT_FALSE(StunMessage::ValidateMessageIntegrity(
+      buf, sizeof(buf), cache.Get("InvalidPassword")));
+  EXPECT_TRUE(StunMessage::ValidateMessageIntegrity(
+      buf, sizeof(buf), cache.Get(kRfc5769SampleMsgPassword)));
+
+  for (int i = 0; i < 2; ++i) {
+    IceMessage msg;
+    rtc::ByteBufferReader reader(
+        reinterpret_cast<const char*>(kRfc5769SampleRequestWithoutMI),
+        sizeof(kRfc5769SampleRequestWithoutMI));
+    EXPECT_TRUE(msg.Read(&reader));
+    EXPECT_TRUE(msg.AddMessageIntegrity(cache.Get(kRfc5769SampleMsgPassword)));
+    const StunByteStringAttribute* mi_attr =
+        msg.GetByteString(STUN_ATTR_MESSAGE_INTEGRITY);
+    EXPECT_EQ(20U, mi_attr->length());
+    EXPECT_EQ(0, memcmp(mi_attr->bytes(), kCalculatedHmac1,
+                        sizeof(kCalculatedHmac1)));
+  }
+}
+
+// Measures the cost of the MESSAGE-INTEGRITY and FINGERPRINT computations of
+// an ICE connectivity check, with and without a cached HMAC.
+TEST_F(StunTest, DISABLED_MessageIntegrityAndFingerprintThroughput) {
+  static const int kIterations = 200000;
+  const std::string password = kRfc5769SampleMsgPassword;
+  StunHmacCache cache;
+
+  for (bool cached : {false, true}) {
+    int64_t start_us = rtc::TimeMicros();
+    size_t valid = 0;
+    for (int i = 0; i < kIterations; ++i) {
+      IceMessage msg;
+      msg.SetType(STUN_BINDING_REQUEST);
+      msg.SetTransactionID("0123456789ab");
+      msg.AddAttribute(std::make_unique<StunByteStringAttribute>(
+          STUN_ATTR_USERNAME, "abcd:efgh"));
+      msg.AddAttribute(std::make_unique<StunUInt64Attribute>(
+          STUN_ATTR_ICE_CONTROLLING, i));
+      msg.AddAttribute(
+          std::make_unique<StunUInt32Attribute>(STUN_ATTR_PRIORITY, 1234));
+      if (cached) {
+        msg.AddMessageIntegrity(cache.Get(password));
+      } else {
+        msg.AddMessageIntegrity(password);
+      }
+      msg.AddFingerprint();
+      rtc::ByteBufferWriter buf;
+      msg.Write(&buf);
+
+      if (StunMessage::ValidateFingerprint(buf.Data(), buf.Length()) &&
+          (cached ? StunMessage::ValidateMessageIntegrity(
+                        buf.Data(), buf.Length(), cache.Get(password))
+                  : StunMessage::ValidateMessageIntegrity(
+                        buf.Data(), buf.Length(), password))) {
+        ++valid;
+      }
+    }
+    int64_t elapsed_us = rtc::TimeMicros() - start_us;
+    EXPECT_EQ(static_cast<size_t>(kIterations), valid);
+    RTC_LOG(LS_INFO) << (cached ? "Cached" : "Uncached")
+                     << " HMAC: " << kIterations * rtc::kNumMicrosecsPerSec /
+                                         std::max<int64_t>(elapsed_us, 1)
+                     << " signed and validated checks/s";
+  }
+}
+
 // Check our STUN message validation code against the RFC5769 test messages.
 TEST_F(StunTest, ValidateFingerprint) {
   EXPECT_TRUE(StunMessage::ValidateFingerprint(
@@ -718,7 +718,8 @@ bool TurnPort::HandleIncomingPacket(rtc::AsyncPacketSocket* socket,
   // This must be a response for one of our requests.
   // Check success responses, but not errors, for MESSAGE-INTEGRITY.
   if (IsStunSuccessResponseType(msg_type) &&
-      !StunMessage::ValidateMessageIntegrity(data, size, hash())) {
+      !StunMessage::ValidateMessageIntegrity(data, size,
+                                             hash_hmac_.Get(hash()))) {
     RTC_LOG(LS_WARNING) << ToString()
                         << ": Received TURN message with invalid "
                            "message integrity, msg_type: "
@@ -1122,7 +1123,7 @@ void TurnPort::AddRequestAuthInfo(StunMessage* msg) {
       std::make_unique<StunByteStringAttribute>(STUN_ATTR_REALM, realm_));
   msg->AddAttribute(
       std::make_unique<StunByteStringAttribute>(STUN_ATTR_NONCE, nonce_));
-  const bool success = msg->AddMessageIntegrity(hash());
+  const bool success = msg->AddMessageIntegrity(hash_hmac_.Get(hash()));
   RTC_DCHECK(success);
 }
 
@@ -375,6 +375,8 @@ class TurnPort : public Port {
   std::string realm_;  // From 401/438 response message.
   std::string nonce_;  // From 401/438 response message.
   std::string hash_;   // Digest of username:realm:password
+  // Signs and validates the STUN messages that use |hash_|.
+  StunHmacCache hash_hmac_;
 
   int next_channel_number_;
   EntryList entries_;
@@ -14,10 +14,11 @@
 #include <tuple>  // for std::tie
 #include <utility>
 
-#include "absl/algorithm/container.h"
 #include "api/packet_socket_factory.h"
 #include "p2p/base/async_stun_tcp_socket.h"
+#include "p2p/base/basic_packet_socket_factory.h"
 #include "p2p/base/stun.h"
+#include "rtc_base/arraysize.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/byte_buffer.h"
 #include "rtc_base/checks.h"
@@ -45,6 +46,10 @@ static const size_t kNonceSize = 48;
 
 static const size_t TURN_CHANNEL_HEADER_SIZE = 4U;
 
+// The number of datagrams read or written at once by each ShardedTurnServer
+// socket when |batch_udp_io| is set.
+static const size_t kTurnServerUdpBatchSize = 32;
+
 // TODO(mallinath) - Move these to a common place.
 inline bool IsTurnChannelData(uint16_t msg_type) {
   // The first two bits of a channel data message are 0b01.
@@ -147,7 +152,7 @@ void TurnServer::AddInternalSocket(rtc::AsyncPacketSocket* socket,
                                    ProtocolType proto) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   RTC_DCHECK(server_sockets_.end() == server_sockets_.find(socket));
-  server_sockets_[socket] = proto;
+  server_sockets_[socket] = {proto, socket->GetRemoteAddress()};
   socket->SignalReadPacket.connect(this, &TurnServer::OnInternalPacket);
 }
 
@@ -209,7 +214,8 @@ void TurnServer::OnInternalPacket(rtc::AsyncPacketSocket* socket,
   }
   InternalSocketMap::iterator iter = server_sockets_.find(socket);
   RTC_DCHECK(iter != server_sockets_.end());
-  TurnServerConnection conn(addr, iter->second, socket);
+  TurnServerConnection conn(addr, iter->second.remote_address,
+                            iter->second.proto, socket);
   uint16_t msg_type = rtc::GetBE16(data);
   if (!IsTurnChannelData(msg_type)) {
     // This is a STUN message.
@@ -542,6 +548,21 @@ void TurnServer::Send(TurnServerConnection* conn,
   conn->socket()->SendTo(buf.Data(), buf.Length(), conn->src(), options);
 }
 
+void TurnServer::SendChannelData(TurnServerConnection* conn,
+                                 uint16_t channel_id,
+                                 const char* data,
+                                 size_t size) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  // The header and the payload are sent as two segments, so that the payload
+  // is not copied behind the header first.
+  char header[TURN_CHANNEL_HEADER_SIZE];
+  rtc::SetBE16(header, channel_id);
+  rtc::SetBE16(header + 2, static_cast<uint16_t>(size));
+  const rtc::SendSegment segments[] = {{header, sizeof(header)}, {data, size}};
+  rtc::PacketOptions options;
+  conn->socket()->SendToV(segments, arraysize(segments), conn->src(), options);
+}
+
 void TurnServer::OnAllocationDestroyed(TurnServerAllocation* allocation) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   // Removing the internal socket if the connection is not udp.
@@ -551,7 +572,8 @@ void TurnServer::OnAllocationDestroyed(TurnServerAllocation* allocation) {
   // by all allocations.
   // Note: We may not find a socket if it's a TCP socket that was closed, and
   // the allocation is only now timing out.
-  if (iter != server_sockets_.end() && iter->second != cricket::PROTO_UDP) {
+  if (iter != server_sockets_.end() &&
+      iter->second.proto != cricket::PROTO_UDP) {
     DestroyInternalSocket(socket);
   }
 
@@ -587,10 +609,13 @@ void TurnServer::FreeSockets() {
 TurnServerConnection::TurnServerConnection(const rtc::SocketAddress& src,
                                            ProtocolType proto,
                                            rtc::AsyncPacketSocket* socket)
-    : src_(src),
-      dst_(socket->GetRemoteAddress()),
-      proto_(proto),
-      socket_(socket) {}
+    : TurnServerConnection(src, socket->GetRemoteAddress(), proto, socket) {}
+
+TurnServerConnection::TurnServerConnection(const rtc::SocketAddress& src,
+                                           const rtc::SocketAddress& dst,
+                                           ProtocolType proto,
+                                           rtc::AsyncPacketSocket* socket)
+    : src_(src), dst_(dst), proto_(proto), socket_(socket) {}
 
 bool TurnServerConnection::operator==(const TurnServerConnection& c) const {
   return src_ == c.src_ && dst_ == c.dst_ && proto_ == c.proto_;
@@ -600,6 +625,11 @@ bool TurnServerConnection::operator<(const TurnServerConnection& c) const {
   return std::tie(src_, dst_, proto_) < std::tie(c.src_, c.dst_, c.proto_);
 }
 
+size_t TurnServerConnection::Hash::operator()(
+    const TurnServerConnection& conn) const {
+  return conn.src_.Hash() ^ (conn.dst_.Hash() * 31) ^ conn.proto_;
+}
+
 std::string TurnServerConnection::ToString() const {
   const char* const kProtos[] = {"unknown", "udp", "tcp", "ssltcp"};
   rtc::StringBuilder ost;
@@ -623,12 +653,11 @@ TurnServerAllocation::TurnServerAllocation(TurnServer* server,
 }
 
 TurnServerAllocation::~TurnServerAllocation() {
-  for (ChannelList::iterator it = channels_.begin(); it != channels_.end();
-       ++it) {
-    delete *it;
+  for (const auto& kv : channels_) {
+    delete kv.second;
   }
-  for (PermissionList::iterator it = perms_.begin(); it != perms_.end(); ++it) {
-    delete *it;
+  for (const auto& kv : perms_) {
+    delete kv.second;
   }
   thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
   RTC_LOG(LS_INFO) << ToString() << ": Allocation destroyed";
@@ -809,7 +838,8 @@ void TurnServerAllocation::HandleChannelBindRequest(const TurnMessage* msg) {
     channel1 = new Channel(thread_, channel_id, peer_attr->GetAddress());
     channel1->SignalDestroyed.connect(
         this, &TurnServerAllocation::OnChannelDestroyed);
-    channels_.push_back(channel1);
+    channels_[channel_id] = channel1;
+    channels_by_peer_[channel1->peer()] = channel1;
   } else {
     channel1->Refresh();
   }
@@ -851,11 +881,8 @@ void TurnServerAllocation::OnExternalPacket(
   Channel* channel = FindChannel(addr);
   if (channel) {
     // There is a channel bound to this address. Send as a channel message.
-    rtc::ByteBufferWriter buf;
-    buf.WriteUInt16(channel->id());
-    buf.WriteUInt16(static_cast<uint16_t>(size));
-    buf.WriteBytes(data, size);
-    server_->Send(&conn_, buf);
+    server_->SendChannelData(&conn_, static_cast<uint16_t>(channel->id()),
+                             data, size);
   } else if (!server_->enable_permission_checks_ ||
              HasPermission(addr.ipaddr())) {
     // No channel, but a permission exists. Send as a data indication.
@@ -894,7 +921,7 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
     perm = new Permission(thread_, addr);
     perm->SignalDestroyed.connect(this,
                                   &TurnServerAllocation::OnPermissionDestroyed);
-    perms_.push_back(perm);
+    perms_[addr] = perm;
   } else {
     perm->Refresh();
   }
@@ -902,32 +929,20 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
 
 TurnServerAllocation::Permission* TurnServerAllocation::FindPermission(
     const rtc::IPAddress& addr) const {
-  for (PermissionList::const_iterator it = perms_.begin(); it != perms_.end();
-       ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  PermissionMap::const_iterator it = perms_.find(addr);
+  return (it != perms_.end()) ? it->second : NULL;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     int channel_id) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->id() == channel_id)
-      return *it;
-  }
-  return NULL;
+  ChannelMap::const_iterator it = channels_.find(channel_id);
+  return (it != channels_.end()) ? it->second : NULL;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     const rtc::SocketAddress& addr) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  ChannelPeerMap::const_iterator it = channels_by_peer_.find(addr);
+  return (it != channels_by_peer_.end()) ? it->second : NULL;
 }
 
 void TurnServerAllocation::SendResponse(TurnMessage* msg) {
@@ -960,15 +975,15 @@ void TurnServerAllocation::OnMessage(rtc::Message* msg) {
 }
 
 void TurnServerAllocation::OnPermissionDestroyed(Permission* perm) {
-  auto it = absl::c_find(perms_, perm);
-  RTC_DCHECK(it != perms_.end());
-  perms_.erase(it);
+  size_t erased = perms_.erase(perm->peer());
+  RTC_DCHECK_EQ(1u, erased);
 }
 
 void TurnServerAllocation::OnChannelDestroyed(Channel* channel) {
-  auto it = absl::c_find(channels_, channel);
-  RTC_DCHECK(it != channels_.end());
-  channels_.erase(it);
+  size_t erased = channels_.erase(channel->id());
+  RTC_DCHECK_EQ(1u, erased);
+  erased = channels_by_peer_.erase(channel->peer());
+  RTC_DCHECK_EQ(1u, erased);
 }
 
 TurnServerAllocation::Permission::Permission(rtc::Thread* thread,
@@ -1016,4 +1031,91 @@ void TurnServerAllocation::Channel::OnMessage(rtc::Message* msg) {
   delete this;
 }
 
+struct ShardedTurnServer::Shard {
+  std::unique_ptr<rtc::Thread> thread;
+  // Created and destroyed on |thread|.
+  std::unique_ptr<TurnServer> server;
+};
+
+ShardedTurnServer::ShardedTurnServer(const Config& config)
+    : config_(config) {}
+
+ShardedTurnServer::~ShardedTurnServer() {
+  Stop();
+}
+
+bool ShardedTurnServer::Start() {
+  RTC_DCHECK(shards_.empty());
+  RTC_DCHECK_GE(config_.num_shards, 1);
+  internal_address_ = config_.internal_address;
+  for (int i = 0; i < config_.num_shards; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+    Shard* shard = shards_.back().get();
+    shard->thread = rtc::Thread::CreateWithSocketServer();
+    shard->thread->SetName("TurnServerShard", shard);
+    shard->thread->Start();
+    if (!shard->thread->Invoke<bool>(
+            RTC_FROM_HERE, [this, shard] { return StartShard(shard); })) {
+      Stop();
+      return false;
+    }
+  }
+  RTC_LOG(LS_INFO) << "Started " << shards_.size()
+                   << " TURN server shards listening at "
+                   << internal_address_.ToSensitiveString();
+  return true;
+}
+
+bool ShardedTurnServer::StartShard(Shard* shard) {
+  RTC_DCHECK(shard->thread->IsCurrent());
+  rtc::BasicPacketSocketFactory internal_factory(shard->thread.get());
+  internal_factory.set_udp_reuse_port_enabled(true);
+  auto external_factory =
+      std::make_unique<rtc::BasicPacketSocketFactory>(shard->thread.get());
+  if (config_.batch_udp_io) {
+    for (rtc::BasicPacketSocketFactory* factory :
+         {&internal_factory, external_factory.get()}) {
+      factory->set_udp_recv_batch_size(kTurnServerUdpBatchSize);
+      factory->set_udp_send_batching_enabled(true);
+    }
+  }
+  rtc::AsyncPacketSocket* internal_socket =
+      internal_factory.CreateUdpSocket(internal_address_, 0, 0);
+  if (!internal_socket) {
+    RTC_LOG(LS_ERROR) << "Failed to listen at "
+                      << internal_address_.ToSensitiveString();
+    return false;
+  }
+  // The other shards have to listen on the port the first one was given.
+  internal_address_ = internal_socket->GetLocalAddress();
+
+  shard->server = std::make_unique<TurnServer>(shard->thread.get());
+  shard->server->set_realm(config_.realm);
+  shard->server->set_software(config_.software);
+  shard->server->set_auth_hook(config_.auth_hook);
+  shard->server->AddInternalSocket(internal_socket, PROTO_UDP);
+  shard->server->SetExternalSocketFactory(external_factory.release(),
+                                          config_.external_address);
+  return true;
+}
+
+void ShardedTurnServer::Stop() {
+  for (const auto& shard : shards_) {
+    shard->thread->Invoke<void>(RTC_FROM_HERE,
+                                [&shard] { shard->server.reset(); });
+    shard->thread->Stop();
+  }
+  shards_.clear();
+}
+
+size_t ShardedTurnServer::GetAllocationCount() const {
+  size_t count = 0;
+  for (const auto& shard : shards_) {
+    count += shard->thread->Invoke<size_t>(RTC_FROM_HERE, [&shard] {
+      return shard->server->allocations().size();
+    });
+  }
+  return count;
+}
+
 }  // namespace cricket
@@ -11,17 +11,19 @@
 #ifndef P2P_BASE_TURN_SERVER_H_
 #define P2P_BASE_TURN_SERVER_H_
 
-#include <list>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "p2p/base/port_interface.h"
 #include "rtc_base/async_invoker.h"
 #include "rtc_base/async_packet_socket.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/ip_address.h"
 #include "rtc_base/message_queue.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
@@ -49,12 +51,22 @@ class TurnServerConnection {
   TurnServerConnection(const rtc::SocketAddress& src,
                        ProtocolType proto,
                        rtc::AsyncPacketSocket* socket);
+  // Like the above, but takes the remote address of |socket| instead of
+  // querying it, which is a system call for physical sockets.
+  TurnServerConnection(const rtc::SocketAddress& src,
+                       const rtc::SocketAddress& dst,
+                       ProtocolType proto,
+                       rtc::AsyncPacketSocket* socket);
   const rtc::SocketAddress& src() const { return src_; }
   rtc::AsyncPacketSocket* socket() { return socket_; }
   bool operator==(const TurnServerConnection& t) const;
   bool operator<(const TurnServerConnection& t) const;
   std::string ToString() const;
 
+  struct Hash {
+    size_t operator()(const TurnServerConnection& conn) const;
+  };
+
  private:
   rtc::SocketAddress src_;
   rtc::SocketAddress dst_;
@@ -95,8 +107,21 @@ class TurnServerAllocation : public rtc::MessageHandler,
  private:
   class Channel;
   class Permission;
-  typedef std::list<Permission*> PermissionList;
-  typedef std::list<Channel*> ChannelList;
+  struct IPAddressHash {
+    size_t operator()(const rtc::IPAddress& ip) const {
+      return rtc::HashIP(ip);
+    }
+  };
+  struct SocketAddressHash {
+    size_t operator()(const rtc::SocketAddress& addr) const {
+      return addr.Hash();
+    }
+  };
+  typedef std::unordered_map<rtc::IPAddress, Permission*, IPAddressHash>
+      PermissionMap;
+  typedef std::unordered_map<int, Channel*> ChannelMap;
+  typedef std::unordered_map<rtc::SocketAddress, Channel*, SocketAddressHash>
+      ChannelPeerMap;
 
   void HandleAllocateRequest(const TurnMessage* msg);
   void HandleRefreshRequest(const TurnMessage* msg);
@@ -139,8 +164,10 @@ class TurnServerAllocation : public rtc::MessageHandler,
   std::string username_;
   std::string origin_;
   std::string last_nonce_;
-  PermissionList perms_;
-  ChannelList channels_;
+  PermissionMap perms_;
+  // The channels by id, and by peer address.
+  ChannelMap channels_;
+  ChannelPeerMap channels_by_peer_;
 };
 
 // An interface through which the MD5 credential hash can be retrieved.
@@ -176,7 +203,9 @@ class StunMessageObserver {
 // Not yet wired up: TCP support.
 class TurnServer : public sigslot::has_slots<> {
  public:
-  typedef std::map<TurnServerConnection, std::unique_ptr<TurnServerAllocation>>
+  typedef std::unordered_map<TurnServerConnection,
+                             std::unique_ptr<TurnServerAllocation>,
+                             TurnServerConnection::Hash>
       AllocationMap;
 
   explicit TurnServer(rtc::Thread* thread);
@@ -306,6 +335,11 @@ class TurnServer : public sigslot::has_slots<> {
 
   void SendStun(TurnServerConnection* conn, StunMessage* msg);
   void Send(TurnServerConnection* conn, const rtc::ByteBufferWriter& buf);
+  // Relays |size| bytes from |data| to the client as a ChannelData message.
+  void SendChannelData(TurnServerConnection* conn,
+                       uint16_t channel_id,
+                       const char* data,
+                       size_t size);
 
   void OnAllocationDestroyed(TurnServerAllocation* allocation);
   void DestroyInternalSocket(rtc::AsyncPacketSocket* socket);
@@ -313,7 +347,14 @@ class TurnServer : public sigslot::has_slots<> {
   // Just clears |sockets_to_delete_|; called asynchronously.
   void FreeSockets();
 
-  typedef std::map<rtc::AsyncPacketSocket*, ProtocolType> InternalSocketMap;
+  struct InternalSocket {
+    ProtocolType proto;
+    // Looked up once, since each lookup is a system call for physical
+    // sockets and it is needed for every packet.
+    rtc::SocketAddress remote_address;
+  };
+  typedef std::unordered_map<rtc::AsyncPacketSocket*, InternalSocket>
+      InternalSocketMap;
   typedef std::map<rtc::AsyncSocket*, ProtocolType> ServerSocketMap;
 
   rtc::Thread* thread_;
@@ -338,7 +379,6 @@ class TurnServer : public sigslot::has_slots<> {
   rtc::SocketAddress external_addr_;
 
   AllocationMap allocations_;
-
   rtc::AsyncInvoker invoker_;
 
   // For testing only. If this is non-zero, the next NONCE will be generated
@@ -351,6 +391,59 @@ class TurnServer : public sigslot::has_slots<> {
   friend class TurnServerAllocation;
 };
 
+// Runs a UDP TURN server on several threads. Each shard is a TurnServer on a
+// thread of its own, with its own UDP socket on the shared internal address.
+// The sockets share the port through SO_REUSEPORT, so the kernel spreads the
+// clients over the shards by a hash of their 5-tuple, and the allocations of
+// a client always live on the same shard. More than one shard requires
+// SO_REUSEPORT support, i.e. Linux.
+class ShardedTurnServer {
+ public:
+  struct Config {
+    // The UDP address to listen on for clients. If the port is 0, the shards
+    // share one picked by the first shard.
+    rtc::SocketAddress internal_address;
+    // The address to allocate relayed addresses on, normally with port 0.
+    rtc::SocketAddress external_address;
+    std::string realm;
+    std::string software;
+    // Called on all the shard threads, so must be thread safe.
+    TurnAuthInterface* auth_hook = nullptr;
+    int num_shards = 1;
+    // Whether the sockets read and write datagrams in batches, see
+    // rtc::AsyncUDPSocket::SetRecvBatchSize() and SetSendBatchingEnabled().
+    bool batch_udp_io = true;
+  };
+
+  explicit ShardedTurnServer(const Config& config);
+  ~ShardedTurnServer();
+
+  // Starts the shard threads and their servers. Returns false and stops
+  // again if any shard cannot listen on the internal address.
+  bool Start();
+  void Stop();
+
+  // The address the shards listen on, once started.
+  const rtc::SocketAddress& internal_address() const {
+    return internal_address_;
+  }
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+  // Returns the number of allocations on all the shards. Blocks on each of
+  // the shard threads.
+  size_t GetAllocationCount() const;
+
+ private:
+  struct Shard;
+
+  bool StartShard(Shard* shard);
+
+  const Config config_;
+  rtc::SocketAddress internal_address_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ShardedTurnServer);
+};
+
 }  // namespace cricket
 
 #endif  // P2P_BASE_TURN_SERVER_H_
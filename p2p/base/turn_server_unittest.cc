@@ -10,7 +10,20 @@
 
 #include "p2p/base/turn_server.h"
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 #include "p2p/base/basic_packet_socket_factory.h"
+#include "p2p/base/stun.h"
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/byte_buffer.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/physical_socket_server.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
 #include "rtc_base/virtual_socket_server.h"
 #include "test/gtest.h"
 
@@ -62,6 +75,313 @@ TEST_F(TurnServerConnectionTest, ComparisonOperators) {
   ExpectEqual(connection1, connection2);
   ExpectNotEqual(connection1, connection3);
   ExpectNotEqual(connection1, connection4);
+  TurnServerConnection::Hash hash;
+  EXPECT_EQ(hash(connection1), hash(connection2));
+}
+
+namespace {
+
+const int kTimeout = 5000;
+const char kRealm[] = "example.org";
+const uint16_t kChannelId = 0x4001;
+
+// The longer reads and writes of the sockets are tested with a real network
+// stack; a second shard needs SO_REUSEPORT.
+#if defined(WEBRTC_LINUX)
+const int kNumShards = 2;
+#else
+const int kNumShards = 1;
+#endif
+
+// Accepts any user whose password is the same as the username.
+class TestAuth : public TurnAuthInterface {
+ public:
+  bool GetKey(const std::string& username,
+              const std::string& realm,
+              std::string* key) override {
+    return ComputeStunCredentialHash(username, realm, username, key);
+  }
+};
+
+// A minimal UDP TURN client, which allocates a relayed address and binds a
+// channel to a peer.
+class TestTurnClient : public sigslot::has_slots<> {
+ public:
+  TestTurnClient(rtc::SocketFactory* factory,
+                 const rtc::SocketAddress& server_address,
+                 const std::string& username)
+      : socket_(rtc::AsyncUDPSocket::Create(
+            factory,
+            rtc::SocketAddress(server_address.ipaddr(), 0))),
+        server_address_(server_address),
+        username_(username) {
+    socket_->SignalReadPacket.connect(this, &TestTurnClient::OnReadPacket);
+  }
+
+  rtc::AsyncUDPSocket* socket() { return socket_.get(); }
+  const rtc::SocketAddress& relayed_address() const {
+    return relayed_address_;
+  }
+  const std::vector<std::string>& channel_data() const {
+    return channel_data_;
+  }
+
+  bool Allocate() {
+    // The first request is rejected with the realm and a nonce to use.
+    std::unique_ptr<TurnMessage> response;
+    for (int i = 0; i < 2; ++i) {
+      TurnMessage request;
+      request.SetType(STUN_ALLOCATE_REQUEST);
+      request.AddAttribute(std::make_unique<StunUInt32Attribute>(
+          STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24));
+      response = SendRequest(&request);
+      if (!response || response->type() != STUN_ALLOCATE_ERROR_RESPONSE ||
+          !response->GetByteString(STUN_ATTR_NONCE)) {
+        break;
+      }
+      nonce_ = response->GetByteString(STUN_ATTR_NONCE)->GetString();
+      ComputeStunCredentialHash(username_, kRealm, username_, &key_);
+    }
+    if (!response || response->type() != STUN_ALLOCATE_RESPONSE ||
+        !response->GetAddress(STUN_ATTR_XOR_RELAYED_ADDRESS)) {
+      return false;
+    }
+    relayed_address_ =
+        response->GetAddress(STUN_ATTR_XOR_RELAYED_ADDRESS)->GetAddress();
+    return true;
+  }
+
+  bool BindChannel(uint16_t channel_id, const rtc::SocketAddress& peer) {
+    TurnMessage request;
+    request.SetType(TURN_CHANNEL_BIND_REQUEST);
+    request.AddAttribute(std::make_unique<StunUInt32Attribute>(
+        STUN_ATTR_CHANNEL_NUMBER, channel_id << 16));
+    request.AddAttribute(std::make_unique<StunXorAddressAttribute>(
+        STUN_ATTR_XOR_PEER_ADDRESS, peer));
+    std::unique_ptr<TurnMessage> response = SendRequest(&request);
+    return response && response->type() == TURN_CHANNEL_BIND_RESPONSE;
+  }
+
+  void SendChannelData(uint16_t channel_id, const std::string& data) {
+    rtc::ByteBufferWriter buf;
+    buf.WriteUInt16(channel_id);
+    buf.WriteUInt16(static_cast<uint16_t>(data.size()));
+    buf.WriteString(data);
+    socket_->SendTo(buf.Data(), buf.Length(), server_address_,
+                    rtc::PacketOptions());
+  }
+
+ private:
+  // Signs |request| if the nonce is known, and waits for the response.
+  std::unique_ptr<TurnMessage> SendRequest(TurnMessage* request) {
+    request->SetTransactionID(
+        rtc::CreateRandomString(kStunTransactionIdLength));
+    if (!nonce_.empty()) {
+      request->AddAttribute(std::make_unique<StunByteStringAttribute>(
+          STUN_ATTR_USERNAME, username_));
+      request->AddAttribute(
+          std::make_unique<StunByteStringAttribute>(STUN_ATTR_REALM, kRealm));
+      request->AddAttribute(
+          std::make_unique<StunByteStringAttribute>(STUN_ATTR_NONCE, nonce_));
+      request->AddMessageIntegrity(key_);
+    }
+    rtc::ByteBufferWriter buf;
+    request->Write(&buf);
+    response_.reset();
+    socket_->SendTo(buf.Data(), buf.Length(), server_address_,
+                    rtc::PacketOptions());
+    EXPECT_TRUE_WAIT(response_ != nullptr, kTimeout);
+    return std::move(response_);
+  }
+
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& addr,
+                    const int64_t& packet_time_us) {
+    // The first two bits of a channel data message are 0b01.
+    if (size >= 4 && (rtc::GetBE16(data) & 0xC000) == 0x4000) {
+      channel_data_.emplace_back(data + 4, size - 4);
+      return;
+    }
+    auto response = std::make_unique<TurnMessage>();
+    rtc::ByteBufferReader buf(data, size);
+    if (response->Read(&buf)) {
+      response_ = std::move(response);
+    }
+  }
+
+  std::unique_ptr<rtc::AsyncUDPSocket> socket_;
+  const rtc::SocketAddress server_address_;
+  const std::string username_;
+  std::string nonce_;
+  std::string key_;
+  rtc::SocketAddress relayed_address_;
+  std::unique_ptr<TurnMessage> response_;
+  std::vector<std::string> channel_data_;
+};
+
+// A peer of the TURN clients. Counts the datagrams it receives, and keeps
+// them if |keep_packets| is set.
+class TestPeer : public sigslot::has_slots<> {
+ public:
+  TestPeer(rtc::AsyncPacketSocket* socket, bool keep_packets)
+      : socket_(socket), keep_packets_(keep_packets) {
+    socket_->SignalReadPacket.connect(this, &TestPeer::OnReadPacket);
+  }
+
+  rtc::AsyncPacketSocket* socket() { return socket_.get(); }
+  int64_t num_packets() const { return num_packets_.load(); }
+  // The packets received, and where from.
+  const std::vector<std::pair<std::string, rtc::SocketAddress>>& packets()
+      const {
+    return packets_;
+  }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const rtc::SocketAddress& addr,
+                    const int64_t& packet_time_us) {
+    if (keep_packets_) {
+      packets_.emplace_back(std::string(data, size), addr);
+    }
+    num_packets_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<rtc::AsyncPacketSocket> socket_;
+  const bool keep_packets_;
+  std::atomic<int64_t> num_packets_{0};
+  std::vector<std::pair<std::string, rtc::SocketAddress>> packets_;
+};
+
+}  // namespace
+
+class ShardedTurnServerTest : public ::testing::Test {
+ public:
+  ShardedTurnServerTest() : thread_(&ss_) {}
+
+ protected:
+  ShardedTurnServer::Config CreateConfig(int num_shards) {
+    ShardedTurnServer::Config config;
+    config.internal_address = rtc::SocketAddress("127.0.0.1", 0);
+    config.external_address = rtc::SocketAddress("127.0.0.1", 0);
+    config.realm = kRealm;
+    config.auth_hook = &auth_;
+    config.num_shards = num_shards;
+    return config;
+  }
+
+  std::vector<std::unique_ptr<TestTurnClient>> CreateClients(
+      const ShardedTurnServer& server,
+      int num_clients,
+      const rtc::SocketAddress& peer) {
+    std::vector<std::unique_ptr<TestTurnClient>> clients;
+    for (int i = 0; i < num_clients; ++i) {
+      auto client = std::make_unique<TestTurnClient>(
+          &ss_, server.internal_address(), "user" + rtc::ToString(i));
+      EXPECT_TRUE(client->Allocate());
+      EXPECT_TRUE(client->BindChannel(kChannelId, peer));
+      clients.push_back(std::move(client));
+    }
+    return clients;
+  }
+
+  rtc::PhysicalSocketServer ss_;
+  rtc::AutoSocketServerThread thread_;
+  TestAuth auth_;
+};
+
+TEST_F(ShardedTurnServerTest, RelaysChannelDataBothWays) {
+  ShardedTurnServer server(CreateConfig(kNumShards));
+  ASSERT_TRUE(server.Start());
+  EXPECT_EQ(kNumShards, server.num_shards());
+  EXPECT_NE(0, server.internal_address().port());
+
+  TestPeer peer(
+      rtc::AsyncUDPSocket::Create(&ss_, rtc::SocketAddress("127.0.0.1", 0)),
+      /*keep_packets=*/true);
+  // Enough clients for every shard to most likely get some of them.
+  std::vector<std::unique_ptr<TestTurnClient>> clients =
+      CreateClients(server, 8, peer.socket()->GetLocalAddress());
+  EXPECT_EQ(clients.size(), server.GetAllocationCount());
+
+  for (size_t i = 0; i < clients.size(); ++i) {
+    TestTurnClient* client = clients[i].get();
+    std::string to_peer = "to peer " + rtc::ToString(i);
+    client->SendChannelData(kChannelId, to_peer);
+    ASSERT_EQ_WAIT(i + 1, peer.packets().size(), kTimeout);
+    EXPECT_EQ(to_peer, peer.packets().back().first);
+    EXPECT_EQ(client->relayed_address(), peer.packets().back().second);
+
+    std::string to_client = "to client " + rtc::ToString(i);
+    peer.socket()->SendTo(to_client.data(), to_client.size(),
+                          client->relayed_address(), rtc::PacketOptions());
+    ASSERT_EQ_WAIT(1u, client->channel_data().size(), kTimeout);
+    EXPECT_EQ(to_client, client->channel_data().back());
+  }
+
+  server.Stop();
+  EXPECT_EQ(0, server.num_shards());
+}
+
+// Measures how many ChannelData messages per second the server relays from
+// clients to a peer over loopback. Disabled since it only logs the results.
+TEST_F(ShardedTurnServerTest, DISABLED_LoopbackRelayThroughput) {
+  static const int kNumClients = 32;
+  static const int kBurstSize = 32;
+  static const int64_t kDurationMs = 2000;
+  const std::string payload(160, 'x');
+
+  for (int num_shards : {1, 2, 4}) {
+    ShardedTurnServer server(CreateConfig(num_shards));
+    if (!server.Start()) {
+      RTC_LOG(LS_WARNING) << "Cannot start " << num_shards << " shards.";
+      continue;
+    }
+    // The peer reads on a thread of its own, so that it does not compete with
+    // the clients.
+    std::unique_ptr<rtc::Thread> peer_thread =
+        rtc::Thread::CreateWithSocketServer();
+    peer_thread->Start();
+    std::unique_ptr<TestPeer> peer =
+        peer_thread->Invoke<std::unique_ptr<TestPeer>>(RTC_FROM_HERE, [&] {
+          rtc::AsyncUDPSocket* socket = rtc::AsyncUDPSocket::Create(
+              peer_thread->socketserver(), rtc::SocketAddress("127.0.0.1", 0));
+          socket->SetRecvBatchSize(kBurstSize);
+          return std::make_unique<TestPeer>(socket, /*keep_packets=*/false);
+        });
+    std::vector<std::unique_ptr<TestTurnClient>> clients =
+        CreateClients(server, kNumClients, peer->socket()->GetLocalAddress());
+    for (const auto& client : clients) {
+      client->socket()->SetSendBatchingEnabled(true);
+    }
+
+    int64_t sent = 0;
+    int64_t start_us = rtc::TimeMicros();
+    int64_t elapsed_us = 0;
+    while (elapsed_us < kDurationMs * rtc::kNumMicrosecsPerMillisec) {
+      for (const auto& client : clients) {
+        for (int i = 0; i < kBurstSize; ++i) {
+          client->SendChannelData(kChannelId, payload);
+        }
+        client->socket()->FlushSendBatch();
+        sent += kBurstSize;
+      }
+      elapsed_us = rtc::TimeMicros() - start_us;
+    }
+    int64_t relayed = peer->num_packets();
+    // Packets per microsecond are millions of packets per second.
+    RTC_LOG(LS_WARNING) << num_shards << " shards: sent "
+                        << static_cast<double>(sent) / elapsed_us
+                        << " Mpps, relayed "
+                        << static_cast<double>(relayed) / elapsed_us
+                        << " Mpps";
+
+    clients.clear();
+    peer_thread->Invoke<void>(RTC_FROM_HERE, [&peer] { peer.reset(); });
+  }
 }
 
 }  // namespace cricket
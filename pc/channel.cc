@@ -275,10 +275,17 @@ bool BaseChannel::SetRtpTransport(webrtc::RtpTransportInternal* rtp_transport) {
 }
 
 bool BaseChannel::Enable(bool enable) {
-  worker_thread_->Invoke<void>(
-      RTC_FROM_HERE,
-      Bind(enable ? &BaseChannel::EnableMedia_w : &BaseChannel::DisableMedia_w,
-           this));
+  auto enable_w =
+      enable ? &BaseChannel::EnableMedia_w : &BaseChannel::DisableMedia_w;
+  if (worker_thread_->IsCurrent()) {
+    (this->*enable_w)();
+    return true;
+  }
+  // Don't block the caller on the worker thread. Enabling commutes with
+  // setting content, since both update the media state once done, and the
+  // task is dropped if the channel is destroyed first.
+  invoker_.AsyncInvoke<void>(RTC_FROM_HERE, worker_thread_,
+                             Bind(enable_w, this));
   return true;
 }
 
@@ -307,14 +314,10 @@ bool BaseChannel::IsReadyToReceiveMedia_w() const {
 }
 
 bool BaseChannel::IsReadyToSendMedia_w() const {
-  // Need to access some state updated on the network thread.
-  return network_thread_->Invoke<bool>(
-      RTC_FROM_HERE, Bind(&BaseChannel::IsReadyToSendMedia_n, this));
-}
-
-bool BaseChannel::IsReadyToSendMedia_n() const {
   // Send outgoing data if we are enabled, have local and remote content,
-  // and we have had some form of connectivity.
+  // and we have had some form of connectivity. The channel becoming writable
+  // triggers UpdateMediaSendRecvState() on the network thread, which
+  // re-evaluates this.
   return enabled() &&
          webrtc::RtpTransceiverDirectionHasRecv(remote_content_direction_) &&
          webrtc::RtpTransceiverDirectionHasSend(local_content_direction_) &&
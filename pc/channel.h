@@ -11,6 +11,7 @@
 #ifndef PC_CHANNEL_H_
 #define PC_CHANNEL_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <set>
@@ -285,7 +286,6 @@ class BaseChannel : public ChannelInterface,
   bool ConnectToRtpTransport();
   void DisconnectFromRtpTransport();
   void SignalSentPacket_n(const rtc::SentPacket& sent_packet);
-  bool IsReadyToSendMedia_n() const;
 
   // MediaTransportNetworkChangeCallback override.
   void OnNetworkRouteChanged(const rtc::NetworkRoute& network_route) override;
@@ -309,17 +309,18 @@ class BaseChannel : public ChannelInterface,
   std::vector<std::pair<rtc::Socket::Option, int> > socket_options_;
   std::vector<std::pair<rtc::Socket::Option, int> > rtcp_socket_options_;
   bool writable_ = false;
-  bool was_ever_writable_ = false;
+  // Set on the network thread, and read on the worker thread when deciding
+  // whether to send, which saves a blocking hop to the network thread.
+  std::atomic<bool> was_ever_writable_{false};
   const bool srtp_required_ = true;
   webrtc::CryptoOptions crypto_options_;
 
   // MediaChannel related members that should be accessed from the worker
   // thread.
   std::unique_ptr<MediaChannel> media_channel_;
-  // Currently the |enabled_| flag is accessed from the signaling thread as
-  // well, but it can be changed only when signaling thread does a synchronous
-  // call to the worker thread, so it should be safe.
-  bool enabled_ = false;
+  // Changed on the worker thread only, but read from the signaling thread
+  // as well, since Enable() doesn't wait for the worker thread.
+  std::atomic<bool> enabled_{false};
   std::vector<StreamParams> local_streams_;
   std::vector<StreamParams> remote_streams_;
   webrtc::RtpTransceiverDirection local_content_direction_ =
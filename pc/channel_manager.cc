@@ -159,6 +159,7 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
     const cricket::MediaConfig& media_config,
     webrtc::RtpTransportInternal* rtp_transport,
     const webrtc::MediaTransportConfig& media_transport_config,
+    rtc::Thread* network_thread,
     rtc::Thread* signaling_thread,
     const std::string& content_name,
     bool srtp_required,
@@ -168,9 +169,9 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
   if (!worker_thread_->IsCurrent()) {
     return worker_thread_->Invoke<VoiceChannel*>(RTC_FROM_HERE, [&] {
       return CreateVoiceChannel(call, media_config, rtp_transport,
-                                media_transport_config, signaling_thread,
-                                content_name, srtp_required, crypto_options,
-                                ssrc_generator, options);
+                                media_transport_config, network_thread,
+                                signaling_thread, content_name, srtp_required,
+                                crypto_options, ssrc_generator, options);
     });
   }
 
@@ -188,7 +189,7 @@ VoiceChannel* ChannelManager::CreateVoiceChannel(
   }
 
   auto voice_channel = std::make_unique<VoiceChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread, signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -229,6 +230,7 @@ VideoChannel* ChannelManager::CreateVideoChannel(
     const cricket::MediaConfig& media_config,
     webrtc::RtpTransportInternal* rtp_transport,
     const webrtc::MediaTransportConfig& media_transport_config,
+    rtc::Thread* network_thread,
     rtc::Thread* signaling_thread,
     const std::string& content_name,
     bool srtp_required,
@@ -240,8 +242,9 @@ VideoChannel* ChannelManager::CreateVideoChannel(
     return worker_thread_->Invoke<VideoChannel*>(RTC_FROM_HERE, [&] {
       return CreateVideoChannel(
           call, media_config, rtp_transport, media_transport_config,
-          signaling_thread, content_name, srtp_required, crypto_options,
-          ssrc_generator, options, video_bitrate_allocator_factory);
+          network_thread, signaling_thread, content_name, srtp_required,
+          crypto_options, ssrc_generator, options,
+          video_bitrate_allocator_factory);
     });
   }
 
@@ -260,7 +263,7 @@ VideoChannel* ChannelManager::CreateVideoChannel(
   }
 
   auto video_channel = std::make_unique<VideoChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread, signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -299,6 +302,7 @@ void ChannelManager::DestroyVideoChannel(VideoChannel* video_channel) {
 RtpDataChannel* ChannelManager::CreateRtpDataChannel(
     const cricket::MediaConfig& media_config,
     webrtc::RtpTransportInternal* rtp_transport,
+    rtc::Thread* network_thread,
     rtc::Thread* signaling_thread,
     const std::string& content_name,
     bool srtp_required,
@@ -306,9 +310,9 @@ RtpDataChannel* ChannelManager::CreateRtpDataChannel(
     rtc::UniqueRandomIdGenerator* ssrc_generator) {
   if (!worker_thread_->IsCurrent()) {
     return worker_thread_->Invoke<RtpDataChannel*>(RTC_FROM_HERE, [&] {
-      return CreateRtpDataChannel(media_config, rtp_transport, signaling_thread,
-                                  content_name, srtp_required, crypto_options,
-                                  ssrc_generator);
+      return CreateRtpDataChannel(media_config, rtp_transport, network_thread,
+                                  signaling_thread, content_name, srtp_required,
+                                  crypto_options, ssrc_generator);
     });
   }
 
@@ -321,7 +325,7 @@ RtpDataChannel* ChannelManager::CreateRtpDataChannel(
   }
 
   auto data_channel = std::make_unique<RtpDataChannel>(
-      worker_thread_, network_thread_, signaling_thread,
+      worker_thread_, network_thread, signaling_thread,
       absl::WrapUnique(media_channel), content_name, srtp_required,
       crypto_options, ssrc_generator);
 
@@ -89,7 +89,10 @@ class ChannelManager final {
 
   // The operations below all occur on the worker thread.
   // ChannelManager retains ownership of the created channels, so clients should
-  // call the appropriate Destroy*Channel method when done.
+  // call the appropriate Destroy*Channel method when done. |network_thread| is
+  // the thread |rtp_transport| runs on, which need not be network_thread()
+  // when the transports of different PeerConnections are spread over several
+  // threads.
 
   // Creates a voice channel, to be associated with the specified session.
   VoiceChannel* CreateVoiceChannel(
@@ -97,6 +100,7 @@ class ChannelManager final {
       const cricket::MediaConfig& media_config,
       webrtc::RtpTransportInternal* rtp_transport,
       const webrtc::MediaTransportConfig& media_transport_config,
+      rtc::Thread* network_thread,
       rtc::Thread* signaling_thread,
       const std::string& content_name,
       bool srtp_required,
@@ -114,6 +118,7 @@ class ChannelManager final {
       const cricket::MediaConfig& media_config,
       webrtc::RtpTransportInternal* rtp_transport,
       const webrtc::MediaTransportConfig& media_transport_config,
+      rtc::Thread* network_thread,
       rtc::Thread* signaling_thread,
       const std::string& content_name,
       bool srtp_required,
@@ -127,6 +132,7 @@ class ChannelManager final {
   RtpDataChannel* CreateRtpDataChannel(
       const cricket::MediaConfig& media_config,
       webrtc::RtpTransportInternal* rtp_transport,
+      rtc::Thread* network_thread,
       rtc::Thread* signaling_thread,
       const std::string& content_name,
       bool srtp_required,
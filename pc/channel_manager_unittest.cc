@@ -91,20 +91,21 @@ class ChannelManagerTest : public ::testing::Test {
       webrtc::MediaTransportConfig media_transport_config) {
     cricket::VoiceChannel* voice_channel = cm_->CreateVoiceChannel(
         &fake_call_, cricket::MediaConfig(), rtp_transport,
-        media_transport_config, rtc::Thread::Current(), cricket::CN_AUDIO,
-        kDefaultSrtpRequired, webrtc::CryptoOptions(), &ssrc_generator_,
-        AudioOptions());
+        media_transport_config, cm_->network_thread(), rtc::Thread::Current(),
+        cricket::CN_AUDIO, kDefaultSrtpRequired, webrtc::CryptoOptions(),
+        &ssrc_generator_, AudioOptions());
     EXPECT_TRUE(voice_channel != nullptr);
     cricket::VideoChannel* video_channel = cm_->CreateVideoChannel(
         &fake_call_, cricket::MediaConfig(), rtp_transport,
-        media_transport_config, rtc::Thread::Current(), cricket::CN_VIDEO,
-        kDefaultSrtpRequired, webrtc::CryptoOptions(), &ssrc_generator_,
-        VideoOptions(), video_bitrate_allocator_factory_.get());
+        media_transport_config, cm_->network_thread(), rtc::Thread::Current(),
+        cricket::CN_VIDEO, kDefaultSrtpRequired, webrtc::CryptoOptions(),
+        &ssrc_generator_, VideoOptions(),
+        video_bitrate_allocator_factory_.get());
     EXPECT_TRUE(video_channel != nullptr);
     cricket::RtpDataChannel* rtp_data_channel = cm_->CreateRtpDataChannel(
-        cricket::MediaConfig(), rtp_transport, rtc::Thread::Current(),
-        cricket::CN_DATA, kDefaultSrtpRequired, webrtc::CryptoOptions(),
-        &ssrc_generator_);
+        cricket::MediaConfig(), rtp_transport, cm_->network_thread(),
+        rtc::Thread::Current(), cricket::CN_DATA, kDefaultSrtpRequired,
+        webrtc::CryptoOptions(), &ssrc_generator_);
     EXPECT_TRUE(rtp_data_channel != nullptr);
     cm_->DestroyVideoChannel(video_channel);
     cm_->DestroyVoiceChannel(voice_channel);
@@ -592,6 +592,8 @@ JsepTransportController::CreateSdesTransport(
   if (config_.enable_external_auth) {
     srtp_transport->EnableExternalAuth();
   }
+  srtp_transport->SetBatchingEnabled(
+      config_.crypto_options.srtp.enable_batching);
   return srtp_transport;
 }
 
@@ -611,6 +613,8 @@ JsepTransportController::CreateDtlsSrtpTransport(
                                          rtcp_dtls_transport);
   dtls_srtp_transport->SetActiveResetSrtpParams(
       config_.active_reset_srtp_params);
+  dtls_srtp_transport->SetBatchingEnabled(
+      config_.crypto_options.srtp.enable_batching);
   dtls_srtp_transport->SignalDtlsStateChange.connect(
       this, &JsepTransportController::UpdateAggregateStates_n);
   return dtls_srtp_transport;
@@ -887,9 +887,11 @@ void ExtractSharedMediaSessionOptions(
 }
 
 PeerConnection::PeerConnection(PeerConnectionFactory* factory,
+                               rtc::Thread* network_thread,
                                std::unique_ptr<RtcEventLog> event_log,
                                std::unique_ptr<Call> call)
     : factory_(factory),
+      network_thread_(network_thread),
       event_log_(std::move(event_log)),
       event_log_ptr_(event_log_.get()),
       datagram_transport_config_(
@@ -935,6 +937,8 @@ PeerConnection::~PeerConnection() {
   // port_allocator_ lives on the network thread and should be destroyed there.
   network_thread()->Invoke<void>(RTC_FROM_HERE, [this] {
     RTC_DCHECK_RUN_ON(network_thread());
+    // Drop posted tasks that still refer to |port_allocator_|.
+    network_invoker_.Clear();
     port_allocator_.reset();
   });
   // call_ and event_log_ must be destroyed on the worker thread.
@@ -1149,7 +1153,8 @@ bool PeerConnection::Initialize(
     }
   }
 
-  sctp_factory_ = factory_->CreateSctpTransportInternalFactory();
+  sctp_factory_ =
+      factory_->CreateSctpTransportInternalFactory(network_thread());
 
   if (use_datagram_transport_for_data_channels_) {
     if (configuration.enable_rtp_data_channel) {
@@ -2319,11 +2324,12 @@ void PeerConnection::SetLocalDescription(
   transport_controller_->MaybeStartGathering();
 
   if (local_description()->GetType() == SdpType::kAnswer) {
-    // TODO(deadbeef): We already had to hop to the network thread for
-    // MaybeStartGathering...
-    network_thread()->Invoke<void>(
-        RTC_FROM_HERE, rtc::Bind(&cricket::PortAllocator::DiscardCandidatePool,
-                                 port_allocator_.get()));
+    // Nothing here depends on the pool being gone, so don't wait for the
+    // network thread.
+    network_invoker_.AsyncInvoke<void>(
+        RTC_FROM_HERE, network_thread(),
+        rtc::Bind(&cricket::PortAllocator::DiscardCandidatePool,
+                  port_allocator_.get()));
     // Make UMA notes about what was agreed to.
     ReportNegotiatedSdpSemantics(*local_description());
   }
@@ -2709,11 +2715,12 @@ void PeerConnection::SetRemoteDescription(
   RTC_DCHECK(remote_description());
 
   if (type == SdpType::kAnswer) {
-    // TODO(deadbeef): We already had to hop to the network thread for
-    // MaybeStartGathering...
-    network_thread()->Invoke<void>(
-        RTC_FROM_HERE, rtc::Bind(&cricket::PortAllocator::DiscardCandidatePool,
-                                 port_allocator_.get()));
+    // Nothing here depends on the pool being gone, so don't wait for the
+    // network thread.
+    network_invoker_.AsyncInvoke<void>(
+        RTC_FROM_HERE, network_thread(),
+        rtc::Bind(&cricket::PortAllocator::DiscardCandidatePool,
+                  port_allocator_.get()));
     // Make UMA notes about what was agreed to.
     ReportNegotiatedSdpSemantics(*remote_description());
   }
@@ -6646,8 +6653,8 @@ cricket::VoiceChannel* PeerConnection::CreateVoiceChannel(
 
   cricket::VoiceChannel* voice_channel = channel_manager()->CreateVoiceChannel(
       call_ptr_, configuration_.media_config, rtp_transport,
-      media_transport_config, signaling_thread(), mid, SrtpRequired(),
-      GetCryptoOptions(), &ssrc_generator_, audio_options_);
+      media_transport_config, network_thread(), signaling_thread(), mid,
+      SrtpRequired(), GetCryptoOptions(), &ssrc_generator_, audio_options_);
   if (!voice_channel) {
     return nullptr;
   }
@@ -6669,8 +6676,8 @@ cricket::VideoChannel* PeerConnection::CreateVideoChannel(
 
   cricket::VideoChannel* video_channel = channel_manager()->CreateVideoChannel(
       call_ptr_, configuration_.media_config, rtp_transport,
-      media_transport_config, signaling_thread(), mid, SrtpRequired(),
-      GetCryptoOptions(), &ssrc_generator_, video_options_,
+      media_transport_config, network_thread(), signaling_thread(), mid,
+      SrtpRequired(), GetCryptoOptions(), &ssrc_generator_, video_options_,
       video_bitrate_allocator_factory_.get());
   if (!video_channel) {
     return nullptr;
@@ -6706,8 +6713,9 @@ bool PeerConnection::CreateDataChannel(const std::string& mid) {
     default:
       RtpTransportInternal* rtp_transport = GetRtpTransport(mid);
       rtp_data_channel_ = channel_manager()->CreateRtpDataChannel(
-          configuration_.media_config, rtp_transport, signaling_thread(), mid,
-          SrtpRequired(), GetCryptoOptions(), &ssrc_generator_);
+          configuration_.media_config, rtp_transport, network_thread(),
+          signaling_thread(), mid, SrtpRequired(), GetCryptoOptions(),
+          &ssrc_generator_);
       if (!rtp_data_channel_) {
         return false;
       }
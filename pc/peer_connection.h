@@ -112,9 +112,12 @@ class PeerConnection : public PeerConnectionInternal,
     MAX_VALUE = 0x80000,
   };
 
-  explicit PeerConnection(PeerConnectionFactory* factory,
-                          std::unique_ptr<RtcEventLog> event_log,
-                          std::unique_ptr<Call> call);
+  // |network_thread| is the thread all transports of this PeerConnection run
+  // on; one of the network threads of |factory|.
+  PeerConnection(PeerConnectionFactory* factory,
+                 rtc::Thread* network_thread,
+                 std::unique_ptr<RtcEventLog> event_log,
+                 std::unique_ptr<Call> call);
 
   bool Initialize(
       const PeerConnectionInterface::RTCConfiguration& configuration,
@@ -241,9 +244,7 @@ class PeerConnection : public PeerConnectionInternal,
   void Close() override;
 
   // PeerConnectionInternal implementation.
-  rtc::Thread* network_thread() const final {
-    return factory_->network_thread();
-  }
+  rtc::Thread* network_thread() const final { return network_thread_; }
   rtc::Thread* worker_thread() const final { return factory_->worker_thread(); }
   rtc::Thread* signaling_thread() const final {
     return factory_->signaling_thread();
@@ -1205,6 +1206,7 @@ class PeerConnection : public PeerConnectionInternal,
   // PeerConnectionFactoryInterface all instances created using the raw pointer
   // will refer to the same reference count.
   const rtc::scoped_refptr<PeerConnectionFactory> factory_;
+  rtc::Thread* const network_thread_;
   PeerConnectionObserver* observer_ RTC_GUARDED_BY(signaling_thread()) =
       nullptr;
 
@@ -1307,6 +1309,10 @@ class PeerConnection : public PeerConnectionInternal,
 
   rtc::AsyncInvoker rtcp_invoker_ RTC_GUARDED_BY(network_thread());
 
+  // Used by the signaling thread to post work to the network thread that it
+  // doesn't need to wait for.
+  rtc::AsyncInvoker network_invoker_;
+
   // Points to the same thing as `call_`. Since it's const, we may read the
   // pointer from any thread.
   Call* const call_ptr_;
@@ -94,7 +94,7 @@ class PeerConnectionFactoryForDataChannelTest
                 std::make_unique<FakeMediaTransportFactory>())) {}
 
   std::unique_ptr<cricket::SctpTransportInternalFactory>
-  CreateSctpTransportInternalFactory() {
+  CreateSctpTransportInternalFactory(rtc::Thread* network_thread) {
     auto factory = std::make_unique<FakeSctpTransportFactory>();
     last_fake_sctp_transport_factory_ = factory.get();
     return factory;
@@ -21,6 +21,7 @@
 #include "api/peer_connection_factory_proxy.h"
 #include "api/peer_connection_proxy.h"
 #include "api/rtc_event_log/rtc_event_log.h"
+#include "api/stats/rtcstats_objects.h"
 #include "api/transport/media/media_transport_interface.h"
 #include "api/turn_customizer.h"
 #include "api/units/data_rate.h"
@@ -40,7 +41,9 @@
 #include "rtc_base/experiments/field_trial_parser.h"
 #include "rtc_base/experiments/field_trial_units.h"
 #include "rtc_base/numerics/safe_conversions.h"
+#include "rtc_base/string_encode.h"
 #include "rtc_base/system/file_wrapper.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
@@ -80,7 +83,9 @@ PeerConnectionFactory::PeerConnectionFactory(
       injected_network_controller_factory_(
           std::move(dependencies.network_controller_factory)),
       media_transport_factory_(
-          std::move(dependencies.media_transport_factory)) {
+          std::move(dependencies.media_transport_factory)),
+      certificate_pool_(std::move(dependencies.certificate_pool)),
+      thread_cpu_baseline_(rtc::GetThreadCpuUsage()) {
   if (!network_thread_) {
     owned_network_thread_ = rtc::Thread::CreateWithSocketServer();
     owned_network_thread_->SetName("pc_network_thread", nullptr);
@@ -88,6 +93,11 @@ PeerConnectionFactory::PeerConnectionFactory(
     network_thread_ = owned_network_thread_.get();
   }
 
+  for (rtc::Thread* thread : dependencies.additional_network_threads) {
+    RTC_DCHECK(thread);
+    additional_network_threads_.emplace_back(thread);
+  }
+
   if (!worker_thread_) {
     owned_worker_thread_ = rtc::Thread::Create();
     owned_worker_thread_->SetName("pc_worker_thread", nullptr);
@@ -114,11 +124,21 @@ PeerConnectionFactory::~PeerConnectionFactory() {
   // |default_socket_factory_| and |default_network_manager_|.
   default_socket_factory_ = nullptr;
   default_network_manager_ = nullptr;
+  additional_network_threads_.clear();
 
   if (wraps_current_thread_)
     rtc::ThreadManager::Instance()->UnwrapCurrentThread();
 }
 
+PeerConnectionFactory::NetworkThreadContext::NetworkThreadContext(
+    rtc::Thread* thread)
+    : thread(thread) {}
+
+PeerConnectionFactory::NetworkThreadContext::NetworkThreadContext(
+    NetworkThreadContext&&) = default;
+
+PeerConnectionFactory::NetworkThreadContext::~NetworkThreadContext() = default;
+
 bool PeerConnectionFactory::Initialize() {
   RTC_DCHECK(signaling_thread_->IsCurrent());
   rtc::InitRandom(rtc::Time32());
@@ -134,6 +154,12 @@ bool PeerConnectionFactory::Initialize() {
     return false;
   }
 
+  for (NetworkThreadContext& context : additional_network_threads_) {
+    context.network_manager.reset(new rtc::BasicNetworkManager());
+    context.socket_factory.reset(
+        new rtc::BasicPacketSocketFactory(context.thread));
+  }
+
   channel_manager_ = std::make_unique<cricket::ChannelManager>(
       std::move(media_engine_), std::make_unique<cricket::RtpDataEngine>(),
       worker_thread_, network_thread_);
@@ -222,6 +248,30 @@ void PeerConnectionFactory::StopAecDump() {
   channel_manager_->StopAecDump();
 }
 
+rtc::scoped_refptr<const RTCStatsReport>
+PeerConnectionFactory::GetThreadCpuStats() {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  int64_t timestamp_us = rtc::TimeMicros();
+  rtc::scoped_refptr<RTCStatsReport> report =
+      RTCStatsReport::Create(timestamp_us);
+  for (const rtc::ThreadCpuUsage& thread :
+       rtc::GetThreadCpuUsageSince(thread_cpu_baseline_)) {
+    bool exited = thread.id == 0;
+    std::unique_ptr<RTCThreadCpuStats> stats(new RTCThreadCpuStats(
+        "RTCThread_" + thread.thread_name + "_" +
+            (exited ? std::string("exited") : rtc::ToString(thread.id)),
+        timestamp_us));
+    stats->thread_name = thread.thread_name;
+    if (!exited)
+      stats->thread_id = static_cast<uint64_t>(thread.thread_id);
+    stats->exited = exited;
+    stats->cpu_time = static_cast<double>(thread.cpu_time_ns) /
+                      rtc::kNumNanosecsPerSec;
+    report->AddStats(std::move(stats));
+  }
+  return report;
+}
+
 rtc::scoped_refptr<PeerConnectionInterface>
 PeerConnectionFactory::CreatePeerConnection(
     const PeerConnectionInterface::RTCConfiguration& configuration,
@@ -245,24 +295,41 @@ PeerConnectionFactory::CreatePeerConnection(
       << "You can't set both allocator and packet_socket_factory; "
          "the former is going away (see bugs.webrtc.org/7447";
 
+  // Pick the network thread. Injected allocators and socket factories are
+  // tied to |network_thread_|, so only PeerConnections using the defaults
+  // are spread over the additional network threads.
+  rtc::Thread* network_thread = network_thread_;
+  rtc::BasicNetworkManager* network_manager = default_network_manager_.get();
+  rtc::PacketSocketFactory* packet_socket_factory =
+      default_socket_factory_.get();
+  if (!dependencies.allocator && !dependencies.packet_socket_factory &&
+      !additional_network_threads_.empty()) {
+    size_t index =
+        next_network_thread_++ % (additional_network_threads_.size() + 1);
+    if (index > 0) {
+      const NetworkThreadContext& context =
+          additional_network_threads_[index - 1];
+      network_thread = context.thread;
+      network_manager = context.network_manager.get();
+      packet_socket_factory = context.socket_factory.get();
+    }
+  }
+
   // Set internal defaults if optional dependencies are not set.
   if (!dependencies.cert_generator) {
     dependencies.cert_generator =
-        std::make_unique<rtc::RTCCertificateGenerator>(signaling_thread_,
-                                                       network_thread_);
+        std::make_unique<rtc::RTCCertificateGenerator>(
+            signaling_thread_, network_thread_, certificate_pool_);
   }
   if (!dependencies.allocator) {
-    rtc::PacketSocketFactory* packet_socket_factory;
     if (dependencies.packet_socket_factory)
       packet_socket_factory = dependencies.packet_socket_factory.get();
-    else
-      packet_socket_factory = default_socket_factory_.get();
 
-    network_thread_->Invoke<void>(RTC_FROM_HERE, [this, &configuration,
-                                                  &dependencies,
-                                                  &packet_socket_factory]() {
+    network_thread->Invoke<void>(RTC_FROM_HERE, [&configuration, &dependencies,
+                                                 network_manager,
+                                                 packet_socket_factory]() {
       dependencies.allocator = std::make_unique<cricket::BasicPortAllocator>(
-          default_network_manager_.get(), packet_socket_factory,
+          network_manager, packet_socket_factory,
           configuration.turn_customizer);
     });
   }
@@ -271,7 +338,7 @@ PeerConnectionFactory::CreatePeerConnection(
   // |dependencies.async_resolver_factory| to a new
   // |rtc::BasicAsyncResolverFactory| if no factory is provided.
 
-  network_thread_->Invoke<void>(
+  network_thread->Invoke<void>(
       RTC_FROM_HERE,
       rtc::Bind(&cricket::PortAllocator::SetNetworkIgnoreMask,
                 dependencies.allocator.get(), options_.network_ignore_mask));
@@ -286,8 +353,8 @@ PeerConnectionFactory::CreatePeerConnection(
       rtc::Bind(&PeerConnectionFactory::CreateCall_w, this, event_log.get()));
 
   rtc::scoped_refptr<PeerConnection> pc(
-      new rtc::RefCountedObject<PeerConnection>(this, std::move(event_log),
-                                                std::move(call)));
+      new rtc::RefCountedObject<PeerConnection>(
+          this, network_thread, std::move(event_log), std::move(call)));
   ActionsBeforeInitializeForTesting(pc);
   if (!pc->Initialize(configuration, std::move(dependencies))) {
     return nullptr;
@@ -320,9 +387,10 @@ rtc::scoped_refptr<AudioTrackInterface> PeerConnectionFactory::CreateAudioTrack(
 }
 
 std::unique_ptr<cricket::SctpTransportInternalFactory>
-PeerConnectionFactory::CreateSctpTransportInternalFactory() {
+PeerConnectionFactory::CreateSctpTransportInternalFactory(
+    rtc::Thread* network_thread) {
 #ifdef HAVE_SCTP
-  return std::make_unique<cricket::SctpTransportFactory>(network_thread());
+  return std::make_unique<cricket::SctpTransportFactory>(network_thread);
 #else
   return nullptr;
 #endif
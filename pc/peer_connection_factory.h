@@ -12,8 +12,11 @@
 #ifndef PC_PEER_CONNECTION_FACTORY_H_
 #define PC_PEER_CONNECTION_FACTORY_H_
 
+#include <stddef.h>
+
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "api/media_stream_interface.h"
 #include "api/peer_connection_interface.h"
@@ -23,6 +26,7 @@
 #include "pc/channel_manager.h"
 #include "rtc_base/rtc_certificate_generator.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/thread_cpu_usage.h"
 
 namespace rtc {
 class BasicNetworkManager;
@@ -72,8 +76,10 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   bool StartAecDump(FILE* file, int64_t max_size_bytes) override;
   void StopAecDump() override;
 
+  rtc::scoped_refptr<const RTCStatsReport> GetThreadCpuStats() override;
+
   virtual std::unique_ptr<cricket::SctpTransportInternalFactory>
-  CreateSctpTransportInternalFactory();
+  CreateSctpTransportInternalFactory(rtc::Thread* network_thread);
 
   virtual cricket::ChannelManager* channel_manager();
 
@@ -104,6 +110,18 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   virtual ~PeerConnectionFactory();
 
  private:
+  // A network thread besides |network_thread_|, with the network manager and
+  // socket factory used by the PeerConnections pinned to it.
+  struct NetworkThreadContext {
+    explicit NetworkThreadContext(rtc::Thread* thread);
+    NetworkThreadContext(NetworkThreadContext&&);
+    ~NetworkThreadContext();
+
+    rtc::Thread* thread;
+    std::unique_ptr<rtc::BasicNetworkManager> network_manager;
+    std::unique_ptr<rtc::BasicPacketSocketFactory> socket_factory;
+  };
+
   std::unique_ptr<RtcEventLog> CreateRtcEventLog_w();
   std::unique_ptr<Call> CreateCall_w(RtcEventLog* event_log);
 
@@ -118,6 +136,10 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   std::unique_ptr<cricket::ChannelManager> channel_manager_;
   std::unique_ptr<rtc::BasicNetworkManager> default_network_manager_;
   std::unique_ptr<rtc::BasicPacketSocketFactory> default_socket_factory_;
+  std::vector<NetworkThreadContext> additional_network_threads_;
+  // Round-robin position over |network_thread_| and
+  // |additional_network_threads_|.
+  size_t next_network_thread_ = 0;
   std::unique_ptr<cricket::MediaEngineInterface> media_engine_;
   std::unique_ptr<webrtc::CallFactoryInterface> call_factory_;
   std::unique_ptr<RtcEventLogFactoryInterface> event_log_factory_;
@@ -127,6 +149,9 @@ class PeerConnectionFactory : public PeerConnectionFactoryInterface {
   std::unique_ptr<NetworkControllerFactoryInterface>
       injected_network_controller_factory_;
   std::unique_ptr<MediaTransportFactory> media_transport_factory_;
+  const rtc::scoped_refptr<rtc::RTCCertificatePool> certificate_pool_;
+  // CPU time of the threads when the factory was created.
+  const std::vector<rtc::ThreadCpuUsage> thread_cpu_baseline_;
 };
 
 }  // namespace webrtc
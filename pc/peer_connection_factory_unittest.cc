@@ -22,22 +22,30 @@
 #include "api/audio_codecs/audio_encoder_factory.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
 #include "api/audio_codecs/builtin_audio_encoder_factory.h"
+#include "api/call/call_factory_interface.h"
 #include "api/create_peerconnection_factory.h"
 #include "api/data_channel_interface.h"
 #include "api/jsep.h"
 #include "api/media_stream_interface.h"
+#include "api/peer_connection_proxy.h"
+#include "api/stats/rtcstats_objects.h"
+#include "api/task_queue/default_task_queue_factory.h"
 #include "api/video_codecs/builtin_video_decoder_factory.h"
 #include "api/video_codecs/builtin_video_encoder_factory.h"
 #include "api/video_codecs/video_decoder_factory.h"
 #include "api/video_codecs/video_encoder_factory.h"
 #include "media/base/fake_frame_source.h"
+#include "media/base/fake_media_engine.h"
 #include "modules/audio_device/include/audio_device.h"
 #include "modules/audio_processing/include/audio_processing.h"
 #include "p2p/base/fake_port_allocator.h"
 #include "p2p/base/port.h"
 #include "p2p/base/port_interface.h"
+#include "pc/peer_connection.h"
 #include "pc/test/fake_audio_capture_module.h"
 #include "pc/test/fake_video_track_source.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
 #include "rtc_base/socket_address.h"
 #include "test/gtest.h"
 
@@ -199,6 +207,100 @@ TEST(PeerConnectionFactoryTestInternal, DISABLED_CreatePCUsingInternalModules) {
   EXPECT_TRUE(pc.get() != nullptr);
 }
 
+// PeerConnections that use the factory's own port allocator are spread
+// round-robin over the default and the additional network threads.
+TEST(PeerConnectionFactoryTestInternal,
+     SpreadsPeerConnectionsOverNetworkThreads) {
+#ifdef WEBRTC_ANDROID
+  webrtc::InitializeAndroidObjects();
+#endif
+  std::unique_ptr<rtc::Thread> extra_network_thread =
+      rtc::Thread::CreateWithSocketServer();
+  extra_network_thread->Start();
+
+  webrtc::PeerConnectionFactoryDependencies dependencies;
+  dependencies.network_thread = rtc::Thread::Current();
+  dependencies.worker_thread = rtc::Thread::Current();
+  dependencies.signaling_thread = rtc::Thread::Current();
+  dependencies.additional_network_threads.push_back(
+      extra_network_thread.get());
+  dependencies.task_queue_factory = webrtc::CreateDefaultTaskQueueFactory();
+  dependencies.media_engine = std::make_unique<cricket::FakeMediaEngine>();
+  dependencies.call_factory = webrtc::CreateCallFactory();
+  rtc::scoped_refptr<PeerConnectionFactoryInterface> factory =
+      webrtc::CreateModularPeerConnectionFactory(std::move(dependencies));
+  ASSERT_TRUE(factory);
+
+  NullPeerConnectionObserver observer;
+  webrtc::PeerConnectionInterface::RTCConfiguration config;
+  std::vector<rtc::scoped_refptr<PeerConnectionInterface>> pcs;
+  std::vector<rtc::Thread*> network_threads;
+  for (int i = 0; i < 3; ++i) {
+    rtc::scoped_refptr<PeerConnectionInterface> pc =
+        factory->CreatePeerConnection(
+            config, nullptr,
+            std::make_unique<FakeRTCCertificateGenerator>(), &observer);
+    ASSERT_TRUE(pc);
+    auto* pc_proxy = static_cast<
+        webrtc::PeerConnectionProxyWithInternal<PeerConnectionInterface>*>(
+        pc.get());
+    network_threads.push_back(
+        static_cast<webrtc::PeerConnection*>(pc_proxy->internal())
+            ->network_thread());
+    pcs.push_back(pc);
+  }
+  EXPECT_EQ(rtc::Thread::Current(), network_threads[0]);
+  EXPECT_EQ(extra_network_thread.get(), network_threads[1]);
+  EXPECT_EQ(rtc::Thread::Current(), network_threads[2]);
+
+  for (auto& pc : pcs) {
+    pc->Close();
+  }
+}
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_MAC) || defined(WEBRTC_WIN)
+TEST_F(PeerConnectionFactoryTest, GetThreadCpuStats) {
+  struct Events {
+    rtc::Event started;
+    rtc::Event release;
+  } events;
+  rtc::PlatformThread thread(
+      [](void* obj) {
+        Events* events = static_cast<Events*>(obj);
+        events->started.Set();
+        events->release.Wait(rtc::Event::kForever);
+      },
+      &events, "StatsTestThread");
+  thread.Start();
+  events.started.Wait(rtc::Event::kForever);
+
+  rtc::scoped_refptr<const webrtc::RTCStatsReport> report =
+      factory_->GetThreadCpuStats();
+  ASSERT_TRUE(report);
+  const webrtc::RTCThreadCpuStats* thread_stats = nullptr;
+  for (const webrtc::RTCThreadCpuStats* stats :
+       report->GetStatsOfType<webrtc::RTCThreadCpuStats>()) {
+    if (*stats->thread_name == "StatsTestThread") {
+      thread_stats = stats;
+    }
+  }
+  ASSERT_TRUE(thread_stats);
+  EXPECT_FALSE(*thread_stats->exited);
+  EXPECT_TRUE(thread_stats->thread_id.is_defined());
+  EXPECT_GE(*thread_stats->cpu_time, 0.0);
+
+  events.release.Set();
+  thread.Stop();
+  report = factory_->GetThreadCpuStats();
+  for (const webrtc::RTCThreadCpuStats* stats :
+       report->GetStatsOfType<webrtc::RTCThreadCpuStats>()) {
+    if (*stats->thread_name == "StatsTestThread") {
+      EXPECT_TRUE(*stats->exited);
+    }
+  }
+}
+#endif
+
 TEST_F(PeerConnectionFactoryTest, CheckRtpSenderAudioCapabilities) {
   webrtc::RtpCapabilities audio_capabilities =
       factory_->GetRtpSenderCapabilities(cricket::MEDIA_TYPE_AUDIO);
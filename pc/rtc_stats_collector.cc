@@ -993,18 +993,15 @@ void RTCStatsCollector::GetStatsReportInternal(
 
     // Prepare |transceiver_stats_infos_| for use in
     // |ProducePartialResultsOnNetworkThread| and
-    // |ProducePartialResultsOnSignalingThread|.
+    // |ProducePartialResultsOnSignalingThread|. This also prepares
+    // |call_stats_|, in the same hop to the worker thread.
+    // TODO(holmer): To avoid the hop for |call_stats_| we could move BWE and
+    // BWE stats to the network thread, where it more naturally belongs.
     transceiver_stats_infos_ = PrepareTransceiverStatsInfos_s();
     // Prepare |transport_names_| for use in
     // |ProducePartialResultsOnNetworkThread|.
     transport_names_ = PrepareTransportNames_s();
 
-    // Prepare |call_stats_| here since GetCallStats() will hop to the worker
-    // thread.
-    // TODO(holmer): To avoid the hop we could move BWE and BWE stats to the
-    // network thread, where it more naturally belongs.
-    call_stats_ = pc_->GetCallStats();
-
     // Don't touch |network_report_| on the signaling thread until
     // ProducePartialResultsOnNetworkThread() has signaled the
     // |network_report_event_|.
@@ -1747,7 +1744,7 @@ RTCStatsCollector::PrepareTransportCertificateStats_n(
 }
 
 std::vector<RTCStatsCollector::RtpTransceiverStatsInfo>
-RTCStatsCollector::PrepareTransceiverStatsInfos_s() const {
+RTCStatsCollector::PrepareTransceiverStatsInfos_s() {
   std::vector<RtpTransceiverStatsInfo> transceiver_stats_infos;
 
   // These are used to invoke GetStats for all the media channels together in
@@ -1796,8 +1793,9 @@ RTCStatsCollector::PrepareTransceiverStatsInfos_s() const {
   }
 
   // Call GetStats for all media channels together on the worker thread in one
-  // hop.
+  // hop, along with GetCallStats().
   worker_thread_->Invoke<void>(RTC_FROM_HERE, [&] {
+    call_stats_ = pc_->GetCallStats();
     for (const auto& entry : voice_stats) {
       if (!entry.first->GetStats(entry.second.get())) {
         RTC_LOG(LS_WARNING) << "Failed to get voice stats.";
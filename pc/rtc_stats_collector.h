@@ -215,7 +215,8 @@ class RTCStatsCollector : public virtual rtc::RefCountInterface,
   PrepareTransportCertificateStats_n(
       const std::map<std::string, cricket::TransportStats>&
           transport_stats_by_name) const;
-  std::vector<RtpTransceiverStatsInfo> PrepareTransceiverStatsInfos_s() const;
+  // Also prepares |call_stats_|.
+  std::vector<RtpTransceiverStatsInfo> PrepareTransceiverStatsInfos_s();
   std::set<std::string> PrepareTransportNames_s() const;
 
   // Stats gathering on a particular thread.
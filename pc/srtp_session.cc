@@ -139,22 +139,80 @@ bool SrtpSession::UnprotectRtp(void* p, int in_len, int* out_len) {
   *out_len = in_len;
   int err = srtp_unprotect(session_, p, out_len);
   if (err != srtp_err_status_ok) {
-    // Limit the error logging to avoid excessive logs when there are lots of
-    // bad packets.
-    const int kFailureLogThrottleCount = 100;
-    if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
-      RTC_LOG(LS_WARNING) << "Failed to unprotect SRTP packet, err=" << err
-                          << ", previous failure count: "
-                          << decryption_failure_count_;
-    }
-    ++decryption_failure_count_;
-    RTC_HISTOGRAM_ENUMERATION("WebRTC.PeerConnection.SrtpUnprotectError",
-                              static_cast<int>(err), kSrtpErrorCodeBoundary);
+    OnUnprotectRtpError(err);
     return false;
   }
   return true;
 }
 
+size_t SrtpSession::ProtectRtpBatch(rtc::ArrayView<Packet> packets) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  if (!session_) {
+    RTC_LOG(LS_WARNING) << "Failed to protect " << packets.size()
+                        << " SRTP packets: no SRTP Session";
+    for (Packet& packet : packets) {
+      packet.ok = false;
+    }
+    return 0;
+  }
+
+  size_t protected_count = 0;
+  const Packet* last_protected = nullptr;
+  for (Packet& packet : packets) {
+    const int in_len = packet.len;
+    packet.ok = false;
+    if (packet.max_len < in_len + rtp_auth_tag_len_) {
+      RTC_LOG(LS_WARNING) << "Failed to protect SRTP packet: The buffer length "
+                          << packet.max_len << " is less than the needed "
+                          << in_len + rtp_auth_tag_len_;
+      continue;
+    }
+    int err = srtp_protect(session_, packet.data, &packet.len);
+    if (err != srtp_err_status_ok) {
+      int seq_num;
+      GetRtpSeqNum(packet.data, in_len, &seq_num);
+      RTC_LOG(LS_WARNING) << "Failed to protect SRTP packet, seqnum="
+                          << seq_num << ", err=" << err
+                          << ", last seqnum=" << last_send_seq_num_;
+      packet.len = in_len;
+      continue;
+    }
+    packet.ok = true;
+    last_protected = &packet;
+    ++protected_count;
+  }
+  // Only the last sequence number is kept, so it is only read once.
+  if (last_protected) {
+    GetRtpSeqNum(last_protected->data, last_protected->len,
+                 &last_send_seq_num_);
+  }
+  return protected_count;
+}
+
+size_t SrtpSession::UnprotectRtpBatch(rtc::ArrayView<Packet> packets) {
+  RTC_DCHECK(thread_checker_.IsCurrent());
+  if (!session_) {
+    RTC_LOG(LS_WARNING) << "Failed to unprotect " << packets.size()
+                        << " SRTP packets: no SRTP Session";
+    for (Packet& packet : packets) {
+      packet.ok = false;
+    }
+    return 0;
+  }
+
+  size_t unprotected_count = 0;
+  for (Packet& packet : packets) {
+    int err = srtp_unprotect(session_, packet.data, &packet.len);
+    packet.ok = err == srtp_err_status_ok;
+    if (!packet.ok) {
+      OnUnprotectRtpError(err);
+      continue;
+    }
+    ++unprotected_count;
+  }
+  return unprotected_count;
+}
+
 bool SrtpSession::UnprotectRtcp(void* p, int in_len, int* out_len) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   if (!session_) {
@@ -173,6 +231,20 @@ bool SrtpSession::UnprotectRtcp(void* p, int in_len, int* out_len) {
   return true;
 }
 
+void SrtpSession::OnUnprotectRtpError(int err) {
+  // Limit the error logging to avoid excessive logs when there are lots of
+  // bad packets.
+  const int kFailureLogThrottleCount = 100;
+  if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
+    RTC_LOG(LS_WARNING) << "Failed to unprotect SRTP packet, err=" << err
+                        << ", previous failure count: "
+                        << decryption_failure_count_;
+  }
+  ++decryption_failure_count_;
+  RTC_HISTOGRAM_ENUMERATION("WebRTC.PeerConnection.SrtpUnprotectError",
+                            static_cast<int>(err), kSrtpErrorCodeBoundary);
+}
+
 bool SrtpSession::GetRtpAuthParams(uint8_t** key, int* key_len, int* tag_len) {
   RTC_DCHECK(thread_checker_.IsCurrent());
   RTC_DCHECK(IsExternalAuthActive());
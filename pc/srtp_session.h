@@ -13,6 +13,7 @@
 
 #include <vector>
 
+#include "api/array_view.h"
 #include "api/scoped_refptr.h"
 #include "rtc_base/thread_checker.h"
 
@@ -25,6 +26,17 @@ namespace cricket {
 // Class that wraps a libSRTP session.
 class SrtpSession {
  public:
+  // A packet of a batch, protected or unprotected in-place.
+  struct Packet {
+    void* data = nullptr;
+    // Length of the packet; updated to the length of the result.
+    int len = 0;
+    // Size of the buffer at |data|. Only used for protection.
+    int max_len = 0;
+    // Set to whether the packet was processed successfully.
+    bool ok = false;
+  };
+
   SrtpSession();
   ~SrtpSession();
 
@@ -65,6 +77,13 @@ class SrtpSession {
   bool UnprotectRtp(void* data, int in_len, int* out_len);
   bool UnprotectRtcp(void* data, int in_len, int* out_len);
 
+  // Encrypts/signs or decrypts/verifies a burst of RTP packets, in order, like
+  // the single packet methods but with the per-call checks and bookkeeping
+  // done once for the burst. A failed packet does not stop the others.
+  // Returns the number of packets processed successfully.
+  size_t ProtectRtpBatch(rtc::ArrayView<Packet> packets);
+  size_t UnprotectRtpBatch(rtc::ArrayView<Packet> packets);
+
   // Helper method to get authentication params.
   bool GetRtpAuthParams(uint8_t** key, int* key_len, int* tag_len);
 
@@ -110,6 +129,9 @@ class SrtpSession {
   static bool IncrementLibsrtpUsageCountAndMaybeInit();
   static void DecrementLibsrtpUsageCountAndMaybeDeinit();
 
+  // Logs and counts an srtp_unprotect() failure.
+  void OnUnprotectRtpError(int err);
+
   void HandleEvent(const srtp_event_data_t* ev);
   static void HandleEventThunk(srtp_event_data_t* ev);
 
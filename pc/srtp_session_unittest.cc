@@ -12,12 +12,18 @@
 
 #include <string.h>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "media/base/fake_rtp.h"
 #include "pc/test/srtp_test_util.h"
+#include "rtc_base/buffer.h"
 #include "rtc_base/byte_order.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/ssl_stream_adapter.h"  // For rtc::SRTP_*
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/metrics.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
@@ -247,4 +253,130 @@ TEST_F(SrtpSessionTest, TestReplay) {
       s1_.ProtectRtp(rtp_packet_, rtp_len_, sizeof(rtp_packet_), &out_len));
 }
 
+TEST_F(SrtpSessionTest, TestProtectUnprotectBatch) {
+  static const int kNumPackets = 8;
+  EXPECT_TRUE(s1_.SetSend(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+  EXPECT_TRUE(s2_.SetRecv(SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen,
+                          kEncryptedHeaderExtensionIds));
+
+  std::vector<Buffer> buffers;
+  std::vector<cricket::SrtpSession::Packet> packets(kNumPackets);
+  for (int i = 0; i < kNumPackets; ++i) {
+    buffers.emplace_back(sizeof(kPcmuFrame) + 10);
+    memcpy(buffers[i].data(), kPcmuFrame, sizeof(kPcmuFrame));
+    SetBE16(buffers[i].data() + 2, 100 + i);
+    packets[i].data = buffers[i].data();
+    packets[i].len = rtp_len_;
+    packets[i].max_len = rtc::checked_cast<int>(buffers[i].size());
+  }
+  // Too small for the auth tag.
+  packets[3].max_len = rtp_len_;
+
+  EXPECT_EQ(static_cast<size_t>(kNumPackets - 1), s1_.ProtectRtpBatch(packets));
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(i != 3, packets[i].ok);
+    EXPECT_EQ(i != 3 ? rtp_len_ + 10 : rtp_len_, packets[i].len);
+  }
+
+  // Tamper with one packet.
+  buffers[5][rtp_len_] ^= 0x01;
+  EXPECT_EQ(static_cast<size_t>(kNumPackets - 2),
+            s2_.UnprotectRtpBatch(packets));
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(i != 3 && i != 5, packets[i].ok);
+    if (packets[i].ok) {
+      EXPECT_EQ(rtp_len_, packets[i].len);
+      EXPECT_EQ(0, memcmp(buffers[i].data() + 4, kPcmuFrame + 4,
+                          rtp_len_ - 4));
+    }
+  }
+}
+
+TEST_F(SrtpSessionTest, TestBatchWithoutSession) {
+  cricket::SrtpSession::Packet packet;
+  packet.data = rtp_packet_;
+  packet.len = rtp_len_;
+  packet.max_len = sizeof(rtp_packet_);
+  rtc::ArrayView<cricket::SrtpSession::Packet> packets(&packet, 1);
+  EXPECT_EQ(0u, s1_.ProtectRtpBatch(packets));
+  EXPECT_FALSE(packet.ok);
+}
+
+// Compares the packet rate of ProtectRtp()/UnprotectRtp() and of the batch
+// calls for every supported crypto suite.
+TEST(SrtpSessionBenchmark, DISABLED_ProtectUnprotectThroughput) {
+  static const int kNumPackets = 100000;
+  static const int kBatchSize = 64;
+  static const int kPayloadSize = 1200;
+  static const int kHeaderSize = 12;
+  const int kSuites[] = {SRTP_AES128_CM_SHA1_80, SRTP_AES128_CM_SHA1_32,
+                         SRTP_AEAD_AES_128_GCM, SRTP_AEAD_AES_256_GCM};
+  for (int suite : kSuites) {
+    int key_len;
+    int salt_len;
+    ASSERT_TRUE(GetSrtpKeyAndSaltLengths(suite, &key_len, &salt_len));
+    Buffer key(key_len + salt_len);
+    for (size_t i = 0; i < key.size(); ++i)
+      key[i] = static_cast<uint8_t>(i);
+
+    for (bool batch : {false, true}) {
+      cricket::SrtpSession sender;
+      cricket::SrtpSession receiver;
+      ASSERT_TRUE(sender.SetSend(suite, key.data(), key.size(),
+                                 kEncryptedHeaderExtensionIds));
+      ASSERT_TRUE(receiver.SetRecv(suite, key.data(), key.size(),
+                                   kEncryptedHeaderExtensionIds));
+      std::vector<Buffer> buffers;
+      std::vector<cricket::SrtpSession::Packet> packets(kBatchSize);
+      for (int i = 0; i < kBatchSize; ++i) {
+        buffers.emplace_back(kHeaderSize + kPayloadSize + 16);
+        memcpy(buffers[i].data(), kPcmuFrame, kHeaderSize);
+        packets[i].data = buffers[i].data();
+        packets[i].max_len = rtc::checked_cast<int>(buffers[i].size());
+      }
+
+      int64_t protect_us = 0;
+      int64_t unprotect_us = 0;
+      uint16_t seq_num = 0;
+      for (int sent = 0; sent < kNumPackets; sent += kBatchSize) {
+        for (int i = 0; i < kBatchSize; ++i) {
+          SetBE16(buffers[i].data() + 2, seq_num++);
+          packets[i].len = kHeaderSize + kPayloadSize;
+        }
+        int64_t start_us = TimeMicros();
+        if (batch) {
+          ASSERT_EQ(static_cast<size_t>(kBatchSize),
+                    sender.ProtectRtpBatch(packets));
+        } else {
+          for (auto& packet : packets) {
+            ASSERT_TRUE(sender.ProtectRtp(packet.data, packet.len,
+                                          packet.max_len, &packet.len));
+          }
+        }
+        int64_t protected_us = TimeMicros();
+        if (batch) {
+          ASSERT_EQ(static_cast<size_t>(kBatchSize),
+                    receiver.UnprotectRtpBatch(packets));
+        } else {
+          for (auto& packet : packets) {
+            ASSERT_TRUE(
+                receiver.UnprotectRtp(packet.data, packet.len, &packet.len));
+          }
+        }
+        protect_us += protected_us - start_us;
+        unprotect_us += TimeMicros() - protected_us;
+      }
+      RTC_LOG(LS_INFO) << SrtpCryptoSuiteToName(suite)
+                       << (batch ? " batch" : " single") << ": protect "
+                       << kNumPackets * kNumMicrosecsPerSec /
+                              std::max<int64_t>(protect_us, 1)
+                       << " packets/s, unprotect "
+                       << kNumPackets * kNumMicrosecsPerSec /
+                              std::max<int64_t>(unprotect_us, 1)
+                       << " packets/s";
+    }
+  }
+}
+
 }  // namespace rtc
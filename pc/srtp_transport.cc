@@ -23,16 +23,29 @@
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/copy_on_write_buffer.h"
+#include "rtc_base/location.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/ssl_stream_adapter.h"
 #include "rtc_base/third_party/base64/base64.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
 #include "rtc_base/trace_event.h"
 #include "rtc_base/zero_memory.h"
 
 namespace webrtc {
 
+namespace {
+
+// Maximum number of packets queued per direction in batching mode before the
+// batch is processed without waiting for the end of the message loop
+// iteration.
+const size_t kMaxBatchSize = 64;
+
+enum { MSG_FLUSH_BATCHES };
+
+}  // namespace
+
 SrtpTransport::SrtpTransport(bool rtcp_mux_enabled)
     : RtpTransport(rtcp_mux_enabled) {}
 
@@ -124,6 +137,21 @@ bool SrtpTransport::SendRtpPacket(rtc::CopyOnWriteBuffer* packet,
         << "Failed to send the packet because SRTP transport is inactive.";
     return false;
   }
+  if (batching_enabled_ && !IsExternalAuthActive()) {
+    PendingRtpPacket pending;
+    pending.packet = *packet;
+    pending.options = options;
+    pending.flags = flags;
+    pending_sends_.push_back(std::move(pending));
+    if (pending_sends_.size() >= kMaxBatchSize) {
+      FlushPendingSends();
+    } else {
+      PostFlush();
+    }
+    return true;
+  }
+  FlushPendingSends();
+
   rtc::PacketOptions updated_options = options;
   TRACE_EVENT0("webrtc", "SRTP Encode");
   bool res;
@@ -160,12 +188,7 @@ bool SrtpTransport::SendRtpPacket(rtc::CopyOnWriteBuffer* packet,
   }
 #endif
   if (!res) {
-    int seq_num = -1;
-    uint32_t ssrc = 0;
-    cricket::GetRtpSeqNum(data, len, &seq_num);
-    cricket::GetRtpSsrc(data, len, &ssrc);
-    RTC_LOG(LS_ERROR) << "Failed to protect RTP packet: size=" << len
-                      << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
+    OnProtectRtpFailure(data, len);
     return false;
   }
 
@@ -182,6 +205,7 @@ bool SrtpTransport::SendRtcpPacket(rtc::CopyOnWriteBuffer* packet,
         << "Failed to send the packet because SRTP transport is inactive.";
     return false;
   }
+  FlushPendingSends();
 
   TRACE_EVENT0("webrtc", "SRTP Encode");
   uint8_t* data = packet->data();
@@ -206,25 +230,23 @@ void SrtpTransport::OnRtpPacketReceived(rtc::CopyOnWriteBuffer packet,
         << "Inactive SRTP transport received an RTP packet. Drop it.";
     return;
   }
+  if (batching_enabled_) {
+    PendingRtpPacket pending;
+    pending.packet = std::move(packet);
+    pending.packet_time_us = packet_time_us;
+    pending_receives_.push_back(std::move(pending));
+    if (pending_receives_.size() >= kMaxBatchSize) {
+      FlushPendingReceives();
+    } else {
+      PostFlush();
+    }
+    return;
+  }
   TRACE_EVENT0("webrtc", "SRTP Decode");
   char* data = packet.data<char>();
   int len = rtc::checked_cast<int>(packet.size());
   if (!UnprotectRtp(data, len, &len)) {
-    int seq_num = -1;
-    uint32_t ssrc = 0;
-    cricket::GetRtpSeqNum(data, len, &seq_num);
-    cricket::GetRtpSsrc(data, len, &ssrc);
-
-    // Limit the error logging to avoid excessive logs when there are lots of
-    // bad packets.
-    const int kFailureLogThrottleCount = 100;
-    if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
-      RTC_LOG(LS_ERROR) << "Failed to unprotect RTP packet: size=" << len
-                        << ", seqnum=" << seq_num << ", SSRC=" << ssrc
-                        << ", previous failure count: "
-                        << decryption_failure_count_;
-    }
-    ++decryption_failure_count_;
+    OnUnprotectRtpFailure(data, len);
     return;
   }
   packet.SetSize(len);
@@ -238,6 +260,7 @@ void SrtpTransport::OnRtcpPacketReceived(rtc::CopyOnWriteBuffer packet,
         << "Inactive SRTP transport received an RTCP packet. Drop it.";
     return;
   }
+  FlushPendingReceives();
   TRACE_EVENT0("webrtc", "SRTP Decode");
   char* data = packet.data<char>();
   int len = rtc::checked_cast<int>(packet.size());
@@ -252,6 +275,139 @@ void SrtpTransport::OnRtcpPacketReceived(rtc::CopyOnWriteBuffer packet,
   SignalRtcpPacketReceived(&packet, packet_time_us);
 }
 
+void SrtpTransport::SetBatchingEnabled(bool enabled) {
+  if (!enabled) {
+    FlushBatches();
+  }
+  batching_enabled_ = enabled;
+}
+
+void SrtpTransport::FlushBatches() {
+  FlushPendingSends();
+  FlushPendingReceives();
+}
+
+void SrtpTransport::OnMessage(rtc::Message* msg) {
+  RTC_DCHECK_EQ(MSG_FLUSH_BATCHES, msg->message_id);
+  flush_posted_ = false;
+  FlushBatches();
+}
+
+void SrtpTransport::PostFlush() {
+  if (flush_posted_) {
+    return;
+  }
+  rtc::Thread* thread = rtc::Thread::Current();
+  if (!thread) {
+    FlushBatches();
+    return;
+  }
+  flush_posted_ = true;
+  thread->Post(RTC_FROM_HERE, this, MSG_FLUSH_BATCHES);
+}
+
+void SrtpTransport::FlushPendingSends() {
+  if (pending_sends_.empty()) {
+    return;
+  }
+  // Taken out of the queue first; sending may queue more packets.
+  std::vector<PendingRtpPacket> sends;
+  sends.swap(pending_sends_);
+  if (!IsSrtpActive()) {
+    RTC_LOG(LS_ERROR) << "Dropped " << sends.size()
+                      << " queued RTP packets because SRTP transport is "
+                         "inactive.";
+    deferred_send_failure_count_ += sends.size();
+    return;
+  }
+
+  TRACE_EVENT1("webrtc", "SRTP Encode batch", "packets", sends.size());
+  std::vector<cricket::SrtpSession::Packet> batch(sends.size());
+  for (size_t i = 0; i < sends.size(); ++i) {
+    batch[i].data = sends[i].packet.data();
+    batch[i].len = rtc::checked_cast<int>(sends[i].packet.size());
+    batch[i].max_len = rtc::checked_cast<int>(sends[i].packet.capacity());
+  }
+  send_session_->ProtectRtpBatch(batch);
+  // SendRtpPacket() already returned true for these packets, so failures can
+  // only be logged and counted here.
+  size_t failures = 0;
+  for (size_t i = 0; i < sends.size(); ++i) {
+    if (!batch[i].ok) {
+      OnProtectRtpFailure(sends[i].packet.data(), batch[i].len);
+      ++failures;
+      continue;
+    }
+    // Update the length of the packet now that we've added the auth tag.
+    sends[i].packet.SetSize(batch[i].len);
+    if (!SendPacket(/*rtcp=*/false, &sends[i].packet, sends[i].options,
+                    sends[i].flags)) {
+      ++failures;
+    }
+  }
+  if (failures > 0) {
+    RTC_LOG(LS_WARNING) << "Failed to send " << failures << " of "
+                        << sends.size() << " queued RTP packets.";
+    deferred_send_failure_count_ += failures;
+  }
+}
+
+void SrtpTransport::FlushPendingReceives() {
+  if (pending_receives_.empty()) {
+    return;
+  }
+  std::vector<PendingRtpPacket> receives;
+  receives.swap(pending_receives_);
+  if (!IsSrtpActive()) {
+    RTC_LOG(LS_WARNING) << "Inactive SRTP transport dropped "
+                        << receives.size() << " queued RTP packets.";
+    return;
+  }
+
+  TRACE_EVENT1("webrtc", "SRTP Decode batch", "packets", receives.size());
+  std::vector<cricket::SrtpSession::Packet> batch(receives.size());
+  for (size_t i = 0; i < receives.size(); ++i) {
+    batch[i].data = receives[i].packet.data();
+    batch[i].len = rtc::checked_cast<int>(receives[i].packet.size());
+  }
+  recv_session_->UnprotectRtpBatch(batch);
+  for (size_t i = 0; i < receives.size(); ++i) {
+    if (!batch[i].ok) {
+      OnUnprotectRtpFailure(receives[i].packet.data<char>(), batch[i].len);
+      continue;
+    }
+    receives[i].packet.SetSize(batch[i].len);
+    DemuxPacket(std::move(receives[i].packet), receives[i].packet_time_us);
+  }
+}
+
+void SrtpTransport::OnProtectRtpFailure(const uint8_t* data, int len) {
+  int seq_num = -1;
+  uint32_t ssrc = 0;
+  cricket::GetRtpSeqNum(data, len, &seq_num);
+  cricket::GetRtpSsrc(data, len, &ssrc);
+  RTC_LOG(LS_ERROR) << "Failed to protect RTP packet: size=" << len
+                    << ", seqnum=" << seq_num << ", SSRC=" << ssrc;
+}
+
+void SrtpTransport::OnUnprotectRtpFailure(const char* data, int len) {
+  int seq_num = -1;
+  uint32_t ssrc = 0;
+  cricket::GetRtpSeqNum(data, len, &seq_num);
+  cricket::GetRtpSsrc(data, len, &ssrc);
+
+  // Limit the error logging to avoid excessive logs when there are lots of
+  // bad packets.
+  const int kFailureLogThrottleCount = 100;
+  if (decryption_failure_count_ % kFailureLogThrottleCount == 0) {
+    RTC_LOG(LS_ERROR) << "Failed to unprotect RTP packet: size=" << len
+                      << ", seqnum=" << seq_num << ", SSRC=" << ssrc
+                      << ", previous failure count: "
+                      << decryption_failure_count_;
+  }
+  ++decryption_failure_count_;
+}
+
 void SrtpTransport::OnNetworkRouteChanged(
     absl::optional<rtc::NetworkRoute> network_route) {
   // Only append the SRTP overhead when there is a selected network route.
@@ -287,6 +443,9 @@ bool SrtpTransport::SetRtpParams(int send_cs,
     RTC_DCHECK(!recv_session_);
     CreateSrtpSessions();
     new_sessions = true;
+  } else {
+    // Queued packets belong to the old keys.
+    FlushBatches();
   }
   bool ret = new_sessions
                  ? send_session_->SetSend(send_cs, send_key, send_key_len,
@@ -357,6 +516,7 @@ bool SrtpTransport::IsWritable(bool rtcp) const {
 }
 
 void SrtpTransport::ResetParams() {
+  FlushBatches();
   send_session_ = nullptr;
   recv_session_ = nullptr;
   send_rtcp_session_ = nullptr;
@@ -27,6 +27,7 @@
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/buffer.h"
 #include "rtc_base/copy_on_write_buffer.h"
+#include "rtc_base/message_handler.h"
 #include "rtc_base/network_route.h"
 
 namespace webrtc {
@@ -34,7 +35,7 @@ namespace webrtc {
 // This subclass of the RtpTransport is used for SRTP which is reponsible for
 // protecting/unprotecting the packets. It provides interfaces to set the crypto
 // parameters for the SrtpSession underneath.
-class SrtpTransport : public RtpTransport {
+class SrtpTransport : public RtpTransport, public rtc::MessageHandler {
  public:
   explicit SrtpTransport(bool rtcp_mux_enabled);
 
@@ -109,6 +110,30 @@ class SrtpTransport : public RtpTransport {
     rtp_abs_sendtime_extn_id_ = rtp_abs_sendtime_extn_id;
   }
 
+  // Enables deferred processing of RTP packets. While enabled, sent and
+  // received RTP packets are queued, and all packets queued during the
+  // current message loop iteration of the network thread are protected or
+  // unprotected with one SrtpSession batch call before they are passed on.
+  // SendRtpPacket() then returns true once the packet is queued, and later
+  // failures are counted in deferred_send_failure_count(). RTCP packets
+  // and packets that need external authentication are not deferred, but
+  // flush the queue of their direction first to keep the packet order.
+  // JsepTransportController enables this from
+  // CryptoOptions::Srtp::enable_batching.
+  void SetBatchingEnabled(bool enabled);
+
+  // Processes all packets queued in batching mode.
+  void FlushBatches();
+
+  // Returns the number of RTP packets that were queued in batching mode but
+  // failed to be protected or sent when the queue was flushed.
+  size_t deferred_send_failure_count() const {
+    return deferred_send_failure_count_;
+  }
+
+  // rtc::MessageHandler override.
+  void OnMessage(rtc::Message* msg) override;
+
  protected:
   // If the writable state changed, fire the SignalWritableState.
   void MaybeUpdateWritableState();
@@ -146,6 +171,21 @@ class SrtpTransport : public RtpTransport {
   bool MaybeSetKeyParams();
   bool ParseKeyParams(const std::string& key_params, uint8_t* key, size_t len);
 
+  struct PendingRtpPacket {
+    rtc::CopyOnWriteBuffer packet;
+    rtc::PacketOptions options;
+    int flags = 0;
+    int64_t packet_time_us = -1;
+  };
+
+  // Makes sure the queued packets get processed at the end of the current
+  // message loop iteration.
+  void PostFlush();
+  void FlushPendingSends();
+  void FlushPendingReceives();
+  void OnProtectRtpFailure(const uint8_t* data, int len);
+  void OnUnprotectRtpFailure(const char* data, int len);
+
   const std::string content_name_;
 
   std::unique_ptr<cricket::SrtpSession> send_session_;
@@ -167,6 +207,12 @@ class SrtpTransport : public RtpTransport {
   int rtp_abs_sendtime_extn_id_ = -1;
 
   int decryption_failure_count_ = 0;
+
+  bool batching_enabled_ = false;
+  bool flush_posted_ = false;
+  size_t deferred_send_failure_count_ = 0;
+  std::vector<PendingRtpPacket> pending_sends_;
+  std::vector<PendingRtpPacket> pending_receives_;
 };
 
 }  // namespace webrtc
@@ -27,6 +27,7 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/ssl_stream_adapter.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
 #include "test/gtest.h"
 
 using rtc::kTestKey1;
@@ -416,4 +417,77 @@ TEST_F(SrtpTransportTest, TestSetParamsKeyTooShort) {
       rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen - 1, extension_ids));
 }
 
+TEST_F(SrtpTransportTest, SendAndRecvBatchedRtpPackets) {
+  static const int kNumPackets = 5;
+  rtc::AutoThread thread;
+  std::vector<int> extension_ids;
+  ASSERT_TRUE(srtp_transport1_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids));
+  ASSERT_TRUE(srtp_transport2_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids));
+  srtp_transport1_->SetBatchingEnabled(true);
+  srtp_transport2_->SetBatchingEnabled(true);
+
+  size_t rtp_len = sizeof(kPcmuFrame);
+  size_t packet_size =
+      rtp_len + rtc::rtp_auth_tag_len(rtc::CS_AES_CM_128_HMAC_SHA1_80);
+  rtc::PacketOptions options;
+  for (int i = 0; i < kNumPackets; ++i) {
+    rtc::CopyOnWriteBuffer packet(kPcmuFrame, rtp_len, packet_size);
+    rtc::SetBE16(packet.data() + 2, ++sequence_number_);
+    EXPECT_TRUE(srtp_transport1_->SendRtpPacket(&packet, options,
+                                                cricket::PF_SRTP_BYPASS));
+  }
+  // Nothing is sent before the end of the message loop iteration.
+  EXPECT_EQ(0, rtp_sink2_.rtp_count());
+
+  rtc::Thread::Current()->ProcessMessages(0);
+  EXPECT_EQ(kNumPackets, rtp_sink2_.rtp_count());
+  rtc::CopyOnWriteBuffer last_packet = rtp_sink2_.last_recv_rtp_packet();
+  ASSERT_EQ(rtp_len, last_packet.size());
+  EXPECT_EQ(sequence_number_, rtc::GetBE16(last_packet.data() + 2));
+  EXPECT_EQ(0, memcmp(last_packet.data() + 4, kPcmuFrame + 4, rtp_len - 4));
+
+  // Disabling batching processes what is queued.
+  rtc::CopyOnWriteBuffer packet(kPcmuFrame, rtp_len, packet_size);
+  rtc::SetBE16(packet.data() + 2, ++sequence_number_);
+  EXPECT_TRUE(srtp_transport1_->SendRtpPacket(&packet, options,
+                                              cricket::PF_SRTP_BYPASS));
+  srtp_transport1_->SetBatchingEnabled(false);
+  srtp_transport2_->SetBatchingEnabled(false);
+  EXPECT_EQ(kNumPackets + 1, rtp_sink2_.rtp_count());
+}
+
+TEST_F(SrtpTransportTest, CountsFailedBatchedRtpSends) {
+  rtc::AutoThread thread;
+  std::vector<int> extension_ids;
+  ASSERT_TRUE(srtp_transport1_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids));
+  ASSERT_TRUE(srtp_transport2_->SetRtpParams(
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey2, kTestKeyLen, extension_ids,
+      rtc::SRTP_AES128_CM_SHA1_80, kTestKey1, kTestKeyLen, extension_ids));
+  srtp_transport1_->SetBatchingEnabled(true);
+
+  size_t rtp_len = sizeof(kPcmuFrame);
+  size_t packet_size =
+      rtp_len + rtc::rtp_auth_tag_len(rtc::CS_AES_CM_128_HMAC_SHA1_80);
+  rtc::PacketOptions options;
+  rtc::CopyOnWriteBuffer packet(kPcmuFrame, rtp_len, packet_size);
+  rtc::SetBE16(packet.data() + 2, ++sequence_number_);
+  EXPECT_TRUE(srtp_transport1_->SendRtpPacket(&packet, options,
+                                              cricket::PF_SRTP_BYPASS));
+  // No room for the auth tag, so protecting this packet fails.
+  rtc::CopyOnWriteBuffer short_packet(kPcmuFrame, rtp_len, rtp_len);
+  rtc::SetBE16(short_packet.data() + 2, ++sequence_number_);
+  EXPECT_TRUE(srtp_transport1_->SendRtpPacket(&short_packet, options,
+                                              cricket::PF_SRTP_BYPASS));
+
+  rtc::Thread::Current()->ProcessMessages(0);
+  EXPECT_EQ(1, rtp_sink2_.rtp_count());
+  EXPECT_EQ(1u, srtp_transport1_->deferred_send_failure_count());
+}
+
 }  // namespace webrtc
@@ -143,4 +143,36 @@ AsyncClosure::~AsyncClosure() {
   invocation_complete_->Set();
 }
 
+NotifyingAsyncClosureBase::NotifyingAsyncClosureBase(
+    AsyncInvoker* invoker,
+    const Location& callback_posted_from,
+    Thread* calling_thread)
+    : AsyncClosure(invoker),
+      callback_posted_from_(callback_posted_from),
+      calling_thread_(calling_thread) {
+  RTC_DCHECK(calling_thread_);
+  calling_thread->SignalQueueDestroyed.connect(
+      this, &NotifyingAsyncClosureBase::CancelCallback);
+}
+
+NotifyingAsyncClosureBase::~NotifyingAsyncClosureBase() {
+  disconnect_all();
+}
+
+void NotifyingAsyncClosureBase::TriggerCallback(
+    std::unique_ptr<AsyncClosure> callback) {
+  CritScope cs(&crit_);
+  if (calling_thread_ == nullptr)
+    return;
+  invoker_->DoInvoke(callback_posted_from_, calling_thread_,
+                     std::move(callback), 0);
+}
+
+void NotifyingAsyncClosureBase::CancelCallback() {
+  // If the callback is triggering when this is called, CritScope protects us
+  // from the calling thread going away in the middle of it.
+  CritScope cs(&crit_);
+  calling_thread_ = nullptr;
+}
+
 }  // namespace rtc
@@ -51,7 +51,7 @@ namespace rtc {
 //    public:
 //     void FireAsyncTaskWithResult(Thread* thread, int x) {
 //       // Specify a callback to get the result upon completion.
-//       invoker_.AsyncInvoke<int>(RTC_FROM_HERE,
+//       invoker_.AsyncInvoke<int>(RTC_FROM_HERE, RTC_FROM_HERE,
 //           thread, Bind(&MyClass::AsyncTaskWithResult, this, x),
 //           &MyClass::OnTaskComplete, this);
 //     }
@@ -119,6 +119,43 @@ class AsyncInvoker : public MessageHandler {
     DoInvokeDelayed(posted_from, thread, std::move(closure), delay_ms, id);
   }
 
+  // Call |functor| asynchronously on |thread|, and |callback| on the calling
+  // thread with the result when done. Returns immediately, so that the caller
+  // isn't blocked like with Thread::Invoke(). The callback is posted with
+  // |callback_posted_from|, and is dropped if the calling thread or this
+  // invoker are destroyed first.
+  template <class ReturnT, class FunctorT, class HostT>
+  void AsyncInvoke(const Location& posted_from,
+                   const Location& callback_posted_from,
+                   Thread* thread,
+                   FunctorT&& functor,
+                   void (HostT::*callback)(ReturnT),
+                   HostT* callback_host,
+                   uint32_t id = 0) {
+    std::unique_ptr<AsyncClosure> closure(
+        new NotifyingAsyncClosure<ReturnT, FunctorT, HostT>(
+            this, callback_posted_from, Thread::Current(),
+            std::forward<FunctorT>(functor), callback, callback_host));
+    DoInvoke(posted_from, thread, std::move(closure), id);
+  }
+
+  // Call |functor| asynchronously on |thread|, calling |callback| when done.
+  // Overloaded for void return.
+  template <class ReturnT, class FunctorT, class HostT>
+  void AsyncInvoke(const Location& posted_from,
+                   const Location& callback_posted_from,
+                   Thread* thread,
+                   FunctorT&& functor,
+                   void (HostT::*callback)(),
+                   HostT* callback_host,
+                   uint32_t id = 0) {
+    std::unique_ptr<AsyncClosure> closure(
+        new NotifyingAsyncClosure<void, FunctorT, HostT>(
+            this, callback_posted_from, Thread::Current(),
+            std::forward<FunctorT>(functor), callback, callback_host));
+    DoInvoke(posted_from, thread, std::move(closure), id);
+  }
+
   // Synchronously execute on |thread| all outstanding calls we own
   // that are pending on |thread|, and wait for calls to complete
   // before returning. Optionally filter by message id.
@@ -165,6 +202,7 @@ class AsyncInvoker : public MessageHandler {
   std::atomic<bool> destroying_;
 
   friend class AsyncClosure;
+  friend class NotifyingAsyncClosureBase;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(AsyncInvoker);
 };
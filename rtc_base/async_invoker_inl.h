@@ -11,10 +11,15 @@
 #ifndef RTC_BASE_ASYNC_INVOKER_INL_H_
 #define RTC_BASE_ASYNC_INVOKER_INL_H_
 
+#include <memory>
+#include <type_traits>
+#include <utility>
+
 #include "api/scoped_refptr.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/critical_section.h"
 #include "rtc_base/event.h"
+#include "rtc_base/location.h"
 #include "rtc_base/message_handler.h"
 #include "rtc_base/ref_counted_object.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
@@ -56,6 +61,121 @@ class FireAndForgetAsyncClosure : public AsyncClosure {
   typename std::decay<FunctorT>::type functor_;
 };
 
+// Closure that runs a callback on the calling thread, with the result of
+// the closure that triggered it.
+template <class ReturnT, class HostT>
+class CallbackAsyncClosure : public AsyncClosure {
+ public:
+  CallbackAsyncClosure(AsyncInvoker* invoker,
+                       void (HostT::*callback)(ReturnT),
+                       HostT* callback_host,
+                       ReturnT result)
+      : AsyncClosure(invoker),
+        callback_(callback),
+        callback_host_(callback_host),
+        result_(std::move(result)) {}
+  void Execute() override { (callback_host_->*callback_)(std::move(result_)); }
+
+ private:
+  void (HostT::*callback_)(ReturnT);
+  HostT* callback_host_;
+  ReturnT result_;
+};
+
+template <class HostT>
+class CallbackAsyncClosure<void, HostT> : public AsyncClosure {
+ public:
+  CallbackAsyncClosure(AsyncInvoker* invoker,
+                       void (HostT::*callback)(),
+                       HostT* callback_host)
+      : AsyncClosure(invoker),
+        callback_(callback),
+        callback_host_(callback_host) {}
+  void Execute() override { (callback_host_->*callback_)(); }
+
+ private:
+  void (HostT::*callback_)();
+  HostT* callback_host_;
+};
+
+// Base class for closures that trigger a callback on the calling thread.
+// Listens for the "destroyed" signal of the calling thread, and drops the
+// callback if it is gone.
+class NotifyingAsyncClosureBase : public AsyncClosure,
+                                  public sigslot::has_slots<> {
+ public:
+  ~NotifyingAsyncClosureBase() override;
+
+ protected:
+  NotifyingAsyncClosureBase(AsyncInvoker* invoker,
+                            const Location& callback_posted_from,
+                            Thread* calling_thread);
+  void TriggerCallback(std::unique_ptr<AsyncClosure> callback);
+
+ private:
+  void CancelCallback();
+
+  const Location callback_posted_from_;
+  CriticalSection crit_;
+  Thread* calling_thread_ RTC_GUARDED_BY(crit_);
+};
+
+// Closures that have a non-void return value and require a callback.
+template <class ReturnT, class FunctorT, class HostT>
+class NotifyingAsyncClosure : public NotifyingAsyncClosureBase {
+ public:
+  NotifyingAsyncClosure(AsyncInvoker* invoker,
+                        const Location& callback_posted_from,
+                        Thread* calling_thread,
+                        FunctorT&& functor,
+                        void (HostT::*callback)(ReturnT),
+                        HostT* callback_host)
+      : NotifyingAsyncClosureBase(invoker,
+                                  callback_posted_from,
+                                  calling_thread),
+        functor_(std::forward<FunctorT>(functor)),
+        callback_(callback),
+        callback_host_(callback_host) {}
+  void Execute() override {
+    TriggerCallback(std::make_unique<CallbackAsyncClosure<ReturnT, HostT>>(
+        invoker_, callback_, callback_host_, functor_()));
+  }
+
+ private:
+  typename std::decay<FunctorT>::type functor_;
+  void (HostT::*callback_)(ReturnT);
+  HostT* callback_host_;
+};
+
+// Specialization for void return.
+template <class FunctorT, class HostT>
+class NotifyingAsyncClosure<void, FunctorT, HostT>
+    : public NotifyingAsyncClosureBase {
+ public:
+  NotifyingAsyncClosure(AsyncInvoker* invoker,
+                        const Location& callback_posted_from,
+                        Thread* calling_thread,
+                        FunctorT&& functor,
+                        void (HostT::*callback)(),
+                        HostT* callback_host)
+      : NotifyingAsyncClosureBase(invoker,
+                                  callback_posted_from,
+                                  calling_thread),
+        functor_(std::forward<FunctorT>(functor)),
+        callback_(callback),
+        callback_host_(callback_host) {}
+  void Execute() override {
+    functor_();
+    TriggerCallback(std::make_unique<CallbackAsyncClosure<void, HostT>>(
+        invoker_, callback_, callback_host_));
+  }
+
+ private:
+  typename std::decay<FunctorT>::type functor_;
+  void (HostT::*callback_)();
+  HostT* callback_host_;
+};
+
 }  // namespace rtc
 
 #endif  // RTC_BASE_ASYNC_INVOKER_INL_H_
@@ -0,0 +1,825 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/async_logging.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#if defined(WEBRTC_WIN)
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/base/config.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/platform_thread_types.h"
+#include "rtc_base/string_encode.h"
+#include "rtc_base/string_utils.h"
+#include "rtc_base/strings/string_builder.h"
+#include "rtc_base/system/file_wrapper.h"
+#include "rtc_base/time_utils.h"
+
+namespace rtc {
+namespace {
+
+using webrtc_logging_impl::LogArgType;
+using webrtc_logging_impl::LogMetadataErr;
+
+constexpr char kBinaryLogMagic[] = {'R', 'T', 'C', 'B', 'L', 'O', 'G', '1'};
+constexpr int kDrainIntervalMs = 10;
+// Larger messages are logged synchronously, so that a single call cannot take
+// all of the ring buffer.
+constexpr size_t kMaxRecordSize = AsyncLogger::kRingBufferSize / 4;
+
+static_assert((AsyncLogger::kRingBufferSize &
+               (AsyncLogger::kRingBufferSize - 1)) == 0,
+              "Ring buffer size must be a power of two");
+
+// Entries of a binary log, after the magic.
+enum class BinaryEntry : uint8_t {
+  kFileName = 1,  // File id, name.
+  kMessage = 2,   // Metadata, tag, arguments, kEnd.
+};
+
+// Message arguments in a binary log.
+enum class BinaryArg : uint8_t {
+  kEnd = 0,
+  kSigned = 1,
+  kUnsigned = 2,
+  kDouble = 3,
+  kString = 4,
+  kPointer = 5,
+};
+
+// Fixed part of a message in a ring buffer. It is followed by the tag, as a
+// uint32_t size and the characters, empty if there is none. Then come the
+// arguments, each a LogArgType and the value in native layout: long long,
+// unsigned long long, double, long double, uintptr_t, or, for all strings,
+// kStringView and the string in the same form as the tag.
+struct RecordHeader {
+  int64_t time_ms;
+  const char* file;
+  int line;
+  int err;
+  LoggingSeverity sev;
+  LogErrorContext err_ctx;
+};
+
+void YieldThread() {
+#if defined(WEBRTC_WIN)
+  ::Sleep(0);
+#else
+  sched_yield();
+#endif
+}
+
+const char* FilenameFromPath(const char* file) {
+  const char* end1 = ::strrchr(file, '/');
+  const char* end2 = ::strrchr(file, '\\');
+  if (!end1 && !end2)
+    return file;
+  else
+    return (end1 > end2) ? end1 + 1 : end2 + 1;
+}
+
+template <typename T>
+void AppendValue(const T& value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void AppendArg(LogArgType type, const T& value, std::string* out) {
+  out->push_back(static_cast<char>(type));
+  AppendValue(value, out);
+}
+
+void AppendString(absl::string_view value, std::string* out) {
+  AppendValue(static_cast<uint32_t>(value.size()), out);
+  out->append(value.data(), value.size());
+}
+
+void AppendStringArg(absl::string_view value, std::string* out) {
+  out->push_back(static_cast<char>(LogArgType::kStringView));
+  AppendString(value, out);
+}
+
+// Reads back what AppendValue() wrote. The data was produced by this process,
+// so it is only checked in debug builds.
+class RecordReader {
+ public:
+  explicit RecordReader(absl::string_view data) : data_(data) {}
+
+  bool empty() const { return data_.empty(); }
+
+  template <typename T>
+  T Read() {
+    T value;
+    RTC_DCHECK_GE(data_.size(), sizeof(value));
+    memcpy(&value, data_.data(), sizeof(value));
+    data_.remove_prefix(sizeof(value));
+    return value;
+  }
+
+  absl::string_view ReadString() {
+    uint32_t size = Read<uint32_t>();
+    RTC_DCHECK_GE(data_.size(), size);
+    absl::string_view value = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return value;
+  }
+
+ private:
+  absl::string_view data_;
+};
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Parses a binary log, which comes from outside and is checked throughout.
+class BinaryReader {
+ public:
+  explicit BinaryReader(absl::string_view data) : data_(data) {}
+
+  bool empty() const { return data_.empty(); }
+
+  bool ReadByte(uint8_t* value) {
+    if (data_.empty())
+      return false;
+    *value = static_cast<uint8_t>(data_[0]);
+    data_.remove_prefix(1);
+    return true;
+  }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(&byte))
+        return false;
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  bool ReadDouble(double* value) {
+    if (data_.size() < sizeof(*value))
+      return false;
+    memcpy(value, data_.data(), sizeof(*value));
+    data_.remove_prefix(sizeof(*value));
+    return true;
+  }
+
+  bool ReadString(absl::string_view* value) {
+    uint64_t size;
+    if (!ReadVarint(&size) || size > data_.size())
+      return false;
+    *value = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return true;
+  }
+
+ private:
+  absl::string_view data_;
+};
+
+// Single producer, single consumer byte queue holding the messages of one
+// thread. Each is stored as a uint32_t size followed by the bytes, wrapping
+// around the end of |data_|. Positions only grow; the unread bytes are the
+// ones between |tail_| and |head_|.
+class RingBuffer {
+ public:
+  explicit RingBuffer(PlatformThreadId thread_id) : thread_id_(thread_id) {}
+
+  PlatformThreadId thread_id() const { return thread_id_; }
+
+  // Called on the owning thread. Returns false if |record| does not fit.
+  // Sets |*half_full| if the call filled the buffer beyond its half.
+  bool Push(absl::string_view record, bool* half_full) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t used = head - tail_.load(std::memory_order_acquire);
+    uint64_t size = sizeof(uint32_t) + record.size();
+    if (used + size > AsyncLogger::kRingBufferSize)
+      return false;
+    uint32_t record_size = static_cast<uint32_t>(record.size());
+    CopyIn(head, &record_size, sizeof(record_size));
+    CopyIn(head + sizeof(record_size), record.data(), record.size());
+    head_.store(head + size, std::memory_order_release);
+    constexpr uint64_t kHalf = AsyncLogger::kRingBufferSize / 2;
+    *half_full = used < kHalf && used + size >= kHalf;
+    return true;
+  }
+
+  // Called on the background thread. Hands the messages pushed so far, one
+  // at a time in |*buffer|, to |callback|.
+  template <typename Callback>
+  void Drain(std::string* buffer, Callback callback) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail != head) {
+      uint32_t record_size;
+      CopyOut(tail, &record_size, sizeof(record_size));
+      buffer->resize(record_size);
+      CopyOut(tail + sizeof(record_size), &(*buffer)[0], record_size);
+      tail += sizeof(record_size) + record_size;
+      // Frees the space before the message is formatted.
+      tail_.store(tail, std::memory_order_release);
+      callback(*buffer);
+    }
+  }
+
+  // The producer sets |writing| while it may push or use the logger, so that
+  // AsyncLogger::Stop() can wait for it. It sets |abandoned| when its thread
+  // exits; the background thread then deletes the buffer once drained.
+  std::atomic<bool> writing{false};
+  std::atomic<bool> abandoned{false};
+  // Used by the producer to encode a message before pushing it.
+  std::string scratch;
+
+ private:
+  static size_t Index(uint64_t position) {
+    return static_cast<size_t>(position & (AsyncLogger::kRingBufferSize - 1));
+  }
+
+  void CopyIn(uint64_t position, const void* src, size_t size) {
+    size_t index = Index(position);
+    size_t first = std::min(size, AsyncLogger::kRingBufferSize - index);
+    memcpy(&data_[index], src, first);
+    memcpy(&data_[0], static_cast<const char*>(src) + first, size - first);
+  }
+
+  void CopyOut(uint64_t position, void* dst, size_t size) const {
+    size_t index = Index(position);
+    size_t first = std::min(size, AsyncLogger::kRingBufferSize - index);
+    memcpy(dst, &data_[index], first);
+    memcpy(static_cast<char*>(dst) + first, &data_[0], size - first);
+  }
+
+  const PlatformThreadId thread_id_;
+  // Keeps the positions on different cache lines.
+  std::atomic<uint64_t> head_{0};
+  char data_[AsyncLogger::kRingBufferSize];
+  std::atomic<uint64_t> tail_{0};
+};
+
+// Serializes Start(), Stop() and Flush().
+ABSL_CONST_INIT GlobalLock g_control_lock;
+// Guards the list of ring buffers.
+ABSL_CONST_INIT GlobalLock g_rings_lock;
+ABSL_CONST_INIT std::atomic<int64_t> g_synchronous_fallbacks{0};
+
+std::vector<RingBuffer*>* RingBuffers() {
+  static std::vector<RingBuffer*>* const rings =
+      new std::vector<RingBuffer*>();
+  return rings;
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+// Abandons the ring buffer of a thread when the thread exits. The pointer to
+// the buffer is kept in a separate, trivially destructible variable, since
+// the destructors of other thread locals may still log.
+struct RingBufferOwner {
+  ~RingBufferOwner();
+  RingBuffer* ring = nullptr;
+};
+
+ABSL_CONST_INIT thread_local RingBuffer* tls_ring = nullptr;
+ABSL_CONST_INIT thread_local bool tls_ring_abandoned = false;
+thread_local RingBufferOwner tls_ring_owner;
+
+RingBufferOwner::~RingBufferOwner() {
+  tls_ring = nullptr;
+  tls_ring_abandoned = true;
+  if (ring)
+    ring->abandoned.store(true, std::memory_order_release);
+}
+#endif
+
+// Returns the ring buffer of the current thread, or null if messages of this
+// thread have to be logged synchronously.
+RingBuffer* CurrentRingBuffer() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  if (tls_ring || tls_ring_abandoned)
+    return tls_ring;
+  RingBuffer* ring = new RingBuffer(CurrentThreadId());
+  {
+    GlobalLockScope lock(&g_rings_lock);
+    RingBuffers()->push_back(ring);
+  }
+  tls_ring_owner.ring = ring;
+  tls_ring = ring;
+  return ring;
+#else
+  return nullptr;
+#endif
+}
+
+// Encodes a log call into |*record| as described at RecordHeader. Returns
+// false if the message is too large for a ring buffer.
+bool EncodeRecord(const LogMetadataErr& meta,
+                  const char* tag,
+                  const LogArgType* fmt,
+                  va_list args,
+                  std::string* record) {
+  record->clear();
+  RecordHeader header = {SystemTimeMillis(),   meta.meta.File(),
+                         meta.meta.Line(),     meta.err,
+                         meta.meta.Severity(), meta.err_ctx};
+  AppendValue(header, record);
+  // The tag may be a temporary of the caller, so it is copied like the
+  // string arguments.
+  AppendString(tag ? tag : "", record);
+  for (; *fmt != LogArgType::kEnd; ++fmt) {
+    switch (*fmt) {
+      case LogArgType::kInt:
+        AppendArg<long long>(LogArgType::kLongLong, va_arg(args, int), record);
+        break;
+      case LogArgType::kLong:
+        AppendArg<long long>(LogArgType::kLongLong, va_arg(args, long),
+                             record);
+        break;
+      case LogArgType::kLongLong:
+        AppendArg(LogArgType::kLongLong, va_arg(args, long long), record);
+        break;
+      case LogArgType::kUInt:
+        AppendArg<unsigned long long>(LogArgType::kULongLong,
+                                      va_arg(args, unsigned), record);
+        break;
+      case LogArgType::kULong:
+        AppendArg<unsigned long long>(LogArgType::kULongLong,
+                                      va_arg(args, unsigned long), record);
+        break;
+      case LogArgType::kULongLong:
+        AppendArg(LogArgType::kULongLong, va_arg(args, unsigned long long),
+                  record);
+        break;
+      case LogArgType::kDouble:
+        AppendArg(LogArgType::kDouble, va_arg(args, double), record);
+        break;
+      case LogArgType::kLongDouble:
+        AppendArg(LogArgType::kLongDouble, va_arg(args, long double), record);
+        break;
+      case LogArgType::kCharP: {
+        const char* s = va_arg(args, const char*);
+        AppendStringArg(s ? s : "(null)", record);
+        break;
+      }
+      case LogArgType::kStdString:
+        AppendStringArg(*va_arg(args, const std::string*), record);
+        break;
+      case LogArgType::kStringView:
+        AppendStringArg(*va_arg(args, const absl::string_view*), record);
+        break;
+      case LogArgType::kVoidP:
+        AppendArg(LogArgType::kVoidP,
+                  reinterpret_cast<uintptr_t>(va_arg(args, const void*)),
+                  record);
+        break;
+      default:
+        RTC_NOTREACHED();
+        return false;
+    }
+    if (record->size() > kMaxRecordSize)
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+// The background thread of a running logger.
+class AsyncLogger::Worker {
+ public:
+  // Writes to |file| if it is open, or else to the LogMessage sinks.
+  explicit Worker(webrtc::FileWrapper file)
+      : file_(std::move(file)),
+        thread_(&Worker::Run, this, "AsyncLogger", kLowPriority) {
+    if (file_.is_open()) {
+      file_.Write(kBinaryLogMagic, sizeof(kBinaryLogMagic));
+    }
+    thread_.Start();
+  }
+
+  ~Worker() {
+    stop_.store(true, std::memory_order_release);
+    wake_.Set();
+    thread_.Stop();
+  }
+
+  void Flush() {
+    flush_requested_.store(true, std::memory_order_release);
+    wake_.Set();
+    flushed_.Wait(Event::kForever);
+  }
+
+  static bool HandleLog(const LogMetadataErr& meta,
+                        const char* tag,
+                        const LogArgType* fmt,
+                        va_list args);
+
+  // Null unless the logger runs.
+  static std::atomic<Worker*> current;
+
+ private:
+  static void Run(void* obj) { static_cast<Worker*>(obj)->Run(); }
+
+  void Run() {
+    while (true) {
+      // Reads the requests before draining, so that the drain covers
+      // everything logged before them.
+      bool stop = stop_.load(std::memory_order_acquire);
+      bool flush = flush_requested_.exchange(false);
+      DrainRingBuffers();
+      if (flush) {
+        if (file_.is_open())
+          file_.Flush();
+        flushed_.Set();
+      }
+      if (stop)
+        break;
+      wake_.Wait(kDrainIntervalMs);
+    }
+  }
+
+  void DrainRingBuffers() {
+    // Formatting may log, and logging may register ring buffers, so the lock
+    // is not held while draining. Only this thread deletes ring buffers.
+    std::vector<RingBuffer*> rings;
+    {
+      GlobalLockScope lock(&g_rings_lock);
+      rings = *RingBuffers();
+    }
+    std::vector<RingBuffer*> abandoned;
+    for (RingBuffer* ring : rings) {
+      if (ring->abandoned.load(std::memory_order_acquire))
+        abandoned.push_back(ring);
+      ring->Drain(&record_, [this, ring](absl::string_view record) {
+        if (file_.is_open()) {
+          EncodeBinary(ring->thread_id(), record);
+        } else {
+          Format(ring->thread_id(), record);
+        }
+      });
+    }
+    if (!binary_.empty()) {
+      file_.Write(binary_.data(), binary_.size());
+      binary_.clear();
+    }
+    if (!abandoned.empty()) {
+      GlobalLockScope lock(&g_rings_lock);
+      std::vector<RingBuffer*>* all = RingBuffers();
+      for (RingBuffer* ring : abandoned) {
+        all->erase(std::find(all->begin(), all->end(), ring));
+        delete ring;
+      }
+    }
+  }
+
+  void Format(PlatformThreadId thread_id, absl::string_view record) {
+    RecordReader reader(record);
+    RecordHeader header = reader.Read<RecordHeader>();
+    // LogMessage keeps the tag pointer, so the copy has to outlive |message|.
+    std::string tag(reader.ReadString());
+    LogMessage message(header.file, header.line, header.sev, header.err_ctx,
+                       header.err, header.time_ms, thread_id);
+    if (!tag.empty())
+      message.AddTag(tag.c_str());
+    while (!reader.empty()) {
+      switch (reader.Read<LogArgType>()) {
+        case LogArgType::kLongLong:
+          message.stream() << reader.Read<long long>();
+          break;
+        case LogArgType::kULongLong:
+          message.stream() << reader.Read<unsigned long long>();
+          break;
+        case LogArgType::kDouble:
+          message.stream() << reader.Read<double>();
+          break;
+        case LogArgType::kLongDouble:
+          message.stream() << reader.Read<long double>();
+          break;
+        case LogArgType::kStringView:
+          message.stream() << reader.ReadString();
+          break;
+        case LogArgType::kVoidP:
+          message.stream() << rtc::ToHex(reader.Read<uintptr_t>());
+          break;
+        default:
+          RTC_NOTREACHED();
+          return;
+      }
+    }
+  }
+
+  void EncodeBinary(PlatformThreadId thread_id, absl::string_view record) {
+    RecordReader reader(record);
+    RecordHeader header = reader.Read<RecordHeader>();
+    absl::string_view tag = reader.ReadString();
+    uint64_t file_id = 0;
+    if (header.file) {
+      auto it = file_ids_.find(header.file);
+      if (it == file_ids_.end()) {
+        it = file_ids_.emplace(header.file, file_ids_.size() + 1).first;
+        const char* name = FilenameFromPath(header.file);
+        binary_.push_back(static_cast<char>(BinaryEntry::kFileName));
+        AppendVarint(it->second, &binary_);
+        AppendVarint(strlen(name), &binary_);
+        binary_.append(name);
+      }
+      file_id = it->second;
+    }
+    binary_.push_back(static_cast<char>(BinaryEntry::kMessage));
+    AppendVarint(ZigZagEncode(header.time_ms - LogMessage::LogStartTime()),
+                 &binary_);
+    AppendVarint(static_cast<uint64_t>(thread_id), &binary_);
+    AppendVarint(file_id, &binary_);
+    AppendVarint(header.line, &binary_);
+    binary_.push_back(static_cast<char>(header.sev));
+    binary_.push_back(static_cast<char>(header.err_ctx));
+    AppendVarint(ZigZagEncode(header.err), &binary_);
+    AppendVarint(tag.size(), &binary_);
+    binary_.append(tag.data(), tag.size());
+    while (!reader.empty()) {
+      switch (reader.Read<LogArgType>()) {
+        case LogArgType::kLongLong:
+          binary_.push_back(static_cast<char>(BinaryArg::kSigned));
+          AppendVarint(ZigZagEncode(reader.Read<long long>()), &binary_);
+          break;
+        case LogArgType::kULongLong:
+          binary_.push_back(static_cast<char>(BinaryArg::kUnsigned));
+          AppendVarint(reader.Read<unsigned long long>(), &binary_);
+          break;
+        case LogArgType::kDouble:
+          binary_.push_back(static_cast<char>(BinaryArg::kDouble));
+          AppendValue(reader.Read<double>(), &binary_);
+          break;
+        case LogArgType::kLongDouble:
+          binary_.push_back(static_cast<char>(BinaryArg::kDouble));
+          AppendValue(static_cast<double>(reader.Read<long double>()),
+                      &binary_);
+          break;
+        case LogArgType::kStringView: {
+          absl::string_view value = reader.ReadString();
+          binary_.push_back(static_cast<char>(BinaryArg::kString));
+          AppendVarint(value.size(), &binary_);
+          binary_.append(value.data(), value.size());
+          break;
+        }
+        case LogArgType::kVoidP:
+          binary_.push_back(static_cast<char>(BinaryArg::kPointer));
+          AppendVarint(reader.Read<uintptr_t>(), &binary_);
+          break;
+        default:
+          RTC_NOTREACHED();
+          break;
+      }
+    }
+    binary_.push_back(static_cast<char>(BinaryArg::kEnd));
+  }
+
+  webrtc::FileWrapper file_;
+  PlatformThread thread_;
+  Event wake_;
+  Event flushed_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> flush_requested_{false};
+
+  // Used on the background thread only.
+  std::string record_;
+  std::string binary_;
+  std::map<const char*, uint64_t> file_ids_;
+};
+
+ABSL_CONST_INIT std::atomic<AsyncLogger::Worker*> AsyncLogger::Worker::current{
+    nullptr};
+
+bool AsyncLogger::Worker::HandleLog(const LogMetadataErr& meta,
+                                    const char* tag,
+                                    const LogArgType* fmt,
+                                    va_list args) {
+  RingBuffer* ring = CurrentRingBuffer();
+  if (!ring)
+    return false;
+  // Pairs with Stop(), which clears |current| before it checks |writing|.
+  ring->writing.store(true);
+  Worker* worker = current.load();
+  bool handled = false;
+  if (worker) {
+    bool half_full = false;
+    handled = EncodeRecord(meta, tag, fmt, args, &ring->scratch) &&
+              ring->Push(ring->scratch, &half_full);
+    if (half_full)
+      worker->wake_.Set();
+    if (!handled)
+      g_synchronous_fallbacks.fetch_add(1, std::memory_order_relaxed);
+  }
+  ring->writing.store(false, std::memory_order_release);
+  return handled;
+}
+
+void AsyncLogger::StartText() {
+  GlobalLockScope lock(&g_control_lock);
+  if (Worker::current.load())
+    return;
+  g_synchronous_fallbacks.store(0);
+  Worker::current.store(new Worker(webrtc::FileWrapper()));
+  webrtc_logging_impl::SetAsyncLogHandler(&Worker::HandleLog);
+}
+
+bool AsyncLogger::StartBinary(const std::string& path) {
+  GlobalLockScope lock(&g_control_lock);
+  if (Worker::current.load())
+    return false;
+  webrtc::FileWrapper file = webrtc::FileWrapper::OpenWriteOnly(path);
+  if (!file.is_open())
+    return false;
+  // Timestamps in the file are relative to the start of logging.
+  LogMessage::LogStartTime();
+  g_synchronous_fallbacks.store(0);
+  Worker::current.store(new Worker(std::move(file)));
+  webrtc_logging_impl::SetAsyncLogHandler(&Worker::HandleLog);
+  return true;
+}
+
+void AsyncLogger::Stop() {
+  GlobalLockScope lock(&g_control_lock);
+  Worker* worker = Worker::current.load();
+  if (!worker)
+    return;
+  webrtc_logging_impl::SetAsyncLogHandler(nullptr);
+  Worker::current.store(nullptr);
+  // Threads that saw the worker may still be pushing, or waking it.
+  {
+    GlobalLockScope rings_lock(&g_rings_lock);
+    for (RingBuffer* ring : *RingBuffers()) {
+      while (ring->writing.load())
+        YieldThread();
+    }
+  }
+  // Drains the ring buffers a last time before the thread exits.
+  delete worker;
+}
+
+bool AsyncLogger::IsRunning() {
+  return Worker::current.load() != nullptr;
+}
+
+void AsyncLogger::Flush() {
+  GlobalLockScope lock(&g_control_lock);
+  Worker* worker = Worker::current.load();
+  if (worker)
+    worker->Flush();
+}
+
+int64_t AsyncLogger::SynchronousFallbacks() {
+  return g_synchronous_fallbacks.load(std::memory_order_relaxed);
+}
+
+bool DecodeBinaryLog(absl::string_view data,
+                     LoggingSeverity min_sev,
+                     std::string* text) {
+  text->clear();
+  if (data.substr(0, sizeof(kBinaryLogMagic)) !=
+      absl::string_view(kBinaryLogMagic, sizeof(kBinaryLogMagic))) {
+    return false;
+  }
+  BinaryReader reader(data.substr(sizeof(kBinaryLogMagic)));
+  std::vector<std::string> file_names = {""};
+  while (!reader.empty()) {
+    uint8_t entry;
+    reader.ReadByte(&entry);
+    if (entry == static_cast<uint8_t>(BinaryEntry::kFileName)) {
+      uint64_t id;
+      absl::string_view name;
+      if (!reader.ReadVarint(&id) || id != file_names.size() ||
+          !reader.ReadString(&name)) {
+        return false;
+      }
+      file_names.emplace_back(name);
+      continue;
+    }
+    if (entry != static_cast<uint8_t>(BinaryEntry::kMessage))
+      return false;
+
+    uint64_t time, thread_id, file_id, line, err;
+    uint8_t sev, err_ctx;
+    absl::string_view tag;
+    if (!reader.ReadVarint(&time) || !reader.ReadVarint(&thread_id) ||
+        !reader.ReadVarint(&file_id) || file_id >= file_names.size() ||
+        !reader.ReadVarint(&line) || !reader.ReadByte(&sev) ||
+        !reader.ReadByte(&err_ctx) || !reader.ReadVarint(&err) ||
+        !reader.ReadString(&tag)) {
+      return false;
+    }
+
+    // Same layout as the LogMessage constructor and FinishPrintStream().
+    StringBuilder message;
+    int64_t time_ms = ZigZagDecode(time);
+    message << "[" << LeftPad('0', 3, ToString(time_ms / 1000)) << ":"
+            << LeftPad('0', 3, ToString(time_ms % 1000)) << "] ";
+    message << "[" << thread_id << "] ";
+    if (file_id != 0)
+      message << "(" << file_names[file_id] << ":" << line << "): ";
+    // LogMessage passes the tag to the platform log instead; logcat shows it
+    // in front of the message.
+    if (!tag.empty())
+      message << tag << ": ";
+
+    while (true) {
+      uint8_t arg;
+      if (!reader.ReadByte(&arg))
+        return false;
+      if (arg == static_cast<uint8_t>(BinaryArg::kEnd))
+        break;
+      switch (static_cast<BinaryArg>(arg)) {
+        case BinaryArg::kSigned: {
+          uint64_t value;
+          if (!reader.ReadVarint(&value))
+            return false;
+          message << static_cast<long long>(ZigZagDecode(value));
+          break;
+        }
+        case BinaryArg::kUnsigned: {
+          uint64_t value;
+          if (!reader.ReadVarint(&value))
+            return false;
+          message << static_cast<unsigned long long>(value);
+          break;
+        }
+        case BinaryArg::kDouble: {
+          double value;
+          if (!reader.ReadDouble(&value))
+            return false;
+          message << value;
+          break;
+        }
+        case BinaryArg::kString: {
+          absl::string_view value;
+          if (!reader.ReadString(&value))
+            return false;
+          message << value;
+          break;
+        }
+        case BinaryArg::kPointer: {
+          uint64_t value;
+          if (!reader.ReadVarint(&value))
+            return false;
+          message << ToHex(static_cast<uintptr_t>(value));
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+
+    if (err_ctx != ERRCTX_NONE) {
+      char tmp_buf[1024];
+      SimpleStringBuilder tmp(tmp_buf);
+      tmp.AppendFormat("[0x%08X]", static_cast<int>(ZigZagDecode(err)));
+      if (err_ctx == ERRCTX_ERRNO)
+        tmp << " " << strerror(static_cast<int>(ZigZagDecode(err)));
+      message << " : " << tmp.str();
+    }
+    message << "\n";
+    if (sev >= min_sev)
+      text->append(message.str());
+  }
+  return true;
+}
+
+}  // namespace rtc
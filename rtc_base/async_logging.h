@@ -0,0 +1,78 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_ASYNC_LOGGING_H_
+#define RTC_BASE_ASYNC_LOGGING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "rtc_base/logging.h"
+
+namespace rtc {
+
+// Moves the cost of RTC_LOG off the threads that log. While the logger runs,
+// a log call that passes the severity checks only copies its arguments into a
+// lock-free ring buffer owned by the calling thread. A background thread
+// drains the rings, and either formats the messages for the LogSinks and
+// debug output configured on LogMessage (text mode), or appends them to a file
+// in a compact binary form that DecodeBinaryLog() turns back into text
+// (binary mode).
+//
+// Messages of one thread are delivered in order; messages of different
+// threads are not ordered with respect to each other. A call that does not fit
+// in the ring of its thread is logged synchronously rather than dropped. Only
+// the RTC_LOG family of macros goes through the logger; code that constructs
+// LogMessage directly keeps logging synchronously.
+//
+// All methods are thread safe.
+class AsyncLogger {
+ public:
+  // Size in bytes of the ring buffer of each logging thread.
+  static constexpr size_t kRingBufferSize = 64 * 1024;
+
+  // Starts delivering messages to the LogMessage sinks and debug output on the
+  // background thread. Does nothing if the logger already runs.
+  static void StartText();
+  // Starts writing messages to the file at |path| in binary form, instead of
+  // to the sinks. Returns false if the file cannot be opened or the logger
+  // already runs.
+  static bool StartBinary(const std::string& path);
+  // Delivers all pending messages, stops the background thread and returns
+  // to synchronous logging.
+  static void Stop();
+  static bool IsRunning();
+
+  // Blocks until the messages logged before the call have been delivered.
+  static void Flush();
+
+  // Number of messages logged synchronously since the logger was started,
+  // because they did not fit in the ring buffer of their thread.
+  static int64_t SynchronousFallbacks();
+
+ private:
+  class Worker;
+};
+
+// Converts the output of AsyncLogger::StartBinary() to text, with the
+// messages of at least |min_sev| formatted the way LogMessage formats them.
+// The tag of a message, if it has one, is written in front of the message.
+// Returns false if |data| is not a complete binary log; |text| then holds the
+// messages decoded before the problem.
+bool DecodeBinaryLog(absl::string_view data,
+                     LoggingSeverity min_sev,
+                     std::string* text);
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_ASYNC_LOGGING_H_
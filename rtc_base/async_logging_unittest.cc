@@ -0,0 +1,152 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/async_logging.h"
+
+#include <string>
+#include <vector>
+
+#include "rtc_base/critical_section.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/system/file_wrapper.h"
+#include "test/gtest.h"
+#include "test/testsupport/file_utils.h"
+
+namespace rtc {
+namespace {
+
+class CollectingSink : public LogSink {
+ public:
+  explicit CollectingSink(LoggingSeverity min_sev = LS_INFO) {
+    LogMessage::AddLogToStream(this, min_sev);
+  }
+  ~CollectingSink() override { LogMessage::RemoveLogToStream(this); }
+
+  void OnLogMessage(const std::string& message) override {
+    CritScope lock(&crit_);
+    messages_.push_back(message);
+  }
+
+  std::vector<std::string> messages() {
+    CritScope lock(&crit_);
+    return messages_;
+  }
+
+ private:
+  CriticalSection crit_;
+  std::vector<std::string> messages_;
+};
+
+// Reads the file at |path| and removes it.
+std::string ReadAndRemoveFile(const std::string& path) {
+  std::string data;
+  webrtc::FileWrapper file = webrtc::FileWrapper::OpenReadOnly(path);
+  EXPECT_TRUE(file.is_open());
+  char buffer[1024];
+  while (size_t read = file.Read(buffer, sizeof(buffer)))
+    data.append(buffer, read);
+  file.Close();
+  webrtc::test::RemoveFile(path);
+  return data;
+}
+
+TEST(AsyncLoggerTest, FormatsOnBackgroundThread) {
+  CollectingSink sink;
+  AsyncLogger::StartText();
+  EXPECT_TRUE(AsyncLogger::IsRunning());
+  const char* null_string = nullptr;
+  RTC_LOG(LS_INFO) << "text " << 42 << " " << -7L << " " << 1.5 << " "
+                   << std::string("string") << " " << null_string;
+  AsyncLogger::Flush();
+  AsyncLogger::Stop();
+  EXPECT_FALSE(AsyncLogger::IsRunning());
+
+  std::vector<std::string> messages = sink.messages();
+  ASSERT_EQ(1u, messages.size());
+  EXPECT_NE(std::string::npos,
+            messages[0].find("): text 42 -7 1.5 string (null)\n"));
+  EXPECT_NE(std::string::npos, messages[0].find("(async_logging_unittest.cc:"));
+}
+
+TEST(AsyncLoggerTest, LogsLargeMessagesSynchronously) {
+  CollectingSink sink;
+  AsyncLogger::StartText();
+  RTC_LOG(LS_INFO) << std::string(AsyncLogger::kRingBufferSize, 'x');
+  // Delivered without a flush.
+  EXPECT_EQ(1u, sink.messages().size());
+  EXPECT_EQ(1, AsyncLogger::SynchronousFallbacks());
+  AsyncLogger::Stop();
+}
+
+TEST(AsyncLoggerTest, DeliversMessagesOfExitedThreads) {
+  CollectingSink sink;
+  AsyncLogger::StartText();
+  PlatformThread thread(
+      [](void*) { RTC_LOG(LS_INFO) << "from thread"; }, nullptr, "Logging");
+  thread.Start();
+  thread.Stop();
+  AsyncLogger::Stop();
+
+  std::vector<std::string> messages = sink.messages();
+  ASSERT_EQ(1u, messages.size());
+  EXPECT_NE(std::string::npos, messages[0].find("from thread"));
+}
+
+TEST(AsyncLoggerTest, BinaryLogDecodesToText) {
+  // Lets verbose messages pass the severity checks. The sink itself receives
+  // nothing while the binary log runs.
+  CollectingSink sink(LS_VERBOSE);
+  std::string path =
+      webrtc::test::TempFilename(webrtc::test::OutputPath(), "async_logging");
+  ASSERT_TRUE(AsyncLogger::StartBinary(path));
+  EXPECT_FALSE(AsyncLogger::StartBinary(path));
+  RTC_LOG(LS_INFO) << "first " << 1u << " " << static_cast<void*>(nullptr);
+  RTC_LOG(LS_VERBOSE) << "second";
+  RTC_LOG_ERR_EX(LS_WARNING, EINVAL) << "third";
+  AsyncLogger::Stop();
+  EXPECT_TRUE(sink.messages().empty());
+
+  std::string data = ReadAndRemoveFile(path);
+  std::string text;
+  ASSERT_TRUE(DecodeBinaryLog(data, LS_INFO, &text));
+  EXPECT_NE(std::string::npos, text.find("): first 1 0\n"));
+  EXPECT_EQ(std::string::npos, text.find("second"));
+  EXPECT_NE(std::string::npos, text.find("): third : [0x00000016] "));
+
+  ASSERT_TRUE(DecodeBinaryLog(data, LS_VERBOSE, &text));
+  EXPECT_NE(std::string::npos, text.find("): second\n"));
+
+  EXPECT_FALSE(DecodeBinaryLog(data.substr(0, data.size() - 1), LS_INFO,
+                               &text));
+  EXPECT_FALSE(DecodeBinaryLog("not a log", LS_INFO, &text));
+}
+
+#if defined(WEBRTC_ANDROID)
+TEST(AsyncLoggerTest, BinaryLogKeepsTags) {
+  CollectingSink sink;
+  std::string path =
+      webrtc::test::TempFilename(webrtc::test::OutputPath(), "async_logging");
+  ASSERT_TRUE(AsyncLogger::StartBinary(path));
+  {
+    // Like the Java bindings, passes a tag that is gone after the call.
+    std::string tag = "SomeTag";
+    RTC_LOG_TAG(LS_INFO, tag.c_str()) << "tagged";
+  }
+  AsyncLogger::Stop();
+
+  std::string text;
+  ASSERT_TRUE(DecodeBinaryLog(ReadAndRemoveFile(path), LS_INFO, &text));
+  EXPECT_NE(std::string::npos, text.find("] SomeTag: tagged\n"));
+}
+#endif
+
+}  // namespace
+}  // namespace rtc
@@ -10,6 +10,7 @@
 
 #include "rtc_base/async_packet_socket.h"
 
+#include "rtc_base/buffer.h"
 #include "rtc_base/net_helper.h"
 
 namespace rtc {
@@ -30,6 +31,18 @@ AsyncPacketSocket::AsyncPacketSocket() = default;
 
 AsyncPacketSocket::~AsyncPacketSocket() = default;
 
+int AsyncPacketSocket::SendToV(const SendSegment* segments,
+                               size_t count,
+                               const SocketAddress& addr,
+                               const PacketOptions& options) {
+  if (count == 1)
+    return SendTo(segments[0].data, segments[0].length, addr, options);
+  Buffer buffer;
+  for (size_t i = 0; i < count; ++i)
+    buffer.AppendData(segments[i].data, segments[i].length);
+  return SendTo(buffer.data(), buffer.size(), addr, options);
+}
+
 void CopySocketInformationToPacketInfo(size_t packet_size_bytes,
                                        const AsyncPacketSocket& socket_from,
                                        bool is_connectionless,
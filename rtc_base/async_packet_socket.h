@@ -80,6 +80,12 @@ class RTC_EXPORT AsyncPacketSocket : public sigslot::has_slots<> {
                      size_t cb,
                      const SocketAddress& addr,
                      const PacketOptions& options) = 0;
+  // Sends the |count| segments as one packet, as if they were one buffer
+  // passed to SendTo(). The default implementation copies them together.
+  virtual int SendToV(const SendSegment* segments,
+                      size_t count,
+                      const SocketAddress& addr,
+                      const PacketOptions& options);
 
   // Close the socket.
   virtual int Close() = 0;
@@ -64,6 +64,11 @@ int AsyncSocketAdapter::SendTo(const void* pv,
   return socket_->SendTo(pv, cb, addr);
 }
 
+int AsyncSocketAdapter::SendToBatch(const SendBatchEntry* entries,
+                                    size_t count) {
+  return socket_->SendToBatch(entries, count);
+}
+
 int AsyncSocketAdapter::Recv(void* pv, size_t cb, int64_t* timestamp) {
   return socket_->Recv(pv, cb, timestamp);
 }
@@ -75,6 +80,10 @@ int AsyncSocketAdapter::RecvFrom(void* pv,
   return socket_->RecvFrom(pv, cb, paddr, timestamp);
 }
 
+int AsyncSocketAdapter::RecvFromBatch(RecvBatchEntry* entries, size_t count) {
+  return socket_->RecvFromBatch(entries, count);
+}
+
 int AsyncSocketAdapter::Listen(int backlog) {
   return socket_->Listen(backlog);
 }
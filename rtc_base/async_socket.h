@@ -58,11 +58,13 @@ class AsyncSocketAdapter : public AsyncSocket, public sigslot::has_slots<> {
   int Connect(const SocketAddress& addr) override;
   int Send(const void* pv, size_t cb) override;
   int SendTo(const void* pv, size_t cb, const SocketAddress& addr) override;
+  int SendToBatch(const SendBatchEntry* entries, size_t count) override;
   int Recv(void* pv, size_t cb, int64_t* timestamp) override;
   int RecvFrom(void* pv,
                size_t cb,
                SocketAddress* paddr,
                int64_t* timestamp) override;
+  int RecvFromBatch(RecvBatchEntry* entries, size_t count) override;
   int Listen(int backlog) override;
   AsyncSocket* Accept(SocketAddress* paddr) override;
   int Close() override;
@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <memory>
 
+#include "rtc_base/arraysize.h"
 #include "rtc_base/byte_order.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
@@ -148,38 +149,77 @@ int AsyncTCPSocketBase::SendTo(const void* pv,
 }
 
 int AsyncTCPSocketBase::SendRaw(const void* pv, size_t cb) {
-  if (outbuf_.size() + cb > max_outsize_) {
+  if (outbuf_.size() - outpos_ + cb > max_outsize_) {
     socket_->SetError(EMSGSIZE);
     return -1;
   }
 
   RTC_DCHECK(!listen_);
-  outbuf_.AppendData(static_cast<const uint8_t*>(pv), cb);
+  AppendToOutBuffer(pv, cb);
 
   return FlushOutBuffer();
 }
 
+int AsyncTCPSocketBase::SendPacket(const SendSegment* segments, size_t count) {
+  RTC_DCHECK(!listen_);
+  RTC_DCHECK(IsOutBufferEmpty());
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i)
+    size += segments[i].length;
+  if (size > max_outsize_) {
+    socket_->SetError(EMSGSIZE);
+    return -1;
+  }
+
+  int res = socket_->SendV(segments, count);
+  if (res <= 0) {
+    return res;
+  }
+  if (static_cast<size_t>(res) > size) {
+    RTC_NOTREACHED();
+    return -1;
+  }
+  size_t written = res;
+  for (size_t i = 0; i < count; ++i) {
+    if (written >= segments[i].length) {
+      written -= segments[i].length;
+      continue;
+    }
+    AppendToOutBuffer(segments[i].data + written,
+                      segments[i].length - written);
+    written = 0;
+  }
+  return res;
+}
+
 int AsyncTCPSocketBase::FlushOutBuffer() {
   RTC_DCHECK(!listen_);
-  int res = socket_->Send(outbuf_.data(), outbuf_.size());
+  size_t size = outbuf_.size() - outpos_;
+  int res = socket_->Send(outbuf_.data() + outpos_, size);
   if (res <= 0) {
     return res;
   }
-  if (static_cast<size_t>(res) > outbuf_.size()) {
+  if (static_cast<size_t>(res) > size) {
     RTC_NOTREACHED();
     return -1;
   }
-  size_t new_size = outbuf_.size() - res;
-  if (new_size > 0) {
-    memmove(outbuf_.data(), outbuf_.data() + res, new_size);
+  // The rest is written from where this write ended, without moving it.
+  outpos_ += res;
+  if (outpos_ == outbuf_.size()) {
+    ClearOutBuffer();
   }
-  outbuf_.SetSize(new_size);
   return res;
 }
 
 void AsyncTCPSocketBase::AppendToOutBuffer(const void* pv, size_t cb) {
-  RTC_DCHECK(outbuf_.size() + cb <= max_outsize_);
+  RTC_DCHECK(outbuf_.size() - outpos_ + cb <= max_outsize_);
   RTC_DCHECK(!listen_);
+  if (outpos_ > 0) {
+    size_t size = outbuf_.size() - outpos_;
+    memmove(outbuf_.data(), outbuf_.data() + outpos_, size);
+    outbuf_.SetSize(size);
+    outpos_ = 0;
+  }
   outbuf_.AppendData(static_cast<const uint8_t*>(pv), cb);
 }
 
@@ -252,11 +292,11 @@ void AsyncTCPSocketBase::OnReadEvent(AsyncSocket* socket) {
 void AsyncTCPSocketBase::OnWriteEvent(AsyncSocket* socket) {
   RTC_DCHECK(socket_.get() == socket);
 
-  if (outbuf_.size() > 0) {
+  if (!IsOutBufferEmpty()) {
     FlushOutBuffer();
   }
 
-  if (outbuf_.size() == 0) {
+  if (IsOutBufferEmpty()) {
     SignalReadyToSend(this);
   }
 }
@@ -293,13 +333,12 @@ int AsyncTCPSocket::Send(const void* pv,
     return static_cast<int>(cb);
 
   PacketLength pkt_len = HostToNetwork16(static_cast<PacketLength>(cb));
-  AppendToOutBuffer(&pkt_len, kPacketLenSize);
-  AppendToOutBuffer(pv, cb);
-
-  int res = FlushOutBuffer();
+  const SendSegment segments[] = {
+      {reinterpret_cast<const char*>(&pkt_len), kPacketLenSize},
+      {static_cast<const char*>(pv), cb}};
+  int res = SendPacket(segments, arraysize(segments));
   if (res <= 0) {
     // drop packet if we made no progress
-    ClearOutBuffer();
     return res;
   }
 
@@ -315,21 +354,27 @@ int AsyncTCPSocket::Send(const void* pv,
 void AsyncTCPSocket::ProcessInput(char* data, size_t* len) {
   SocketAddress remote_addr(GetRemoteAddress());
 
+  // The packets are signaled where they are; only an incomplete one at the
+  // end is moved to the front, once.
+  size_t processed = 0;
   while (true) {
-    if (*len < kPacketLenSize)
-      return;
+    size_t remaining = *len - processed;
+    if (remaining < kPacketLenSize)
+      break;
 
-    PacketLength pkt_len = rtc::GetBE16(data);
-    if (*len < kPacketLenSize + pkt_len)
-      return;
+    PacketLength pkt_len = rtc::GetBE16(data + processed);
+    if (remaining < kPacketLenSize + pkt_len)
+      break;
 
-    SignalReadPacket(this, data + kPacketLenSize, pkt_len, remote_addr,
-                     TimeMicros());
+    SignalReadPacket(this, data + processed + kPacketLenSize, pkt_len,
+                     remote_addr, TimeMicros());
 
-    *len -= kPacketLenSize + pkt_len;
-    if (*len > 0) {
-      memmove(data, data + kPacketLenSize + pkt_len, *len);
-    }
+    processed += kPacketLenSize + pkt_len;
+  }
+
+  *len -= processed;
+  if (processed > 0 && *len > 0) {
+    memmove(data, data + processed, *len);
   }
 }
 
@@ -62,13 +62,22 @@ class AsyncTCPSocketBase : public AsyncPacketSocket {
                                     const SocketAddress& bind_address,
                                     const SocketAddress& remote_address);
   virtual int SendRaw(const void* pv, size_t cb);
+  // Writes the |count| segments of one packet with a single gathered write,
+  // without copying them first. Whatever the socket does not take is copied
+  // to |outbuf_| and written when the socket becomes writable. Returns the
+  // number of bytes written; if that is not positive, nothing is kept and the
+  // packet is dropped. The out buffer must be empty.
+  int SendPacket(const SendSegment* segments, size_t count);
   int FlushOutBuffer();
   // Add data to |outbuf_|.
   void AppendToOutBuffer(const void* pv, size_t cb);
 
   // Helper methods for |outpos_|.
-  bool IsOutBufferEmpty() const { return outbuf_.size() == 0; }
-  void ClearOutBuffer() { outbuf_.Clear(); }
+  bool IsOutBufferEmpty() const { return outbuf_.size() == outpos_; }
+  void ClearOutBuffer() {
+    outbuf_.Clear();
+    outpos_ = 0;
+  }
 
  private:
   // Called by the underlying socket
@@ -81,6 +90,8 @@ class AsyncTCPSocketBase : public AsyncPacketSocket {
   bool listen_;
   Buffer inbuf_;
   Buffer outbuf_;
+  // The offset in |outbuf_| of the data that is not written yet.
+  size_t outpos_ = 0;
   size_t max_insize_;
   size_t max_outsize_;
 
@@ -16,14 +16,22 @@
 
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/location.h"
 #include "rtc_base/network/sent_packet.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
 #include "rtc_base/time_utils.h"
 
 namespace rtc {
 
 static const int BUF_SIZE = 64 * 1024;
 
+// Maximum number of packets queued in send batching mode before the batch is
+// flushed without waiting for the end of the message loop iteration.
+static const size_t kMaxSendBatchSize = 64;
+
+enum { MSG_FLUSH_SEND_BATCH };
+
 AsyncUDPSocket* AsyncUDPSocket::Create(AsyncSocket* socket,
                                        const SocketAddress& bind_address) {
   std::unique_ptr<AsyncSocket> owned_socket(socket);
@@ -79,15 +87,49 @@ int AsyncUDPSocket::SendTo(const void* pv,
                            size_t cb,
                            const SocketAddress& addr,
                            const rtc::PacketOptions& options) {
+  const SendSegment segment = {static_cast<const char*>(pv), cb};
+  return SendToV(&segment, 1, addr, options);
+}
+
+int AsyncUDPSocket::SendToV(const SendSegment* segments,
+                            size_t count,
+                            const SocketAddress& addr,
+                            const rtc::PacketOptions& options) {
+  size_t cb = 0;
+  for (size_t i = 0; i < count; ++i)
+    cb += segments[i].length;
+  if (send_batching_) {
+    pending_sends_.push_back(
+        PendingSend{send_batch_buf_.size(), cb, addr, options});
+    for (size_t i = 0; i < count; ++i) {
+      send_batch_buf_.AppendData(
+          reinterpret_cast<const uint8_t*>(segments[i].data),
+          segments[i].length);
+    }
+    if (pending_sends_.size() >= kMaxSendBatchSize) {
+      FlushSendBatch();
+    } else if (!flush_posted_) {
+      Thread* thread = Thread::Current();
+      if (thread) {
+        flush_posted_ = true;
+        thread->Post(RTC_FROM_HERE, this, MSG_FLUSH_SEND_BATCH);
+      } else {
+        FlushSendBatch();
+      }
+    }
+    return static_cast<int>(cb);
+  }
+
   rtc::SentPacket sent_packet(options.packet_id, rtc::TimeMillis(),
                               options.info_signaled_after_sent);
   CopySocketInformationToPacketInfo(cb, *this, true, &sent_packet.info);
-  int ret = socket_->SendTo(pv, cb, addr);
+  int ret = socket_->SendToV(segments, count, addr);
   SignalSentPacket(this, sent_packet);
   return ret;
 }
 
 int AsyncUDPSocket::Close() {
+  FlushSendBatch();
   return socket_->Close();
 }
 
@@ -111,9 +153,74 @@ void AsyncUDPSocket::SetError(int error) {
   return socket_->SetError(error);
 }
 
+void AsyncUDPSocket::SetSendBatchingEnabled(bool enabled) {
+  if (!enabled)
+    FlushSendBatch();
+  send_batching_ = enabled;
+}
+
+void AsyncUDPSocket::FlushSendBatch() {
+  if (pending_sends_.empty())
+    return;
+
+  std::vector<SendBatchEntry> entries(pending_sends_.size());
+  for (size_t i = 0; i < pending_sends_.size(); ++i) {
+    entries[i].data =
+        send_batch_buf_.data<char>() + pending_sends_[i].offset;
+    entries[i].length = pending_sends_[i].size;
+    entries[i].addr = pending_sends_[i].addr;
+  }
+
+  size_t sent = 0;
+  while (sent < entries.size()) {
+    int ret = socket_->SendToBatch(&entries[sent], entries.size() - sent);
+    int64_t now_ms = TimeMillis();
+    if (ret <= 0) {
+      // Like a failed SendTo(), the remaining packets are dropped.
+      RTC_LOG(LS_VERBOSE) << "AsyncUDPSocket dropped "
+                          << entries.size() - sent
+                          << " batched packets, error " << socket_->GetError();
+      break;
+    }
+    for (size_t i = sent; i < sent + static_cast<size_t>(ret); ++i) {
+      const PacketOptions& options = pending_sends_[i].options;
+      rtc::SentPacket sent_packet(options.packet_id, now_ms,
+                                  options.info_signaled_after_sent);
+      CopySocketInformationToPacketInfo(entries[i].length, *this, true,
+                                        &sent_packet.info);
+      SignalSentPacket(this, sent_packet);
+    }
+    sent += ret;
+  }
+  pending_sends_.clear();
+  send_batch_buf_.Clear();
+}
+
+void AsyncUDPSocket::OnMessage(Message* msg) {
+  RTC_DCHECK_EQ(MSG_FLUSH_SEND_BATCH, msg->message_id);
+  flush_posted_ = false;
+  FlushSendBatch();
+}
+
+void AsyncUDPSocket::SetRecvBatchSize(size_t max_batch_size) {
+  RTC_DCHECK_GT(max_batch_size, 0);
+  if (max_batch_size <= 1) {
+    batch_entries_.clear();
+    batch_buf_.reset();
+    return;
+  }
+  batch_buf_.reset(new char[max_batch_size * kRecvBatchSlotSize]);
+  batch_entries_.resize(max_batch_size);
+}
+
 void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
   RTC_DCHECK(socket_.get() == socket);
 
+  if (!batch_entries_.empty()) {
+    ReadBatch();
+    return;
+  }
+
   SocketAddress remote_addr;
   int64_t timestamp;
   int len = socket_->RecvFrom(buf_, size_, &remote_addr, &timestamp);
@@ -134,6 +241,32 @@ void AsyncUDPSocket::OnReadEvent(AsyncSocket* socket) {
                    (timestamp > -1 ? timestamp : TimeMicros()));
 }
 
+void AsyncUDPSocket::ReadBatch() {
+  for (size_t i = 0; i < batch_entries_.size(); ++i) {
+    batch_entries_[i].buffer = &batch_buf_[i * kRecvBatchSlotSize];
+    batch_entries_[i].capacity = kRecvBatchSlotSize;
+  }
+  int count =
+      socket_->RecvFromBatch(batch_entries_.data(), batch_entries_.size());
+  if (count < 0) {
+    // See OnReadEvent() for why errors are only logged.
+    if (!socket_->IsBlocking()) {
+      SocketAddress local_addr = socket_->GetLocalAddress();
+      RTC_LOG(LS_INFO) << "AsyncUDPSocket[" << local_addr.ToSensitiveString()
+                       << "] batched receive failed with error "
+                       << socket_->GetError();
+    }
+    return;
+  }
+
+  int64_t now_us = TimeMicros();
+  for (int i = 0; i < count; ++i) {
+    const RecvBatchEntry& entry = batch_entries_[i];
+    SignalReadPacket(this, entry.buffer, entry.length, entry.addr,
+                     (entry.timestamp > -1 ? entry.timestamp : now_us));
+  }
+}
+
 void AsyncUDPSocket::OnWriteEvent(AsyncSocket* socket) {
   SignalReadyToSend(this);
 }
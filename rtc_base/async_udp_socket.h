@@ -14,9 +14,12 @@
 #include <stddef.h>
 
 #include <memory>
+#include <vector>
 
 #include "rtc_base/async_packet_socket.h"
 #include "rtc_base/async_socket.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/message_handler.h"
 #include "rtc_base/socket.h"
 #include "rtc_base/socket_address.h"
 #include "rtc_base/socket_factory.h"
@@ -25,7 +28,7 @@ namespace rtc {
 
 // Provides the ability to receive packets asynchronously.  Sends are not
 // buffered since it is acceptable to drop packets under high load.
-class AsyncUDPSocket : public AsyncPacketSocket {
+class AsyncUDPSocket : public AsyncPacketSocket, public MessageHandler {
  public:
   // Binds |socket| and creates AsyncUDPSocket for it. Takes ownership
   // of |socket|. Returns null if bind() fails (|socket| is destroyed
@@ -48,6 +51,12 @@ class AsyncUDPSocket : public AsyncPacketSocket {
              size_t cb,
              const SocketAddress& addr,
              const rtc::PacketOptions& options) override;
+  // Sends the segments as one datagram with a gathered write, or appends
+  // them to the pending batch in batching mode.
+  int SendToV(const SendSegment* segments,
+              size_t count,
+              const SocketAddress& addr,
+              const rtc::PacketOptions& options) override;
   int Close() override;
 
   State GetState() const override;
@@ -56,15 +65,55 @@ class AsyncUDPSocket : public AsyncPacketSocket {
   int GetError() const override;
   void SetError(int error) override;
 
+  // Enables reading up to |max_batch_size| datagrams per read event, using a
+  // single system call where the underlying socket supports it. Each datagram
+  // is still delivered through SignalReadPacket. A size of 1 (the default)
+  // disables batching.
+  void SetRecvBatchSize(size_t max_batch_size);
+
+  // Every slot can hold the largest UDP datagram, like the buffer used for
+  // unbatched reads. The slots are not initialized, so only the pages the
+  // kernel writes to are backed by memory.
+  static const size_t kRecvBatchSlotSize = 64 * 1024;
+
+  // Enables deferred sending. While enabled, SendTo() queues the packet and
+  // returns immediately; all packets queued during the current message loop
+  // iteration of the calling thread are then handed to the socket with one
+  // SendToBatch() call, and SignalSentPacket is emitted as they go out.
+  void SetSendBatchingEnabled(bool enabled);
+
+  // Sends all packets queued by SetSendBatchingEnabled() mode.
+  void FlushSendBatch();
+
+  // MessageHandler:
+  void OnMessage(Message* msg) override;
+
  private:
+  struct PendingSend {
+    size_t offset;
+    size_t size;
+    SocketAddress addr;
+    PacketOptions options;
+  };
+
   // Called when the underlying socket is ready to be read from.
   void OnReadEvent(AsyncSocket* socket);
+  void ReadBatch();
   // Called when the underlying socket is ready to send.
   void OnWriteEvent(AsyncSocket* socket);
 
   std::unique_ptr<AsyncSocket> socket_;
   char* buf_;
   size_t size_;
+  // Pooled receive buffers for batched reads, one slot per batch entry.
+  std::unique_ptr<char[]> batch_buf_;
+  std::vector<RecvBatchEntry> batch_entries_;
+  // Queued outgoing packets in send batching mode. |send_batch_buf_| keeps
+  // its capacity between flushes.
+  bool send_batching_ = false;
+  bool flush_posted_ = false;
+  Buffer send_batch_buf_;
+  std::vector<PendingSend> pending_sends_;
 };
 
 }  // namespace rtc
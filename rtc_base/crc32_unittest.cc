@@ -11,10 +11,27 @@
 #include "rtc_base/crc32.h"
 
 #include <string>
+#include <vector>
 
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
 #include "test/gtest.h"
 
 namespace rtc {
+namespace {
+
+// Bit by bit implementation of RFC 1952.
+uint32_t ReferenceCrc32(const uint8_t* buf, size_t len) {
+  uint32_t c = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; ++i) {
+    c ^= buf[i];
+    for (int j = 0; j < 8; ++j)
+      c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+  }
+  return c ^ 0xFFFFFFFF;
+}
+
+}  // namespace
 
 TEST(Crc32Test, TestBasic) {
   EXPECT_EQ(0U, ComputeCrc32(""));
@@ -34,4 +51,45 @@ TEST(Crc32Test, TestMultipleUpdates) {
   EXPECT_EQ(0x171A3F5FU, c);
 }
 
+// Covers the lengths and alignments where the implementations that process
+// several bytes per step switch to their tail handling.
+TEST(Crc32Test, TestMatchesReferenceForAllLengthsAndAlignments) {
+  std::vector<uint8_t> data(600);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  for (size_t offset = 0; offset < 16; ++offset) {
+    for (size_t len = 0; len + offset <= data.size(); ++len) {
+      ASSERT_EQ(ReferenceCrc32(&data[offset], len),
+                ComputeCrc32(&data[offset], len))
+          << "offset " << offset << ", len " << len;
+    }
+  }
+}
+
+TEST(Crc32Test, TestSplitUpdatesOfLongInput) {
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i ^ (i >> 3));
+  uint32_t expected = ReferenceCrc32(data.data(), data.size());
+  for (size_t split : {1, 63, 64, 65, 200, 999}) {
+    uint32_t c = UpdateCrc32(0, data.data(), split);
+    EXPECT_EQ(expected,
+              UpdateCrc32(c, data.data() + split, data.size() - split));
+  }
+}
+
+TEST(Crc32Test, DISABLED_Throughput) {
+  static const int kIterations = 1000000;
+  for (size_t len : {20, 100, 1200}) {
+    std::vector<uint8_t> data(len, 0xA5);
+    uint32_t c = 0;
+    int64_t start_us = TimeMicros();
+    for (int i = 0; i < kIterations; ++i)
+      c = UpdateCrc32(c, data.data(), data.size());
+    int64_t elapsed_us = TimeMicros() - start_us;
+    RTC_LOG(LS_INFO) << "CRC32 of " << len << " bytes: "
+                     << elapsed_us * 1000 / kIterations << " ns (" << c << ")";
+  }
+}
+
 }  // namespace rtc
@@ -14,9 +14,17 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "absl/base/attributes.h"
+#include "absl/base/config.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/critical_section.h"
@@ -29,8 +37,6 @@
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
 
-// This is a guesstimate that should be enough in most cases.
-static const size_t kEventLoggerArgsStrBufferInitialSize = 256;
 static const size_t kTraceArgBufferLength = 32;
 
 namespace webrtc {
@@ -79,11 +85,625 @@ namespace rtc {
 namespace tracing {
 namespace {
 
-static void EventTracingThreadFunc(void* params);
+// Events kept per thread. Streaming captures drain the buffers every
+// kLoggingIntervalMs, recordings keep the latest events until overwritten.
+const size_t kMaxEventsPerThread = 8192;
+const int kLoggingIntervalMs = 100;
+// trace_event.h passes at most two arguments.
+const int kMaxArgs = 2;
+const char kDefaultCategories[] = "*";
+static const char* const kDisabledTracePrefix = TRACE_DISABLED_BY_DEFAULT("");
 
 // Atomic-int fast path for avoiding logging when disabled.
 static volatile int g_event_logging_active = 0;
 
+// The enabled flag handed out by GetCategoryEnabled() and cached by the
+// TRACE_EVENT macros. |enabled| must stay the first member, so that the flag
+// pointer converts back to the state. It is written under
+// |g_categories_lock| but read by the macros on any thread, which see it as a
+// plain byte.
+struct CategoryState {
+  explicit CategoryState(const char* name) : enabled(0), name(name) {}
+
+  std::atomic<unsigned char> enabled;
+  // Points into the key of the category map.
+  const char* const name;
+};
+static_assert(std::is_standard_layout<CategoryState>::value,
+              "CategoryState must be standard layout");
+static_assert(sizeof(std::atomic<unsigned char>) == 1,
+              "The enabled flag must be readable as a single byte");
+
+const CategoryState* ToCategoryState(const unsigned char* category_enabled) {
+  return reinterpret_cast<const CategoryState*>(category_enabled);
+}
+
+// Category states live forever, since the TRACE_EVENT macros keep pointers to
+// them in statics.
+ABSL_CONST_INIT GlobalLock g_categories_lock;
+
+std::map<std::string, CategoryState*>& Categories()
+    RTC_EXCLUSIVE_LOCKS_REQUIRED(g_categories_lock) {
+  static std::map<std::string, CategoryState*>* const categories =
+      new std::map<std::string, CategoryState*>();
+  return *categories;
+}
+
+std::string& CategoryFilter() RTC_EXCLUSIVE_LOCKS_REQUIRED(g_categories_lock) {
+  static std::string* const filter = new std::string(kDefaultCategories);
+  return *filter;
+}
+
+bool IsDisabledByDefault(const std::string& category) {
+  return category.compare(0, strlen(kDisabledTracePrefix),
+                          kDisabledTracePrefix) == 0;
+}
+
+// Splits at commas and drops surrounding spaces.
+std::vector<std::string> SplitCategories(const std::string& list) {
+  std::vector<std::string> result;
+  size_t begin = 0;
+  while (begin <= list.size()) {
+    size_t end = list.find(',', begin);
+    if (end == std::string::npos)
+      end = list.size();
+    size_t first = list.find_first_not_of(' ', begin);
+    size_t last = list.find_last_not_of(' ', end == 0 ? 0 : end - 1);
+    if (first < end && last != std::string::npos && last >= first)
+      result.push_back(list.substr(first, last - first + 1));
+    begin = end + 1;
+  }
+  return result;
+}
+
+// A category group, like "webrtc,webrtc_stats", is enabled if one of its
+// categories is. "*" matches all categories that are not disabled by default,
+// and "-category" excludes one.
+bool CategoryGroupMatches(const std::string& filter, const std::string& group) {
+  const std::vector<std::string> filter_entries = SplitCategories(filter);
+  for (const std::string& category : SplitCategories(group)) {
+    bool included = false;
+    bool excluded = false;
+    for (const std::string& entry : filter_entries) {
+      if (entry[0] == '-') {
+        excluded |= entry.compare(1, std::string::npos, category) == 0;
+      } else if (entry == "*") {
+        included |= !IsDisabledByDefault(category);
+      } else {
+        included |= entry == category;
+      }
+    }
+    if (included && !excluded)
+      return true;
+  }
+  return false;
+}
+
+void UpdateCategory(CategoryState* state)
+    RTC_EXCLUSIVE_LOCKS_REQUIRED(g_categories_lock) {
+  bool enabled = rtc::AtomicOps::AcquireLoad(&g_event_logging_active) &&
+                 CategoryGroupMatches(CategoryFilter(), state->name);
+  state->enabled.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+// Called when capturing starts or stops, or the filter changes.
+void UpdateCategories() {
+  GlobalLockScope lock(&g_categories_lock);
+  for (auto& kv : Categories())
+    UpdateCategory(kv.second);
+}
+
+struct TraceArg {
+  const char* name;
+  unsigned char type;
+  // Copied from webrtc/rtc_base/trace_event.h TraceValueUnion.
+  union TraceArgValue {
+    bool as_bool;
+    unsigned long long as_uint;
+    long long as_int;
+    double as_double;
+    const void* as_pointer;
+    const char* as_string;
+  } value;
+
+  // Assert that the size of the union is equal to the size of the as_uint
+  // field since we are assigning to arbitrary types using it.
+  static_assert(sizeof(TraceArgValue) == sizeof(unsigned long long),
+                "Size of TraceArg value union is not equal to the size of "
+                "the uint field of that union.");
+};
+
+struct TraceEvent {
+  // Points into |copied_strings| for events with TRACE_EVENT_FLAG_COPY.
+  const char* name;
+  const CategoryState* category;
+  char phase;
+  unsigned long long id;
+  int num_args;
+  TraceArg args[kMaxArgs];
+  uint64_t timestamp;
+  int pid;
+  rtc::PlatformThreadId tid;
+  // Copies of temporary strings; the pointers above are fixed up whenever
+  // the event is copied or moved.
+  std::vector<std::string> copied_strings;
+};
+
+// Events of one thread, in the order they were added. Only the owning thread
+// adds events, so the lock is contended only while a capture drains the
+// buffer or a recording is dumped.
+class ThreadEventBuffer {
+ public:
+  void Add(TraceEvent event) {
+    rtc::CritScope lock(&crit_);
+    if (events_.size() < kMaxEventsPerThread) {
+      events_.push_back(std::move(event));
+      return;
+    }
+    // Overwrites the oldest event.
+    events_[oldest_] = std::move(event);
+    oldest_ = (oldest_ + 1) % events_.size();
+    ++overwritten_;
+  }
+
+  // Moves the events out, oldest first.
+  void TakeAll(std::vector<TraceEvent>* events) {
+    rtc::CritScope lock(&crit_);
+    for (size_t i = 0; i < events_.size(); ++i)
+      events->push_back(std::move(events_[(oldest_ + i) % events_.size()]));
+    events_.clear();
+    oldest_ = 0;
+  }
+
+  // Copies the events from |timestamp| onwards, oldest first.
+  void CopySince(uint64_t timestamp, std::vector<TraceEvent>* events) const {
+    rtc::CritScope lock(&crit_);
+    for (size_t i = 0; i < events_.size(); ++i) {
+      const TraceEvent& event = events_[(oldest_ + i) % events_.size()];
+      if (event.timestamp >= timestamp)
+        events->push_back(CopyEvent(event));
+    }
+  }
+
+  void Clear() {
+    rtc::CritScope lock(&crit_);
+    events_.clear();
+    oldest_ = 0;
+    overwritten_ = 0;
+  }
+
+  // Number of events overwritten since the last call.
+  size_t TakeOverwritten() {
+    rtc::CritScope lock(&crit_);
+    size_t overwritten = overwritten_;
+    overwritten_ = 0;
+    return overwritten;
+  }
+
+  void Abandon() {
+    rtc::CritScope lock(&crit_);
+    abandoned_ = true;
+  }
+
+  bool abandoned() const {
+    rtc::CritScope lock(&crit_);
+    return abandoned_;
+  }
+
+  static TraceEvent CopyEvent(const TraceEvent& event) {
+    TraceEvent copy = event;
+    FixUpCopiedStrings(event, &copy);
+    return copy;
+  }
+
+  // Points the name and string arguments of |copy| at its own copies of the
+  // strings that |original| copied.
+  static void FixUpCopiedStrings(const TraceEvent& original,
+                                 TraceEvent* copy) {
+    for (size_t i = 0; i < original.copied_strings.size(); ++i) {
+      const char* from = original.copied_strings[i].c_str();
+      const char* to = copy->copied_strings[i].c_str();
+      if (copy->name == from)
+        copy->name = to;
+      for (int arg = 0; arg < copy->num_args; ++arg) {
+        if (copy->args[arg].type == TRACE_VALUE_TYPE_COPY_STRING &&
+            copy->args[arg].value.as_string == from) {
+          copy->args[arg].value.as_string = to;
+        }
+      }
+    }
+  }
+
+ private:
+  rtc::CriticalSection crit_;
+  std::vector<TraceEvent> events_ RTC_GUARDED_BY(crit_);
+  size_t oldest_ RTC_GUARDED_BY(crit_) = 0;
+  size_t overwritten_ RTC_GUARDED_BY(crit_) = 0;
+  bool abandoned_ RTC_GUARDED_BY(crit_) = false;
+};
+
+// Buffers of all threads that traced. They outlive the EventLogger, since
+// threads keep pointers to them; buffers of exited threads are deleted when
+// the next capture starts.
+ABSL_CONST_INIT GlobalLock g_buffers_lock;
+
+std::vector<ThreadEventBuffer*>& ThreadEventBuffers()
+    RTC_EXCLUSIVE_LOCKS_REQUIRED(g_buffers_lock) {
+  static std::vector<ThreadEventBuffer*>* const buffers =
+      new std::vector<ThreadEventBuffer*>();
+  return *buffers;
+}
+
+ThreadEventBuffer* NewThreadEventBuffer() {
+  ThreadEventBuffer* buffer = new ThreadEventBuffer();
+  GlobalLockScope lock(&g_buffers_lock);
+  ThreadEventBuffers().push_back(buffer);
+  return buffer;
+}
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+// Abandons the buffer of a thread when the thread exits. The pointer is kept
+// in a separate, trivially destructible variable, since the destructors of
+// other thread locals may still trace.
+struct ThreadEventBufferOwner {
+  ~ThreadEventBufferOwner();
+  ThreadEventBuffer* buffer = nullptr;
+};
+
+ABSL_CONST_INIT thread_local ThreadEventBuffer* tls_buffer = nullptr;
+ABSL_CONST_INIT thread_local bool tls_buffer_abandoned = false;
+thread_local ThreadEventBufferOwner tls_buffer_owner;
+
+ThreadEventBufferOwner::~ThreadEventBufferOwner() {
+  tls_buffer = nullptr;
+  tls_buffer_abandoned = true;
+  if (buffer)
+    buffer->Abandon();
+}
+#endif
+
+// Returns the buffer of the calling thread, or null once the thread exits.
+ThreadEventBuffer* CurrentThreadEventBuffer() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  if (tls_buffer || tls_buffer_abandoned)
+    return tls_buffer;
+  tls_buffer = NewThreadEventBuffer();
+  tls_buffer_owner.buffer = tls_buffer;
+  return tls_buffer;
+#else
+  // Without thread locals, all threads share one buffer.
+  static ThreadEventBuffer* const shared_buffer = NewThreadEventBuffer();
+  return shared_buffer;
+#endif
+}
+
+std::string TraceArgValueAsString(TraceArg arg) {
+  std::string output;
+
+  if (arg.type == TRACE_VALUE_TYPE_STRING ||
+      arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
+    // Space for every character to be an espaced character + two for
+    // quatation marks.
+    output.reserve(strlen(arg.value.as_string) * 2 + 2);
+    output += '\"';
+    for (const char* c = arg.value.as_string; *c; ++c) {
+      if (*c == '"' || *c == '\\')
+        output += '\\';
+      output += *c;
+    }
+    output += '\"';
+  } else {
+    output.resize(kTraceArgBufferLength);
+    size_t print_length = 0;
+    switch (arg.type) {
+      case TRACE_VALUE_TYPE_BOOL:
+        if (arg.value.as_bool) {
+          strcpy(&output[0], "true");
+          print_length = 4;
+        } else {
+          strcpy(&output[0], "false");
+          print_length = 5;
+        }
+        break;
+      case TRACE_VALUE_TYPE_UINT:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "%llu",
+                                arg.value.as_uint);
+        break;
+      case TRACE_VALUE_TYPE_INT:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "%lld",
+                                arg.value.as_int);
+        break;
+      case TRACE_VALUE_TYPE_DOUBLE:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "%f",
+                                arg.value.as_double);
+        break;
+      case TRACE_VALUE_TYPE_POINTER:
+        print_length = snprintf(&output[0], kTraceArgBufferLength, "\"%p\"",
+                                arg.value.as_pointer);
+        break;
+    }
+    size_t output_length = print_length < kTraceArgBufferLength
+                               ? print_length
+                               : kTraceArgBufferLength - 1;
+    // This will hopefully be very close to nop. On most implementations, it
+    // just writes null byte and sets the length field of the string.
+    output.resize(output_length);
+  }
+
+  return output;
+}
+
+bool PhaseHasId(char phase) {
+  return strchr("STFstf", phase) != nullptr;
+}
+
+// Minimal protobuf encoding for the Perfetto trace format.
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void AppendVarintField(int field, uint64_t value, std::string* out) {
+  AppendVarint(static_cast<uint64_t>(field) << 3, out);
+  AppendVarint(value, out);
+}
+
+void AppendBytesField(int field, const std::string& value, std::string* out) {
+  AppendVarint((static_cast<uint64_t>(field) << 3) | 2, out);
+  AppendVarint(value.size(), out);
+  out->append(value);
+}
+
+void AppendDoubleField(int field, double value, std::string* out) {
+  AppendVarint((static_cast<uint64_t>(field) << 3) | 1, out);
+  char bytes[sizeof(value)];
+  memcpy(bytes, &value, sizeof(value));
+  out->append(bytes, sizeof(bytes));
+}
+
+// Writes events in one of the TraceFormats.
+//
+// The Chrome JSON format is documented here:
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
+// The Perfetto format is a perfetto.protos.Trace, holding a track per thread
+// with begin/end slices; other phases become instant events, with the phase
+// and id as debug annotations.
+class TraceWriter {
+ public:
+  TraceWriter(FILE* file, TraceFormat format) : file_(file), format_(format) {
+    if (format_ == TraceFormat::kChromeJson)
+      fprintf(file_, "{ \"traceEvents\": [\n");
+  }
+
+  ~TraceWriter() {
+    if (format_ == TraceFormat::kChromeJson)
+      fprintf(file_, "]}\n");
+    fflush(file_);
+  }
+
+  void Write(const TraceEvent& event) {
+    if (format_ == TraceFormat::kChromeJson) {
+      WriteJson(event);
+    } else {
+      WritePerfetto(event);
+    }
+  }
+
+ private:
+  void WriteJson(const TraceEvent& e) {
+    args_str_.clear();
+    if (e.num_args > 0) {
+      args_str_ += ", \"args\": {";
+      for (int i = 0; i < e.num_args; ++i) {
+        if (i > 0)
+          args_str_ += ",";
+        args_str_ += " \"";
+        args_str_ += e.args[i].name;
+        args_str_ += "\": ";
+        args_str_ += TraceArgValueAsString(e.args[i]);
+      }
+      args_str_ += " }";
+    }
+    char id_str[32] = "";
+    if (PhaseHasId(e.phase))
+      snprintf(id_str, sizeof(id_str), ", \"id\": \"0x%llx\"", e.id);
+    fprintf(file_,
+            "%s{ \"name\": \"%s\""
+            ", \"cat\": \"%s\""
+            ", \"ph\": \"%c\""
+            ", \"ts\": %" PRIu64
+            ", \"pid\": %d"
+#if defined(WEBRTC_WIN)
+            ", \"tid\": %lu"
+#else
+            ", \"tid\": %d"
+#endif  // defined(WEBRTC_WIN)
+            "%s%s"
+            "}\n",
+            has_logged_event_ ? "," : " ", e.name, e.category->name, e.phase,
+            e.timestamp, e.pid, e.tid, id_str, args_str_.c_str());
+    has_logged_event_ = true;
+  }
+
+  // Field numbers from perfetto/protos/perfetto/trace.
+  enum : int {
+    kTracePacket = 1,             // Trace.
+    kTimestamp = 8,               // TracePacket.
+    kTrustedSequenceId = 10,      // TracePacket.
+    kTrackEvent = 11,             // TracePacket.
+    kSequenceFlags = 13,          // TracePacket.
+    kTrackDescriptor = 60,        // TracePacket.
+    kDebugAnnotations = 4,        // TrackEvent.
+    kType = 9,                    // TrackEvent.
+    kTrackUuid = 11,              // TrackEvent.
+    kCategories = 22,             // TrackEvent.
+    kName = 23,                   // TrackEvent.
+    kUuid = 1,                    // TrackDescriptor.
+    kThread = 4,                  // TrackDescriptor.
+    kPid = 1,                     // ThreadDescriptor.
+    kTid = 2,                     // ThreadDescriptor.
+    kAnnotationBool = 2,          // DebugAnnotation.
+    kAnnotationUint = 3,          // DebugAnnotation.
+    kAnnotationInt = 4,           // DebugAnnotation.
+    kAnnotationDouble = 5,        // DebugAnnotation.
+    kAnnotationString = 6,        // DebugAnnotation.
+    kAnnotationPointer = 7,       // DebugAnnotation.
+    kAnnotationName = 10,         // DebugAnnotation.
+  };
+  enum : uint64_t {
+    kSliceBegin = 1,  // TrackEvent.Type.
+    kSliceEnd = 2,
+    kInstant = 3,
+    kIncrementalStateCleared = 1,  // TracePacket.SequenceFlags.
+  };
+  static const uint64_t kSequenceId = 1;
+
+  static uint64_t TrackUuid(rtc::PlatformThreadId tid) {
+    return static_cast<uint64_t>(tid) + 1;
+  }
+
+  void WritePacket(const std::string& packet) {
+    std::string framed;
+    AppendBytesField(kTracePacket, packet, &framed);
+    fwrite(framed.data(), 1, framed.size(), file_);
+  }
+
+  void WritePerfetto(const TraceEvent& e) {
+    if (described_threads_.insert(e.tid).second) {
+      std::string thread;
+      AppendVarintField(kPid, e.pid, &thread);
+      AppendVarintField(kTid, static_cast<uint64_t>(e.tid), &thread);
+      std::string track;
+      AppendVarintField(kUuid, TrackUuid(e.tid), &track);
+      AppendBytesField(kThread, thread, &track);
+      std::string packet;
+      AppendVarintField(kTrustedSequenceId, kSequenceId, &packet);
+      if (!has_logged_event_) {
+        AppendVarintField(kSequenceFlags, kIncrementalStateCleared, &packet);
+        has_logged_event_ = true;
+      }
+      AppendBytesField(kTrackDescriptor, track, &packet);
+      WritePacket(packet);
+    }
+
+    std::string track_event;
+    uint64_t type = e.phase == TRACE_EVENT_PHASE_BEGIN
+                        ? kSliceBegin
+                        : e.phase == TRACE_EVENT_PHASE_END ? kSliceEnd
+                                                           : kInstant;
+    AppendVarintField(kType, type, &track_event);
+    AppendVarintField(kTrackUuid, TrackUuid(e.tid), &track_event);
+    AppendBytesField(kCategories, e.category->name, &track_event);
+    if (type != kSliceEnd)
+      AppendBytesField(kName, e.name, &track_event);
+    if (type == kInstant) {
+      std::string annotation;
+      AppendBytesField(kAnnotationName, "phase", &annotation);
+      AppendBytesField(kAnnotationString, std::string(1, e.phase),
+                       &annotation);
+      AppendBytesField(kDebugAnnotations, annotation, &track_event);
+      if (PhaseHasId(e.phase)) {
+        annotation.clear();
+        AppendBytesField(kAnnotationName, "id", &annotation);
+        AppendVarintField(kAnnotationUint, e.id, &annotation);
+        AppendBytesField(kDebugAnnotations, annotation, &track_event);
+      }
+    }
+    for (int i = 0; i < e.num_args; ++i) {
+      const TraceArg& arg = e.args[i];
+      std::string annotation;
+      AppendBytesField(kAnnotationName, arg.name, &annotation);
+      switch (arg.type) {
+        case TRACE_VALUE_TYPE_BOOL:
+          AppendVarintField(kAnnotationBool, arg.value.as_bool, &annotation);
+          break;
+        case TRACE_VALUE_TYPE_UINT:
+          AppendVarintField(kAnnotationUint, arg.value.as_uint, &annotation);
+          break;
+        case TRACE_VALUE_TYPE_INT:
+          AppendVarintField(kAnnotationInt,
+                            static_cast<uint64_t>(arg.value.as_int),
+                            &annotation);
+          break;
+        case TRACE_VALUE_TYPE_DOUBLE:
+          AppendDoubleField(kAnnotationDouble, arg.value.as_double,
+                            &annotation);
+          break;
+        case TRACE_VALUE_TYPE_POINTER:
+          AppendVarintField(kAnnotationPointer,
+                            reinterpret_cast<uintptr_t>(arg.value.as_pointer),
+                            &annotation);
+          break;
+        default:
+          AppendBytesField(kAnnotationString, arg.value.as_string,
+                           &annotation);
+          break;
+      }
+      AppendBytesField(kDebugAnnotations, annotation, &track_event);
+    }
+
+    std::string packet;
+    AppendVarintField(kTimestamp, e.timestamp * 1000, &packet);
+    AppendVarintField(kTrustedSequenceId, kSequenceId, &packet);
+    AppendBytesField(kTrackEvent, track_event, &packet);
+    WritePacket(packet);
+  }
+
+  FILE* const file_;
+  const TraceFormat format_;
+  bool has_logged_event_ = false;
+  std::string args_str_;
+  std::set<rtc::PlatformThreadId> described_threads_;
+};
+
+FILE* OpenTraceFile(const char* filename, TraceFormat format) {
+  FILE* file = fopen(filename, format == TraceFormat::kPerfetto ? "wb" : "w");
+  if (!file) {
+    RTC_LOG(LS_ERROR) << "Failed to open trace file '" << filename
+                      << "' for writing.";
+  }
+  return file;
+}
+
+// Collects the events of all threads, ordered by time.
+std::vector<TraceEvent> CollectEvents(bool take, uint64_t since) {
+  std::vector<TraceEvent> events;
+  {
+    GlobalLockScope lock(&g_buffers_lock);
+    for (ThreadEventBuffer* buffer : ThreadEventBuffers()) {
+      if (take) {
+        buffer->TakeAll(&events);
+      } else {
+        buffer->CopySince(since, &events);
+      }
+    }
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) {
+                     return a.timestamp < b.timestamp;
+                   });
+  return events;
+}
+
+// Deletes the buffers of exited threads, and empties the others.
+void ResetThreadEventBuffers() {
+  GlobalLockScope lock(&g_buffers_lock);
+  std::vector<ThreadEventBuffer*>& buffers = ThreadEventBuffers();
+  auto abandoned = std::partition(
+      buffers.begin(), buffers.end(),
+      [](const ThreadEventBuffer* buffer) { return !buffer->abandoned(); });
+  for (auto it = abandoned; it != buffers.end(); ++it)
+    delete *it;
+  buffers.erase(abandoned, buffers.end());
+  for (ThreadEventBuffer* buffer : buffers)
+    buffer->Clear();
+}
+
+static void EventTracingThreadFunc(void* params);
+
 // TODO(pbos): Log metadata for all threads, etc.
 class EventLogger final {
  public:
@@ -97,120 +717,119 @@ class EventLogger final {
   void AddTraceEvent(const char* name,
                      const unsigned char* category_enabled,
                      char phase,
+                     unsigned long long id,
                      int num_args,
                      const char** arg_names,
                      const unsigned char* arg_types,
                      const unsigned long long* arg_values,
+                     unsigned char flags,
                      uint64_t timestamp,
                      int pid,
                      rtc::PlatformThreadId thread_id) {
-    std::vector<TraceArg> args(num_args);
-    for (int i = 0; i < num_args; ++i) {
-      TraceArg& arg = args[i];
+    ThreadEventBuffer* buffer = CurrentThreadEventBuffer();
+    if (!buffer)
+      return;
+    RTC_DCHECK_LE(num_args, kMaxArgs);
+    TraceEvent event = {name,
+                        ToCategoryState(category_enabled),
+                        phase,
+                        id,
+                        std::min(num_args, kMaxArgs),
+                        {},
+                        timestamp,
+                        pid,
+                        thread_id,
+                        {}};
+    // The name is temporary too for the TRACE_EVENT_COPY_* macros.
+    if (flags & TRACE_EVENT_FLAG_COPY)
+      event.copied_strings.emplace_back(name);
+    for (int i = 0; i < event.num_args; ++i) {
+      TraceArg& arg = event.args[i];
       arg.name = arg_names[i];
       arg.type = arg_types[i];
       arg.value.as_uint = arg_values[i];
-
       // Value is a pointer to a temporary string, so we have to make a copy.
-      if (arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
-        // Space for the string and for the terminating null character.
-        size_t str_length = strlen(arg.value.as_string) + 1;
-        char* str_copy = new char[str_length];
-        memcpy(str_copy, arg.value.as_string, str_length);
-        arg.value.as_string = str_copy;
-      }
+      if (arg.type == TRACE_VALUE_TYPE_COPY_STRING)
+        event.copied_strings.emplace_back(arg.value.as_string);
     }
-    rtc::CritScope lock(&crit_);
-    trace_events_.push_back(
-        {name, category_enabled, phase, args, timestamp, 1, thread_id});
+    // Points at the copies only once the vector stops growing.
+    size_t copy = 0;
+    if (flags & TRACE_EVENT_FLAG_COPY)
+      event.name = event.copied_strings[copy++].c_str();
+    for (int i = 0; i < event.num_args; ++i) {
+      if (event.args[i].type == TRACE_VALUE_TYPE_COPY_STRING)
+        event.args[i].value.as_string = event.copied_strings[copy++].c_str();
+    }
+    buffer->Add(std::move(event));
   }
 
-  // The TraceEvent format is documented here:
-  // https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU/preview
   void Log() {
     RTC_DCHECK(output_file_);
-    static const int kLoggingIntervalMs = 100;
-    fprintf(output_file_, "{ \"traceEvents\": [\n");
-    bool has_logged_event = false;
-    while (true) {
-      bool shutting_down = shutdown_event_.Wait(kLoggingIntervalMs);
-      std::vector<TraceEvent> events;
-      {
-        rtc::CritScope lock(&crit_);
-        trace_events_.swap(events);
-      }
-      std::string args_str;
-      args_str.reserve(kEventLoggerArgsStrBufferInitialSize);
-      for (TraceEvent& e : events) {
-        args_str.clear();
-        if (!e.args.empty()) {
-          args_str += ", \"args\": {";
-          bool is_first_argument = true;
-          for (TraceArg& arg : e.args) {
-            if (!is_first_argument)
-              args_str += ",";
-            is_first_argument = false;
-            args_str += " \"";
-            args_str += arg.name;
-            args_str += "\": ";
-            args_str += TraceArgValueAsString(arg);
-
-            // Delete our copy of the string.
-            if (arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
-              delete[] arg.value.as_string;
-              arg.value.as_string = nullptr;
-            }
-          }
-          args_str += " }";
-        }
-        fprintf(output_file_,
-                "%s{ \"name\": \"%s\""
-                ", \"cat\": \"%s\""
-                ", \"ph\": \"%c\""
-                ", \"ts\": %" PRIu64
-                ", \"pid\": %d"
-#if defined(WEBRTC_WIN)
-                ", \"tid\": %lu"
-#else
-                ", \"tid\": %d"
-#endif  // defined(WEBRTC_WIN)
-                "%s"
-                "}\n",
-                has_logged_event ? "," : " ", e.name, e.category_enabled,
-                e.phase, e.timestamp, e.pid, e.tid, args_str.c_str());
-        has_logged_event = true;
+    {
+      TraceWriter writer(output_file_, output_format_);
+      while (true) {
+        bool shutting_down = shutdown_event_.Wait(kLoggingIntervalMs);
+        for (const TraceEvent& event : CollectEvents(/*take=*/true, 0))
+          writer.Write(event);
+        if (shutting_down)
+          break;
       }
-      if (shutting_down)
-        break;
     }
-    fprintf(output_file_, "]}\n");
     if (output_file_owned_)
       fclose(output_file_);
     output_file_ = nullptr;
   }
 
-  void Start(FILE* file, bool owned) {
+  // Returns false, and leaves |file| to the caller, while a capture or
+  // recording already runs.
+  bool Start(FILE* file, bool owned, TraceFormat format) {
     RTC_DCHECK(thread_checker_.IsCurrent());
     RTC_DCHECK(file);
+    if (IsActive())
+      return false;
     RTC_DCHECK(!output_file_);
     output_file_ = file;
     output_file_owned_ = owned;
-    {
-      rtc::CritScope lock(&crit_);
-      // Since the atomic fast-path for adding events to the queue can be
-      // bypassed while the logging thread is shutting down there may be some
-      // stale events in the queue, hence the vector needs to be cleared to not
-      // log events from a previous logging session (which may be days old).
-      trace_events_.clear();
-    }
-    // Enable event logging (fast-path). This should be disabled since starting
-    // shouldn't be done twice.
-    RTC_CHECK_EQ(0,
-                 rtc::AtomicOps::CompareAndSwap(&g_event_logging_active, 0, 1));
-
+    output_format_ = format;
+    streaming_.store(true);
+    EnableRecording();
     // Finally start, everything should be set up now.
     logging_thread_.Start();
     TRACE_EVENT_INSTANT0("webrtc", "EventLogger::Start");
+    return true;
+  }
+
+  // Records into the thread buffers only. Returns false while a capture or
+  // recording already runs.
+  bool StartRecording() {
+    RTC_DCHECK(thread_checker_.IsCurrent());
+    if (IsActive())
+      return false;
+    EnableRecording();
+    return true;
+  }
+
+  static bool IsActive() {
+    return rtc::AtomicOps::AcquireLoad(&g_event_logging_active) != 0;
+  }
+
+  bool Dump(const char* filename, int seconds, TraceFormat format) {
+    if (!IsActive() || streaming_.load()) {
+      return false;
+    }
+    FILE* file = OpenTraceFile(filename, format);
+    if (!file)
+      return false;
+    int64_t since = rtc::TimeMicros() - int64_t{seconds} * 1000000;
+    {
+      TraceWriter writer(file, format);
+      for (const TraceEvent& event :
+           CollectEvents(/*take=*/false, since > 0 ? since : 0)) {
+        writer.Write(event);
+      }
+    }
+    fclose(file);
+    return true;
   }
 
   void Stop() {
@@ -219,111 +838,49 @@ class EventLogger final {
     // Try to stop. Abort if we're not currently logging.
     if (rtc::AtomicOps::CompareAndSwap(&g_event_logging_active, 1, 0) == 0)
       return;
+    UpdateCategories();
 
-    // Wake up logging thread to finish writing.
-    shutdown_event_.Set();
-    // Join the logging thread.
-    logging_thread_.Stop();
-  }
-
- private:
-  struct TraceArg {
-    const char* name;
-    unsigned char type;
-    // Copied from webrtc/rtc_base/trace_event.h TraceValueUnion.
-    union TraceArgValue {
-      bool as_bool;
-      unsigned long long as_uint;
-      long long as_int;
-      double as_double;
-      const void* as_pointer;
-      const char* as_string;
-    } value;
-
-    // Assert that the size of the union is equal to the size of the as_uint
-    // field since we are assigning to arbitrary types using it.
-    static_assert(sizeof(TraceArgValue) == sizeof(unsigned long long),
-                  "Size of TraceArg value union is not equal to the size of "
-                  "the uint field of that union.");
-  };
-
-  struct TraceEvent {
-    const char* name;
-    const unsigned char* category_enabled;
-    char phase;
-    std::vector<TraceArg> args;
-    uint64_t timestamp;
-    int pid;
-    rtc::PlatformThreadId tid;
-  };
+    if (streaming_.exchange(false)) {
+      // Wake up logging thread to finish writing.
+      shutdown_event_.Set();
+      // Join the logging thread.
+      logging_thread_.Stop();
+    }
 
-  static std::string TraceArgValueAsString(TraceArg arg) {
-    std::string output;
-
-    if (arg.type == TRACE_VALUE_TYPE_STRING ||
-        arg.type == TRACE_VALUE_TYPE_COPY_STRING) {
-      // Space for every character to be an espaced character + two for
-      // quatation marks.
-      output.reserve(strlen(arg.value.as_string) * 2 + 2);
-      output += '\"';
-      const char* c = arg.value.as_string;
-      do {
-        if (*c == '"' || *c == '\\') {
-          output += '\\';
-          output += *c;
-        } else {
-          output += *c;
-        }
-      } while (*++c);
-      output += '\"';
-    } else {
-      output.resize(kTraceArgBufferLength);
-      size_t print_length = 0;
-      switch (arg.type) {
-        case TRACE_VALUE_TYPE_BOOL:
-          if (arg.value.as_bool) {
-            strcpy(&output[0], "true");
-            print_length = 4;
-          } else {
-            strcpy(&output[0], "false");
-            print_length = 5;
-          }
-          break;
-        case TRACE_VALUE_TYPE_UINT:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "%llu",
-                                  arg.value.as_uint);
-          break;
-        case TRACE_VALUE_TYPE_INT:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "%lld",
-                                  arg.value.as_int);
-          break;
-        case TRACE_VALUE_TYPE_DOUBLE:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "%f",
-                                  arg.value.as_double);
-          break;
-        case TRACE_VALUE_TYPE_POINTER:
-          print_length = snprintf(&output[0], kTraceArgBufferLength, "\"%p\"",
-                                  arg.value.as_pointer);
-          break;
-      }
-      size_t output_length = print_length < kTraceArgBufferLength
-                                 ? print_length
-                                 : kTraceArgBufferLength - 1;
-      // This will hopefully be very close to nop. On most implementations, it
-      // just writes null byte and sets the length field of the string.
-      output.resize(output_length);
+    size_t overwritten = 0;
+    {
+      GlobalLockScope lock(&g_buffers_lock);
+      for (ThreadEventBuffer* buffer : ThreadEventBuffers())
+        overwritten += buffer->TakeOverwritten();
     }
+    if (overwritten > 0 && output_file_owned_) {
+      RTC_LOG(LS_WARNING) << "Trace capture lost " << overwritten
+                          << " events to full buffers.";
+    }
+  }
 
-    return output;
+ private:
+  // Enables the buffers of all threads, for both a capture and a recording.
+  void EnableRecording() {
+    // Since the atomic fast-path for adding events to the buffers can be
+    // bypassed while the logging thread is shutting down there may be some
+    // stale events, hence the buffers need to be cleared to not log events
+    // from a previous logging session (which may be days old).
+    ResetThreadEventBuffers();
+    // Enable event logging (fast-path). Starting checked that it is disabled.
+    RTC_CHECK_EQ(0,
+                 rtc::AtomicOps::CompareAndSwap(&g_event_logging_active, 0, 1));
+    UpdateCategories();
   }
 
-  rtc::CriticalSection crit_;
-  std::vector<TraceEvent> trace_events_ RTC_GUARDED_BY(crit_);
   rtc::PlatformThread logging_thread_;
   rtc::Event shutdown_event_;
   rtc::ThreadChecker thread_checker_;
   FILE* output_file_ = nullptr;
   bool output_file_owned_ = false;
+  TraceFormat output_format_ = TraceFormat::kChromeJson;
+  // Set while a capture streams to |output_file_|, rather than recording.
+  std::atomic<bool> streaming_{false};
 };
 
 static void EventTracingThreadFunc(void* params) {
@@ -331,17 +888,15 @@ static void EventTracingThreadFunc(void* params) {
 }
 
 static EventLogger* volatile g_event_logger = nullptr;
-static const char* const kDisabledTracePrefix = TRACE_DISABLED_BY_DEFAULT("");
+
 const unsigned char* InternalGetCategoryEnabled(const char* name) {
-  const char* prefix_ptr = &kDisabledTracePrefix[0];
-  const char* name_ptr = name;
-  // Check whether name contains the default-disabled prefix.
-  while (*prefix_ptr == *name_ptr && *prefix_ptr != '\0') {
-    ++prefix_ptr;
-    ++name_ptr;
+  GlobalLockScope lock(&g_categories_lock);
+  auto it = Categories().emplace(name, nullptr).first;
+  if (!it->second) {
+    it->second = new CategoryState(it->first.c_str());
+    UpdateCategory(it->second);
   }
-  return reinterpret_cast<const unsigned char*>(*prefix_ptr == '\0' ? ""
-                                                                    : name);
+  return reinterpret_cast<const unsigned char*>(&it->second->enabled);
 }
 
 void InternalAddTraceEvent(char phase,
@@ -357,8 +912,8 @@ void InternalAddTraceEvent(char phase,
   if (rtc::AtomicOps::AcquireLoad(&g_event_logging_active) == 0)
     return;
 
-  g_event_logger->AddTraceEvent(name, category_enabled, phase, num_args,
-                                arg_names, arg_types, arg_values,
+  g_event_logger->AddTraceEvent(name, category_enabled, phase, id, num_args,
+                                arg_names, arg_types, arg_values, flags,
                                 rtc::TimeMicros(), 1, rtc::CurrentThreadId());
 }
 
@@ -372,31 +927,58 @@ void SetupInternalTracer() {
 }
 
 void StartInternalCaptureToFile(FILE* file) {
+  StartInternalCaptureToFile(file, TraceFormat::kChromeJson);
+}
+
+void StartInternalCaptureToFile(FILE* file, TraceFormat format) {
   if (g_event_logger) {
-    g_event_logger->Start(file, false);
+    g_event_logger->Start(file, false, format);
   }
 }
 
 bool StartInternalCapture(const char* filename) {
-  if (!g_event_logger)
+  return StartInternalCapture(filename, TraceFormat::kChromeJson);
+}
+
+bool StartInternalCapture(const char* filename, TraceFormat format) {
+  // Check first, to not truncate |filename| for nothing.
+  if (!g_event_logger || EventLogger::IsActive())
     return false;
 
-  FILE* file = fopen(filename, "w");
-  if (!file) {
-    RTC_LOG(LS_ERROR) << "Failed to open trace file '" << filename
-                      << "' for writing.";
+  FILE* file = OpenTraceFile(filename, format);
+  if (!file)
+    return false;
+  if (!g_event_logger->Start(file, true, format)) {
+    fclose(file);
     return false;
   }
-  g_event_logger->Start(file, true);
   return true;
 }
 
+bool StartInternalRecording() {
+  return g_event_logger && g_event_logger->StartRecording();
+}
+
+bool DumpInternalRecording(const char* filename,
+                           int seconds,
+                           TraceFormat format) {
+  return g_event_logger && g_event_logger->Dump(filename, seconds, format);
+}
+
 void StopInternalCapture() {
   if (g_event_logger) {
     g_event_logger->Stop();
   }
 }
 
+void SetInternalTraceCategories(const char* categories) {
+  {
+    GlobalLockScope lock(&g_categories_lock);
+    CategoryFilter() = categories;
+  }
+  UpdateCategories();
+}
+
 void ShutdownInternalTracer() {
   StopInternalCapture();
   EventLogger* old_logger = rtc::AtomicOps::AcquireLoadPtr(&g_event_logger);
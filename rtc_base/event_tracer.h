@@ -69,11 +69,35 @@ class EventTracer {
 
 namespace rtc {
 namespace tracing {
+// Output formats of the internal tracer: the JSON read by chrome://tracing, and
+// the protobuf trace read by ui.perfetto.dev.
+enum class TraceFormat { kChromeJson, kPerfetto };
+
 // Set up internal event tracer.
 void SetupInternalTracer();
+// Starts writing all events to a file until StopInternalCapture(). Events are
+// buffered per thread and written from a background thread. Defaults to the
+// Chrome JSON format. Does nothing, returning false, while a capture or
+// recording already runs.
 bool StartInternalCapture(const char* filename);
+bool StartInternalCapture(const char* filename, TraceFormat format);
 void StartInternalCaptureToFile(FILE* file);
+void StartInternalCaptureToFile(FILE* file, TraceFormat format);
+// Starts keeping the latest events of each thread in memory, overwriting the
+// oldest ones, until StopInternalCapture(). DumpInternalRecording() can be
+// called from any thread meanwhile, to write the events of the last |seconds|
+// to |filename| without stopping the recording. It returns false if no
+// recording runs. Starting returns false while a capture or recording already
+// runs.
+bool StartInternalRecording();
+bool DumpInternalRecording(const char* filename,
+                           int seconds,
+                           TraceFormat format);
 void StopInternalCapture();
+// Selects the traced categories, as a comma separated list. "*" matches the
+// categories that are not disabled by default, and a "-" prefix excludes a
+// category. The default is "*". Takes effect immediately.
+void SetInternalTraceCategories(const char* categories);
 // Make sure we run this, this will tear down the internal tracing.
 void ShutdownInternalTracer();
 }  // namespace tracing
@@ -10,10 +10,15 @@
 
 #include "rtc_base/event_tracer.h"
 
+#include <stdio.h>
+
+#include <string>
+
 #include "rtc_base/critical_section.h"
 #include "rtc_base/thread_annotations.h"
 #include "rtc_base/trace_event.h"
 #include "test/gtest.h"
+#include "test/testsupport/file_utils.h"
 
 namespace {
 
@@ -61,6 +66,19 @@ void TraceEventHandler(char /*phase*/,
   TestStatistics::Get()->Increment();
 }
 
+std::string ReadAndRemoveFile(const std::string& path) {
+  std::string contents;
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file) {
+    char buffer[1024];
+    while (size_t read = fread(buffer, 1, sizeof(buffer), file))
+      contents.append(buffer, read);
+    fclose(file);
+  }
+  webrtc::test::RemoveFile(path);
+  return contents;
+}
+
 }  // namespace
 
 namespace webrtc {
@@ -78,4 +96,78 @@ TEST(EventTracerTest, ScopedTraceEvent) {
   TestStatistics::Get()->Reset();
 }
 
+TEST(EventTracerTest, DumpsRecordedEventsOfEnabledCategories) {
+  rtc::tracing::SetupInternalTracer();
+  rtc::tracing::SetInternalTraceCategories("test, -excluded");
+  ASSERT_TRUE(rtc::tracing::StartInternalRecording());
+  TRACE_EVENT_INSTANT1("test", "Included", "value", 7);
+  TRACE_EVENT_INSTANT0("excluded", "Excluded");
+  TRACE_EVENT_INSTANT0("other", "Other");
+  TRACE_EVENT_COPY_INSTANT1("test", std::string("Copied").c_str(), "str",
+                            TRACE_STR_COPY(std::string("copy").c_str()));
+
+  const std::string path =
+      test::TempFilename(test::OutputPath(), "event_tracer");
+  ASSERT_TRUE(rtc::tracing::DumpInternalRecording(
+      path.c_str(), 10, rtc::tracing::TraceFormat::kChromeJson));
+  rtc::tracing::StopInternalCapture();
+  EXPECT_FALSE(rtc::tracing::DumpInternalRecording(
+      path.c_str(), 10, rtc::tracing::TraceFormat::kChromeJson));
+  rtc::tracing::SetInternalTraceCategories("*");
+  rtc::tracing::ShutdownInternalTracer();
+
+  const std::string json = ReadAndRemoveFile(path);
+  EXPECT_NE(std::string::npos,
+            json.find("\"name\": \"Included\", \"cat\": \"test\""));
+  EXPECT_NE(std::string::npos, json.find("\"args\": { \"value\": 7 }"));
+  EXPECT_NE(std::string::npos, json.find("\"name\": \"Copied\""));
+  EXPECT_NE(std::string::npos, json.find("\"str\": \"copy\""));
+  EXPECT_EQ(std::string::npos, json.find("Excluded"));
+  EXPECT_EQ(std::string::npos, json.find("Other"));
+}
+
+TEST(EventTracerTest, CapturesPerfettoTrace) {
+  const std::string path =
+      test::TempFilename(test::OutputPath(), "event_tracer");
+  rtc::tracing::SetupInternalTracer();
+  ASSERT_TRUE(rtc::tracing::StartInternalCapture(
+      path.c_str(), rtc::tracing::TraceFormat::kPerfetto));
+  { TRACE_EVENT0("test", "PerfettoSlice"); }
+  rtc::tracing::StopInternalCapture();
+  rtc::tracing::ShutdownInternalTracer();
+
+  const std::string trace = ReadAndRemoveFile(path);
+  // Each Trace.packet starts with the tag of field 1, length delimited.
+  ASSERT_FALSE(trace.empty());
+  EXPECT_EQ('\x0A', trace[0]);
+  EXPECT_NE(std::string::npos, trace.find("PerfettoSlice"));
+}
+
+TEST(EventTracerTest, DoesNotStartWhileActive) {
+  const std::string path =
+      test::TempFilename(test::OutputPath(), "event_tracer");
+  rtc::tracing::SetupInternalTracer();
+
+  // Capture while recording.
+  ASSERT_TRUE(rtc::tracing::StartInternalRecording());
+  EXPECT_FALSE(rtc::tracing::StartInternalCapture(path.c_str()));
+  EXPECT_FALSE(rtc::tracing::StartInternalRecording());
+  TRACE_EVENT_INSTANT0("test", "StillRecording");
+  ASSERT_TRUE(rtc::tracing::DumpInternalRecording(
+      path.c_str(), 10, rtc::tracing::TraceFormat::kChromeJson));
+  rtc::tracing::StopInternalCapture();
+  EXPECT_NE(std::string::npos,
+            ReadAndRemoveFile(path).find("StillRecording"));
+
+  // Recording while capturing.
+  ASSERT_TRUE(rtc::tracing::StartInternalCapture(path.c_str()));
+  EXPECT_FALSE(rtc::tracing::StartInternalRecording());
+  EXPECT_FALSE(rtc::tracing::StartInternalCapture(path.c_str()));
+  TRACE_EVENT_INSTANT0("test", "StillCapturing");
+  rtc::tracing::StopInternalCapture();
+  rtc::tracing::ShutdownInternalTracer();
+  EXPECT_NE(std::string::npos,
+            ReadAndRemoveFile(path).find("StillCapturing"));
+}
+
 }  // namespace webrtc
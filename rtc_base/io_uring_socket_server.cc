@@ -0,0 +1,894 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/io_uring_socket_server.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/socket_address.h"
+#include "rtc_base/time_utils.h"
+
+// Buffer selection (IORING_OP_PROVIDE_BUFFERS) and the probe interface were
+// added in Linux 5.7.
+#if !defined(IORING_CQE_F_BUFFER) || !defined(IO_URING_OP_SUPPORTED)
+#error "io_uring_socket_server.cc requires Linux 5.7 or newer uapi headers."
+#endif
+
+namespace rtc {
+
+namespace {
+
+// Number of submission queue entries. The completion queue is twice as big.
+const unsigned kRingEntries = 1024;
+// Size of the fixed file table.
+const unsigned kMaxFixedFiles = 1024;
+// Buffer group the receive buffers are provided to.
+const uint16_t kRecvBufferGroup = 0;
+
+int IoUringSetup(unsigned entries, struct io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int fd,
+                 unsigned to_submit,
+                 unsigned min_complete,
+                 unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int fd,
+                    unsigned opcode,
+                    const void* arg,
+                    unsigned nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// The ring indices are shared with the kernel, which reads and writes them
+// concurrently.
+unsigned LoadAcquire(const unsigned* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void StoreRelease(unsigned* p, unsigned value) {
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+}  // namespace
+
+struct IoUringSocketServer::Operation {
+  enum Type { kRecv, kSend };
+
+  Type type = kRecv;
+  // Null once the socket has been closed; the operation then only waits for
+  // its completion to be released.
+  IoUringUdpSocket* socket = nullptr;
+  // Set while the socket is being closed, if the operation is in flight.
+  // Counts down the operations the close waits for.
+  size_t* pending_on_close = nullptr;
+  bool in_flight = false;
+  // Whether the operation is in |pending_cancels_|.
+  bool cancel_pending = false;
+  struct msghdr msg;
+  struct iovec iov;
+  sockaddr_storage addr;
+  // Copy of the payload for sends.
+  std::unique_ptr<char[]> data;
+  size_t capacity = 0;
+};
+
+// A UDP socket whose receives and sends are completed through the ring of
+// the IoUringSocketServer that created it. The descriptor is left in blocking
+// mode so that the kernel waits for readiness internally instead of failing
+// operations with EAGAIN; it is never read from or written to directly.
+class IoUringUdpSocket : public PhysicalSocket {
+ public:
+  explicit IoUringUdpSocket(IoUringSocketServer* ss);
+  ~IoUringUdpSocket() override;
+
+  bool Create(int family, int type) override;
+
+  int Send(const void* pv, size_t cb) override;
+  int SendTo(const void* buffer,
+             size_t length,
+             const SocketAddress& addr) override;
+  int SendToBatch(const SendBatchEntry* entries, size_t count) override;
+
+  int Recv(void* buffer, size_t length, int64_t* timestamp) override;
+  int RecvFrom(void* buffer,
+               size_t length,
+               SocketAddress* out_addr,
+               int64_t* timestamp) override;
+  int RecvFromBatch(RecvBatchEntry* entries, size_t count) override;
+
+  int Close() override;
+
+ protected:
+  int DoClose(SOCKET socket) override;
+
+ private:
+  friend class IoUringSocketServer;
+
+  struct Datagram {
+    uint16_t buffer_id;
+    size_t length;
+    SocketAddress addr;
+    int64_t timestamp;
+  };
+
+  // Queues a send of |length| bytes to |addr|, or to the connected peer if
+  // |addr| is null. Does not submit it.
+  int QueueSend(const void* buffer, size_t length, const SocketAddress* addr);
+  int PopDatagram(void* buffer,
+                  size_t length,
+                  SocketAddress* out_addr,
+                  int64_t* timestamp);
+
+  IoUringSocketServer* const server_;
+  // Index in the fixed file table, or -1 if |s_| is used directly.
+  int file_index_ = -1;
+  std::set<IoUringSocketServer::Operation*> operations_;
+  std::deque<Datagram> received_;
+  size_t sends_in_flight_ = 0;
+  bool write_blocked_ = false;
+};
+
+IoUringUdpSocket::IoUringUdpSocket(IoUringSocketServer* ss)
+    : PhysicalSocket(ss), server_(ss) {}
+
+IoUringUdpSocket::~IoUringUdpSocket() {
+  Close();
+}
+
+bool IoUringUdpSocket::Create(int family, int type) {
+  RTC_DCHECK_EQ(SOCK_DGRAM, type);
+  if (!PhysicalSocket::Create(family, type))
+    return false;
+  file_index_ = server_->RegisterFile(s_);
+  server_->AddSocket(this);
+  for (size_t i = 0; i < IoUringSocketServer::kRecvsPerSocket; ++i) {
+    IoUringSocketServer::Operation* op = server_->AllocateOperation(this);
+    op->type = IoUringSocketServer::Operation::kRecv;
+    server_->PostRecv(op);
+  }
+  server_->MaybeSubmit();
+  return true;
+}
+
+int IoUringUdpSocket::Send(const void* pv, size_t cb) {
+  int sent = QueueSend(pv, cb, nullptr);
+  server_->MaybeSubmit();
+  return sent;
+}
+
+int IoUringUdpSocket::SendTo(const void* buffer,
+                             size_t length,
+                             const SocketAddress& addr) {
+  int sent = QueueSend(buffer, length, &addr);
+  server_->MaybeSubmit();
+  return sent;
+}
+
+int IoUringUdpSocket::SendToBatch(const SendBatchEntry* entries,
+                                  size_t count) {
+  // All sends of the batch go to the kernel in one submission.
+  size_t sent = 0;
+  while (sent < count && QueueSend(entries[sent].data, entries[sent].length,
+                                   &entries[sent].addr) >= 0) {
+    ++sent;
+  }
+  server_->MaybeSubmit();
+  return sent > 0 ? static_cast<int>(sent) : SOCKET_ERROR;
+}
+
+int IoUringUdpSocket::QueueSend(const void* buffer,
+                                size_t length,
+                                const SocketAddress* addr) {
+  if (s_ == INVALID_SOCKET) {
+    SetError(EBADF);
+    return SOCKET_ERROR;
+  }
+  if (!addr && state_ != CS_CONNECTED) {
+    SetError(ENOTCONN);
+    return SOCKET_ERROR;
+  }
+  if (sends_in_flight_ >= IoUringSocketServer::kMaxSendsPerSocket) {
+    write_blocked_ = true;
+    SetError(EWOULDBLOCK);
+    return SOCKET_ERROR;
+  }
+  struct io_uring_sqe* sqe = server_->GetSqe();
+  if (!sqe) {
+    write_blocked_ = true;
+    SetError(EWOULDBLOCK);
+    return SOCKET_ERROR;
+  }
+
+  IoUringSocketServer::Operation* op = server_->AllocateOperation(this);
+  op->type = IoUringSocketServer::Operation::kSend;
+  if (op->capacity < length) {
+    op->data.reset(new char[length]);
+    op->capacity = length;
+  }
+  memcpy(op->data.get(), buffer, length);
+  op->iov.iov_base = op->data.get();
+  op->iov.iov_len = length;
+  memset(&op->msg, 0, sizeof(op->msg));
+  if (addr) {
+    op->msg.msg_name = &op->addr;
+    op->msg.msg_namelen =
+        static_cast<socklen_t>(addr->ToSockAddrStorage(&op->addr));
+  }
+  op->msg.msg_iov = &op->iov;
+  op->msg.msg_iovlen = 1;
+
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = file_index_ >= 0 ? file_index_ : s_;
+  if (file_index_ >= 0)
+    sqe->flags |= IOSQE_FIXED_FILE;
+  sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+  sqe->len = 1;
+  // Suppress SIGPIPE, as PhysicalSocket does.
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = reinterpret_cast<uint64_t>(op);
+  op->in_flight = true;
+  ++server_->operations_in_flight_;
+  ++sends_in_flight_;
+  return static_cast<int>(length);
+}
+
+int IoUringUdpSocket::Recv(void* buffer, size_t length, int64_t* timestamp) {
+  return PopDatagram(buffer, length, nullptr, timestamp);
+}
+
+int IoUringUdpSocket::RecvFrom(void* buffer,
+                               size_t length,
+                               SocketAddress* out_addr,
+                               int64_t* timestamp) {
+  return PopDatagram(buffer, length, out_addr, timestamp);
+}
+
+int IoUringUdpSocket::RecvFromBatch(RecvBatchEntry* entries, size_t count) {
+  size_t filled = 0;
+  while (filled < count && !received_.empty()) {
+    RecvBatchEntry& entry = entries[filled];
+    int received = PopDatagram(entry.buffer, entry.capacity, &entry.addr,
+                               &entry.timestamp);
+    entry.length = static_cast<size_t>(received);
+    ++filled;
+  }
+  if (filled == 0) {
+    SetError(EWOULDBLOCK);
+    return SOCKET_ERROR;
+  }
+  return static_cast<int>(filled);
+}
+
+int IoUringUdpSocket::PopDatagram(void* buffer,
+                                  size_t length,
+                                  SocketAddress* out_addr,
+                                  int64_t* timestamp) {
+  if (received_.empty()) {
+    SetError(s_ == INVALID_SOCKET ? EBADF : EWOULDBLOCK);
+    return SOCKET_ERROR;
+  }
+  const Datagram& datagram = received_.front();
+  // Like recvfrom(), the rest of a datagram that does not fit is discarded.
+  size_t copied = std::min(length, datagram.length);
+  memcpy(buffer, server_->recv_buffer(datagram.buffer_id), copied);
+  if (out_addr)
+    *out_addr = datagram.addr;
+  if (timestamp)
+    *timestamp = datagram.timestamp;
+  server_->ProvideBuffer(datagram.buffer_id);
+  received_.pop_front();
+  // Reading re-arms readability while datagrams are left, as a read on a
+  // PhysicalSocket re-enables DE_READ.
+  if (!received_.empty())
+    server_->readable_.insert(this);
+  return static_cast<int>(copied);
+}
+
+int IoUringUdpSocket::Close() {
+  if (s_ == INVALID_SOCKET)
+    return 0;
+  // The cancellations are queued behind the sends that are still queued, so
+  // those go out unless the kernel would have to wait for buffer space.
+  // DoClose() waits for all of them to finish.
+  for (IoUringSocketServer::Operation* op : operations_) {
+    op->socket = nullptr;
+    server_->CancelOperation(op);
+  }
+  for (const Datagram& datagram : received_)
+    server_->ProvideBuffer(datagram.buffer_id);
+  received_.clear();
+  sends_in_flight_ = 0;
+  write_blocked_ = false;
+  server_->RemoveSocket(this);
+  int err = PhysicalSocket::Close();
+  server_->MaybeSubmit();
+  return err;
+}
+
+int IoUringUdpSocket::DoClose(SOCKET socket) {
+  int err = server_->ReleaseFile(socket, file_index_, operations_);
+  operations_.clear();
+  file_index_ = -1;
+  return err;
+}
+
+class IoUringSocketServer::RingDispatcher : public Dispatcher {
+ public:
+  explicit RingDispatcher(IoUringSocketServer* server) : server_(server) {}
+
+  uint32_t GetRequestedEvents() override { return DE_READ; }
+  void OnPreEvent(uint32_t ff) override {}
+  void OnEvent(uint32_t ff, int err) override { server_->ProcessCompletions(); }
+  int GetDescriptor() override { return server_->ring_fd_; }
+  bool IsDescriptorClosed() override { return false; }
+
+ private:
+  IoUringSocketServer* const server_;
+};
+
+std::unique_ptr<IoUringSocketServer> IoUringSocketServer::Create() {
+  std::unique_ptr<IoUringSocketServer> server(new IoUringSocketServer());
+  if (!server->Initialize())
+    return nullptr;
+  return server;
+}
+
+IoUringSocketServer::IoUringSocketServer() = default;
+
+IoUringSocketServer::~IoUringSocketServer() {
+  if (ring_dispatcher_)
+    Remove(ring_dispatcher_.get());
+  if (ring_fd_ < 0)
+    return;
+
+  // Operations refer to memory owned by this object, so all of them have to
+  // be completed before it goes away.
+  for (const std::unique_ptr<Operation>& op : operations_) {
+    if (op->in_flight)
+      CancelOperation(op.get());
+  }
+  while (operations_in_flight_ > 0) {
+    SubmitPendingCancels();
+    Submit();
+    if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+        errno != EINTR) {
+      RTC_LOG_E(LS_ERROR, EN, errno) << "io_uring_enter";
+      break;
+    }
+    unsigned head = *cq_head_;
+    unsigned tail = LoadAcquire(cq_tail_);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+      Operation* op = reinterpret_cast<Operation*>(cqe.user_data);
+      if (op && op->in_flight) {
+        op->in_flight = false;
+        --operations_in_flight_;
+      }
+    }
+    StoreRelease(cq_head_, head);
+  }
+
+  if (recv_buffers_)
+    munmap(recv_buffers_, kNumRecvBuffers * kRecvBufferSize);
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+bool IoUringSocketServer::Initialize() {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = IoUringSetup(kRingEntries, &params);
+  if (ring_fd_ < 0) {
+    RTC_LOG_E(LS_INFO, EN, errno) << "io_uring_setup";
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    RTC_LOG_E(LS_ERROR, EN, errno) << "mmap";
+    close(ring_fd_);
+    ring_fd_ = -1;
+    return false;
+  }
+  cq_ring_ = sq_ring_;
+  if (!single_mmap) {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+    RTC_LOG_E(LS_ERROR, EN, errno) << "mmap";
+    if (sqes != MAP_FAILED)
+      munmap(sqes, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+      munmap(cq_ring_, cq_ring_size_);
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+    ring_fd_ = -1;
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sq_entries_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  char* cq = static_cast<char*>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  sqe_tail_ = sqe_submitted_ = *sq_tail_;
+
+  // Check that the kernel knows all the operations used.
+  const size_t probe_size =
+      sizeof(struct io_uring_probe) +
+      IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+  std::unique_ptr<char[]> probe_buffer(new char[probe_size]);
+  memset(probe_buffer.get(), 0, probe_size);
+  struct io_uring_probe* probe =
+      reinterpret_cast<struct io_uring_probe*>(probe_buffer.get());
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_PROBE, probe,
+                      IORING_OP_LAST) < 0) {
+    RTC_LOG_E(LS_INFO, EN, errno) << "IORING_REGISTER_PROBE";
+    return false;
+  }
+  for (int opcode : {IORING_OP_RECVMSG, IORING_OP_SENDMSG,
+                     IORING_OP_PROVIDE_BUFFERS, IORING_OP_ASYNC_CANCEL}) {
+    if (opcode > probe->last_op ||
+        !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+      RTC_LOG(LS_INFO) << "io_uring operation " << opcode
+                       << " is not supported.";
+      return false;
+    }
+  }
+
+  // Sockets are added to a sparse fixed file table as they are created, so
+  // that the kernel does not have to look up and reference count the
+  // descriptor for every operation.
+  std::vector<int> files(kMaxFixedFiles, -1);
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_FILES, files.data(),
+                      kMaxFixedFiles) == 0) {
+    for (int i = kMaxFixedFiles - 1; i >= 0; --i)
+      free_file_indices_.push_back(i);
+  } else {
+    RTC_LOG_E(LS_INFO, EN, errno)
+        << "IORING_REGISTER_FILES, using plain descriptors";
+  }
+
+  void* recv_buffers =
+      mmap(nullptr, kNumRecvBuffers * kRecvBufferSize, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (recv_buffers == MAP_FAILED) {
+    RTC_LOG_E(LS_ERROR, EN, errno) << "mmap";
+    return false;
+  }
+  recv_buffers_ = static_cast<char*>(recv_buffers);
+  struct io_uring_sqe* sqe = GetSqe();
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = kNumRecvBuffers;
+  sqe->addr = reinterpret_cast<uint64_t>(recv_buffers_);
+  sqe->len = kRecvBufferSize;
+  sqe->off = 0;
+  sqe->buf_group = kRecvBufferGroup;
+  Submit();
+
+  ring_dispatcher_.reset(new RingDispatcher(this));
+  Add(ring_dispatcher_.get());
+  return true;
+}
+
+AsyncSocket* IoUringSocketServer::CreateAsyncSocket(int family, int type) {
+  if (type != SOCK_DGRAM)
+    return PhysicalSocketServer::CreateAsyncSocket(family, type);
+
+  IoUringUdpSocket* socket = new IoUringUdpSocket(this);
+  if (socket->Create(family, type)) {
+    return socket;
+  } else {
+    delete socket;
+    return nullptr;
+  }
+}
+
+bool IoUringSocketServer::Wait(int cms, bool process_io) {
+  SubmitPendingCancels();
+  Submit();
+  waiting_ = true;
+  // Sockets re-armed outside of a read event are signaled without blocking,
+  // the way epoll reports a socket that still has data queued.
+  bool rearmed = process_io && !readable_.empty();
+  bool result = PhysicalSocketServer::Wait(rearmed ? 0 : cms, process_io);
+  if (process_io && !readable_.empty())
+    ProcessCompletions();
+  waiting_ = false;
+  return result;
+}
+
+struct io_uring_sqe* IoUringSocketServer::GetSqe() {
+  if (sqe_tail_ - LoadAcquire(sq_head_) >= *sq_entries_) {
+    Submit();
+    if (sqe_tail_ - LoadAcquire(sq_head_) >= *sq_entries_)
+      return nullptr;
+  }
+  unsigned index = sqe_tail_ & *sq_mask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  ++sqe_tail_;
+  return sqe;
+}
+
+void IoUringSocketServer::Submit() {
+  if (sqe_tail_ == sqe_submitted_)
+    return;
+  StoreRelease(sq_tail_, sqe_tail_);
+  int submitted = IoUringEnter(ring_fd_, sqe_tail_ - sqe_submitted_, 0, 0);
+  if (submitted < 0) {
+    // EAGAIN and EBUSY mean the kernel is short on resources or completions
+    // need to be reaped first; the entries are submitted on the next try.
+    if (errno != EAGAIN && errno != EBUSY && errno != EINTR)
+      RTC_LOG_E(LS_ERROR, EN, errno) << "io_uring_enter";
+    return;
+  }
+  sqe_submitted_ += submitted;
+}
+
+void IoUringSocketServer::MaybeSubmit() {
+  if (waiting_ && !processing_completions_)
+    Submit();
+}
+
+void IoUringSocketServer::ProcessCompletions() {
+  processing_completions_ = true;
+  ReapCompletions();
+
+  // Sockets are signaled until they stop reading, to match the level
+  // triggered behavior of the epoll path for readers that only take one
+  // datagram per event. A socket that reads nothing is disarmed, like a
+  // PhysicalSocket with DE_READ disabled, until it reads again or another
+  // datagram arrives. Callbacks may close or delete any socket.
+  while (!readable_.empty()) {
+    std::vector<IoUringUdpSocket*> sockets(readable_.begin(), readable_.end());
+    for (IoUringUdpSocket* socket : sockets) {
+      if (readable_.find(socket) == readable_.end())
+        continue;
+      size_t queued = socket->received_.size();
+      socket->SignalReadEvent(socket);
+      if (sockets_.find(socket) == sockets_.end())
+        continue;
+      if (socket->received_.empty() || socket->received_.size() == queued)
+        readable_.erase(socket);
+    }
+  }
+  while (!writable_.empty()) {
+    IoUringUdpSocket* socket = *writable_.begin();
+    writable_.erase(writable_.begin());
+    socket->write_blocked_ = false;
+    socket->SignalWriteEvent(socket);
+  }
+
+  // Buffers may have been given back above.
+  size_t starved = starved_recvs_.size();
+  for (size_t i = 0; i < starved; ++i) {
+    Operation* op = starved_recvs_.front();
+    starved_recvs_.pop_front();
+    PostRecv(op);
+  }
+
+  processing_completions_ = false;
+  SubmitPendingCancels();
+  Submit();
+}
+
+void IoUringSocketServer::ReapCompletions() {
+  unsigned head = *cq_head_;
+  unsigned tail = LoadAcquire(cq_tail_);
+  while (head != tail) {
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+      Operation* op = reinterpret_cast<Operation*>(cqe.user_data);
+      int32_t res = cqe.res;
+      uint32_t flags = cqe.flags;
+      if (op) {
+        HandleCompletion(op, res, flags);
+      } else if (res < 0 && res != -ENOENT && res != -EALREADY) {
+        // Buffer hand-backs and cancellations are not tracked; a failed
+        // cancellation just means the operation already finished.
+        RTC_LOG(LS_WARNING) << "io_uring operation failed: " << -res;
+      }
+    }
+    StoreRelease(cq_head_, head);
+    tail = LoadAcquire(cq_tail_);
+  }
+}
+
+void IoUringSocketServer::HandleCompletion(Operation* op,
+                                           int32_t res,
+                                           uint32_t flags) {
+  RTC_DCHECK(op->in_flight);
+  op->in_flight = false;
+  --operations_in_flight_;
+  IoUringUdpSocket* socket = op->socket;
+
+  if (op->type == Operation::kSend) {
+    if (socket) {
+      socket->operations_.erase(op);
+      --socket->sends_in_flight_;
+      if (socket->write_blocked_)
+        writable_.insert(socket);
+      if (res < 0) {
+        // Datagram sends are fire and forget; report the error through
+        // GetError() like a failed sendto() on the epoll path would have.
+        socket->SetError(-res);
+        RTC_LOG(LS_VERBOSE) << "io_uring sendmsg failed: " << -res;
+      }
+    }
+    ReleaseOperation(op);
+    return;
+  }
+
+  if (flags & IORING_CQE_F_BUFFER) {
+    uint16_t buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+    if (socket && res >= 0 && !(op->msg.msg_flags & MSG_TRUNC)) {
+      IoUringUdpSocket::Datagram datagram;
+      datagram.buffer_id = buffer_id;
+      datagram.length = res;
+      SocketAddressFromSockAddrStorage(op->addr, &datagram.addr);
+      datagram.timestamp = TimeMicros();
+      socket->received_.push_back(datagram);
+      readable_.insert(socket);
+    } else {
+      ProvideBuffer(buffer_id);
+    }
+  }
+  if (!socket || res == -ECANCELED) {
+    if (socket)
+      socket->operations_.erase(op);
+    ReleaseOperation(op);
+    return;
+  }
+  if (res == -ENOBUFS) {
+    // All buffers are queued on sockets; try again once some are read.
+    starved_recvs_.push_back(op);
+    return;
+  }
+  if (res < 0)
+    RTC_LOG(LS_VERBOSE) << "io_uring recvmsg failed: " << -res;
+  PostRecv(op);
+}
+
+IoUringSocketServer::Operation* IoUringSocketServer::AllocateOperation(
+    IoUringUdpSocket* socket) {
+  Operation* op;
+  if (free_operations_.empty()) {
+    operations_.emplace_back(new Operation());
+    op = operations_.back().get();
+  } else {
+    op = free_operations_.back();
+    free_operations_.pop_back();
+  }
+  op->socket = socket;
+  socket->operations_.insert(op);
+  return op;
+}
+
+void IoUringSocketServer::ReleaseOperation(Operation* op) {
+  RTC_DCHECK(!op->in_flight);
+  if (op->cancel_pending) {
+    pending_cancels_.erase(
+        std::find(pending_cancels_.begin(), pending_cancels_.end(), op));
+    op->cancel_pending = false;
+  }
+  if (op->pending_on_close) {
+    --*op->pending_on_close;
+    op->pending_on_close = nullptr;
+  }
+  op->socket = nullptr;
+  free_operations_.push_back(op);
+}
+
+bool IoUringSocketServer::PostRecv(Operation* op) {
+  RTC_DCHECK(op->socket);
+  struct io_uring_sqe* sqe = GetSqe();
+  if (!sqe) {
+    starved_recvs_.push_back(op);
+    return false;
+  }
+  IoUringUdpSocket* socket = op->socket;
+  memset(&op->msg, 0, sizeof(op->msg));
+  op->msg.msg_name = &op->addr;
+  op->msg.msg_namelen = sizeof(op->addr);
+  // The kernel picks the buffer; only its size is given here.
+  op->iov.iov_base = nullptr;
+  op->iov.iov_len = kRecvBufferSize;
+  op->msg.msg_iov = &op->iov;
+  op->msg.msg_iovlen = 1;
+
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = socket->file_index_ >= 0 ? socket->file_index_ : socket->s_;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  if (socket->file_index_ >= 0)
+    sqe->flags |= IOSQE_FIXED_FILE;
+  sqe->addr = reinterpret_cast<uint64_t>(&op->msg);
+  sqe->len = 1;
+  sqe->buf_group = kRecvBufferGroup;
+  sqe->user_data = reinterpret_cast<uint64_t>(op);
+  op->in_flight = true;
+  ++operations_in_flight_;
+  return true;
+}
+
+void IoUringSocketServer::ProvideBuffer(uint16_t buffer_id) {
+  struct io_uring_sqe* sqe = GetSqe();
+  if (!sqe) {
+    // Only possible if the kernel stops consuming entries altogether; the
+    // buffer is lost to the pool.
+    RTC_LOG(LS_ERROR) << "No submission queue entry to give back buffer "
+                      << buffer_id;
+    return;
+  }
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = 1;
+  sqe->addr = reinterpret_cast<uint64_t>(recv_buffer(buffer_id));
+  sqe->len = kRecvBufferSize;
+  sqe->off = buffer_id;
+  sqe->buf_group = kRecvBufferGroup;
+}
+
+void IoUringSocketServer::CancelOperation(Operation* op) {
+  if (!op->in_flight) {
+    // A starved receive.
+    auto it = std::find(starved_recvs_.begin(), starved_recvs_.end(), op);
+    if (it != starved_recvs_.end())
+      starved_recvs_.erase(it);
+    ReleaseOperation(op);
+    return;
+  }
+  if (op->cancel_pending)
+    return;
+  struct io_uring_sqe* sqe = GetSqe();
+  if (!sqe) {
+    op->cancel_pending = true;
+    pending_cancels_.push_back(op);
+    return;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = reinterpret_cast<uint64_t>(op);
+}
+
+void IoUringSocketServer::SubmitPendingCancels() {
+  while (!pending_cancels_.empty()) {
+    struct io_uring_sqe* sqe = GetSqe();
+    if (!sqe)
+      return;
+    Operation* op = pending_cancels_.back();
+    pending_cancels_.pop_back();
+    op->cancel_pending = false;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(op);
+  }
+}
+
+int IoUringSocketServer::RegisterFile(int fd) {
+  if (free_file_indices_.empty())
+    return -1;
+  int index = free_file_indices_.back();
+  struct io_uring_files_update update;
+  memset(&update, 0, sizeof(update));
+  update.offset = index;
+  update.fds = reinterpret_cast<uint64_t>(&fd);
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1) !=
+      1) {
+    RTC_LOG_E(LS_WARNING, EN, errno) << "IORING_REGISTER_FILES_UPDATE";
+    return -1;
+  }
+  free_file_indices_.pop_back();
+  return index;
+}
+
+void IoUringSocketServer::UnregisterFile(int index) {
+  int fd = -1;
+  struct io_uring_files_update update;
+  memset(&update, 0, sizeof(update));
+  update.offset = index;
+  update.fds = reinterpret_cast<uint64_t>(&fd);
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_FILES_UPDATE, &update, 1) !=
+      1) {
+    // Leave the slot out of the free list rather than risk reusing it.
+    RTC_LOG_E(LS_WARNING, EN, errno) << "IORING_REGISTER_FILES_UPDATE";
+    return;
+  }
+  free_file_indices_.push_back(index);
+}
+
+int IoUringSocketServer::ReleaseFile(int fd,
+                                     int file_index,
+                                     const std::set<Operation*>& operations) {
+  size_t pending = 0;
+  for (Operation* op : operations) {
+    if (op->in_flight) {
+      op->pending_on_close = &pending;
+      ++pending;
+    }
+  }
+  // All of them have been cancelled, so this does not block for long.
+  // Completions of other sockets are handled along the way and signaled from
+  // the next Wait().
+  ReapCompletions();
+  while (pending > 0) {
+    SubmitPendingCancels();
+    Submit();
+    if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+        errno != EINTR) {
+      // Leak the descriptor and the slot rather than risk reusing them.
+      RTC_LOG_E(LS_ERROR, EN, errno) << "io_uring_enter";
+      for (Operation* op : operations)
+        op->pending_on_close = nullptr;
+      return 0;
+    }
+    ReapCompletions();
+  }
+  if (file_index >= 0)
+    UnregisterFile(file_index);
+  return ::close(fd);
+}
+
+void IoUringSocketServer::AddSocket(IoUringUdpSocket* socket) {
+  sockets_.insert(socket);
+}
+
+void IoUringSocketServer::RemoveSocket(IoUringUdpSocket* socket) {
+  sockets_.erase(socket);
+  readable_.erase(socket);
+  writable_.erase(socket);
+}
+
+std::unique_ptr<SocketServer> CreateIoUringSocketServer() {
+  std::unique_ptr<IoUringSocketServer> server = IoUringSocketServer::Create();
+  if (server)
+    return server;
+  RTC_LOG(LS_INFO) << "io_uring unavailable, using the default socket server.";
+  return SocketServer::CreateDefault();
+}
+
+}  // namespace rtc
@@ -0,0 +1,178 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_IO_URING_SOCKET_SERVER_H_
+#define RTC_BASE_IO_URING_SOCKET_SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "rtc_base/physical_socket_server.h"
+#include "rtc_base/system/rtc_export.h"
+
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+namespace rtc {
+
+class IoUringUdpSocket;
+
+// A PhysicalSocketServer that moves UDP I/O onto an io_uring submission and
+// completion queue pair instead of epoll readiness plus recvfrom()/sendto().
+//
+// Every UDP socket keeps a few RECVMSG operations posted on the ring. The
+// kernel fills buffers picked from a pool handed to it up front
+// (IORING_OP_PROVIDE_BUFFERS), and completions are reaped from shared memory
+// without a system call per datagram. Sends are copied into pooled operation
+// buffers and queued as SENDMSG operations, which are handed to the kernel
+// together when the thread gets back to Wait(). Sockets are registered in the
+// ring's fixed file table where the kernel supports it.
+//
+// TCP sockets, the wake-up signaler and POSIX signal handling are unchanged
+// and still go through the epoll path of PhysicalSocketServer; the ring itself
+// is one more dispatcher on that epoll set, readable whenever completions are
+// pending.
+//
+// Like the other socket servers, an instance must only be used from the
+// thread that runs Wait().
+class RTC_EXPORT IoUringSocketServer : public PhysicalSocketServer {
+ public:
+  // Number of receive buffers given to the kernel and their size, which is
+  // enough for any UDP datagram. The pool is only reserved address space;
+  // memory is committed as the kernel writes datagrams into it, so a buffer
+  // that only ever holds small datagrams costs about a page.
+  static const size_t kNumRecvBuffers = 1024;
+  static const size_t kRecvBufferSize = 64 * 1024;
+  // Number of RECVMSG operations kept posted per UDP socket.
+  static const size_t kRecvsPerSocket = 4;
+  // Maximum number of unfinished SENDMSG operations per UDP socket. Beyond
+  // that, SendTo() fails with EWOULDBLOCK until a send completes.
+  static const size_t kMaxSendsPerSocket = 256;
+
+  // Returns null if io_uring, or one of the features used here, is not
+  // available in the running kernel.
+  static std::unique_ptr<IoUringSocketServer> Create();
+  ~IoUringSocketServer() override;
+
+  // SocketFactory:
+  AsyncSocket* CreateAsyncSocket(int family, int type) override;
+
+  // SocketServer:
+  bool Wait(int cms, bool process_io) override;
+
+ private:
+  friend class IoUringUdpSocket;
+  class RingDispatcher;
+  struct Operation;
+
+  IoUringSocketServer();
+  bool Initialize();
+
+  // Returns a zeroed submission queue entry, submitting what is queued if
+  // the submission queue is full. Returns null if no entry can be obtained.
+  struct io_uring_sqe* GetSqe();
+  // Hands queued submission queue entries to the kernel.
+  void Submit();
+  // Submits right away if called from a dispatcher callback inside Wait().
+  // Otherwise entries are left queued, and everything queued between two
+  // Wait() calls, or while completions are processed, goes to the kernel in
+  // one io_uring_enter().
+  void MaybeSubmit();
+  void ProcessCompletions();
+  // Handles the completions that are ready, without signaling sockets.
+  void ReapCompletions();
+  void HandleCompletion(Operation* op, int32_t res, uint32_t flags);
+
+  Operation* AllocateOperation(IoUringUdpSocket* socket);
+  void ReleaseOperation(Operation* op);
+  bool PostRecv(Operation* op);
+  void ProvideBuffer(uint16_t buffer_id);
+  // Queues a cancellation of |op|. If the submission queue is full, the
+  // cancellation is queued by a later call to SubmitPendingCancels().
+  void CancelOperation(Operation* op);
+  void SubmitPendingCancels();
+  char* recv_buffer(uint16_t buffer_id) {
+    return recv_buffers_ + buffer_id * kRecvBufferSize;
+  }
+
+  int RegisterFile(int fd);
+  void UnregisterFile(int index);
+  // Closes the descriptor of a closed socket and frees its fixed file table
+  // slot once |operations| have all completed. Until then, neither can be
+  // handed to a new socket, so operations queued for the closed socket cannot
+  // end up on another one.
+  int ReleaseFile(int fd,
+                  int file_index,
+                  const std::set<Operation*>& operations);
+
+  void AddSocket(IoUringUdpSocket* socket);
+  void RemoveSocket(IoUringUdpSocket* socket);
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  struct io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_entries_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  struct io_uring_cqe* cqes_ = nullptr;
+  // Entries handed out by GetSqe() but not yet taken by the kernel are the
+  // ones from |sqe_submitted_| up to |sqe_tail_|.
+  unsigned sqe_tail_ = 0;
+  unsigned sqe_submitted_ = 0;
+  bool waiting_ = false;
+  bool processing_completions_ = false;
+  size_t operations_in_flight_ = 0;
+
+  char* recv_buffers_ = nullptr;
+
+  // Fixed file table. Empty if the kernel does not support sparse tables, in
+  // which case plain descriptors are used.
+  std::vector<int> free_file_indices_;
+
+  std::vector<std::unique_ptr<Operation>> operations_;
+  std::vector<Operation*> free_operations_;
+  // Receives that failed for lack of buffers or submission queue entries, to
+  // be posted again once some are given back.
+  std::deque<Operation*> starved_recvs_;
+  // Operations to cancel once there is room in the submission queue.
+  std::vector<Operation*> pending_cancels_;
+
+  std::set<IoUringUdpSocket*> sockets_;
+  // Sockets with received data or freed send capacity to be signaled once
+  // the current completion batch is processed.
+  std::set<IoUringUdpSocket*> readable_;
+  std::set<IoUringUdpSocket*> writable_;
+
+  std::unique_ptr<RingDispatcher> ring_dispatcher_;
+};
+
+// Returns an IoUringSocketServer where the kernel supports it, and the
+// default socket server otherwise. Intended for network threads, e.g.
+//   auto network_thread =
+//       std::make_unique<rtc::Thread>(rtc::CreateIoUringSocketServer());
+RTC_EXPORT std::unique_ptr<SocketServer> CreateIoUringSocketServer();
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_IO_URING_SOCKET_SERVER_H_
@@ -0,0 +1,345 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/io_uring_socket_server.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "rtc_base/async_udp_socket.h"
+#include "rtc_base/cpu_time.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/ip_address.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/socket_unittest.h"
+#include "rtc_base/test_utils.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace rtc {
+
+using webrtc::testing::SSE_READ;
+using webrtc::testing::StreamSink;
+
+#define MAYBE_SKIP_IPV4                        \
+  if (!HasIPv4Enabled()) {                     \
+    RTC_LOG(LS_INFO) << "No IPv4... skipping"; \
+    return;                                    \
+  }
+
+#define MAYBE_SKIP_IPV6                        \
+  if (!HasIPv6Enabled()) {                     \
+    RTC_LOG(LS_INFO) << "No IPv6... skipping"; \
+    return;                                    \
+  }
+
+#define MAYBE_SKIP_IO_URING                        \
+  if (!server_) {                                  \
+    RTC_LOG(LS_INFO) << "No io_uring... skipping"; \
+    return;                                        \
+  }
+
+class IoUringSocketServerTest : public SocketTest {
+ protected:
+  IoUringSocketServerTest()
+      : server_(IoUringSocketServer::Create()),
+        fallback_server_(server_ ? nullptr : new PhysicalSocketServer()),
+        thread_(server_ ? server_.get() : fallback_server_.get()) {}
+
+  std::unique_ptr<IoUringSocketServer> server_;
+  // Keeps the thread usable when io_uring is not available, so that tests
+  // can skip themselves.
+  std::unique_ptr<PhysicalSocketServer> fallback_server_;
+  rtc::AutoSocketServerThread thread_;
+};
+
+TEST_F(IoUringSocketServerTest, TestConnectIPv4) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestConnectIPv4();
+}
+
+TEST_F(IoUringSocketServerTest, TestTcpIPv4) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestTcpIPv4();
+}
+
+TEST_F(IoUringSocketServerTest, TestSocketServerWaitIPv4) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestSocketServerWaitIPv4();
+}
+
+TEST_F(IoUringSocketServerTest, TestUdpIPv4) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestUdpIPv4();
+}
+
+TEST_F(IoUringSocketServerTest, TestUdpIPv6) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV6;
+  SocketTest::TestUdpIPv6();
+}
+
+TEST_F(IoUringSocketServerTest, TestUdpReadyToSendIPv4) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestUdpReadyToSendIPv4();
+}
+
+TEST_F(IoUringSocketServerTest, TestGetSetOptionsIPv4) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  SocketTest::TestGetSetOptionsIPv4();
+}
+
+class UdpPacketCounter : public sigslot::has_slots<> {
+ public:
+  void OnReadPacket(AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const SocketAddress& remote_addr,
+                    const int64_t& packet_time_us) {
+    ++packets_;
+  }
+  int packets() const { return packets_; }
+
+ private:
+  int packets_ = 0;
+};
+
+// An AsyncUDPSocket reads one datagram per read event, so every datagram that
+// completed in the same batch has to be signaled.
+TEST_F(IoUringSocketServerTest, DeliversEveryDatagramOfABurst) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncUDPSocket> receiver(
+      AsyncUDPSocket::Create(server_.get(), SocketAddress(kIPv4Loopback, 0)));
+  std::unique_ptr<AsyncUDPSocket> sender(
+      AsyncUDPSocket::Create(server_.get(), SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_TRUE(receiver);
+  ASSERT_TRUE(sender);
+  UdpPacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter,
+                                     &UdpPacketCounter::OnReadPacket);
+
+  char payload[100] = {0};
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(100, sender->SendTo(payload, sizeof(payload),
+                                  receiver->GetLocalAddress(),
+                                  PacketOptions()));
+  }
+  EXPECT_EQ_WAIT(50, counter.packets(), kTimeout);
+}
+
+TEST_F(IoUringSocketServerTest, ClosesSocketWithPendingDatagrams) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+  StreamSink sink;
+  sink.Monitor(receiver.get());
+
+  char payload[100] = {0};
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(100, sender->SendTo(payload, sizeof(payload),
+                                  receiver->GetLocalAddress()));
+  }
+  EXPECT_TRUE_WAIT(sink.Check(receiver.get(), SSE_READ), kTimeout);
+  // The queued datagrams hold receive buffers that must go back to the pool.
+  EXPECT_EQ(0, receiver->Close());
+  receiver.reset();
+  Thread::Current()->ProcessMessages(100);
+
+  std::unique_ptr<AsyncSocket> receiver2(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver2->Bind(SocketAddress(kIPv4Loopback, 0)));
+  sink.Monitor(receiver2.get());
+  EXPECT_EQ(100, sender->SendTo(payload, sizeof(payload),
+                                receiver2->GetLocalAddress()));
+  EXPECT_TRUE_WAIT(sink.Check(receiver2.get(), SSE_READ), kTimeout);
+  char buffer[200];
+  SocketAddress from;
+  EXPECT_EQ(100, receiver2->RecvFrom(buffer, sizeof(buffer), &from, nullptr));
+  EXPECT_EQ(sender->GetLocalAddress(), from);
+}
+
+class ReadEventCounter : public sigslot::has_slots<> {
+ public:
+  void OnReadEvent(AsyncSocket* socket) { ++events_; }
+  int events() const { return events_; }
+
+ private:
+  int events_ = 0;
+};
+
+// Like a PhysicalSocket, a socket whose owner does not read on a read event
+// is not signaled again, but reading re-arms it while datagrams are left.
+TEST_F(IoUringSocketServerTest, RearmsReadabilityWhileDatagramsArePending) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ReadEventCounter counter;
+  receiver->SignalReadEvent.connect(&counter, &ReadEventCounter::OnReadEvent);
+
+  char payload[100] = {0};
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(100, sender->SendTo(payload, sizeof(payload),
+                                  receiver->GetLocalAddress()));
+  }
+  EXPECT_EQ_WAIT(1, counter.events(), kTimeout);
+  Thread::Current()->ProcessMessages(100);
+  EXPECT_EQ(1, counter.events());
+
+  char buffer[200];
+  EXPECT_EQ(100, receiver->RecvFrom(buffer, sizeof(buffer), nullptr, nullptr));
+  EXPECT_EQ_WAIT(2, counter.events(), kTimeout);
+  EXPECT_EQ(100, receiver->RecvFrom(buffer, sizeof(buffer), nullptr, nullptr));
+  EXPECT_EQ_WAIT(3, counter.events(), kTimeout);
+  EXPECT_EQ(100, receiver->RecvFrom(buffer, sizeof(buffer), nullptr, nullptr));
+  Thread::Current()->ProcessMessages(100);
+  EXPECT_EQ(3, counter.events());
+}
+
+// Sends queued on a socket that is closed before they are submitted go out
+// from that socket, and not from a socket created right after it, which could
+// otherwise get the same descriptor or fixed file table slot.
+TEST_F(IoUringSocketServerTest, SendsQueuedBeforeCloseUseTheClosedSocket) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+  SocketAddress sender_address = sender->GetLocalAddress();
+
+  // Outside of Wait(), the sends are only queued.
+  char payload[100] = {0};
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(100, sender->SendTo(payload, sizeof(payload),
+                                  receiver->GetLocalAddress()));
+  }
+  EXPECT_EQ(0, sender->Close());
+  std::unique_ptr<AsyncSocket> other(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, other->Bind(SocketAddress(kIPv4Loopback, 0)));
+
+  char buffer[200];
+  SocketAddress from;
+  for (int i = 0; i < 10; ++i) {
+    int received = -1;
+    EXPECT_TRUE_WAIT(
+        (received = receiver->RecvFrom(buffer, sizeof(buffer), &from,
+                                       nullptr)) >= 0,
+        kTimeout);
+    EXPECT_EQ(100, received);
+    EXPECT_EQ(sender_address, from);
+  }
+}
+
+TEST_F(IoUringSocketServerTest, ReceivesLargeDatagrams) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+  StreamSink sink;
+  sink.Monitor(receiver.get());
+
+  // The largest UDP payload over IPv4.
+  const size_t kSize = 65507;
+  std::unique_ptr<char[]> payload(new char[kSize]);
+  for (size_t i = 0; i < kSize; ++i)
+    payload[i] = static_cast<char>(i);
+  EXPECT_EQ(static_cast<int>(kSize),
+            sender->SendTo(payload.get(), kSize, receiver->GetLocalAddress()));
+  EXPECT_TRUE_WAIT(sink.Check(receiver.get(), SSE_READ), kTimeout);
+  std::unique_ptr<char[]> buffer(new char[kSize + 1]);
+  EXPECT_EQ(static_cast<int>(kSize),
+            receiver->RecvFrom(buffer.get(), kSize + 1, nullptr, nullptr));
+  EXPECT_EQ(0, memcmp(payload.get(), buffer.get(), kSize));
+}
+
+// Sends bursts of datagrams over loopback and reports how many packets per
+// second, and how much thread CPU time per packet, a socket server needs to
+// send and receive them on one thread.
+static void RunUdpLoopbackBenchmark(SocketServer* ss,
+                                    const IPAddress& loopback,
+                                    const char* name) {
+  static const int kBurstSize = 64;
+  static const int kNumBursts = 10000;
+  static const size_t kPacketSize = 1200;
+
+  std::unique_ptr<AsyncUDPSocket> receiver(
+      AsyncUDPSocket::Create(ss, SocketAddress(loopback, 0)));
+  ASSERT_TRUE(receiver);
+  receiver->SetOption(Socket::OPT_RCVBUF, 4 * 1024 * 1024);
+  std::unique_ptr<AsyncSocket> sender(
+      ss->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(loopback, 0)));
+  UdpPacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter,
+                                     &UdpPacketCounter::OnReadPacket);
+
+  char payload[kPacketSize] = {0};
+  SocketAddress dest = receiver->GetLocalAddress();
+  int sent = 0;
+  int64_t start_us = TimeMicros();
+  int64_t start_cpu_ns = GetThreadCpuTimeNanos();
+  for (int i = 0; i < kNumBursts; ++i) {
+    for (int j = 0; j < kBurstSize; ++j) {
+      if (sender->SendTo(payload, kPacketSize, dest) > 0)
+        ++sent;
+    }
+    int64_t deadline_ms = TimeMillis() + 1000;
+    while (counter.packets() < sent && TimeMillis() < deadline_ms) {
+      ss->Wait(0, true);
+    }
+  }
+  int64_t elapsed_us = std::max<int64_t>(TimeMicros() - start_us, 1);
+  int64_t cpu_ns = GetThreadCpuTimeNanos() - start_cpu_ns;
+  int packets = std::max(counter.packets(), 1);
+  RTC_LOG(LS_INFO) << name << ": " << counter.packets() << " of " << sent
+                   << " packets in " << elapsed_us / 1000 << " ms, "
+                   << counter.packets() * kNumMicrosecsPerSec / elapsed_us
+                   << " packets/s, " << cpu_ns / packets
+                   << " ns CPU per packet";
+}
+
+// Compares the io_uring path against the epoll path. Disabled by default
+// since it only reports numbers and takes several seconds.
+TEST_F(IoUringSocketServerTest, DISABLED_UdpLoopbackThroughput) {
+  MAYBE_SKIP_IO_URING;
+  MAYBE_SKIP_IPV4;
+  RunUdpLoopbackBenchmark(server_.get(), kIPv4Loopback, "io_uring");
+  PhysicalSocketServer epoll_server;
+  RunUdpLoopbackBenchmark(&epoll_server, kIPv4Loopback, "epoll");
+}
+
+}  // namespace rtc
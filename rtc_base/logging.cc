@@ -32,6 +32,7 @@ static const int kMaxLogLineSize = 1024 - 60;
 #include <time.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <vector>
 
@@ -106,11 +107,26 @@ LogMessage::LogMessage(const char* file,
                        LoggingSeverity sev,
                        LogErrorContext err_ctx,
                        int err)
-    : severity_(sev) {
-  if (timestamp_) {
     // Use SystemTimeMillis so that even if tests use fake clocks, the timestamp
     // in log messages represents the real system time.
-    int64_t time = TimeDiff(SystemTimeMillis(), LogStartTime());
+    : LogMessage(file,
+                 line,
+                 sev,
+                 err_ctx,
+                 err,
+                 timestamp_ ? SystemTimeMillis() : 0,
+                 thread_ ? CurrentThreadId() : 0) {}
+
+LogMessage::LogMessage(const char* file,
+                       int line,
+                       LoggingSeverity sev,
+                       LogErrorContext err_ctx,
+                       int err,
+                       int64_t time_ms,
+                       PlatformThreadId thread_id)
+    : severity_(sev) {
+  if (timestamp_) {
+    int64_t time = TimeDiff(time_ms, LogStartTime());
     // Also ensure WallClockStartTime is initialized, so that it matches
     // LogStartTime.
     WallClockStartTime();
@@ -120,8 +136,7 @@ LogMessage::LogMessage(const char* file,
   }
 
   if (thread_) {
-    PlatformThreadId id = CurrentThreadId();
-    print_stream_ << "[" << id << "] ";
+    print_stream_ << "[" << thread_id << "] ";
   }
 
   if (file != nullptr) {
@@ -459,6 +474,14 @@ void LogMessage::FinishPrintStream() {
 
 namespace webrtc_logging_impl {
 
+namespace {
+ABSL_CONST_INIT std::atomic<AsyncLogHandler> g_async_log_handler{nullptr};
+}  // namespace
+
+void SetAsyncLogHandler(AsyncLogHandler handler) {
+  g_async_log_handler.store(handler, std::memory_order_release);
+}
+
 void Log(const LogArgType* fmt, ...) {
   va_list args;
   va_start(args, fmt);
@@ -494,6 +517,20 @@ void Log(const LogArgType* fmt, ...) {
     return;
   }
 
+  AsyncLogHandler async_handler =
+      g_async_log_handler.load(std::memory_order_acquire);
+  if (async_handler) {
+    // The handler may consume arguments before it gives up.
+    va_list async_args;
+    va_copy(async_args, args);
+    bool handled = async_handler(meta, tag, fmt + 1, async_args);
+    va_end(async_args);
+    if (handled) {
+      va_end(args);
+      return;
+    }
+  }
+
   LogMessage log_message(meta.meta.File(), meta.meta.Line(),
                          meta.meta.Severity(), meta.err_ctx, meta.err);
   if (tag) {
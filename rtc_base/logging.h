@@ -45,6 +45,7 @@
 #define RTC_BASE_LOGGING_H_
 
 #include <errno.h>
+#include <stdarg.h>
 
 #include <list>
 #include <sstream>  // no-presubmit-check TODO(webrtc:8982)
@@ -55,6 +56,7 @@
 #include "absl/strings/string_view.h"
 #include "rtc_base/constructor_magic.h"
 #include "rtc_base/deprecation.h"
+#include "rtc_base/platform_thread_types.h"
 #include "rtc_base/strings/string_builder.h"
 #include "rtc_base/system/inline.h"
 
@@ -291,6 +293,16 @@ ToStringVal MakeVal(const T& x) {
 
 void Log(const LogArgType* fmt, ...);
 
+// While set, receives the arguments of every log call that passes the
+// severity checks, instead of them being formatted on the calling thread.
+// |fmt| and |args| are the ones following the metadata. Returns false if the
+// call has to be logged synchronously after all. See rtc::AsyncLogger.
+typedef bool (*AsyncLogHandler)(const LogMetadataErr& meta,
+                                const char* tag,
+                                const LogArgType* fmt,
+                                va_list args);
+void SetAsyncLogHandler(AsyncLogHandler handler);
+
 // Ephemeral type that represents the result of the logging << operator.
 template <typename... Ts>
 class LogStreamer;
@@ -463,10 +475,21 @@ class LogMessage {
   static bool IsNoop(LoggingSeverity severity);
 
  private:
+  friend class AsyncLogger;
   friend class LogMessageForTesting;
   typedef std::pair<LogSink*, LoggingSeverity> StreamAndSeverity;
   typedef std::list<StreamAndSeverity> StreamList;
 
+  // Formats a log call made at SystemTimeMillis() |time_ms|, on the thread
+  // |thread_id|. The other constructors pass the current ones.
+  LogMessage(const char* file,
+             int line,
+             LoggingSeverity sev,
+             LogErrorContext err_ctx,
+             int err,
+             int64_t time_ms,
+             PlatformThreadId thread_id);
+
   // Updates min_sev_ appropriately when debug sinks change.
   static void UpdateMinLogSeverity();
 
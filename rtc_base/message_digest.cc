@@ -179,4 +179,72 @@ std::string ComputeHmac(const std::string& alg,
   return output;
 }
 
+Hmac::Hmac(const std::string& alg, const void* key, size_t key_len)
+    : inner_(new OpenSSLDigest(alg)),
+      outer_(new OpenSSLDigest(alg)),
+      current_(new OpenSSLDigest(alg)) {
+  // Like ComputeHmac(), only handles algorithms with a 64-byte blocksize.
+  size_t digest_len = inner_->Size();
+  if (digest_len == 0 || digest_len > 32) {
+    return;
+  }
+  uint8_t new_key[kBlockSize];
+  if (key_len > kBlockSize) {
+    ComputeDigest(inner_.get(), key, key_len, new_key, kBlockSize);
+    memset(new_key + digest_len, 0, kBlockSize - digest_len);
+  } else {
+    memcpy(new_key, key, key_len);
+    memset(new_key + key_len, 0, kBlockSize - key_len);
+  }
+  uint8_t pad[kBlockSize];
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    pad[i] = 0x36 ^ new_key[i];
+  }
+  inner_->Update(pad, kBlockSize);
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    pad[i] = 0x5c ^ new_key[i];
+  }
+  outer_->Update(pad, kBlockSize);
+  current_->CopyFrom(*inner_);
+  valid_ = true;
+}
+
+Hmac::~Hmac() = default;
+
+size_t Hmac::Size() const {
+  return valid_ ? inner_->Size() : 0;
+}
+
+void Hmac::Update(const void* buf, size_t len) {
+  if (valid_) {
+    current_->Update(buf, len);
+  }
+}
+
+size_t Hmac::Finish(void* buf, size_t len) {
+  size_t digest_len = Size();
+  if (digest_len == 0) {
+    return 0;
+  }
+  if (len < digest_len) {
+    current_->CopyFrom(*inner_);
+    return 0;
+  }
+  uint8_t inner[MessageDigest::kMaxSize];
+  current_->Finish(inner, digest_len);
+  current_->CopyFrom(*outer_);
+  current_->Update(inner, digest_len);
+  size_t ret = current_->Finish(buf, len);
+  current_->CopyFrom(*inner_);
+  return ret;
+}
+
+size_t Hmac::Compute(const void* input,
+                     size_t in_len,
+                     void* output,
+                     size_t out_len) {
+  Update(input, in_len);
+  return Finish(output, out_len);
+}
+
 }  // namespace rtc
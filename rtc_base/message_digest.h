@@ -13,10 +13,15 @@
 
 #include <stddef.h>
 
+#include <memory>
 #include <string>
 
+#include "rtc_base/constructor_magic.h"
+
 namespace rtc {
 
+class OpenSSLDigest;
+
 // Definitions for the digest algorithms.
 extern const char DIGEST_MD5[];
 extern const char DIGEST_SHA_1[];
@@ -125,6 +130,43 @@ bool ComputeHmac(const std::string& alg,
                  const std::string& input,
                  std::string* output);
 
+// Computes RFC 2104 HMACs with a fixed key. ComputeHmac() pads and hashes the
+// key again for every input; this class does that once, when it is created,
+// and starts every HMAC from copies of the resulting digest states. Not
+// thread safe.
+class Hmac {
+ public:
+  // Keys the HMAC with |key_len| bytes of |key|, using the digest named
+  // |alg|, e.g. DIGEST_SHA_1. Size() returns 0 if there is no digest with the
+  // given name.
+  Hmac(const std::string& alg, const void* key, size_t key_len);
+  ~Hmac();
+
+  // Returns the HMAC output size, or 0 if the HMAC is not usable.
+  size_t Size() const;
+  // Adds |len| bytes from |buf| to the input of the current HMAC.
+  void Update(const void* buf, size_t len);
+  // Outputs the HMAC of the input added since the previous Finish() to |buf|
+  // with length |len|, and starts a new HMAC. Returns the number of bytes
+  // written, or 0 if |len| was too small; the input is discarded either way.
+  size_t Finish(void* buf, size_t len);
+  // Computes the HMAC of |in_len| bytes of |input|, like ComputeHmac().
+  size_t Compute(const void* input,
+                 size_t in_len,
+                 void* output,
+                 size_t out_len);
+
+ private:
+  // The digest states after the inner and the outer padded key.
+  const std::unique_ptr<OpenSSLDigest> inner_;
+  const std::unique_ptr<OpenSSLDigest> outer_;
+  // The digest of the current HMAC.
+  const std::unique_ptr<OpenSSLDigest> current_;
+  bool valid_ = false;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(Hmac);
+};
+
 }  // namespace rtc
 
 #endif  // RTC_BASE_MESSAGE_DIGEST_H_
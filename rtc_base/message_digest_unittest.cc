@@ -152,4 +152,44 @@ TEST(MessageDigestTest, TestBadHmac) {
   EXPECT_EQ("", ComputeHmac("sha-9000", "key", "abc"));
 }
 
+// Test vectors from RFC 2202, computed repeatedly with one precomputed key.
+TEST(MessageDigestTest, TestPrecomputedSha1Hmac) {
+  std::string key(80, '\xaa');
+  Hmac hmac(DIGEST_SHA_1, key.data(), key.size());
+  ASSERT_EQ(20U, hmac.Size());
+  char output[20];
+  for (int i = 0; i < 3; ++i) {
+    std::string input("Test Using Larger Than Block-Size Key - Hash Key First");
+    EXPECT_EQ(sizeof(output), hmac.Compute(input.data(), input.size(), output,
+                                           sizeof(output)));
+    EXPECT_EQ("aa4ae5e15272d00e95705637ce8a3b55ed402112",
+              hex_encode(output, sizeof(output)));
+
+    // The same input in two parts.
+    input = "Test Using Larger Than Block-Size Key and Larger "
+            "Than One Block-Size Data";
+    hmac.Update(input.data(), 10);
+    hmac.Update(input.data() + 10, input.size() - 10);
+    EXPECT_EQ(sizeof(output), hmac.Finish(output, sizeof(output)));
+    EXPECT_EQ("e8e99d0f45237d786d6bbaa7965c7808bbff1a91",
+              hex_encode(output, sizeof(output)));
+  }
+
+  Hmac short_key_hmac(DIGEST_SHA_1, "Jefe", 4);
+  std::string input("what do ya want for nothing?");
+  EXPECT_EQ(0U, short_key_hmac.Compute(input.data(), input.size(), output,
+                                       sizeof(output) - 1));
+  EXPECT_EQ(sizeof(output), short_key_hmac.Compute(input.data(), input.size(),
+                                                   output, sizeof(output)));
+  EXPECT_EQ("effcdf6ae5eb2fa2d27416d5f184df9c259a7c79",
+            hex_encode(output, sizeof(output)));
+}
+
+TEST(MessageDigestTest, TestBadPrecomputedHmac) {
+  Hmac hmac("sha-9000", "key", 3);
+  EXPECT_EQ(0U, hmac.Size());
+  char output[64];
+  EXPECT_EQ(0U, hmac.Compute("abc", 3, output, sizeof(output)));
+}
+
 }  // namespace rtc
@@ -151,9 +151,9 @@ void MessageQueueManager::ProcessAllMessageQueuesInternal() {
 // MessageQueue
 MessageQueue::MessageQueue(SocketServer* ss, bool init_queue)
     : fPeekKeep_(false),
-      dmsgq_next_num_(0),
       fInitialized_(false),
       fDestroyed_(false),
+      latency_stats_("MessageQueue"),
       stop_(0),
       ss_(ss) {
   RTC_DCHECK(ss);
@@ -274,14 +274,9 @@ bool MessageQueue::Get(Message* pmsg, int cmsWait, bool process_io) {
         // triggered and calculate the next trigger time.
         if (first_pass) {
           first_pass = false;
-          while (!dmsgq_.empty()) {
-            if (msCurrent < dmsgq_.top().msTrigger_) {
-              cmsDelayNext = TimeDiff(dmsgq_.top().msTrigger_, msCurrent);
-              break;
-            }
-            msgq_.push_back(dmsgq_.top().msg_);
-            dmsgq_.pop();
-          }
+          dmsgq_.Advance(msCurrent, &msgq_);
+          if (!dmsgq_.empty())
+            cmsDelayNext = TimeDiff(dmsgq_.EarliestTrigger(), msCurrent);
         }
         // Pull a message off the message queue, if available.
         if (msgq_.empty()) {
@@ -369,6 +364,8 @@ void MessageQueue::Post(const Location& posted_from,
     if (time_sensitive) {
       msg.ts_sensitive = TimeMillis() + kMaxMsgLatency;
     }
+    if (TaskLatencyStats::IsEnabled())
+      msg.ready_us = TimeMicros();
     msgq_.push_back(msg);
   }
   WakeUpSocketServer();
@@ -414,7 +411,7 @@ void MessageQueue::DoDelayPost(const Location& posted_from,
   }
 
   // Keep thread safe
-  // Add to the priority queue. Gets sorted soonest first.
+  // Add to the timer wheel. Messages come out soonest first.
   // Signal for the multiplexer to return.
 
   {
@@ -424,13 +421,9 @@ void MessageQueue::DoDelayPost(const Location& posted_from,
     msg.phandler = phandler;
     msg.message_id = id;
     msg.pdata = pdata;
-    DelayedMessage dmsg(cmsDelay, tstamp, dmsgq_next_num_, msg);
-    dmsgq_.push(dmsg);
-    // If this message queue processes 1 message every millisecond for 50 days,
-    // we will wrap this number.  Even then, only messages with identical times
-    // will be misordered, and then only briefly.  This is probably ok.
-    ++dmsgq_next_num_;
-    RTC_DCHECK_NE(0, dmsgq_next_num_);
+    if (TaskLatencyStats::IsEnabled())
+      msg.ready_us = tstamp * kNumMicrosecsPerMillisec;
+    dmsgq_.Insert(tstamp - cmsDelay, tstamp, msg);
   }
   WakeUpSocketServer();
 }
@@ -442,7 +435,7 @@ int MessageQueue::GetDelay() {
     return 0;
 
   if (!dmsgq_.empty()) {
-    int delay = TimeUntil(dmsgq_.top().msTrigger_);
+    int delay = TimeUntil(dmsgq_.EarliestTrigger());
     if (delay < 0)
       delay = 0;
     return delay;
@@ -487,23 +480,18 @@ void MessageQueue::ClearInternal(MessageHandler* phandler,
     }
   }
 
-  // Remove from priority queue. Not directly iterable, so use this approach
+  // Remove from the timer wheel
 
-  PriorityQueue::container_type::iterator new_end = dmsgq_.container().begin();
-  for (PriorityQueue::container_type::iterator it = new_end;
-       it != dmsgq_.container().end(); ++it) {
-    if (it->msg_.Match(phandler, id)) {
-      if (removed) {
-        removed->push_back(it->msg_);
-      } else {
-        delete it->msg_.pdata;
-      }
+  dmsgq_.RemoveIf([phandler, id, removed](Message& msg) {
+    if (!msg.Match(phandler, id))
+      return false;
+    if (removed) {
+      removed->push_back(msg);
     } else {
-      *new_end++ = *it;
+      delete msg.pdata;
     }
-  }
-  dmsgq_.container().erase(new_end, dmsgq_.container().end());
-  dmsgq_.reheap();
+    return true;
+  });
 }
 
 void MessageQueue::Dispatch(Message* pmsg) {
@@ -511,7 +499,12 @@ void MessageQueue::Dispatch(Message* pmsg) {
                pmsg->posted_from.file_and_line(), "src_func",
                pmsg->posted_from.function_name());
   int64_t start_time = TimeMillis();
+  int64_t start_us = pmsg->ready_us ? TimeMicros() : 0;
   pmsg->phandler->OnMessage(pmsg);
+  if (pmsg->ready_us) {
+    latency_stats_.RecordTask(pmsg->ready_us, start_us, TimeMicros(),
+                              pmsg->posted_from.file_and_line());
+  }
   int64_t end_time = TimeMillis();
   int64_t diff = TimeDiff(end_time, start_time);
   if (diff >= kSlowDispatchLoggingThreshold) {
@@ -16,7 +16,6 @@
 #include <algorithm>
 #include <list>
 #include <memory>
-#include <queue>
 #include <vector>
 
 #include "api/scoped_refptr.h"
@@ -26,7 +25,9 @@
 #include "rtc_base/message_handler.h"
 #include "rtc_base/socket_server.h"
 #include "rtc_base/system/rtc_export.h"
+#include "rtc_base/task_latency_stats.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/timer_wheel.h"
 #include "rtc_base/thread_annotations.h"
 
 namespace rtc {
@@ -153,7 +154,11 @@ const uint32_t MQID_DISPOSE = static_cast<uint32_t>(-2);
 
 struct Message {
   Message()
-      : phandler(nullptr), message_id(0), pdata(nullptr), ts_sensitive(0) {}
+      : phandler(nullptr),
+        message_id(0),
+        pdata(nullptr),
+        ts_sensitive(0),
+        ready_us(0) {}
   inline bool Match(MessageHandler* handler, uint32_t id) const {
     return (handler == nullptr || handler == phandler) &&
            (id == MQID_ANY || id == message_id);
@@ -163,32 +168,13 @@ struct Message {
   uint32_t message_id;
   MessageData* pdata;
   int64_t ts_sensitive;
+  // When the message became due, in us. Only set while TaskLatencyStats are
+  // enabled.
+  int64_t ready_us;
 };
 
 typedef std::list<Message> MessageList;
 
-// DelayedMessage goes into a priority queue, sorted by trigger time.  Messages
-// with the same trigger time are processed in num_ (FIFO) order.
-
-class DelayedMessage {
- public:
-  DelayedMessage(int64_t delay,
-                 int64_t trigger,
-                 uint32_t num,
-                 const Message& msg)
-      : cmsDelay_(delay), msTrigger_(trigger), num_(num), msg_(msg) {}
-
-  bool operator<(const DelayedMessage& dmsg) const {
-    return (dmsg.msTrigger_ < msTrigger_) ||
-           ((dmsg.msTrigger_ == msTrigger_) && (dmsg.num_ < num_));
-  }
-
-  int64_t cmsDelay_;  // for debugging
-  int64_t msTrigger_;
-  uint32_t num_;
-  Message msg_;
-};
-
 class RTC_EXPORT MessageQueue {
  public:
   static const int kForever = -1;
@@ -280,12 +266,6 @@ class RTC_EXPORT MessageQueue {
   sigslot::signal0<> SignalQueueDestroyed;
 
  protected:
-  class PriorityQueue : public std::priority_queue<DelayedMessage> {
-   public:
-    container_type& container() { return c; }
-    void reheap() { make_heap(c.begin(), c.end(), comp); }
-  };
-
   void DoDelayPost(const Location& posted_from,
                    int64_t cmsDelay,
                    int64_t tstamp,
@@ -312,11 +292,12 @@ class RTC_EXPORT MessageQueue {
   bool fPeekKeep_;
   Message msgPeek_;
   MessageList msgq_ RTC_GUARDED_BY(crit_);
-  PriorityQueue dmsgq_ RTC_GUARDED_BY(crit_);
-  uint32_t dmsgq_next_num_ RTC_GUARDED_BY(crit_);
+  // Delayed messages, handed out by trigger time and then in posting order.
+  TimerWheel<Message> dmsgq_ RTC_GUARDED_BY(crit_);
   CriticalSection crit_;
   bool fInitialized_;
   bool fDestroyed_;
+  TaskLatencyStats latency_stats_;
 
  private:
   volatile int stop_;
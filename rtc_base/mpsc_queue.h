@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_MPSC_QUEUE_H_
+#define RTC_BASE_MPSC_QUEUE_H_
+
+#include <atomic>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/constructor_magic.h"
+
+namespace rtc {
+
+// Unbounded lock-free FIFO queue with any number of producer threads and a
+// single consumer thread, after Dmitry Vyukov's intrusive MPSC node-based
+// queue. Push() is wait-free: one atomic exchange and one store. Pop() never
+// blocks, but may report the queue as empty while a Push() on another thread
+// is half done; the value shows up once that Push() returns.
+//
+// The queue is intrusive: T derives from MpscQueue<T>::Node, and nodes are
+// linked in place without any allocation. The queue never owns its nodes.
+//
+// Values pushed by one thread are popped in the order they were pushed.
+template <typename T>
+class MpscQueue {
+ public:
+  class Node {
+   public:
+    Node() = default;
+
+   private:
+    friend class MpscQueue;
+    std::atomic<Node*> next_{nullptr};
+  };
+
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  ~MpscQueue() { RTC_DCHECK(empty()); }
+
+  // May be called on any thread.
+  void Push(T* value) { PushNode(value); }
+
+  // Must only be called on the consumer thread. Returns null if the queue is
+  // empty, or if the value next in line is still being pushed.
+  T* Pop() {
+    Node* head = head_;
+    Node* next = head->next_.load(std::memory_order_acquire);
+    if (head == &stub_) {
+      if (!next)
+        return nullptr;
+      head_ = next;
+      head = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+    if (next) {
+      head_ = next;
+      return static_cast<T*>(head);
+    }
+    if (head != tail_.load(std::memory_order_acquire))
+      return nullptr;
+    // |head| is the last node. Put the stub behind it so that |head| can be
+    // handed out without leaving the queue without a node.
+    PushNode(&stub_);
+    next = head->next_.load(std::memory_order_acquire);
+    if (!next)
+      return nullptr;
+    head_ = next;
+    return static_cast<T*>(head);
+  }
+
+  // Must only be called on the consumer thread. Returns false also while a
+  // Push() is half done. The load is sequentially consistent, so a consumer
+  // that publishes that it is going to sleep before calling empty() either
+  // sees a concurrent Push(), or the producer sees the published state.
+  bool empty() const {
+    return head_ == &stub_ && tail_.load(std::memory_order_seq_cst) == &stub_;
+  }
+
+ private:
+  void PushNode(Node* node) {
+    node->next_.store(nullptr, std::memory_order_relaxed);
+    Node* prev = tail_.exchange(node, std::memory_order_seq_cst);
+    prev->next_.store(node, std::memory_order_release);
+  }
+
+  Node stub_;
+  // Only accessed by the consumer.
+  Node* head_;
+  std::atomic<Node*> tail_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(MpscQueue);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_MPSC_QUEUE_H_
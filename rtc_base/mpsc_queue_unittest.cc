@@ -0,0 +1,270 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/mpsc_queue.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include "api/task_queue/queued_task.h"
+#include "api/task_queue/task_queue_base.h"
+#include "api/task_queue/task_queue_factory.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/task_queue_stdlib.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+struct Item : public MpscQueue<Item>::Node {
+  int producer = 0;
+  int sequence = 0;
+};
+
+TEST(MpscQueueTest, PopsInPushOrder) {
+  MpscQueue<Item> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(nullptr, queue.Pop());
+
+  Item items[3];
+  for (int i = 0; i < 3; ++i) {
+    items[i].sequence = i;
+    queue.Push(&items[i]);
+  }
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(&items[0], queue.Pop());
+  EXPECT_EQ(&items[1], queue.Pop());
+  // Interleaving pushes with pops keeps the order.
+  queue.Push(&items[0]);
+  EXPECT_EQ(&items[2], queue.Pop());
+  EXPECT_EQ(&items[0], queue.Pop());
+  EXPECT_EQ(nullptr, queue.Pop());
+  EXPECT_TRUE(queue.empty());
+}
+
+// Pushes |count| items onto |queue| from a thread of its own, once |go| is
+// set.
+class Producer {
+ public:
+  Producer(MpscQueue<Item>* queue,
+           const std::atomic<bool>* go,
+           int id,
+           int count)
+      : queue_(queue),
+        go_(go),
+        items_(count),
+        thread_(&Producer::Run, this, "Producer") {
+    for (int i = 0; i < count; ++i) {
+      items_[i].producer = id;
+      items_[i].sequence = i;
+    }
+    thread_.Start();
+  }
+  ~Producer() { thread_.Stop(); }
+
+ private:
+  static void Run(void* obj) {
+    Producer* me = static_cast<Producer*>(obj);
+    while (!me->go_->load())
+      continue;
+    for (Item& item : me->items_)
+      me->queue_->Push(&item);
+  }
+
+  MpscQueue<Item>* const queue_;
+  const std::atomic<bool>* const go_;
+  std::vector<Item> items_;
+  PlatformThread thread_;
+};
+
+TEST(MpscQueueTest, DeliversEveryItemOfManyProducersInOrder) {
+  static const int kNumProducers = 4;
+  static const int kItemsPerProducer = 20000;
+  MpscQueue<Item> queue;
+  std::atomic<bool> go(false);
+  std::vector<std::unique_ptr<Producer>> producers;
+  for (int i = 0; i < kNumProducers; ++i) {
+    producers.push_back(
+        std::make_unique<Producer>(&queue, &go, i, kItemsPerProducer));
+  }
+  go.store(true);
+
+  std::vector<int> next_sequence(kNumProducers, 0);
+  int popped = 0;
+  while (popped < kNumProducers * kItemsPerProducer) {
+    Item* item = queue.Pop();
+    if (!item)
+      continue;
+    ASSERT_EQ(next_sequence[item->producer], item->sequence);
+    ++next_sequence[item->producer];
+    ++popped;
+  }
+  producers.clear();
+  EXPECT_EQ(nullptr, queue.Pop());
+  EXPECT_TRUE(queue.empty());
+}
+
+// The std::queue under a lock that TaskQueueStdlib used before.
+class LockedQueue {
+ public:
+  void Push(Item* item) {
+    CritScope lock(&lock_);
+    queue_.push(item);
+  }
+  Item* Pop() {
+    CritScope lock(&lock_);
+    if (queue_.empty())
+      return nullptr;
+    Item* item = queue_.front();
+    queue_.pop();
+    return item;
+  }
+
+ private:
+  CriticalSection lock_;
+  std::queue<Item*> queue_ RTC_GUARDED_BY(lock_);
+};
+
+template <typename Queue>
+class BenchmarkProducer {
+ public:
+  BenchmarkProducer(Queue* queue, const std::atomic<bool>* go, int count)
+      : queue_(queue),
+        go_(go),
+        items_(count),
+        thread_(&BenchmarkProducer::Run, this, "BenchmarkProducer") {
+    thread_.Start();
+  }
+  ~BenchmarkProducer() { thread_.Stop(); }
+
+ private:
+  static void Run(void* obj) {
+    BenchmarkProducer* me = static_cast<BenchmarkProducer*>(obj);
+    while (!me->go_->load())
+      continue;
+    for (Item& item : me->items_)
+      me->queue_->Push(&item);
+  }
+
+  Queue* const queue_;
+  const std::atomic<bool>* const go_;
+  std::vector<Item> items_;
+  PlatformThread thread_;
+};
+
+// Returns the time in ns per item it takes |num_producers| threads to push,
+// and the calling thread to pop, |total| items.
+template <typename Queue>
+int64_t MeasureQueue(int num_producers, int total) {
+  Queue queue;
+  std::atomic<bool> go(false);
+  std::vector<std::unique_ptr<BenchmarkProducer<Queue>>> producers;
+  for (int i = 0; i < num_producers; ++i) {
+    producers.push_back(std::make_unique<BenchmarkProducer<Queue>>(
+        &queue, &go, total / num_producers));
+  }
+  int expected = total / num_producers * num_producers;
+  int64_t start_ns = TimeNanos();
+  go.store(true);
+  for (int popped = 0; popped < expected;) {
+    if (queue.Pop())
+      ++popped;
+  }
+  int64_t elapsed_ns = TimeNanos() - start_ns;
+  producers.clear();
+  return elapsed_ns / expected;
+}
+
+class CountingTask : public webrtc::QueuedTask {
+ public:
+  CountingTask(std::atomic<int>* remaining, Event* done)
+      : remaining_(remaining), done_(done) {}
+  bool Run() override {
+    if (remaining_->fetch_sub(1) == 1)
+      done_->Set();
+    return true;
+  }
+
+ private:
+  std::atomic<int>* const remaining_;
+  Event* const done_;
+};
+
+struct PostingContext {
+  webrtc::TaskQueueBase* task_queue;
+  const std::atomic<bool>* go;
+  std::atomic<int>* remaining;
+  Event* done;
+  int count;
+};
+
+void PostTasks(void* obj) {
+  PostingContext* context = static_cast<PostingContext*>(obj);
+  while (!context->go->load())
+    continue;
+  for (int i = 0; i < context->count; ++i) {
+    context->task_queue->PostTask(
+        std::make_unique<CountingTask>(context->remaining, context->done));
+  }
+}
+
+// Returns the time in ns per task it takes |num_producers| threads to post
+// |total| tasks to a TaskQueueStdlib, and for all of them to run.
+int64_t MeasureTaskQueue(int num_producers, int total) {
+  std::unique_ptr<webrtc::TaskQueueFactory> factory =
+      webrtc::CreateTaskQueueStdlibFactory();
+  auto task_queue = factory->CreateTaskQueue(
+      "Benchmark", webrtc::TaskQueueFactory::Priority::NORMAL);
+  int per_producer = total / num_producers;
+  std::atomic<bool> go(false);
+  std::atomic<int> remaining(per_producer * num_producers);
+  Event done;
+  PostingContext context{task_queue.get(), &go, &remaining, &done,
+                         per_producer};
+  std::vector<std::unique_ptr<PlatformThread>> producers;
+  for (int i = 0; i < num_producers; ++i) {
+    producers.push_back(
+        std::make_unique<PlatformThread>(&PostTasks, &context, "Poster"));
+    producers.back()->Start();
+  }
+  int64_t start_ns = TimeNanos();
+  go.store(true);
+  done.Wait(Event::kForever);
+  int64_t elapsed_ns = TimeNanos() - start_ns;
+  for (auto& producer : producers)
+    producer->Stop();
+  return elapsed_ns / (per_producer * num_producers);
+}
+
+// Reports the cost per item with 1 to 32 producer threads, for the lock-free
+// queue against a locked std::queue, and for posting to a TaskQueueStdlib.
+// Disabled by default since it only reports numbers.
+TEST(MpscQueueTest, DISABLED_ContentionBenchmark) {
+  static const int kTotal = 1 << 20;
+  for (int producers = 1; producers <= 32; producers *= 2) {
+    RTC_LOG(LS_INFO) << producers << " producers: MpscQueue "
+                     << MeasureQueue<MpscQueue<Item>>(producers, kTotal)
+                     << " ns/item, locked std::queue "
+                     << MeasureQueue<LockedQueue>(producers, kTotal)
+                     << " ns/item, TaskQueueStdlib::PostTask "
+                     << MeasureTaskQueue(producers, kTotal) << " ns/task";
+  }
+}
+
+}  // namespace
+}  // namespace rtc
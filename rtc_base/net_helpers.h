@@ -17,6 +17,7 @@
 #include <winsock2.h>  // NOLINT
 #endif
 
+#include <string>
 #include <vector>
 
 #include "rtc_base/async_resolver_interface.h"
@@ -53,6 +54,13 @@ class RTC_EXPORT AsyncResolver : public SignalThread,
   int error_;
 };
 
+// Resolves |hostname| for |family|, AF_UNSPEC for both IPv4 and IPv6, on the
+// calling thread, which may block for a long time. Returns 0 on success, or
+// the error of getaddrinfo().
+int ResolveHostname(const std::string& hostname,
+                    int family,
+                    std::vector<IPAddress>* addresses);
+
 // rtc namespaced wrappers for inet_ntop and inet_pton so we can avoid
 // the windows-native versions of these.
 const char* inet_ntop(int af, const void* src, char* dst, socklen_t size);
@@ -0,0 +1,420 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/netlink_network_monitor.h"
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/location.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/physical_socket_server.h"
+
+namespace rtc {
+
+namespace {
+
+using InterfaceMap = std::map<int, NetworkInterfaceInfo>;
+
+// Enough for the notifications of a burst of changes, such as those of a
+// container that starts, so that they are rarely dropped.
+const int kSocketReceiveBufferSize = 256 * 1024;
+const size_t kMaxReadSize = 32 * 1024;
+// The kernel answers right away; this only guards against a hang.
+const int kDumpTimeoutMs = 2000;
+
+void MarkChanged(const std::string& name, std::set<std::string>* changed) {
+  if (!name.empty())
+    changed->insert(name);
+}
+
+void ProcessLinkMessage(const nlmsghdr* header,
+                        InterfaceMap* interfaces,
+                        std::set<std::string>* changed) {
+  if (header->nlmsg_len < NLMSG_LENGTH(sizeof(ifinfomsg)))
+    return;
+  const ifinfomsg* msg = static_cast<const ifinfomsg*>(NLMSG_DATA(header));
+  if (header->nlmsg_type == RTM_DELLINK) {
+    auto it = interfaces->find(msg->ifi_index);
+    if (it != interfaces->end()) {
+      MarkChanged(it->second.name, changed);
+      interfaces->erase(it);
+    }
+    return;
+  }
+  std::string name;
+  int payload_len = IFLA_PAYLOAD(header);
+  for (const rtattr* rta = IFLA_RTA(msg); RTA_OK(rta, payload_len);
+       rta = RTA_NEXT(rta, payload_len)) {
+    if (rta->rta_type == IFLA_IFNAME) {
+      const char* data = static_cast<const char*>(RTA_DATA(rta));
+      name.assign(data, strnlen(data, RTA_PAYLOAD(rta)));
+    }
+  }
+  NetworkInterfaceInfo& interface = (*interfaces)[msg->ifi_index];
+  bool running = (msg->ifi_flags & IFF_RUNNING) != 0;
+  bool loopback = (msg->ifi_flags & IFF_LOOPBACK) != 0;
+  // Links are also reported when only their statistics or other properties
+  // that do not matter here change.
+  if (!name.empty() && name != interface.name) {
+    MarkChanged(interface.name, changed);
+    interface.name = name;
+    MarkChanged(interface.name, changed);
+  }
+  if (running != interface.running || loopback != interface.loopback) {
+    interface.running = running;
+    interface.loopback = loopback;
+    MarkChanged(interface.name, changed);
+  }
+}
+
+void ProcessAddressMessage(const nlmsghdr* header,
+                           InterfaceMap* interfaces,
+                           std::set<std::string>* changed) {
+  if (header->nlmsg_len < NLMSG_LENGTH(sizeof(ifaddrmsg)))
+    return;
+  const ifaddrmsg* msg = static_cast<const ifaddrmsg*>(NLMSG_DATA(header));
+  if (msg->ifa_family != AF_INET && msg->ifa_family != AF_INET6)
+    return;
+  IPAddress ip;
+  IPAddress local_ip;
+  uint32_t flags = msg->ifa_flags;
+  int payload_len = IFA_PAYLOAD(header);
+  for (const rtattr* rta = IFA_RTA(msg); RTA_OK(rta, payload_len);
+       rta = RTA_NEXT(rta, payload_len)) {
+    const void* data = RTA_DATA(rta);
+    if (rta->rta_type == IFA_ADDRESS || rta->rta_type == IFA_LOCAL) {
+      IPAddress* target = rta->rta_type == IFA_ADDRESS ? &ip : &local_ip;
+      if (msg->ifa_family == AF_INET && RTA_PAYLOAD(rta) >= sizeof(in_addr)) {
+        in_addr addr;
+        memcpy(&addr, data, sizeof(addr));
+        *target = IPAddress(addr);
+      } else if (msg->ifa_family == AF_INET6 &&
+                 RTA_PAYLOAD(rta) >= sizeof(in6_addr)) {
+        in6_addr addr;
+        memcpy(&addr, data, sizeof(addr));
+        *target = IPAddress(addr);
+      }
+    } else if (rta->rta_type == IFA_FLAGS &&
+               RTA_PAYLOAD(rta) >= sizeof(uint32_t)) {
+      memcpy(&flags, data, sizeof(flags));
+    }
+  }
+  // On point-to-point links, IFA_ADDRESS is the address of the peer.
+  if (!local_ip.IsNil())
+    ip = local_ip;
+  if (ip.IsNil())
+    return;
+
+  int ipv6_flags = IPV6_ADDRESS_FLAG_NONE;
+  if (msg->ifa_family == AF_INET6) {
+    if (flags & IFA_F_TEMPORARY)
+      ipv6_flags |= IPV6_ADDRESS_FLAG_TEMPORARY;
+    if (flags & IFA_F_DEPRECATED)
+      ipv6_flags |= IPV6_ADDRESS_FLAG_DEPRECATED;
+  }
+  NetworkInterfaceInfo::Address address;
+  address.ip = InterfaceAddress(ip, ipv6_flags);
+  address.prefix_length = msg->ifa_prefixlen;
+
+  if (header->nlmsg_type == RTM_DELADDR) {
+    auto it = interfaces->find(msg->ifa_index);
+    if (it == interfaces->end())
+      return;
+    std::vector<NetworkInterfaceInfo::Address>& addresses =
+        it->second.addresses;
+    for (auto addr = addresses.begin(); addr != addresses.end(); ++addr) {
+      if (static_cast<const IPAddress&>(addr->ip) == ip) {
+        addresses.erase(addr);
+        MarkChanged(it->second.name, changed);
+        return;
+      }
+    }
+    return;
+  }
+  // Addresses are also reported when only their lifetimes change.
+  NetworkInterfaceInfo& interface = (*interfaces)[msg->ifa_index];
+  for (NetworkInterfaceInfo::Address& existing : interface.addresses) {
+    if (static_cast<const IPAddress&>(existing.ip) == ip) {
+      if (existing.ip.ipv6_flags() != address.ip.ipv6_flags() ||
+          existing.prefix_length != address.prefix_length) {
+        existing = address;
+        MarkChanged(interface.name, changed);
+      }
+      return;
+    }
+  }
+  interface.addresses.push_back(address);
+  MarkChanged(interface.name, changed);
+}
+
+// Applies the messages in |data|. Sets |*done| when they end the dump of
+// sequence number |dump_seq|, and |*failed| if that dump failed.
+void ProcessNetlinkMessages(const void* data,
+                            size_t size,
+                            uint32_t dump_seq,
+                            InterfaceMap* interfaces,
+                            std::set<std::string>* changed,
+                            bool* done,
+                            bool* failed) {
+  const nlmsghdr* header = static_cast<const nlmsghdr*>(data);
+  // The NLMSG_* macros take an int length.
+  int len = static_cast<int>(size);
+  for (; NLMSG_OK(header, len); header = NLMSG_NEXT(header, len)) {
+    switch (header->nlmsg_type) {
+      case NLMSG_DONE:
+      case NLMSG_ERROR:
+        if (dump_seq != 0 && header->nlmsg_seq == dump_seq) {
+          *done = true;
+          *failed = header->nlmsg_type == NLMSG_ERROR;
+        }
+        break;
+      case RTM_NEWLINK:
+      case RTM_DELLINK:
+        ProcessLinkMessage(header, interfaces, changed);
+        break;
+      case RTM_NEWADDR:
+      case RTM_DELADDR:
+        ProcessAddressMessage(header, interfaces, changed);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+bool Dump(int fd,
+          uint16_t type,
+          uint32_t seq,
+          InterfaceMap* interfaces,
+          std::set<std::string>* changed) {
+  struct {
+    nlmsghdr header;
+    rtgenmsg msg;
+  } request;
+  memset(&request, 0, sizeof(request));
+  request.header.nlmsg_len = NLMSG_LENGTH(sizeof(rtgenmsg));
+  request.header.nlmsg_type = type;
+  request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.header.nlmsg_seq = seq;
+  request.msg.rtgen_family = AF_UNSPEC;
+  if (send(fd, &request, request.header.nlmsg_len, 0) !=
+      static_cast<ssize_t>(request.header.nlmsg_len)) {
+    RTC_LOG_ERR(LS_WARNING) << "Failed to send rtnetlink dump request";
+    return false;
+  }
+  char buffer[kMaxReadSize];
+  bool done = false;
+  bool failed = false;
+  while (!done) {
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received < 0) {
+      if (errno == EINTR)
+        continue;
+      RTC_LOG_ERR(LS_WARNING) << "Failed to read rtnetlink dump";
+      return false;
+    }
+    ProcessNetlinkMessages(buffer, received, seq, interfaces, changed, &done,
+                           &failed);
+  }
+  return !failed;
+}
+
+}  // namespace
+
+NetlinkNetworkMonitor::NetlinkNetworkMonitor() = default;
+
+NetlinkNetworkMonitor::~NetlinkNetworkMonitor() {
+  Stop();
+}
+
+void NetlinkNetworkMonitor::Start() {
+  RTC_DCHECK(worker_thread()->IsCurrent());
+  if (thread_)
+    return;
+  auto socket_server = std::make_unique<PhysicalSocketServer>();
+  socket_server_ = socket_server.get();
+  thread_ = std::make_unique<Thread>(std::move(socket_server));
+  thread_->SetName("NetlinkNetworkMonitor", this);
+
+  InterfaceMap interfaces;
+  int fd = OpenAndDump(&interfaces);
+  if (fd < 0)
+    return;
+  {
+    CritScope lock(&crit_);
+    tracking_ = true;
+    interfaces_ = std::move(interfaces);
+    changed_.clear();
+    for (const auto& kv : interfaces_)
+      MarkChanged(kv.second.name, &changed_);
+    notification_pending_ = false;
+  }
+  Listen(fd);
+  thread_->Start();
+}
+
+void NetlinkNetworkMonitor::Stop() {
+  if (!thread_)
+    return;
+  thread_->Stop();
+  socket_.reset();
+  thread_.reset();
+  socket_server_ = nullptr;
+  CritScope lock(&crit_);
+  tracking_ = false;
+  interfaces_.clear();
+  changed_.clear();
+}
+
+AdapterType NetlinkNetworkMonitor::GetAdapterType(
+    const std::string& interface_name) {
+  return ADAPTER_TYPE_UNKNOWN;
+}
+
+bool NetlinkNetworkMonitor::GetInterfaceChanges(
+    std::vector<NetworkInterfaceInfo>* interfaces) {
+  CritScope lock(&crit_);
+  if (!tracking_)
+    return false;
+  interfaces->clear();
+  for (const std::string& name : changed_) {
+    NetworkInterfaceInfo gone;
+    gone.name = name;
+    const NetworkInterfaceInfo* found = &gone;
+    for (const auto& kv : interfaces_) {
+      if (kv.second.name == name) {
+        found = &kv.second;
+        break;
+      }
+    }
+    interfaces->push_back(*found);
+  }
+  changed_.clear();
+  notification_pending_ = false;
+  return true;
+}
+
+void NetlinkNetworkMonitor::ProcessMessagesForTesting(const void* data,
+                                                      size_t size) {
+  ProcessMessages(data, size);
+}
+
+int NetlinkNetworkMonitor::OpenAndDump(InterfaceMap* interfaces) {
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd < 0) {
+    RTC_LOG_ERR(LS_WARNING) << "Failed to open an rtnetlink socket";
+    return -1;
+  }
+  int buffer_size = kSocketReceiveBufferSize;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+  timeval timeout = {kDumpTimeoutMs / 1000, (kDumpTimeoutMs % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+  // The notifications that arrive during the dumps are applied along with
+  // them, so that none is missed in between.
+  std::set<std::string> changed;
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      !Dump(fd, RTM_GETLINK, 1, interfaces, &changed) ||
+      !Dump(fd, RTM_GETADDR, 2, interfaces, &changed)) {
+    RTC_LOG_ERR(LS_WARNING) << "Failed to read the interfaces with rtnetlink";
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void NetlinkNetworkMonitor::Listen(int fd) {
+  socket_.reset(socket_server_->WrapSocket(fd));
+  RTC_DCHECK(socket_);
+  socket_->SignalReadEvent.connect(this, &NetlinkNetworkMonitor::OnReadEvent);
+  socket_->SignalCloseEvent.connect(this,
+                                    &NetlinkNetworkMonitor::OnCloseEvent);
+}
+
+void NetlinkNetworkMonitor::OnReadEvent(AsyncSocket* socket) {
+  RTC_DCHECK(thread_->IsCurrent());
+  char buffer[kMaxReadSize];
+  while (true) {
+    int received = socket->Recv(buffer, sizeof(buffer), nullptr);
+    if (received > 0) {
+      ProcessMessages(buffer, received);
+      continue;
+    }
+    if (received < 0 && socket->GetError() == ENOBUFS)
+      OnCloseEvent(socket, ENOBUFS);
+    break;
+  }
+}
+
+void NetlinkNetworkMonitor::OnCloseEvent(AsyncSocket* socket, int error) {
+  RTC_DCHECK(thread_->IsCurrent());
+  RTC_LOG(LS_WARNING) << "rtnetlink notifications were lost, error " << error
+                      << "; reading all the interfaces again";
+  // Not from within a signal of the socket, which Resync() deletes.
+  thread_->PostTask(RTC_FROM_HERE, [this] { Resync(); });
+}
+
+void NetlinkNetworkMonitor::Resync() {
+  RTC_DCHECK(thread_->IsCurrent());
+  socket_.reset();
+  InterfaceMap interfaces;
+  int fd = OpenAndDump(&interfaces);
+  CritScope lock(&crit_);
+  // Report the interfaces that changed, or are gone, in the meantime. If
+  // rtnetlink cannot be used anymore, the network manager falls back to
+  // polling.
+  for (const auto& kv : interfaces_)
+    MarkChanged(kv.second.name, &changed_);
+  for (const auto& kv : interfaces)
+    MarkChanged(kv.second.name, &changed_);
+  interfaces_ = std::move(interfaces);
+  tracking_ = fd >= 0;
+  MaybeNotify();
+  if (fd >= 0)
+    Listen(fd);
+}
+
+void NetlinkNetworkMonitor::ProcessMessages(const void* data, size_t size) {
+  CritScope lock(&crit_);
+  bool done = false;
+  bool failed = false;
+  ProcessNetlinkMessages(data, size, 0, &interfaces_, &changed_, &done,
+                         &failed);
+  if (!changed_.empty())
+    MaybeNotify();
+}
+
+void NetlinkNetworkMonitor::MaybeNotify() {
+  if (notification_pending_)
+    return;
+  notification_pending_ = true;
+  OnNetworksChanged();
+}
+
+NetworkMonitorInterface* NetlinkNetworkMonitorFactory::CreateNetworkMonitor() {
+  return new NetlinkNetworkMonitor();
+}
+
+}  // namespace rtc
@@ -0,0 +1,99 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_NETLINK_NETWORK_MONITOR_H_
+#define RTC_BASE_NETLINK_NETWORK_MONITOR_H_
+
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rtc_base/async_socket.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/network_monitor.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace rtc {
+
+class PhysicalSocketServer;
+
+// Tracks the interfaces and their addresses with the link and address
+// notifications of rtnetlink (Linux), so that BasicNetworkManager neither
+// polls the interfaces nor enumerates all of them on every change. The
+// notifications are read on a thread of the monitor, which only wakes up
+// when the kernel sends some.
+class NetlinkNetworkMonitor : public NetworkMonitorBase {
+ public:
+  NetlinkNetworkMonitor();
+  ~NetlinkNetworkMonitor() override;
+
+  // Reads the current interfaces before returning. If rtnetlink cannot be
+  // used, GetInterfaceChanges() returns false, so that the network manager
+  // falls back to polling.
+  void Start() override;
+  void Stop() override;
+
+  // The type is left to the network manager, which guesses it from the name.
+  AdapterType GetAdapterType(const std::string& interface_name) override;
+
+  bool GetInterfaceChanges(
+      std::vector<NetworkInterfaceInfo>* interfaces) override;
+
+  // Applies the rtnetlink messages in |data| as if they had been received.
+  void ProcessMessagesForTesting(const void* data, size_t size);
+
+ private:
+  // By interface index.
+  using InterfaceMap = std::map<int, NetworkInterfaceInfo>;
+
+  // Opens a socket that gets the notifications, and reads the current
+  // interfaces through it into |interfaces|. Returns the socket, or -1.
+  int OpenAndDump(InterfaceMap* interfaces);
+  // Reads the notifications from |fd| on |thread_|.
+  void Listen(int fd);
+  void OnReadEvent(AsyncSocket* socket);
+  // Called when notifications were dropped because the receive buffer was
+  // full.
+  void OnCloseEvent(AsyncSocket* socket, int error);
+  // Reads all the interfaces again with a new socket.
+  void Resync();
+  void ProcessMessages(const void* data, size_t size);
+  // Signals the change unless the previous one has not been picked up yet.
+  void MaybeNotify() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  std::unique_ptr<Thread> thread_;
+  PhysicalSocketServer* socket_server_ = nullptr;
+  std::unique_ptr<AsyncSocket> socket_;
+
+  CriticalSection crit_;
+  bool tracking_ RTC_GUARDED_BY(crit_) = false;
+  bool notification_pending_ RTC_GUARDED_BY(crit_) = false;
+  InterfaceMap interfaces_ RTC_GUARDED_BY(crit_);
+  // The names of the interfaces changed since the last GetInterfaceChanges().
+  std::set<std::string> changed_ RTC_GUARDED_BY(crit_);
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(NetlinkNetworkMonitor);
+};
+
+class NetlinkNetworkMonitorFactory : public NetworkMonitorFactory {
+ public:
+  NetworkMonitorInterface* CreateNetworkMonitor() override;
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_NETLINK_NETWORK_MONITOR_H_
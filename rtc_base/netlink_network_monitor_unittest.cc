@@ -0,0 +1,213 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/netlink_network_monitor.h"
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "rtc_base/gunit.h"
+#include "rtc_base/ip_address.h"
+#include "rtc_base/third_party/sigslot/sigslot.h"
+#include "rtc_base/thread.h"
+#include "test/gtest.h"
+
+namespace rtc {
+
+namespace {
+
+// An interface index that no real interface has.
+const int kIndex = 1000000;
+const char kName[] = "test0";
+
+void AppendAttribute(std::vector<char>* message,
+                     uint16_t type,
+                     const void* data,
+                     size_t size) {
+  size_t offset = message->size();
+  message->resize(offset + RTA_SPACE(size));
+  rtattr* rta = reinterpret_cast<rtattr*>(message->data() + offset);
+  rta->rta_len = RTA_LENGTH(size);
+  rta->rta_type = type;
+  memcpy(RTA_DATA(rta), data, size);
+}
+
+void FinishMessage(std::vector<char>* message, uint16_t type) {
+  nlmsghdr* header = reinterpret_cast<nlmsghdr*>(message->data());
+  header->nlmsg_len = message->size();
+  header->nlmsg_type = type;
+}
+
+std::vector<char> LinkMessage(uint16_t type, unsigned int flags) {
+  std::vector<char> message(NLMSG_SPACE(sizeof(ifinfomsg)));
+  ifinfomsg* msg = static_cast<ifinfomsg*>(
+      NLMSG_DATA(reinterpret_cast<nlmsghdr*>(message.data())));
+  msg->ifi_index = kIndex;
+  msg->ifi_flags = flags;
+  AppendAttribute(&message, IFLA_IFNAME, kName, sizeof(kName));
+  FinishMessage(&message, type);
+  return message;
+}
+
+std::vector<char> AddressMessage(uint16_t type,
+                                 const IPAddress& ip,
+                                 int prefix_length,
+                                 uint32_t flags) {
+  std::vector<char> message(NLMSG_SPACE(sizeof(ifaddrmsg)));
+  ifaddrmsg* msg = static_cast<ifaddrmsg*>(
+      NLMSG_DATA(reinterpret_cast<nlmsghdr*>(message.data())));
+  msg->ifa_family = ip.family();
+  msg->ifa_prefixlen = prefix_length;
+  msg->ifa_index = kIndex;
+  if (ip.family() == AF_INET) {
+    in_addr addr = ip.ipv4_address();
+    AppendAttribute(&message, IFA_ADDRESS, &addr, sizeof(addr));
+    AppendAttribute(&message, IFA_LOCAL, &addr, sizeof(addr));
+  } else {
+    in6_addr addr = ip.ipv6_address();
+    AppendAttribute(&message, IFA_ADDRESS, &addr, sizeof(addr));
+  }
+  AppendAttribute(&message, IFA_FLAGS, &flags, sizeof(flags));
+  FinishMessage(&message, type);
+  return message;
+}
+
+}  // namespace
+
+class NetlinkNetworkMonitorTest : public ::testing::Test,
+                                  public sigslot::has_slots<> {
+ protected:
+  void SetUp() override {
+    monitor_.SignalNetworksChanged.connect(
+        this, &NetlinkNetworkMonitorTest::OnNetworksChanged);
+    monitor_.Start();
+    std::vector<NetworkInterfaceInfo> interfaces;
+    ASSERT_TRUE(monitor_.GetInterfaceChanges(&interfaces));
+  }
+
+  void TearDown() override { monitor_.Stop(); }
+
+  void OnNetworksChanged() { ++signals_; }
+
+  void Process(const std::vector<char>& message) {
+    monitor_.ProcessMessagesForTesting(message.data(), message.size());
+  }
+
+  // Returns the changes of the test interface.
+  std::vector<NetworkInterfaceInfo> GetChanges() {
+    std::vector<NetworkInterfaceInfo> changes;
+    EXPECT_TRUE(monitor_.GetInterfaceChanges(&changes));
+    std::vector<NetworkInterfaceInfo> test_changes;
+    for (const NetworkInterfaceInfo& interface : changes) {
+      if (interface.name == kName)
+        test_changes.push_back(interface);
+    }
+    return test_changes;
+  }
+
+  AutoThread main_thread_;
+  NetlinkNetworkMonitor monitor_;
+  int signals_ = 0;
+};
+
+TEST_F(NetlinkNetworkMonitorTest, ReportsAllInterfacesAfterStart) {
+  monitor_.Stop();
+  monitor_.Start();
+  std::vector<NetworkInterfaceInfo> interfaces;
+  ASSERT_TRUE(monitor_.GetInterfaceChanges(&interfaces));
+  bool found_loopback = false;
+  for (const NetworkInterfaceInfo& interface : interfaces) {
+    if (!interface.loopback)
+      continue;
+    for (const NetworkInterfaceInfo::Address& address : interface.addresses) {
+      if (address.ip == InterfaceAddress(IPAddress(INADDR_LOOPBACK))) {
+        EXPECT_EQ(8, address.prefix_length);
+        found_loopback = true;
+      }
+    }
+  }
+  EXPECT_TRUE(found_loopback);
+}
+
+TEST_F(NetlinkNetworkMonitorTest, AppliesIncrementalChanges) {
+  IPAddress ip(0xC0A8050A);
+  Process(LinkMessage(RTM_NEWLINK, IFF_UP | IFF_RUNNING));
+  Process(AddressMessage(RTM_NEWADDR, ip, 24, 0));
+  std::vector<NetworkInterfaceInfo> changes = GetChanges();
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_TRUE(changes[0].running);
+  EXPECT_FALSE(changes[0].loopback);
+  ASSERT_EQ(1u, changes[0].addresses.size());
+  EXPECT_EQ(ip, changes[0].addresses[0].ip);
+  EXPECT_EQ(24, changes[0].addresses[0].prefix_length);
+
+  // Reported again with nothing that matters changed, such as when the
+  // lifetime of an address is extended.
+  Process(LinkMessage(RTM_NEWLINK, IFF_UP | IFF_RUNNING | IFF_PROMISC));
+  Process(AddressMessage(RTM_NEWADDR, ip, 24, 0));
+  EXPECT_TRUE(GetChanges().empty());
+
+  Process(LinkMessage(RTM_NEWLINK, IFF_UP));
+  changes = GetChanges();
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_FALSE(changes[0].running);
+  EXPECT_EQ(1u, changes[0].addresses.size());
+
+  Process(AddressMessage(RTM_DELADDR, ip, 24, 0));
+  changes = GetChanges();
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_TRUE(changes[0].addresses.empty());
+
+  Process(AddressMessage(RTM_NEWADDR, ip, 24, 0));
+  Process(LinkMessage(RTM_DELLINK, 0));
+  changes = GetChanges();
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_TRUE(changes[0].addresses.empty());
+}
+
+TEST_F(NetlinkNetworkMonitorTest, ReportsIPv6AddressFlags) {
+  IPAddress ip;
+  ASSERT_TRUE(IPFromString("2001:db8::1234", &ip));
+  Process(LinkMessage(RTM_NEWLINK, IFF_UP | IFF_RUNNING));
+  Process(AddressMessage(RTM_NEWADDR, ip, 64, IFA_F_TEMPORARY));
+  std::vector<NetworkInterfaceInfo> changes = GetChanges();
+  ASSERT_EQ(1u, changes.size());
+  ASSERT_EQ(1u, changes[0].addresses.size());
+  EXPECT_EQ(IPV6_ADDRESS_FLAG_TEMPORARY,
+            changes[0].addresses[0].ip.ipv6_flags());
+
+  Process(AddressMessage(RTM_NEWADDR, ip, 64,
+                         IFA_F_TEMPORARY | IFA_F_DEPRECATED));
+  changes = GetChanges();
+  ASSERT_EQ(1u, changes.size());
+  ASSERT_EQ(1u, changes[0].addresses.size());
+  EXPECT_EQ(IPV6_ADDRESS_FLAG_TEMPORARY | IPV6_ADDRESS_FLAG_DEPRECATED,
+            changes[0].addresses[0].ip.ipv6_flags());
+}
+
+TEST_F(NetlinkNetworkMonitorTest, SignalsOnceUntilChangesArePickedUp) {
+  Process(LinkMessage(RTM_NEWLINK, IFF_UP | IFF_RUNNING));
+  Process(AddressMessage(RTM_NEWADDR, IPAddress(0xC0A8050A), 24, 0));
+  Process(AddressMessage(RTM_NEWADDR, IPAddress(0xC0A8050B), 24, 0));
+  EXPECT_EQ_WAIT(1, signals_, 1000);
+  main_thread_.ProcessMessages(10);
+  EXPECT_EQ(1, signals_);
+
+  EXPECT_EQ(1u, GetChanges().size());
+  Process(AddressMessage(RTM_DELADDR, IPAddress(0xC0A8050B), 24, 0));
+  EXPECT_EQ_WAIT(2, signals_, 1000);
+}
+
+}  // namespace rtc
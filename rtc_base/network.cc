@@ -33,6 +33,7 @@
 #include <stdio.h>
 
 #include <memory>
+#include <set>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/match.h"
@@ -146,7 +147,6 @@ uint16_t ComputeNetworkCostByType(int type) {
   }
 }
 
-#if !defined(__native_client__)
 bool IsIgnoredIPv6(const InterfaceAddress& ip) {
   if (ip.family() != AF_INET6) {
     return false;
@@ -171,7 +171,6 @@ bool IsIgnoredIPv6(const InterfaceAddress& ip) {
 
   return false;
 }
-#endif  // !defined(__native_client__)
 
 }  // namespace
 
@@ -484,6 +483,93 @@ void BasicNetworkManager::OnNetworksChanged() {
   UpdateNetworksOnce();
 }
 
+void BasicNetworkManager::CreateNetworksFromInterfaceChanges(
+    const std::vector<NetworkInterfaceInfo>& changes,
+    bool keep_unchanged,
+    NetworkList* networks) const {
+  NetworkMap current_networks;
+  std::set<std::string> changed_names;
+  for (const NetworkInterfaceInfo& interface : changes) {
+    changed_names.insert(interface.name);
+    if (!interface.running) {
+      continue;
+    }
+    for (const NetworkInterfaceInfo::Address& address : interface.addresses) {
+      if (IsIgnoredIPv6(address.ip)) {
+        continue;
+      }
+      AddInterfaceAddress(interface.name, interface.loopback, address.ip,
+                          address.prefix_length, 0, false, &current_networks,
+                          networks);
+    }
+  }
+  if (keep_unchanged) {
+    // These are passed back to MergeNetworkList() as they are, so only the
+    // changed interfaces are examined again.
+    NetworkList current;
+    GetNetworks(&current);
+    for (Network* network : current) {
+      if (changed_names.find(network->name()) == changed_names.end()) {
+        networks->push_back(network);
+      }
+    }
+  }
+}
+
+void BasicNetworkManager::AddInterfaceAddress(const std::string& name,
+                                              bool loopback,
+                                              const InterfaceAddress& ip,
+                                              int prefix_length,
+                                              int scope_id,
+                                              bool include_ignored,
+                                              NetworkMap* current_networks,
+                                              NetworkList* networks) const {
+  AdapterType adapter_type = ADAPTER_TYPE_UNKNOWN;
+  AdapterType vpn_underlying_adapter_type = ADAPTER_TYPE_UNKNOWN;
+  if (loopback) {
+    adapter_type = ADAPTER_TYPE_LOOPBACK;
+  } else {
+    // If there is a network_monitor, use it to get the adapter type.
+    // Otherwise, get the adapter type based on a few name matching rules.
+    if (network_monitor_) {
+      adapter_type = network_monitor_->GetAdapterType(name);
+    }
+    if (adapter_type == ADAPTER_TYPE_UNKNOWN) {
+      adapter_type = GetAdapterTypeFromName(name.c_str());
+    }
+  }
+
+  if (adapter_type == ADAPTER_TYPE_VPN && network_monitor_) {
+    vpn_underlying_adapter_type =
+        network_monitor_->GetVpnUnderlyingAdapterType(name);
+  }
+  IPAddress prefix = TruncateIP(ip, prefix_length);
+  std::string key = MakeNetworkKey(name, prefix, prefix_length);
+  auto iter = current_networks->find(key);
+  if (iter == current_networks->end()) {
+    // TODO(phoglund): Need to recognize other types as well.
+    std::unique_ptr<Network> network(
+        new Network(name, name, prefix, prefix_length, adapter_type));
+    network->set_default_local_address_provider(this);
+    network->set_scope_id(scope_id);
+    network->AddIP(ip);
+    network->set_ignored(IsIgnoredNetwork(*network));
+    network->set_underlying_type_for_vpn(vpn_underlying_adapter_type);
+    if (include_ignored || !network->ignored()) {
+      (*current_networks)[key] = network.get();
+      networks->push_back(network.release());
+    }
+  } else {
+    Network* existing_network = iter->second;
+    existing_network->AddIP(ip);
+    if (adapter_type != ADAPTER_TYPE_UNKNOWN) {
+      existing_network->set_type(adapter_type);
+      existing_network->set_underlying_type_for_vpn(
+          vpn_underlying_adapter_type);
+    }
+  }
+}
+
 #if defined(__native_client__)
 
 bool BasicNetworkManager::CreateNetworks(bool include_ignored,
@@ -502,7 +588,6 @@ void BasicNetworkManager::ConvertIfAddrs(struct ifaddrs* interfaces,
 
   for (struct ifaddrs* cursor = interfaces; cursor != nullptr;
        cursor = cursor->ifa_next) {
-    IPAddress prefix;
     IPAddress mask;
     InterfaceAddress ip;
     int scope_id = 0;
@@ -534,53 +619,11 @@ void BasicNetworkManager::ConvertIfAddrs(struct ifaddrs* interfaces,
           reinterpret_cast<sockaddr_in6*>(cursor->ifa_addr)->sin6_scope_id;
     }
 
-    AdapterType adapter_type = ADAPTER_TYPE_UNKNOWN;
-    AdapterType vpn_underlying_adapter_type = ADAPTER_TYPE_UNKNOWN;
-    if (cursor->ifa_flags & IFF_LOOPBACK) {
-      adapter_type = ADAPTER_TYPE_LOOPBACK;
-    } else {
-      // If there is a network_monitor, use it to get the adapter type.
-      // Otherwise, get the adapter type based on a few name matching rules.
-      if (network_monitor_) {
-        adapter_type = network_monitor_->GetAdapterType(cursor->ifa_name);
-      }
-      if (adapter_type == ADAPTER_TYPE_UNKNOWN) {
-        adapter_type = GetAdapterTypeFromName(cursor->ifa_name);
-      }
-    }
-
-    if (adapter_type == ADAPTER_TYPE_VPN && network_monitor_) {
-      vpn_underlying_adapter_type =
-          network_monitor_->GetVpnUnderlyingAdapterType(cursor->ifa_name);
-    }
     int prefix_length = CountIPMaskBits(mask);
-    prefix = TruncateIP(ip, prefix_length);
-    std::string key =
-        MakeNetworkKey(std::string(cursor->ifa_name), prefix, prefix_length);
-    auto iter = current_networks.find(key);
-    if (iter == current_networks.end()) {
-      // TODO(phoglund): Need to recognize other types as well.
-      std::unique_ptr<Network> network(
-          new Network(cursor->ifa_name, cursor->ifa_name, prefix, prefix_length,
-                      adapter_type));
-      network->set_default_local_address_provider(this);
-      network->set_scope_id(scope_id);
-      network->AddIP(ip);
-      network->set_ignored(IsIgnoredNetwork(*network));
-      network->set_underlying_type_for_vpn(vpn_underlying_adapter_type);
-      if (include_ignored || !network->ignored()) {
-        current_networks[key] = network.get();
-        networks->push_back(network.release());
-      }
-    } else {
-      Network* existing_network = iter->second;
-      existing_network->AddIP(ip);
-      if (adapter_type != ADAPTER_TYPE_UNKNOWN) {
-        existing_network->set_type(adapter_type);
-        existing_network->set_underlying_type_for_vpn(
-            vpn_underlying_adapter_type);
-      }
-    }
+    AddInterfaceAddress(cursor->ifa_name,
+                        (cursor->ifa_flags & IFF_LOOPBACK) != 0, ip,
+                        prefix_length, scope_id, include_ignored,
+                        &current_networks, networks);
   }
 }
 
@@ -858,6 +901,8 @@ void BasicNetworkManager::StopUpdating() {
   if (!start_count_) {
     thread_->Clear(this);
     sent_first_update_ = false;
+    updated_from_network_monitor_ = false;
+    update_scheduled_ = false;
     StopNetworkMonitor();
   }
 }
@@ -933,7 +978,29 @@ void BasicNetworkManager::UpdateNetworksOnce() {
   RTC_DCHECK(Thread::Current() == thread_);
 
   NetworkList list;
-  if (!CreateNetworks(false, &list)) {
+  std::vector<NetworkInterfaceInfo> changes;
+  bool keep_unchanged = updated_from_network_monitor_;
+  // The changes are picked up even when they are not used, since the monitor
+  // does not signal again until they are. Whether an interface is on a
+  // default route can change without any change to its addresses, so that
+  // still requires polling.
+  bool has_changes =
+      network_monitor_ && network_monitor_->GetInterfaceChanges(&changes);
+  updated_from_network_monitor_ = has_changes && !ignore_non_default_routes_;
+  bool created = true;
+  if (updated_from_network_monitor_) {
+    // The first changes after the monitor started include all the interfaces.
+    CreateNetworksFromInterfaceChanges(changes, keep_unchanged, &list);
+  } else {
+    created = CreateNetworks(false, &list);
+  }
+  if (!updated_from_network_monitor_ && !update_scheduled_) {
+    thread_->PostDelayed(RTC_FROM_HERE, kNetworksUpdateIntervalMs, this,
+                         kUpdateNetworksMessage);
+    update_scheduled_ = true;
+  }
+
+  if (!created) {
     SignalError();
   } else {
     bool changed;
@@ -949,9 +1016,8 @@ void BasicNetworkManager::UpdateNetworksOnce() {
 }
 
 void BasicNetworkManager::UpdateNetworksContinually() {
+  update_scheduled_ = false;
   UpdateNetworksOnce();
-  thread_->PostDelayed(RTC_FROM_HERE, kNetworksUpdateIntervalMs, this,
-                       kUpdateNetworksMessage);
 }
 
 void BasicNetworkManager::DumpNetworks() {
@@ -258,6 +258,27 @@ class RTC_EXPORT BasicNetworkManager : public NetworkManagerBase,
   // Creates a network object for each network available on the machine.
   bool CreateNetworks(bool include_ignored, NetworkList* networks) const;
 
+  // Creates the networks of the interfaces in |changes|, as reported by
+  // NetworkMonitorInterface::GetInterfaceChanges(). If |keep_unchanged|, the
+  // current networks of the other interfaces are added to |networks| too, as
+  // they are.
+  void CreateNetworksFromInterfaceChanges(
+      const std::vector<NetworkInterfaceInfo>& changes,
+      bool keep_unchanged,
+      NetworkList* networks) const;
+
+  // Adds |ip| of the interface |name| to the network of its prefix in
+  // |current_networks|, creating the network, and adding it to |networks|, if
+  // there is none. Used by the ways of creating the networks above.
+  void AddInterfaceAddress(const std::string& name,
+                           bool loopback,
+                           const InterfaceAddress& ip,
+                           int prefix_length,
+                           int scope_id,
+                           bool include_ignored,
+                           NetworkMap* current_networks,
+                           NetworkList* networks) const;
+
   // Determines if a network should be ignored. This should only be determined
   // based on the network's property instead of any individual IP.
   bool IsIgnoredNetwork(const Network& network) const;
@@ -277,14 +298,20 @@ class RTC_EXPORT BasicNetworkManager : public NetworkManagerBase,
   // Called when it receives updates from the network monitor.
   void OnNetworksChanged();
 
-  // Updates the networks and reschedules the next update.
+  // Updates the networks and reschedules the next update, unless the network
+  // monitor reports the changes of the interfaces.
   void UpdateNetworksContinually();
-  // Only updates the networks; does not reschedule the next update.
+  // Only updates the networks; schedules the next update only if the
+  // networks are polled and none is scheduled yet.
   void UpdateNetworksOnce();
 
   Thread* thread_;
   bool sent_first_update_;
   int start_count_;
+  // Whether the networks were last updated from the changes reported by the
+  // network monitor, which makes polling unnecessary.
+  bool updated_from_network_monitor_ = false;
+  bool update_scheduled_ = false;
   std::vector<std::string> network_ignore_list_;
   bool ignore_non_default_routes_;
   std::unique_ptr<NetworkMonitorInterface> network_monitor_;
@@ -26,10 +26,20 @@ rtc::NetworkMonitorFactory* network_monitor_factory = nullptr;
 }  // namespace
 
 namespace rtc {
+NetworkInterfaceInfo::NetworkInterfaceInfo() = default;
+NetworkInterfaceInfo::NetworkInterfaceInfo(const NetworkInterfaceInfo&) =
+    default;
+NetworkInterfaceInfo::~NetworkInterfaceInfo() = default;
+
 NetworkMonitorInterface::NetworkMonitorInterface() {}
 
 NetworkMonitorInterface::~NetworkMonitorInterface() {}
 
+bool NetworkMonitorInterface::GetInterfaceChanges(
+    std::vector<NetworkInterfaceInfo>* interfaces) {
+  return false;
+}
+
 NetworkMonitorBase::NetworkMonitorBase() : worker_thread_(Thread::Current()) {}
 NetworkMonitorBase::~NetworkMonitorBase() {}
 
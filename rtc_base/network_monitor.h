@@ -11,14 +11,16 @@
 #ifndef RTC_BASE_NETWORK_MONITOR_H_
 #define RTC_BASE_NETWORK_MONITOR_H_
 
+#include <string>
+#include <vector>
+
+#include "rtc_base/ip_address.h"
 #include "rtc_base/network_constants.h"
 #include "rtc_base/third_party/sigslot/sigslot.h"
 #include "rtc_base/thread.h"
 
 namespace rtc {
 
-class IPAddress;
-
 enum class NetworkBindingResult {
   SUCCESS = 0,   // No error
   FAILURE = -1,  // Generic error
@@ -39,6 +41,25 @@ class NetworkBinderInterface {
   virtual ~NetworkBinderInterface() {}
 };
 
+// A network interface and its addresses, as reported by the network monitors
+// that track them. See NetworkMonitorInterface::GetInterfaceChanges().
+struct NetworkInterfaceInfo {
+  struct Address {
+    // Carries the IPv6 address flags.
+    InterfaceAddress ip;
+    int prefix_length = 0;
+  };
+
+  NetworkInterfaceInfo();
+  NetworkInterfaceInfo(const NetworkInterfaceInfo&);
+  ~NetworkInterfaceInfo();
+
+  std::string name;
+  bool running = false;
+  bool loopback = false;
+  std::vector<Address> addresses;
+};
+
 /*
  * Receives network-change events via |OnNetworksChanged| and signals the
  * networks changed event.
@@ -75,6 +96,15 @@ class NetworkMonitorInterface {
   virtual AdapterType GetAdapterType(const std::string& interface_name) = 0;
   virtual AdapterType GetVpnUnderlyingAdapterType(
       const std::string& interface_name) = 0;
+
+  // Monitors that keep track of the interfaces and their addresses return
+  // true and set |interfaces| to the interfaces that changed since the
+  // previous call, or to all of them on the first call after Start(). An
+  // interface that is gone is reported without addresses. The network manager
+  // then only rebuilds the networks of these interfaces, and does not poll
+  // the interfaces. Called on the thread that started the monitor.
+  virtual bool GetInterfaceChanges(
+      std::vector<NetworkInterfaceInfo>* interfaces);
 };
 
 class NetworkMonitorBase : public NetworkMonitorInterface,
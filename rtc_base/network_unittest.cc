@@ -13,6 +13,7 @@
 #include <stdlib.h>
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "rtc_base/checks.h"
@@ -55,9 +56,25 @@ class FakeNetworkMonitor : public NetworkMonitorBase {
     }
     return ADAPTER_TYPE_UNKNOWN;
   }
+  bool GetInterfaceChanges(
+      std::vector<NetworkInterfaceInfo>* interfaces) override {
+    if (!tracking_interfaces_)
+      return false;
+    interfaces->swap(interface_changes_);
+    interface_changes_.clear();
+    return true;
+  }
+  // Makes the network manager take the interfaces from the monitor.
+  void set_interface_changes(std::vector<NetworkInterfaceInfo> changes) {
+    tracking_interfaces_ = true;
+    interface_changes_ = std::move(changes);
+  }
+  bool has_interface_changes() const { return !interface_changes_.empty(); }
 
  private:
   bool started_ = false;
+  bool tracking_interfaces_ = false;
+  std::vector<NetworkInterfaceInfo> interface_changes_;
 };
 
 class FakeNetworkMonitorFactory : public NetworkMonitorFactory {
@@ -114,6 +131,9 @@ class NetworkTest : public ::testing::Test, public sigslot::has_slots<> {
     return static_cast<FakeNetworkMonitor*>(
         network_manager.network_monitor_.get());
   }
+  bool IsUpdateScheduled(const BasicNetworkManager& network_manager) {
+    return network_manager.update_scheduled_;
+  }
   void ClearNetworks(BasicNetworkManager& network_manager) {
     for (const auto& kv : network_manager.networks_map_) {
       delete kv.second;
@@ -1091,6 +1111,78 @@ TEST_F(NetworkTest, TestNetworkMonitoring) {
   NetworkMonitorFactory::ReleaseFactory(factory);
 }
 
+TEST_F(NetworkTest, TestNetworkMonitorInterfaceChanges) {
+  BasicNetworkManager manager;
+  manager.SignalNetworksChanged.connect(static_cast<NetworkTest*>(this),
+                                        &NetworkTest::OnNetworksChanged);
+  FakeNetworkMonitorFactory* factory = new FakeNetworkMonitorFactory();
+  NetworkMonitorFactory::SetFactory(factory);
+  manager.StartUpdating();
+  FakeNetworkMonitor* network_monitor = GetNetworkMonitor(manager);
+  ASSERT_TRUE(network_monitor);
+
+  NetworkInterfaceInfo eth0;
+  eth0.name = "eth0";
+  eth0.running = true;
+  eth0.addresses.resize(1);
+  eth0.addresses[0].ip = InterfaceAddress(IPAddress(0xC0A80105));
+  eth0.addresses[0].prefix_length = 24;
+  NetworkInterfaceInfo eth1 = eth0;
+  eth1.name = "eth1";
+  eth1.addresses[0].ip = InterfaceAddress(IPAddress(0x0A000002));
+  eth1.addresses[0].prefix_length = 8;
+  network_monitor->set_interface_changes({eth0, eth1});
+  EXPECT_TRUE_WAIT(callback_called_, 1000);
+  callback_called_ = false;
+  // The interfaces are not polled while the monitor tracks them.
+  EXPECT_FALSE(IsUpdateScheduled(manager));
+
+  NetworkManager::NetworkList list;
+  manager.GetNetworks(&list);
+  ASSERT_EQ(2u, list.size());
+  Network* eth0_network = list[0]->name() == "eth0" ? list[0] : list[1];
+  EXPECT_EQ(IPAddress(0xC0A80100), eth0_network->prefix());
+
+  // Only eth1 changed; its network goes away with its address, and the one
+  // of eth0 is kept as it is.
+  eth1.addresses.clear();
+  network_monitor->set_interface_changes({eth1});
+  network_monitor->OnNetworksChanged();
+  EXPECT_TRUE_WAIT(callback_called_, 1000);
+  list.clear();
+  manager.GetNetworks(&list);
+  ASSERT_EQ(1u, list.size());
+  EXPECT_EQ(eth0_network, list[0]);
+  EXPECT_EQ(1u, eth0_network->GetIPs().size());
+  EXPECT_FALSE(IsUpdateScheduled(manager));
+
+  manager.StopUpdating();
+  NetworkMonitorFactory::ReleaseFactory(factory);
+}
+
+// With non-default routes ignored, the interfaces are polled, but the changes
+// of the monitor are still picked up so that it keeps signaling new ones.
+TEST_F(NetworkTest, TestNetworkMonitorInterfaceChangesIgnored) {
+  BasicNetworkManager manager;
+  manager.set_ignore_non_default_routes(true);
+  FakeNetworkMonitorFactory* factory = new FakeNetworkMonitorFactory();
+  NetworkMonitorFactory::SetFactory(factory);
+  manager.StartUpdating();
+  FakeNetworkMonitor* network_monitor = GetNetworkMonitor(manager);
+  ASSERT_TRUE(network_monitor);
+
+  NetworkInterfaceInfo eth0;
+  eth0.name = "eth0";
+  eth0.running = true;
+  network_monitor->set_interface_changes({eth0});
+  network_monitor->OnNetworksChanged();
+  EXPECT_TRUE_WAIT(!network_monitor->has_interface_changes(), 1000);
+  EXPECT_TRUE(IsUpdateScheduled(manager));
+
+  manager.StopUpdating();
+  NetworkMonitorFactory::ReleaseFactory(factory);
+}
+
 // Fails on Android: https://bugs.chromium.org/p/webrtc/issues/detail?id=4364.
 #if defined(WEBRTC_ANDROID)
 #define MAYBE_DefaultLocalAddress DISABLED_DefaultLocalAddress
@@ -55,6 +55,14 @@ size_t OpenSSLDigest::Finish(void* buf, size_t len) {
   return md_len;
 }
 
+void OpenSSLDigest::CopyFrom(const OpenSSLDigest& other) {
+  RTC_DCHECK(md_ == other.md_);
+  if (!md_) {
+    return;
+  }
+  EVP_MD_CTX_copy_ex(ctx_, other.ctx_);
+}
+
 bool OpenSSLDigest::GetDigestEVP(const std::string& algorithm,
                                  const EVP_MD** mdp) {
   const EVP_MD* md;
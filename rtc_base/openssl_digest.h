@@ -32,6 +32,8 @@ class OpenSSLDigest final : public MessageDigest {
   void Update(const void* buf, size_t len) override;
   // Outputs the digest value to |buf| with length |len|.
   size_t Finish(void* buf, size_t len) override;
+  // Continues from the state of |other|, which must use the same algorithm.
+  void CopyFrom(const OpenSSLDigest& other);
 
   // Helper function to look up a digest's EVP by name.
   static bool GetDigestEVP(const std::string& algorithm, const EVP_MD** md);
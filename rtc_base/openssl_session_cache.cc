@@ -10,11 +10,46 @@
 
 #include "rtc_base/openssl_session_cache.h"
 
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <string.h>
+
 #include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/openssl.h"
+#include "rtc_base/time_utils.h"
 
 namespace rtc {
 
+namespace {
+
+// Index of the SSL_CTX ex_data that points at the OpenSSLDtlsSessionCache
+// whose ticket keys the context uses.
+int GetDtlsSessionCacheIndex() {
+  static const int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+int TicketKeyCallback(SSL* ssl,
+                      uint8_t* key_name,
+                      uint8_t* iv,
+                      EVP_CIPHER_CTX* cipher_ctx,
+                      HMAC_CTX* hmac_ctx,
+                      int encrypt) {
+  auto* cache = static_cast<OpenSSLDtlsSessionCache*>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), GetDtlsSessionCacheIndex()));
+  if (!cache) {
+    return -1;
+  }
+  return cache->SetupTicketCipher(key_name, iv, cipher_ctx, hmac_ctx,
+                                  encrypt != 0);
+}
+
+}  // namespace
+
 OpenSSLSessionCache::OpenSSLSessionCache(SSLMode ssl_mode, SSL_CTX* ssl_ctx)
     : ssl_mode_(ssl_mode), ssl_ctx_(ssl_ctx) {
   // It is invalid to pass in a null context.
@@ -50,4 +85,134 @@ SSLMode OpenSSLSessionCache::GetSSLMode() const {
   return ssl_mode_;
 }
 
+constexpr int64_t OpenSSLDtlsSessionCache::kTicketKeyLifetimeMs;
+constexpr size_t OpenSSLDtlsSessionCache::kTicketKeyNameSize;
+
+OpenSSLDtlsSessionCache::OpenSSLDtlsSessionCache(size_t max_sessions)
+    : max_sessions_(max_sessions) {
+  RTC_DCHECK_GT(max_sessions, 0);
+  RTC_CHECK_EQ(RAND_bytes(reinterpret_cast<uint8_t*>(&current_ticket_key_),
+                          sizeof(current_ticket_key_)),
+               1);
+  current_ticket_key_.created_ms = TimeMillis();
+}
+
+OpenSSLDtlsSessionCache::~OpenSSLDtlsSessionCache() {
+  for (const auto& it : sessions_) {
+    SSL_SESSION_free(it.second);
+  }
+  OPENSSL_cleanse(&current_ticket_key_, sizeof(current_ticket_key_));
+  OPENSSL_cleanse(&previous_ticket_key_, sizeof(previous_ticket_key_));
+}
+
+SSL_SESSION* OpenSSLDtlsSessionCache::LookupSession(const std::string& key) {
+  CritScope lock(&crit_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  sessions_.splice(sessions_.begin(), sessions_, it->second);
+  SSL_SESSION* session = it->second->second;
+  SSL_SESSION_up_ref(session);
+  return session;
+}
+
+void OpenSSLDtlsSessionCache::AddSession(const std::string& key,
+                                         SSL_SESSION* session) {
+  CritScope lock(&crit_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    SSL_SESSION_free(it->second->second);
+    sessions_.erase(it->second);
+    index_.erase(it);
+  }
+  sessions_.emplace_front(key, session);
+  index_[key] = sessions_.begin();
+  if (sessions_.size() > max_sessions_) {
+    SSL_SESSION_free(sessions_.back().second);
+    index_.erase(sessions_.back().first);
+    sessions_.pop_back();
+  }
+}
+
+void OpenSSLDtlsSessionCache::RemoveSession(const std::string& key) {
+  CritScope lock(&crit_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+  SSL_SESSION_free(it->second->second);
+  sessions_.erase(it->second);
+  index_.erase(it);
+}
+
+size_t OpenSSLDtlsSessionCache::size() const {
+  CritScope lock(&crit_);
+  return sessions_.size();
+}
+
+bool OpenSSLDtlsSessionCache::ConfigureTicketKeys(SSL_CTX* ctx) {
+  if (!SSL_CTX_set_ex_data(ctx, GetDtlsSessionCacheIndex(), this)) {
+    RTC_LOG(LS_WARNING) << "Failed to attach the DTLS session cache.";
+    return false;
+  }
+  return SSL_CTX_set_tlsext_ticket_key_cb(ctx, &TicketKeyCallback) == 1;
+}
+
+int OpenSSLDtlsSessionCache::SetupTicketCipher(uint8_t* key_name,
+                                               uint8_t* iv,
+                                               EVP_CIPHER_CTX* cipher_ctx,
+                                               HMAC_CTX* hmac_ctx,
+                                               bool encrypt) {
+  CritScope lock(&crit_);
+  MaybeRotateTicketKeys();
+  const TicketKey* key = &current_ticket_key_;
+  int result = 1;
+  if (encrypt) {
+    if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_128_cbc())) != 1) {
+      return -1;
+    }
+    memcpy(key_name, key->name, kTicketKeyNameSize);
+  } else if (memcmp(key_name, key->name, kTicketKeyNameSize) != 0) {
+    if (!has_previous_ticket_key_ ||
+        memcmp(key_name, previous_ticket_key_.name, kTicketKeyNameSize) !=
+            0) {
+      return 0;
+    }
+    // Ask for a new ticket under the current key.
+    key = &previous_ticket_key_;
+    result = 2;
+  }
+  if (!HMAC_Init_ex(hmac_ctx, key->hmac_key, sizeof(key->hmac_key),
+                    EVP_sha256(), nullptr)) {
+    return -1;
+  }
+  int cipher_ok =
+      encrypt ? EVP_EncryptInit_ex(cipher_ctx, EVP_aes_128_cbc(), nullptr,
+                                   key->aes_key, iv)
+              : EVP_DecryptInit_ex(cipher_ctx, EVP_aes_128_cbc(), nullptr,
+                                   key->aes_key, iv);
+  return cipher_ok ? result : -1;
+}
+
+void OpenSSLDtlsSessionCache::MaybeRotateTicketKeys() {
+  const int64_t now = TimeMillis();
+  const int64_t age = now - current_ticket_key_.created_ms;
+  if (age < kTicketKeyLifetimeMs) {
+    return;
+  }
+  // Tickets of the current key stay valid for one more interval, unless it
+  // was not rotated in time and that interval has already passed too.
+  has_previous_ticket_key_ = age < 2 * kTicketKeyLifetimeMs;
+  if (has_previous_ticket_key_) {
+    previous_ticket_key_ = current_ticket_key_;
+  } else {
+    OPENSSL_cleanse(&previous_ticket_key_, sizeof(previous_ticket_key_));
+  }
+  RTC_CHECK_EQ(RAND_bytes(reinterpret_cast<uint8_t*>(&current_ticket_key_),
+                          sizeof(current_ticket_key_)),
+               1);
+  current_ticket_key_.created_ms = now;
+}
+
 }  // namespace rtc
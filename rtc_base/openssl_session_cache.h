@@ -13,10 +13,16 @@
 
 #include <openssl/ossl_typ.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
 #include <map>
 #include <string>
+#include <utility>
 
 #include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
 #include "rtc_base/ssl_stream_adapter.h"
 
 #ifndef OPENSSL_IS_BORINGSSL
@@ -63,6 +69,79 @@ class OpenSSLSessionCache final {
   RTC_DISALLOW_COPY_AND_ASSIGN(OpenSSLSessionCache);
 };
 
+// The OpenSSLDtlsSessionCache holds the sessions of DTLS associations that
+// OpenSSLStreamAdapters have completed, so that a later association with the
+// same peer can resume one with an abbreviated handshake. Sessions are keyed
+// by the caller, normally with the certificate fingerprints of both ends, and
+// the least recently used session is evicted once |max_sessions| are held.
+// It also holds the keys that the server side uses to encrypt its session
+// tickets, so that all adapters sharing the cache accept each other's
+// tickets. The key is replaced every kTicketKeyLifetimeMs, and the previous
+// one is kept for one more interval to decrypt the tickets it issued, so that
+// no ticket is accepted for more than twice that. Thread safe.
+class OpenSSLDtlsSessionCache final {
+ public:
+  static constexpr int64_t kTicketKeyLifetimeMs = 60 * 60 * 1000;
+  // Length of the key names that identify the key of a ticket.
+  static constexpr size_t kTicketKeyNameSize = 16;
+
+  explicit OpenSSLDtlsSessionCache(size_t max_sessions);
+  // Frees the cached SSL_SESSIONs.
+  ~OpenSSLDtlsSessionCache();
+
+  // Looks up a session by key, and marks it as the most recently used. The
+  // returned SSL_SESSION is up_refed; the caller must free it.
+  SSL_SESSION* LookupSession(const std::string& key);
+  // Adds a session to the cache, taking over the reference of the caller. Any
+  // existing session with the same key is replaced.
+  void AddSession(const std::string& key, SSL_SESSION* session);
+  // Drops the session of |key|, if any, e.g. after it failed to resume.
+  void RemoveSession(const std::string& key);
+  size_t size() const;
+
+  // Configures |ctx| to issue and accept session tickets encrypted with the
+  // keys of this cache, which must outlive it. Returns false on failure.
+  bool ConfigureTicketKeys(SSL_CTX* ctx);
+
+  // Sets up |cipher_ctx| and |hmac_ctx| for a session ticket, as the callback
+  // of SSL_CTX_set_tlsext_ticket_key_cb(). When |encrypt| is true, the current
+  // key is used and its name and a new IV are written to |key_name| and |iv|.
+  // Otherwise the key named |key_name| is looked up; returns 1 if it is the
+  // current key, 2 if it is the previous one and the ticket should be renewed,
+  // and 0 if the ticket is too old to be accepted.
+  int SetupTicketCipher(uint8_t* key_name,
+                        uint8_t* iv,
+                        EVP_CIPHER_CTX* cipher_ctx,
+                        HMAC_CTX* hmac_ctx,
+                        bool encrypt);
+
+ private:
+  using SessionList = std::list<std::pair<std::string, SSL_SESSION*>>;
+
+  struct TicketKey {
+    uint8_t name[kTicketKeyNameSize];
+    uint8_t aes_key[16];
+    uint8_t hmac_key[32];
+    int64_t created_ms;
+  };
+
+  // Replaces the current ticket key once it is older than
+  // kTicketKeyLifetimeMs, and drops the previous one.
+  void MaybeRotateTicketKeys() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  const size_t max_sessions_;
+  CriticalSection crit_;
+  TicketKey current_ticket_key_ RTC_GUARDED_BY(crit_);
+  // Only used to decrypt tickets; cleared once it is too old for that.
+  TicketKey previous_ticket_key_ RTC_GUARDED_BY(crit_);
+  bool has_previous_ticket_key_ RTC_GUARDED_BY(crit_) = false;
+  // Most recently used session first.
+  SessionList sessions_ RTC_GUARDED_BY(crit_);
+  std::map<std::string, SessionList::iterator> index_ RTC_GUARDED_BY(crit_);
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(OpenSSLDtlsSessionCache);
+};
+
 }  // namespace rtc
 
 #endif  // RTC_BASE_OPENSSL_SESSION_CACHE_H_
@@ -10,12 +10,17 @@
 
 #include "rtc_base/openssl_session_cache.h"
 
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/ssl.h>
 #include <stdlib.h>
 
 #include <map>
 #include <memory>
+#include <vector>
 
+#include "api/units/time_delta.h"
+#include "rtc_base/fake_clock.h"
 #include "rtc_base/gunit.h"
 #include "rtc_base/openssl.h"
 
@@ -83,4 +88,122 @@ TEST(OpenSSLSessionCache, AddToExistingReplacesPrevious) {
   SSL_CTX_free(ssl_ctx);
 }
 
+TEST(OpenSSLDtlsSessionCache, LookupReturnsReferencedSession) {
+  SSL_CTX* ssl_ctx = SSL_CTX_new(DTLSv1_2_client_method());
+  SSL_SESSION* ssl_session = SSL_SESSION_new(ssl_ctx);
+
+  OpenSSLDtlsSessionCache session_cache(4);
+  EXPECT_EQ(session_cache.LookupSession("peer"), nullptr);
+  session_cache.AddSession("peer", ssl_session);
+  SSL_SESSION* found = session_cache.LookupSession("peer");
+  EXPECT_EQ(found, ssl_session);
+  SSL_SESSION_free(found);
+  EXPECT_EQ(session_cache.size(), 1u);
+
+  SSL_CTX_free(ssl_ctx);
+}
+
+TEST(OpenSSLDtlsSessionCache, EvictsLeastRecentlyUsedSession) {
+  SSL_CTX* ssl_ctx = SSL_CTX_new(DTLSv1_2_client_method());
+
+  OpenSSLDtlsSessionCache session_cache(2);
+  session_cache.AddSession("a", SSL_SESSION_new(ssl_ctx));
+  session_cache.AddSession("b", SSL_SESSION_new(ssl_ctx));
+  // Makes "a" the most recently used session.
+  SSL_SESSION_free(session_cache.LookupSession("a"));
+  session_cache.AddSession("c", SSL_SESSION_new(ssl_ctx));
+  EXPECT_EQ(session_cache.size(), 2u);
+  EXPECT_EQ(session_cache.LookupSession("b"), nullptr);
+  SSL_SESSION* found = session_cache.LookupSession("a");
+  EXPECT_NE(found, nullptr);
+  SSL_SESSION_free(found);
+
+  session_cache.RemoveSession("a");
+  EXPECT_EQ(session_cache.LookupSession("a"), nullptr);
+  EXPECT_EQ(session_cache.size(), 1u);
+
+  SSL_CTX_free(ssl_ctx);
+}
+
+TEST(OpenSSLDtlsSessionCache, ConfiguresContexts) {
+  SSL_CTX* ssl_ctx_1 = SSL_CTX_new(DTLS_method());
+  SSL_CTX* ssl_ctx_2 = SSL_CTX_new(DTLS_method());
+
+  OpenSSLDtlsSessionCache session_cache(1);
+  EXPECT_TRUE(session_cache.ConfigureTicketKeys(ssl_ctx_1));
+  EXPECT_TRUE(session_cache.ConfigureTicketKeys(ssl_ctx_2));
+
+  SSL_CTX_free(ssl_ctx_1);
+  SSL_CTX_free(ssl_ctx_2);
+}
+
+// Sets up the ciphers of a session ticket like the ticket key callback, and
+// returns its result. Issues a new ticket when |encrypt| is true, writing the
+// name of its key to |key_name|.
+int SetupTicketCipher(OpenSSLDtlsSessionCache* session_cache,
+                      std::vector<uint8_t>* key_name,
+                      bool encrypt) {
+  uint8_t iv[EVP_MAX_IV_LENGTH] = {0};
+  EVP_CIPHER_CTX* cipher_ctx = EVP_CIPHER_CTX_new();
+  HMAC_CTX* hmac_ctx = HMAC_CTX_new();
+  key_name->resize(OpenSSLDtlsSessionCache::kTicketKeyNameSize);
+  int result = session_cache->SetupTicketCipher(key_name->data(), iv,
+                                                cipher_ctx, hmac_ctx, encrypt);
+  HMAC_CTX_free(hmac_ctx);
+  EVP_CIPHER_CTX_free(cipher_ctx);
+  return result;
+}
+
+TEST(OpenSSLDtlsSessionCache, RenewsTicketsOfPreviousKey) {
+  ScopedFakeClock clock;
+  OpenSSLDtlsSessionCache session_cache(1);
+  std::vector<uint8_t> key_name;
+  ASSERT_EQ(1, SetupTicketCipher(&session_cache, &key_name, true));
+  std::vector<uint8_t> ticket_key_name = key_name;
+  EXPECT_EQ(1, SetupTicketCipher(&session_cache, &key_name, false));
+
+  clock.AdvanceTime(webrtc::TimeDelta::ms(
+      OpenSSLDtlsSessionCache::kTicketKeyLifetimeMs));
+  EXPECT_EQ(2, SetupTicketCipher(&session_cache, &key_name, false));
+  ASSERT_EQ(1, SetupTicketCipher(&session_cache, &key_name, true));
+  EXPECT_NE(ticket_key_name, key_name);
+}
+
+TEST(OpenSSLDtlsSessionCache, RejectsTicketsOlderThanRotationWindow) {
+  ScopedFakeClock clock;
+  OpenSSLDtlsSessionCache session_cache(1);
+  std::vector<uint8_t> key_name;
+  ASSERT_EQ(1, SetupTicketCipher(&session_cache, &key_name, true));
+  std::vector<uint8_t> old_key_name = key_name;
+
+  // A ticket issued just before the first rotation is still accepted one
+  // interval later, but not after the second rotation.
+  clock.AdvanceTime(webrtc::TimeDelta::ms(
+      OpenSSLDtlsSessionCache::kTicketKeyLifetimeMs - 1));
+  ASSERT_EQ(1, SetupTicketCipher(&session_cache, &key_name, true));
+  std::vector<uint8_t> newer_key_name = key_name;
+  clock.AdvanceTime(webrtc::TimeDelta::ms(1));
+  key_name = old_key_name;
+  EXPECT_EQ(2, SetupTicketCipher(&session_cache, &key_name, false));
+
+  clock.AdvanceTime(webrtc::TimeDelta::ms(
+      OpenSSLDtlsSessionCache::kTicketKeyLifetimeMs));
+  key_name = old_key_name;
+  EXPECT_EQ(0, SetupTicketCipher(&session_cache, &key_name, false));
+  key_name = newer_key_name;
+  EXPECT_EQ(0, SetupTicketCipher(&session_cache, &key_name, false));
+}
+
+TEST(OpenSSLDtlsSessionCache, RejectsTicketsAfterIdleRotationWindows) {
+  ScopedFakeClock clock;
+  OpenSSLDtlsSessionCache session_cache(1);
+  std::vector<uint8_t> key_name;
+  ASSERT_EQ(1, SetupTicketCipher(&session_cache, &key_name, true));
+
+  // No ticket was issued in between to rotate the key.
+  clock.AdvanceTime(webrtc::TimeDelta::ms(
+      2 * OpenSSLDtlsSessionCache::kTicketKeyLifetimeMs));
+  EXPECT_EQ(0, SetupTicketCipher(&session_cache, &key_name, false));
+}
+
 }  // namespace rtc
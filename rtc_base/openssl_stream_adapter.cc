@@ -26,14 +26,17 @@
 #include <vector>
 
 #include "rtc_base/checks.h"
+#include "rtc_base/cpu_time.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/openssl.h"
 #include "rtc_base/openssl_adapter.h"
 #include "rtc_base/openssl_digest.h"
 #include "rtc_base/openssl_identity.h"
+#include "rtc_base/openssl_session_cache.h"
 #include "rtc_base/ssl_certificate.h"
 #include "rtc_base/stream.h"
+#include "rtc_base/string_encode.h"
 #include "rtc_base/thread.h"
 #include "rtc_base/time_utils.h"
 
@@ -145,6 +148,19 @@ void TimeCallbackForTesting(const SSL* ssl, struct timeval* out_clock) {
 }
 #endif
 
+// Bounds the number of peers whose sessions are kept for resumption.
+constexpr size_t kMaxDtlsSessions = 256;
+
+// Ties the sessions to WebRTC, so that they are not resumed by other users of
+// the SSL library.
+constexpr unsigned char kDtlsSessionIdContext[] = "WebRTC DTLS";
+
+OpenSSLDtlsSessionCache* GetDtlsSessionCache() {
+  static OpenSSLDtlsSessionCache* const cache =
+      new OpenSSLDtlsSessionCache(kMaxDtlsSessions);
+  return cache;
+}
+
 }  // namespace
 
 //////////////////////////////////////////////////////////////////////
@@ -332,6 +348,7 @@ bool OpenSSLStreamAdapter::SetPeerCertificateDigest(
   }
 
   if (state_ == SSL_CONNECTED) {
+    MaybeCacheSession();
     // Post the event asynchronously to unwind the stack. The caller
     // of ContinueSSL may be the same object listening for these
     // events and may not be prepared for reentrancy.
@@ -465,6 +482,14 @@ bool OpenSSLStreamAdapter::GetDtlsSrtpCryptoSuite(int* crypto_suite) {
   return true;
 }
 
+bool OpenSSLStreamAdapter::GetHandshakeStats(SSLHandshakeStats* stats) const {
+  if (!handshake_completed_) {
+    return false;
+  }
+  *stats = handshake_stats_;
+  return true;
+}
+
 bool OpenSSLStreamAdapter::IsTlsConnected() {
   return state_ == SSL_CONNECTED;
 }
@@ -504,6 +529,11 @@ void OpenSSLStreamAdapter::SetInitialRetransmissionTimeout(int timeout_ms) {
   dtls_handshake_timeout_ms_ = timeout_ms;
 }
 
+void OpenSSLStreamAdapter::EnableSessionResumption() {
+  RTC_DCHECK(ssl_ctx_ == nullptr);
+  session_resumption_enabled_ = true;
+}
+
 //
 // StreamInterface Implementation
 //
@@ -774,6 +804,7 @@ int OpenSSLStreamAdapter::BeginSSL() {
   RTC_DCHECK(state_ == SSL_CONNECTING);
   // The underlying stream has opened.
   RTC_LOG(LS_INFO) << "BeginSSL with peer.";
+  handshake_start_ms_ = TimeMillis();
 
   BIO* bio = nullptr;
 
@@ -811,6 +842,16 @@ int OpenSSLStreamAdapter::BeginSSL() {
   SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE |
                          SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 
+  if (SessionResumptionEnabled() && role_ == SSL_CLIENT) {
+    std::string key = SessionCacheKey();
+    SSL_SESSION* session =
+        key.empty() ? nullptr : GetDtlsSessionCache()->LookupSession(key);
+    if (session) {
+      session_resumption_attempted_ = SSL_set_session(ssl_, session) == 1;
+      SSL_SESSION_free(session);
+    }
+  }
+
   // Do the connect
   return ContinueSSL();
 }
@@ -822,17 +863,34 @@ int OpenSSLStreamAdapter::ContinueSSL() {
   // Clear the DTLS timer
   Thread::Current()->Clear(this, MSG_TIMEOUT);
 
-  const int code = (role_ == SSL_CLIENT) ? SSL_connect(ssl_) : SSL_accept(ssl_);
+  const int code = DoHandshakeStep();
   const int ssl_error = SSL_get_error(ssl_, code);
 
   switch (ssl_error) {
     case SSL_ERROR_NONE:
       RTC_LOG(LS_VERBOSE) << " -- success";
+      handshake_completed_ = true;
+      handshake_stats_.resumed = SSL_session_reused(ssl_) != 0;
+      handshake_stats_.duration_ms = TimeMillis() - handshake_start_ms_;
+      handshake_stats_.cpu_time_us =
+          handshake_cpu_time_ns_ / kNumNanosecsPerMicrosec;
+      if (handshake_stats_.resumed) {
+        RTC_LOG(LS_INFO) << "Resumed DTLS session.";
+        SetPeerCertChainFromSession();
+        if (HasPeerCertificateDigest() && !VerifyPeerCertificate()) {
+          // The session must not be offered again.
+          GetDtlsSessionCache()->RemoveSession(SessionCacheKey());
+          return -1;
+        }
+      } else if (session_resumption_attempted_) {
+        RTC_LOG(LS_INFO) << "Peer declined to resume DTLS session.";
+      }
       // By this point, OpenSSL should have given us a certificate, or errored
       // out if one was missing.
       RTC_DCHECK(peer_cert_chain_ || !GetClientAuthEnabled());
 
       state_ = SSL_CONNECTED;
+      MaybeCacheSession();
       if (!WaitingToVerifyPeerCertificate()) {
         // We have everything we need to start the connection, so signal
         // SE_OPEN. If we need a client certificate fingerprint and don't have
@@ -871,12 +929,30 @@ int OpenSSLStreamAdapter::ContinueSSL() {
         ssl_handshake_err = SSLHandshakeError::INCOMPATIBLE_CIPHERSUITE;
       }
       SignalSSLHandshakeError(ssl_handshake_err);
+      if (session_resumption_attempted_) {
+        // Do not try the session again, in case it is what the peer rejected.
+        GetDtlsSessionCache()->RemoveSession(SessionCacheKey());
+      }
       return (ssl_error != 0) ? ssl_error : -1;
   }
 
   return 0;
 }
 
+int OpenSSLStreamAdapter::DoHandshakeStep() {
+  BIO* bio = SSL_get_wbio(ssl_);
+  const uint64_t written = BIO_number_written(bio);
+  const int64_t cpu_start_ns = GetThreadCpuTimeNanos();
+  const int code = (role_ == SSL_CLIENT) ? SSL_connect(ssl_) : SSL_accept(ssl_);
+  handshake_cpu_time_ns_ += GetThreadCpuTimeNanos() - cpu_start_ns;
+  // Each step that writes sends the next flight; retransmissions are sent
+  // from OnMessage.
+  if (BIO_number_written(bio) != written) {
+    ++handshake_stats_.flights_sent;
+  }
+  return code;
+}
+
 void OpenSSLStreamAdapter::Error(const char* context,
                                  int err,
                                  uint8_t alert,
@@ -937,7 +1013,11 @@ void OpenSSLStreamAdapter::OnMessage(Message* msg) {
   // Process our own messages and then pass others to the superclass
   if (MSG_TIMEOUT == msg->message_id) {
     RTC_LOG(LS_INFO) << "DTLS timeout expired";
-    DTLSv1_handle_timeout(ssl_);
+    const int64_t cpu_start_ns = GetThreadCpuTimeNanos();
+    if (DTLSv1_handle_timeout(ssl_) > 0) {
+      ++handshake_stats_.retransmissions;
+    }
+    handshake_cpu_time_ns_ += GetThreadCpuTimeNanos() - cpu_start_ns;
     ContinueSSL();
   } else {
     StreamInterface::OnMessage(msg);
@@ -1015,6 +1095,19 @@ SSL_CTX* OpenSSLStreamAdapter::SetupSSLContext() {
     }
   }
 
+  if (SessionResumptionEnabled()) {
+    // The server keeps no sessions of its own; it accepts the tickets that
+    // any adapter of this process has issued.
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    if (!SSL_CTX_set_session_id_context(ctx, kDtlsSessionIdContext,
+                                        sizeof(kDtlsSessionIdContext)) ||
+        (role_ == SSL_SERVER &&
+         !GetDtlsSessionCache()->ConfigureTicketKeys(ctx))) {
+      SSL_CTX_free(ctx);
+      return nullptr;
+    }
+  }
+
   return ctx;
 }
 
@@ -1050,6 +1143,57 @@ bool OpenSSLStreamAdapter::VerifyPeerCertificate() {
   return true;
 }
 
+void OpenSSLStreamAdapter::SetPeerCertChainFromSession() {
+#if defined(OPENSSL_IS_BORINGSSL)
+  STACK_OF(X509)* chain = SSL_get_peer_full_cert_chain(ssl_);
+  if (!chain) {
+    return;
+  }
+  std::vector<std::unique_ptr<SSLCertificate>> cert_chain;
+  for (X509* cert : chain) {
+    cert_chain.emplace_back(new OpenSSLCertificate(cert));
+  }
+  peer_cert_chain_.reset(new SSLCertChain(std::move(cert_chain)));
+#else
+  X509* cert = SSL_SESSION_get0_peer(SSL_get_session(ssl_));
+  if (!cert) {
+    return;
+  }
+  peer_cert_chain_.reset(
+      new SSLCertChain(std::make_unique<OpenSSLCertificate>(cert)));
+#endif
+}
+
+std::string OpenSSLStreamAdapter::SessionCacheKey() const {
+  // A session is only valid between the same two certificates, so both
+  // fingerprints are part of the key.
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  size_t digest_length;
+  if (!HasPeerCertificateDigest() || !identity_ ||
+      !identity_->certificate().ComputeDigest(DIGEST_SHA_256, digest,
+                                              sizeof(digest), &digest_length)) {
+    return std::string();
+  }
+  return peer_certificate_digest_algorithm_ + ":" +
+         hex_encode(peer_certificate_digest_value_.data<char>(),
+                    peer_certificate_digest_value_.size()) +
+         "/" + hex_encode(reinterpret_cast<const char*>(digest), digest_length);
+}
+
+void OpenSSLStreamAdapter::MaybeCacheSession() {
+  if (!SessionResumptionEnabled() || role_ != SSL_CLIENT ||
+      !peer_certificate_verified_) {
+    return;
+  }
+  std::string key = SessionCacheKey();
+  SSL_SESSION* session = SSL_get1_session(ssl_);
+  if (key.empty() || !session) {
+    SSL_SESSION_free(session);
+    return;
+  }
+  GetDtlsSessionCache()->AddSession(key, session);
+}
+
 std::unique_ptr<SSLCertChain> OpenSSLStreamAdapter::GetPeerSSLCertChain()
     const {
   return peer_cert_chain_ ? peer_cert_chain_->Clone() : nullptr;
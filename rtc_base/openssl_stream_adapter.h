@@ -79,6 +79,7 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   void SetMode(SSLMode mode) override;
   void SetMaxProtocolVersion(SSLProtocolVersion version) override;
   void SetInitialRetransmissionTimeout(int timeout_ms) override;
+  void EnableSessionResumption() override;
 
   StreamResult Read(void* data,
                     size_t data_len,
@@ -98,6 +99,8 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
 
   int GetSslVersion() const override;
 
+  bool GetHandshakeStats(SSLHandshakeStats* stats) const override;
+
   // Key Extractor interface
   bool ExportKeyingMaterial(const std::string& label,
                             const uint8_t* context,
@@ -148,6 +151,9 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   int BeginSSL();
   // Perform SSL negotiation steps.
   int ContinueSSL();
+  // Performs one step of SSL_connect() or SSL_accept() and accounts for it in
+  // |handshake_stats_|.
+  int DoHandshakeStep();
 
   // Error handler helper. signal is given as true for errors in
   // asynchronous contexts (when an error method was not returned
@@ -171,6 +177,21 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   SSL_CTX* SetupSSLContext();
   // Verify the peer certificate matches the signaled digest.
   bool VerifyPeerCertificate();
+  // An abbreviated handshake does not run the verification callback; records
+  // the peer certificate chain of the resumed session instead.
+  void SetPeerCertChainFromSession();
+
+  // Session resumption. Only the client keeps sessions; the server issues
+  // session tickets that hold its state.
+  bool SessionResumptionEnabled() const {
+    return session_resumption_enabled_ && ssl_mode_ == SSL_MODE_DTLS;
+  }
+  // Returns the key of the sessions with the peer in the session cache, or an
+  // empty string if it cannot be formed yet.
+  std::string SessionCacheKey() const;
+  // Offers the session of the established association for later resumption,
+  // once the peer certificate has been verified.
+  void MaybeCacheSession();
   // SSL certificate verification callback. See
   // SSL_CTX_set_cert_verify_callback.
   static int SSLVerifyCallback(X509_STORE_CTX* store, void* arg);
@@ -217,6 +238,15 @@ class OpenSSLStreamAdapter final : public SSLStreamAdapter {
   // A 50-ms initial timeout ensures rapid setup on fast connections, but may
   // be too aggressive for low bandwidth links.
   int dtls_handshake_timeout_ms_ = 50;
+
+  bool session_resumption_enabled_ = false;
+  // Set when the client offered a cached session in its ClientHello.
+  bool session_resumption_attempted_ = false;
+
+  bool handshake_completed_ = false;
+  SSLHandshakeStats handshake_stats_;
+  int64_t handshake_start_ms_ = 0;
+  int64_t handshake_cpu_time_ns_ = 0;
 };
 
 /////////////////////////////////////////////////////////////////////////////
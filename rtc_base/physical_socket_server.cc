@@ -55,6 +55,18 @@
 #include <linux/sockios.h>
 #endif
 
+#if defined(WEBRTC_USE_SENDMMSG)
+#include <netinet/udp.h>
+// UDP_SEGMENT (generic segmentation offload) is only defined by kernel headers
+// starting with Linux 4.18.
+#if !defined(SOL_UDP)
+#define SOL_UDP 17
+#endif
+#if !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#endif
+
 #if defined(WEBRTC_WIN)
 #define LAST_SYSTEM_ERROR (::GetLastError())
 #elif defined(__native_client__) && __native_client__
@@ -106,6 +118,66 @@ typedef char* SockOptArg;
 
 namespace rtc {
 
+#if defined(WEBRTC_USE_RECVMMSG)
+// Upper bound on the number of datagrams read by a single recvmmsg() call.
+static const size_t kMaxRecvBatchSize = 64;
+#endif
+
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+// Kernel timestamps older than this are assumed to be bogus, e.g. because the
+// wall clock was stepped or a fake clock is in use.
+static const int64_t kMaxKernelTimestampAgeUs = 10 * kNumMicrosecsPerSec;
+
+// Kernel receive timestamps use CLOCK_REALTIME. Translates |ts| into the
+// rtc::TimeMicros() time base by preserving the age of the packet.
+static int64_t KernelTimestampToTimeMicros(const struct timespec& ts) {
+  int64_t kernel_us = static_cast<int64_t>(ts.tv_sec) * kNumMicrosecsPerSec +
+                      ts.tv_nsec / kNumNanosecsPerMicrosec;
+  int64_t age_us = TimeUTCMicros() - kernel_us;
+  if (age_us < 0 || age_us > kMaxKernelTimestampAgeUs)
+    age_us = 0;
+  return TimeMicros() - age_us;
+}
+
+// Returns the translated SCM_TIMESTAMPNS timestamp attached to |msg|, or -1.
+// An SCM_TIMESTAMP timestamp is returned as is, on the same clock as
+// GetSocketRecvTimestamp().
+static int64_t GetTimestampFromControlMessage(struct msghdr* msg) {
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg;
+       cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET)
+      continue;
+    if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+      memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+      return KernelTimestampToTimeMicros(ts);
+    }
+    if (cmsg->cmsg_type == SCM_TIMESTAMP) {
+      struct timeval tv;
+      memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+      return kNumMicrosecsPerSec * static_cast<int64_t>(tv.tv_sec) +
+             static_cast<int64_t>(tv.tv_usec);
+    }
+  }
+  return -1;
+}
+#endif  // WEBRTC_USE_SCM_TIMESTAMPNS
+
+#if defined(WEBRTC_POSIX)
+// Upper bound on the number of segments passed to a single sendmsg() call,
+// well below IOV_MAX.
+static const size_t kMaxSendSegments = 64;
+#endif
+
+#if defined(WEBRTC_USE_SENDMMSG)
+// Upper bound on the number of datagrams passed to a single sendmmsg() call.
+static const size_t kMaxSendBatchSize = 64;
+// Limits for coalescing datagrams into one UDP_SEGMENT send, as enforced by
+// the kernel.
+static const size_t kMaxGsoSegments = 64;
+static const size_t kMaxGsoBytes = 65000;
+#endif
+
 std::unique_ptr<SocketServer> SocketServer::CreateDefault() {
 #if defined(__native_client__)
   return std::unique_ptr<SocketServer>(new rtc::NullSocketServer);
@@ -283,6 +355,12 @@ AsyncSocket::ConnState PhysicalSocket::GetState() const {
 }
 
 int PhysicalSocket::GetOption(Option opt, int* value) {
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  if (opt == OPT_RECV_TIMESTAMP) {
+    *value = recv_timestamps_ ? 1 : 0;
+    return 0;
+  }
+#endif
   int slevel;
   int sopt;
   if (TranslateOption(opt, &slevel, &sopt) == -1)
@@ -298,6 +376,21 @@ int PhysicalSocket::GetOption(Option opt, int* value) {
 }
 
 int PhysicalSocket::SetOption(Option opt, int value) {
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  if (opt == OPT_RECV_TIMESTAMP) {
+    int enable = value ? 1 : 0;
+    int ret = ::setsockopt(s_, SOL_SOCKET, SO_TIMESTAMPNS, &enable,
+                           sizeof(enable));
+    if (ret == 0) {
+      recv_timestamps_ = (enable != 0);
+#if defined(WEBRTC_USE_RECVMMSG)
+      // Turning SO_TIMESTAMPNS off also turns SO_TIMESTAMP off.
+      batch_timestamps_ = false;
+#endif
+    }
+    return ret;
+  }
+#endif
   int slevel;
   int sopt;
   if (TranslateOption(opt, &slevel, &sopt) == -1)
@@ -360,6 +453,174 @@ int PhysicalSocket::SendTo(const void* buffer,
   return sent;
 }
 
+int PhysicalSocket::SendToBatch(const SendBatchEntry* entries, size_t count) {
+#if defined(WEBRTC_USE_SENDMMSG)
+  if (!udp_ || count <= 1)
+    return AsyncSocket::SendToBatch(entries, count);
+  count = std::min(count, kMaxSendBatchSize);
+  const bool use_gso = IsUdpGsoSupported();
+
+  struct mmsghdr msgs[kMaxSendBatchSize];
+  struct iovec iovs[kMaxSendBatchSize];
+  sockaddr_storage addrs[kMaxSendBatchSize];
+  char control[kMaxSendBatchSize][CMSG_SPACE(sizeof(uint16_t))];
+  size_t datagrams_per_msg[kMaxSendBatchSize];
+  size_t num_msgs = 0;
+  size_t i = 0;
+  while (i < count) {
+    const size_t first = i;
+    const size_t segment_size = entries[first].length;
+    size_t total_size = segment_size;
+    iovs[i].iov_base = const_cast<char*>(entries[i].data);
+    iovs[i].iov_len = entries[i].length;
+    ++i;
+    // With GSO the kernel splits one send into datagrams of |segment_size|;
+    // only the last one may be shorter.
+    while (use_gso && i < count && i - first < kMaxGsoSegments &&
+           entries[i].addr == entries[first].addr &&
+           entries[i].length <= segment_size && entries[i].length > 0 &&
+           total_size + entries[i].length <= kMaxGsoBytes) {
+      iovs[i].iov_base = const_cast<char*>(entries[i].data);
+      iovs[i].iov_len = entries[i].length;
+      total_size += entries[i].length;
+      ++i;
+      if (entries[i - 1].length < segment_size)
+        break;
+    }
+
+    struct mmsghdr& msg = msgs[num_msgs];
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_hdr.msg_name = &addrs[num_msgs];
+    msg.msg_hdr.msg_namelen = static_cast<socklen_t>(
+        entries[first].addr.ToSockAddrStorage(&addrs[num_msgs]));
+    msg.msg_hdr.msg_iov = &iovs[first];
+    msg.msg_hdr.msg_iovlen = i - first;
+    if (i - first > 1) {
+      msg.msg_hdr.msg_control = control[num_msgs];
+      msg.msg_hdr.msg_controllen = sizeof(control[num_msgs]);
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+      cmsg->cmsg_level = SOL_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      uint16_t gso_size = static_cast<uint16_t>(segment_size);
+      memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+    }
+    datagrams_per_msg[num_msgs] = i - first;
+    ++num_msgs;
+  }
+
+  int sent_msgs = DoSendMmsg(s_, msgs, static_cast<unsigned int>(num_msgs),
+                             MSG_NOSIGNAL);
+  UpdateLastError();
+  if (sent_msgs < 0 && use_gso && GetError() == EIO) {
+    // The egress device can't do segmentation offload (e.g. checksum offload
+    // is disabled); fall back to one datagram per message.
+    RTC_LOG(LS_WARNING) << "UDP GSO send failed, disabling it for socket "
+                        << s_;
+    udp_gso_supported_ = false;
+    return SendToBatch(entries, count);
+  }
+  MaybeRemapSendError();
+  if (sent_msgs < 0) {
+    if (IsBlockingError(GetError()))
+      EnableEvents(DE_WRITE);
+    return SOCKET_ERROR;
+  }
+  if (static_cast<size_t>(sent_msgs) < num_msgs) {
+    // The remaining messages hit an error that will be reported by the next
+    // call; ask to be told when the socket is writable again.
+    EnableEvents(DE_WRITE);
+  }
+  size_t sent = 0;
+  for (int m = 0; m < sent_msgs; ++m)
+    sent += datagrams_per_msg[m];
+  return static_cast<int>(sent);
+#else
+  return AsyncSocket::SendToBatch(entries, count);
+#endif  // WEBRTC_USE_SENDMMSG
+}
+
+int PhysicalSocket::SendV(const SendSegment* segments, size_t count) {
+#if defined(WEBRTC_POSIX)
+  // A datagram must not be cut short by the segment limit, and a single
+  // segment needs no gathering.
+  if (udp_ || count <= 1 || count > kMaxSendSegments)
+    return AsyncSocket::SendV(segments, count);
+
+  struct iovec iovs[kMaxSendSegments];
+  size_t total_size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = const_cast<char*>(segments[i].data);
+    iovs[i].iov_len = segments[i].length;
+    total_size += segments[i].length;
+  }
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iovs;
+  msg.msg_iovlen = count;
+  int sent = DoSendMsg(s_, &msg,
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+                       // Suppress SIGPIPE. See Send() for explanation.
+                       MSG_NOSIGNAL
+#else
+                       0
+#endif
+  );
+  UpdateLastError();
+  MaybeRemapSendError();
+  RTC_DCHECK(sent <= static_cast<int>(total_size));
+  if ((sent > 0 && sent < static_cast<int>(total_size)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent;
+#else
+  return AsyncSocket::SendV(segments, count);
+#endif  // WEBRTC_POSIX
+}
+
+int PhysicalSocket::SendToV(const SendSegment* segments,
+                            size_t count,
+                            const SocketAddress& addr) {
+#if defined(WEBRTC_POSIX)
+  if (count <= 1 || count > kMaxSendSegments)
+    return AsyncSocket::SendToV(segments, count, addr);
+
+  struct iovec iovs[kMaxSendSegments];
+  size_t total_size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = const_cast<char*>(segments[i].data);
+    iovs[i].iov_len = segments[i].length;
+    total_size += segments[i].length;
+  }
+  sockaddr_storage saddr;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &saddr;
+  msg.msg_namelen = static_cast<socklen_t>(addr.ToSockAddrStorage(&saddr));
+  msg.msg_iov = iovs;
+  msg.msg_iovlen = count;
+  int sent = DoSendMsg(s_, &msg,
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+                       // Suppress SIGPIPE. See Send() for explanation.
+                       MSG_NOSIGNAL
+#else
+                       0
+#endif
+  );
+  UpdateLastError();
+  MaybeRemapSendError();
+  RTC_DCHECK(sent <= static_cast<int>(total_size));
+  if ((sent > 0 && sent < static_cast<int>(total_size)) ||
+      (sent < 0 && IsBlockingError(GetError()))) {
+    EnableEvents(DE_WRITE);
+  }
+  return sent;
+#else
+  return AsyncSocket::SendToV(segments, count, addr);
+#endif  // WEBRTC_POSIX
+}
+
 int PhysicalSocket::Recv(void* buffer, size_t length, int64_t* timestamp) {
   int received =
       ::recv(s_, static_cast<char*>(buffer), static_cast<int>(length), 0);
@@ -396,10 +657,18 @@ int PhysicalSocket::RecvFrom(void* buffer,
   sockaddr_storage addr_storage;
   socklen_t addr_len = sizeof(addr_storage);
   sockaddr* addr = reinterpret_cast<sockaddr*>(&addr_storage);
-  int received = ::recvfrom(s_, static_cast<char*>(buffer),
-                            static_cast<int>(length), 0, addr, &addr_len);
-  if (timestamp) {
-    *timestamp = GetSocketRecvTimestamp(s_);
+  int received;
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  if (recv_timestamps_) {
+    received = RecvFromWithTimestamp(buffer, length, &addr_storage, timestamp);
+  } else
+#endif
+  {
+    received = ::recvfrom(s_, static_cast<char*>(buffer),
+                          static_cast<int>(length), 0, addr, &addr_len);
+    if (timestamp) {
+      *timestamp = GetSocketRecvTimestamp(s_);
+    }
   }
   UpdateLastError();
   if ((received >= 0) && (out_addr != nullptr))
@@ -415,6 +684,83 @@ int PhysicalSocket::RecvFrom(void* buffer,
   return received;
 }
 
+int PhysicalSocket::RecvFromBatch(RecvBatchEntry* entries, size_t count) {
+#if defined(WEBRTC_USE_RECVMMSG)
+  if (!udp_ || count <= 1)
+    return AsyncSocket::RecvFromBatch(entries, count);
+  count = std::min(count, kMaxRecvBatchSize);
+
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  // Unbatched reads take the receive time with SIOCGSTAMP, which only covers
+  // the last datagram read. Ask the kernel to attach it to every datagram.
+  if (!recv_timestamps_ && !batch_timestamps_) {
+    int enable = 1;
+    batch_timestamps_ = ::setsockopt(s_, SOL_SOCKET, SO_TIMESTAMP, &enable,
+                                     sizeof(enable)) == 0;
+  }
+#endif
+
+  static_assert(sizeof(struct timeval) <= sizeof(struct timespec),
+                "Control buffers must fit either timestamp");
+  struct mmsghdr msgs[kMaxRecvBatchSize];
+  struct iovec iovs[kMaxRecvBatchSize];
+  sockaddr_storage addrs[kMaxRecvBatchSize];
+  char control[kMaxRecvBatchSize][CMSG_SPACE(sizeof(struct timespec))];
+  memset(msgs, 0, count * sizeof(msgs[0]));
+  for (size_t i = 0; i < count; ++i) {
+    iovs[i].iov_base = entries[i].buffer;
+    iovs[i].iov_len = entries[i].capacity;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = control[i];
+    msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+  }
+  int received = ::recvmmsg(s_, msgs, static_cast<unsigned int>(count),
+                            MSG_DONTWAIT, nullptr);
+  UpdateLastError();
+  // UDP sockets always stay readable, see RecvFrom().
+  EnableEvents(DE_READ);
+  if (received < 0) {
+    int error = GetError();
+    if (!IsBlockingError(error)) {
+      RTC_LOG_F(LS_VERBOSE) << "Error = " << error;
+    }
+    return SOCKET_ERROR;
+  }
+
+  // Datagrams that did not fit into their slot are dropped rather than
+  // delivered truncated; the remaining entries are compacted to the front.
+  int filled = 0;
+  for (int i = 0; i < received; ++i) {
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      RTC_LOG(LS_WARNING) << "Dropping truncated datagram, slot size "
+                          << entries[i].capacity;
+      continue;
+    }
+    if (filled != i)
+      std::swap(entries[filled], entries[i]);
+    entries[filled].length = msgs[i].msg_len;
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+    entries[filled].timestamp =
+        GetTimestampFromControlMessage(&msgs[i].msg_hdr);
+#else
+    entries[filled].timestamp = -1;
+#endif
+    SocketAddressFromSockAddrStorage(addrs[i], &entries[filled].addr);
+    ++filled;
+  }
+  if (filled == 0) {
+    SetError(EWOULDBLOCK);
+    return SOCKET_ERROR;
+  }
+  return filled;
+#else
+  return AsyncSocket::RecvFromBatch(entries, count);
+#endif  // WEBRTC_USE_RECVMMSG
+}
+
 int PhysicalSocket::Listen(int backlog) {
   int err = ::listen(s_, backlog);
   UpdateLastError();
@@ -448,11 +794,18 @@ AsyncSocket* PhysicalSocket::Accept(SocketAddress* out_addr) {
 int PhysicalSocket::Close() {
   if (s_ == INVALID_SOCKET)
     return 0;
-  int err = ::closesocket(s_);
+  int err = DoClose(s_);
   UpdateLastError();
   s_ = INVALID_SOCKET;
   state_ = CS_CLOSED;
   SetEnabledEvents(0);
+#if defined(WEBRTC_USE_SENDMMSG)
+  udp_gso_probed_ = false;
+  udp_gso_supported_ = false;
+#endif
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  recv_timestamps_ = false;
+#endif
   if (resolver_) {
     resolver_->Destroy(false);
     resolver_ = nullptr;
@@ -466,6 +819,10 @@ SOCKET PhysicalSocket::DoAccept(SOCKET socket,
   return ::accept(socket, addr, addrlen);
 }
 
+int PhysicalSocket::DoClose(SOCKET socket) {
+  return ::closesocket(socket);
+}
+
 int PhysicalSocket::DoSend(SOCKET socket, const char* buf, int len, int flags) {
   return ::send(socket, buf, len, flags);
 }
@@ -479,6 +836,58 @@ int PhysicalSocket::DoSendTo(SOCKET socket,
   return ::sendto(socket, buf, len, flags, dest_addr, addrlen);
 }
 
+#if defined(WEBRTC_POSIX)
+int PhysicalSocket::DoSendMsg(SOCKET socket, struct msghdr* msg, int flags) {
+  return ::sendmsg(socket, msg, flags);
+}
+#endif
+
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+int PhysicalSocket::RecvFromWithTimestamp(void* buffer,
+                                          size_t length,
+                                          sockaddr_storage* addr,
+                                          int64_t* timestamp) {
+  struct iovec iov = {buffer, length};
+  char control[CMSG_SPACE(sizeof(struct timespec))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = addr;
+  msg.msg_namelen = sizeof(*addr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  int received = ::recvmsg(s_, &msg, 0);
+  if (timestamp) {
+    *timestamp = received >= 0 ? GetTimestampFromControlMessage(&msg) : -1;
+  }
+  return received;
+}
+#endif  // WEBRTC_USE_SCM_TIMESTAMPNS
+
+#if defined(WEBRTC_USE_SENDMMSG)
+int PhysicalSocket::DoSendMmsg(SOCKET socket,
+                               struct mmsghdr* msgs,
+                               unsigned int vlen,
+                               int flags) {
+  return ::sendmmsg(socket, msgs, vlen, flags);
+}
+
+bool PhysicalSocket::IsUdpGsoSupported() {
+  if (!udp_gso_probed_) {
+    udp_gso_probed_ = true;
+    int value = 0;
+    socklen_t len = sizeof(value);
+    udp_gso_supported_ =
+        ::getsockopt(s_, SOL_UDP, UDP_SEGMENT, &value, &len) == 0;
+    RTC_LOG(LS_VERBOSE) << "UDP GSO "
+                        << (udp_gso_supported_ ? "supported" : "unsupported")
+                        << " on socket " << s_;
+  }
+  return udp_gso_supported_;
+}
+#endif  // WEBRTC_USE_SENDMMSG
+
 void PhysicalSocket::OnResolveResult(AsyncResolverInterface* resolver) {
   if (resolver != resolver_) {
     return;
@@ -558,6 +967,17 @@ int PhysicalSocket::TranslateOption(Option opt, int* slevel, int* sopt) {
       return -1;
     case OPT_RTP_SENDTIME_EXTN_ID:
       return -1;  // No logging is necessary as this not a OS socket option.
+    case OPT_RECV_TIMESTAMP:
+      return -1;  // Handled by GetOption() and SetOption() where supported.
+    case OPT_REUSEPORT:
+#if defined(SO_REUSEPORT)
+      *slevel = SOL_SOCKET;
+      *sopt = SO_REUSEPORT;
+      break;
+#else
+      RTC_LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+      return -1;
+#endif
     default:
       RTC_NOTREACHED();
       return -1;
@@ -16,6 +16,12 @@
 #define WEBRTC_USE_EPOLL 1
 #endif
 
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+#define WEBRTC_USE_RECVMMSG 1
+#define WEBRTC_USE_SENDMMSG 1
+#define WEBRTC_USE_SCM_TIMESTAMPNS 1
+#endif
+
 #include <memory>
 #include <set>
 #include <vector>
@@ -158,12 +164,24 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
   int SendTo(const void* buffer,
              size_t length,
              const SocketAddress& addr) override;
+  // Uses sendmmsg() on UDP sockets where available, and UDP segmentation
+  // offload for runs of same-sized datagrams to the same destination when the
+  // kernel supports it.
+  int SendToBatch(const SendBatchEntry* entries, size_t count) override;
+  // Uses sendmsg() on TCP sockets.
+  int SendV(const SendSegment* segments, size_t count) override;
+  // Uses sendmsg().
+  int SendToV(const SendSegment* segments,
+              size_t count,
+              const SocketAddress& addr) override;
 
   int Recv(void* buffer, size_t length, int64_t* timestamp) override;
   int RecvFrom(void* buffer,
                size_t length,
                SocketAddress* out_addr,
                int64_t* timestamp) override;
+  // Uses recvmmsg() on UDP sockets where available.
+  int RecvFromBatch(RecvBatchEntry* entries, size_t count) override;
 
   int Listen(int backlog) override;
   AsyncSocket* Accept(SocketAddress* out_addr) override;
@@ -178,6 +196,10 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
   // Make virtual so ::accept can be overwritten in tests.
   virtual SOCKET DoAccept(SOCKET socket, sockaddr* addr, socklen_t* addrlen);
 
+  // Make virtual so subclasses can keep the descriptor open for a while
+  // after Close().
+  virtual int DoClose(SOCKET socket);
+
   // Make virtual so ::send can be overwritten in tests.
   virtual int DoSend(SOCKET socket, const char* buf, int len, int flags);
 
@@ -189,6 +211,19 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
                        const struct sockaddr* dest_addr,
                        socklen_t addrlen);
 
+#if defined(WEBRTC_POSIX)
+  // Make virtual so ::sendmsg can be overwritten in tests.
+  virtual int DoSendMsg(SOCKET socket, struct msghdr* msg, int flags);
+#endif
+
+#if defined(WEBRTC_USE_SENDMMSG)
+  // Make virtual so ::sendmmsg can be overwritten in tests.
+  virtual int DoSendMmsg(SOCKET socket,
+                         struct mmsghdr* msgs,
+                         unsigned int vlen,
+                         int flags);
+#endif
+
   void OnResolveResult(AsyncResolverInterface* resolver);
 
   void UpdateLastError();
@@ -214,7 +249,32 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
 #endif
 
  private:
+#if defined(WEBRTC_USE_SENDMMSG)
+  bool IsUdpGsoSupported();
+#endif
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  // recvfrom() replacement that also returns the kernel receive timestamp
+  // attached by SO_TIMESTAMPNS, translated to the rtc::TimeMicros() clock.
+  int RecvFromWithTimestamp(void* buffer,
+                            size_t length,
+                            sockaddr_storage* addr,
+                            int64_t* timestamp);
+#endif
+
   uint8_t enabled_events_ = 0;
+#if defined(WEBRTC_USE_SENDMMSG)
+  // Whether UDP_SEGMENT has been probed for on |s_|, and the result.
+  bool udp_gso_probed_ = false;
+  bool udp_gso_supported_ = false;
+#endif
+#if defined(WEBRTC_USE_SCM_TIMESTAMPNS)
+  // Set by OPT_RECV_TIMESTAMP.
+  bool recv_timestamps_ = false;
+#endif
+#if defined(WEBRTC_USE_RECVMMSG)
+  // Whether SO_TIMESTAMP has been enabled for batched reads.
+  bool batch_timestamps_ = false;
+#endif
 };
 
 class SocketDispatcher : public Dispatcher, public PhysicalSocket {
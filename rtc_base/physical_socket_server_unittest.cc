@@ -14,7 +14,12 @@
 
 #include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "rtc_base/arraysize.h"
+#include "rtc_base/async_tcp_socket.h"
+#include "rtc_base/async_udp_socket.h"
 #include "rtc_base/gunit.h"
 #include "rtc_base/ip_address.h"
 #include "rtc_base/logging.h"
@@ -22,6 +27,7 @@
 #include "rtc_base/socket_unittest.h"
 #include "rtc_base/test_utils.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/time_utils.h"
 #include "test/gtest.h"
 
 namespace rtc {
@@ -57,6 +63,9 @@ class FakeSocketDispatcher : public SocketDispatcher {
                int flags,
                const struct sockaddr* dest_addr,
                socklen_t addrlen) override;
+#if defined(WEBRTC_POSIX)
+  int DoSendMsg(SOCKET socket, struct msghdr* msg, int flags) override;
+#endif
 };
 
 class FakePhysicalSocketServer : public PhysicalSocketServer {
@@ -170,6 +179,29 @@ int FakeSocketDispatcher::DoSendTo(SOCKET socket,
                                     addrlen);
 }
 
+#if defined(WEBRTC_POSIX)
+int FakeSocketDispatcher::DoSendMsg(SOCKET socket,
+                                    struct msghdr* msg,
+                                    int flags) {
+  FakePhysicalSocketServer* ss =
+      static_cast<FakePhysicalSocketServer*>(socketserver());
+  if (ss->GetTest()->MaxSendSize() >= 0) {
+    // Cut the segments short at the maximum size.
+    size_t remaining = ss->GetTest()->MaxSendSize();
+    for (size_t i = 0; i < msg->msg_iovlen; ++i) {
+      if (msg->msg_iov[i].iov_len >= remaining) {
+        msg->msg_iov[i].iov_len = remaining;
+        msg->msg_iovlen = i + 1;
+        break;
+      }
+      remaining -= msg->msg_iov[i].iov_len;
+    }
+  }
+
+  return SocketDispatcher::DoSendMsg(socket, msg, flags);
+}
+#endif
+
 TEST_F(PhysicalSocketTest, TestConnectIPv4) {
   MAYBE_SKIP_IPV4;
   SocketTest::TestConnectIPv4();
@@ -461,6 +493,471 @@ TEST_F(PhysicalSocketTest, TestSocketRecvTimestampIPv6) {
 }
 #endif
 
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+// With OPT_RECV_TIMESTAMP the receive time reflects when the kernel got the
+// datagram, not when it was read, and is in the rtc::TimeMicros() time base.
+TEST_F(PhysicalSocketTest, TestSocketRecvKernelTimestampIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> socket(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, socket->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, socket->SetOption(Socket::OPT_RECV_TIMESTAMP, 1));
+  int value = 0;
+  EXPECT_EQ(0, socket->GetOption(Socket::OPT_RECV_TIMESTAMP, &value));
+  EXPECT_EQ(1, value);
+
+  const int64_t kReadDelayMs = 100;
+  int64_t send_time_us = TimeMicros();
+  ASSERT_EQ(3, socket->SendTo("foo", 3, socket->GetLocalAddress()));
+  Thread::SleepMs(kReadDelayMs);
+
+  char buffer[3];
+  int64_t recv_timestamp_us = -1;
+  ASSERT_EQ(3, socket->RecvFrom(buffer, sizeof(buffer), nullptr,
+                                &recv_timestamp_us));
+  int64_t read_time_us = TimeMicros();
+  EXPECT_GE(recv_timestamp_us, send_time_us - 5000);
+  EXPECT_LT(recv_timestamp_us, read_time_us - kReadDelayMs * 1000 / 2);
+
+  // Batched reads carry the timestamp too.
+  ASSERT_EQ(3, socket->SendTo("bar", 3, socket->GetLocalAddress()));
+  ASSERT_EQ(3, socket->SendTo("baz", 3, socket->GetLocalAddress()));
+  Thread::SleepMs(kReadDelayMs);
+  char buffers[2][3];
+  RecvBatchEntry entries[2];
+  for (size_t i = 0; i < arraysize(entries); ++i) {
+    entries[i].buffer = buffers[i];
+    entries[i].capacity = sizeof(buffers[i]);
+  }
+  ASSERT_EQ(2, socket->RecvFromBatch(entries, arraysize(entries)));
+  read_time_us = TimeMicros();
+  for (const RecvBatchEntry& entry : entries) {
+    EXPECT_GT(entry.timestamp, -1);
+    EXPECT_LT(entry.timestamp, read_time_us - kReadDelayMs * 1000 / 2);
+  }
+}
+#endif
+
+TEST_F(PhysicalSocketTest, TestRecvFromBatchIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+
+  static const int kNumPackets = 5;
+  for (int i = 0; i < kNumPackets; ++i) {
+    char payload = 'a' + i;
+    ASSERT_EQ(1, sender->SendTo(&payload, 1, receiver->GetLocalAddress()));
+  }
+
+  char buffers[8][16];
+  RecvBatchEntry entries[8];
+  int received = 0;
+  while (received < kNumPackets) {
+    for (size_t i = 0; i < arraysize(entries); ++i) {
+      entries[i].buffer = buffers[i];
+      entries[i].capacity = sizeof(buffers[i]);
+    }
+    int count = receiver->RecvFromBatch(entries, arraysize(entries));
+    ASSERT_GT(count, 0);
+    for (int i = 0; i < count; ++i, ++received) {
+      EXPECT_EQ(1u, entries[i].length);
+      EXPECT_EQ('a' + received, entries[i].buffer[0]);
+      EXPECT_EQ(sender->GetLocalAddress(), entries[i].addr);
+    }
+  }
+  EXPECT_EQ(kNumPackets, received);
+  EXPECT_EQ(SOCKET_ERROR,
+            receiver->RecvFromBatch(entries, arraysize(entries)));
+  EXPECT_TRUE(receiver->IsBlocking());
+}
+
+TEST_F(PhysicalSocketTest, TestSendToBatchIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+
+  // Four equally sized datagrams followed by a shorter one, so that they can
+  // be coalesced into a single segmentation offload send where supported.
+  static const size_t kSizes[] = {100, 100, 100, 100, 40};
+  char payloads[arraysize(kSizes)][100];
+  SendBatchEntry entries[arraysize(kSizes)];
+  for (size_t i = 0; i < arraysize(kSizes); ++i) {
+    memset(payloads[i], 'a' + i, sizeof(payloads[i]));
+    entries[i].data = payloads[i];
+    entries[i].length = kSizes[i];
+    entries[i].addr = receiver->GetLocalAddress();
+  }
+  EXPECT_EQ(static_cast<int>(arraysize(kSizes)),
+            sender->SendToBatch(entries, arraysize(entries)));
+
+  for (size_t i = 0; i < arraysize(kSizes); ++i) {
+    char buffer[200];
+    SocketAddress addr;
+    ASSERT_EQ(static_cast<int>(kSizes[i]),
+              receiver->RecvFrom(buffer, sizeof(buffer), &addr, nullptr));
+    EXPECT_EQ('a' + static_cast<int>(i), buffer[0]);
+    EXPECT_EQ('a' + static_cast<int>(i), buffer[kSizes[i] - 1]);
+    EXPECT_EQ(sender->GetLocalAddress(), addr);
+  }
+}
+
+class UdpPacketCounter : public sigslot::has_slots<> {
+ public:
+  void OnReadPacket(AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const SocketAddress& remote_addr,
+                    const int64_t& packet_time_us) {
+    ++packets_;
+    packet_sizes_.push_back(size);
+  }
+  void OnSentPacket(AsyncPacketSocket* socket, const SentPacket& sent_packet) {
+    sent_packet_ids_.push_back(sent_packet.packet_id);
+  }
+  int packets() const { return packets_; }
+  const std::vector<size_t>& packet_sizes() const { return packet_sizes_; }
+  const std::vector<int64_t>& sent_packet_ids() const {
+    return sent_packet_ids_;
+  }
+
+ private:
+  int packets_ = 0;
+  std::vector<size_t> packet_sizes_;
+  std::vector<int64_t> sent_packet_ids_;
+};
+
+TEST_F(PhysicalSocketTest, TestAsyncUdpSendBatchingIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncUDPSocket> receiver(
+      AsyncUDPSocket::Create(server_.get(), SocketAddress(kIPv4Loopback, 0)));
+  std::unique_ptr<AsyncUDPSocket> sender(
+      AsyncUDPSocket::Create(server_.get(), SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_TRUE(receiver);
+  ASSERT_TRUE(sender);
+  UdpPacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter,
+                                     &UdpPacketCounter::OnReadPacket);
+  sender->SignalSentPacket.connect(&counter, &UdpPacketCounter::OnSentPacket);
+  sender->SetSendBatchingEnabled(true);
+
+  char payload[100] = {0};
+  for (int i = 0; i < 3; ++i) {
+    PacketOptions options;
+    options.packet_id = i;
+    EXPECT_EQ(100, sender->SendTo(payload, sizeof(payload),
+                                  receiver->GetLocalAddress(), options));
+  }
+  // Nothing goes out until the thread gets back to its message loop.
+  EXPECT_TRUE(counter.sent_packet_ids().empty());
+  EXPECT_EQ_WAIT(3, counter.packets(), kTimeout);
+  EXPECT_EQ((std::vector<int64_t>{0, 1, 2}), counter.sent_packet_ids());
+
+  // Turning batching off flushes anything still queued.
+  sender->SendTo(payload, sizeof(payload), receiver->GetLocalAddress(),
+                 PacketOptions());
+  sender->SetSendBatchingEnabled(false);
+  EXPECT_EQ(4u, counter.sent_packet_ids().size());
+  EXPECT_EQ_WAIT(4, counter.packets(), kTimeout);
+}
+
+// Batched reads deliver datagrams of any size, like unbatched reads.
+TEST_F(PhysicalSocketTest, TestAsyncUdpRecvBatchingLargeDatagramIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncUDPSocket> receiver(
+      AsyncUDPSocket::Create(server_.get(), SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_TRUE(receiver);
+  receiver->SetRecvBatchSize(8);
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+  UdpPacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter,
+                                     &UdpPacketCounter::OnReadPacket);
+
+  const std::vector<size_t> kSizes = {100, 9000, 100};
+  std::vector<char> payload(9000, 'x');
+  SocketAddress dest = receiver->GetLocalAddress();
+  for (size_t size : kSizes) {
+    ASSERT_EQ(static_cast<int>(size),
+              sender->SendTo(payload.data(), size, dest));
+  }
+  EXPECT_EQ_WAIT(3, counter.packets(), kTimeout);
+  EXPECT_EQ(kSizes, counter.packet_sizes());
+}
+
+#if defined(WEBRTC_LINUX) && !defined(WEBRTC_ANDROID)
+// Batched reads attach a receive time to every datagram even without
+// OPT_RECV_TIMESTAMP, as unbatched reads do with SIOCGSTAMP.
+TEST_F(PhysicalSocketTest, TestRecvFromBatchTimestampIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> socket(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, socket->Bind(SocketAddress(kIPv4Loopback, 0)));
+  char buffers[2][3];
+  RecvBatchEntry entries[2];
+  for (size_t i = 0; i < arraysize(entries); ++i) {
+    entries[i].buffer = buffers[i];
+    entries[i].capacity = sizeof(buffers[i]);
+  }
+  // Like SIOCGSTAMP, the first read turns timestamping on.
+  EXPECT_EQ(SOCKET_ERROR, socket->RecvFromBatch(entries, arraysize(entries)));
+
+  ASSERT_EQ(3, socket->SendTo("foo", 3, socket->GetLocalAddress()));
+  ASSERT_EQ(3, socket->SendTo("bar", 3, socket->GetLocalAddress()));
+  Thread::SleepMs(10);
+  ASSERT_EQ(2, socket->RecvFromBatch(entries, arraysize(entries)));
+  for (const RecvBatchEntry& entry : entries)
+    EXPECT_GT(entry.timestamp, -1);
+  EXPECT_LE(entries[0].timestamp, entries[1].timestamp);
+}
+#endif
+
+TEST_F(PhysicalSocketTest, TestSendVIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> server(
+      server_->CreateAsyncSocket(AF_INET, SOCK_STREAM));
+  ASSERT_EQ(0, server->Bind(SocketAddress(kIPv4Loopback, 0)));
+  ASSERT_EQ(0, server->Listen(5));
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_STREAM));
+  ASSERT_EQ(0, sender->Connect(server->GetLocalAddress()));
+  AsyncSocket* accepted = nullptr;
+  EXPECT_TRUE_WAIT((accepted = server->Accept(nullptr)) != nullptr, kTimeout);
+  std::unique_ptr<AsyncSocket> receiver(accepted);
+  ASSERT_TRUE(receiver);
+  EXPECT_EQ_WAIT(Socket::CS_CONNECTED, sender->GetState(), kTimeout);
+
+  const SendSegment segments[] = {{"ab", 2}, {"", 0}, {"cdef", 4}, {"g", 1}};
+  EXPECT_EQ(7, sender->SendV(segments, arraysize(segments)));
+  // A partial write ends in the middle of a segment.
+  SetMaxSendSize(3);
+  EXPECT_EQ(3, sender->SendV(segments, arraysize(segments)));
+  SetMaxSendSize(-1);
+
+  std::string received;
+  char buffer[16];
+  while (received.size() < 10) {
+    int len = receiver->Recv(buffer, sizeof(buffer), nullptr);
+    if (len > 0) {
+      received.append(buffer, len);
+    } else {
+      ASSERT_TRUE(receiver->IsBlocking());
+      ASSERT_TRUE(thread_.ProcessMessages(10));
+    }
+  }
+  EXPECT_EQ("abcdefgabc", received);
+}
+
+TEST_F(PhysicalSocketTest, TestSendToVIPv4) {
+  MAYBE_SKIP_IPV4;
+  std::unique_ptr<AsyncSocket> sender(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(kIPv4Loopback, 0)));
+  std::unique_ptr<AsyncSocket> receiver(
+      server_->CreateAsyncSocket(AF_INET, SOCK_DGRAM));
+  ASSERT_EQ(0, receiver->Bind(SocketAddress(kIPv4Loopback, 0)));
+
+  // The segments of each call form one datagram.
+  const SendSegment segments[] = {{"ab", 2}, {"", 0}, {"cde", 3}};
+  EXPECT_EQ(5, sender->SendToV(segments, arraysize(segments),
+                               receiver->GetLocalAddress()));
+  EXPECT_EQ(2, sender->SendToV(segments, 1, receiver->GetLocalAddress()));
+
+  std::vector<std::string> received;
+  char buffer[16];
+  while (received.size() < 2) {
+    SocketAddress addr;
+    int len = receiver->RecvFrom(buffer, sizeof(buffer), &addr, nullptr);
+    if (len >= 0) {
+      EXPECT_EQ(sender->GetLocalAddress(), addr);
+      received.emplace_back(buffer, len);
+    } else {
+      ASSERT_TRUE(receiver->IsBlocking());
+      ASSERT_TRUE(thread_.ProcessMessages(10));
+    }
+  }
+  EXPECT_EQ("abcde", received[0]);
+  EXPECT_EQ("ab", received[1]);
+}
+
+// Accepts a connection on a listening AsyncTCPSocket and keeps the last packet
+// read from it.
+class TcpPacketSink : public sigslot::has_slots<> {
+ public:
+  void OnNewConnection(AsyncPacketSocket* server, AsyncPacketSocket* socket) {
+    socket_.reset(socket);
+    socket->SignalReadPacket.connect(this, &TcpPacketSink::OnReadPacket);
+  }
+  void OnReadPacket(AsyncPacketSocket* socket,
+                    const char* data,
+                    size_t size,
+                    const SocketAddress& remote_addr,
+                    const int64_t& packet_time_us) {
+    ++packets_;
+    last_packet_.assign(data, size);
+  }
+  bool connected() const { return socket_ != nullptr; }
+  int packets() const { return packets_; }
+  const std::string& last_packet() const { return last_packet_; }
+
+ private:
+  std::unique_ptr<AsyncPacketSocket> socket_;
+  int packets_ = 0;
+  std::string last_packet_;
+};
+
+static const int kConnectTimeoutMs = 5000;
+
+// Connects an AsyncTCPSocket to a listening one on |loopback|, whose end of
+// the connection is given to |sink|.
+static void ConnectAsyncTcpSockets(SocketServer* ss,
+                                   const IPAddress& loopback,
+                                   TcpPacketSink* sink,
+                                   std::unique_ptr<AsyncTCPSocket>* listener,
+                                   std::unique_ptr<AsyncTCPSocket>* client) {
+  AsyncSocket* socket = ss->CreateAsyncSocket(loopback.family(), SOCK_STREAM);
+  ASSERT_EQ(0, socket->Bind(SocketAddress(loopback, 0)));
+  listener->reset(new AsyncTCPSocket(socket, true));
+  (*listener)->SignalNewConnection.connect(sink,
+                                           &TcpPacketSink::OnNewConnection);
+  client->reset(AsyncTCPSocket::Create(
+      ss->CreateAsyncSocket(loopback.family(), SOCK_STREAM),
+      SocketAddress(loopback, 0), (*listener)->GetLocalAddress()));
+  ASSERT_TRUE(*client);
+  EXPECT_TRUE_WAIT(sink->connected(), kConnectTimeoutMs);
+  EXPECT_EQ_WAIT(AsyncPacketSocket::STATE_CONNECTED, (*client)->GetState(),
+                 kConnectTimeoutMs);
+}
+
+TEST_F(PhysicalSocketTest, TestAsyncTcpPartialWriteIPv4) {
+  MAYBE_SKIP_IPV4;
+  TcpPacketSink sink;
+  std::unique_ptr<AsyncTCPSocket> listener;
+  std::unique_ptr<AsyncTCPSocket> client;
+  ConnectAsyncTcpSockets(server_.get(), kIPv4Loopback, &sink, &listener,
+                         &client);
+  ASSERT_TRUE(sink.connected());
+
+  const std::string first(1000, 'a');
+  const std::string second(500, 'b');
+  const std::string third(200, 'c');
+  SetMaxSendSize(100);
+  EXPECT_EQ(1000, client->Send(first.data(), first.size(), PacketOptions()));
+  // Dropped, since the rest of the first packet is still waiting for the
+  // socket to become writable.
+  EXPECT_EQ(500, client->Send(second.data(), second.size(), PacketOptions()));
+  SetMaxSendSize(-1);
+  EXPECT_EQ_WAIT(1, sink.packets(), kTimeout);
+  EXPECT_EQ(first, sink.last_packet());
+
+  EXPECT_EQ(200, client->Send(third.data(), third.size(), PacketOptions()));
+  EXPECT_EQ_WAIT(2, sink.packets(), kTimeout);
+  EXPECT_EQ(third, sink.last_packet());
+}
+
+// Sends bursts of datagrams over loopback and measures how fast an
+// AsyncUDPSocket with the given receive batch size drains them.
+static void RunUdpLoopbackThroughput(SocketServer* ss,
+                                     const IPAddress& loopback,
+                                     size_t batch_size) {
+  static const int kBurstSize = 64;
+  static const int kNumBursts = 10000;
+  static const size_t kPacketSize = 1200;
+
+  std::unique_ptr<AsyncUDPSocket> receiver(
+      AsyncUDPSocket::Create(ss, SocketAddress(loopback, 0)));
+  ASSERT_TRUE(receiver);
+  receiver->SetRecvBatchSize(batch_size);
+  receiver->SetOption(Socket::OPT_RCVBUF, 4 * 1024 * 1024);
+  std::unique_ptr<AsyncSocket> sender(
+      ss->CreateAsyncSocket(loopback.family(), SOCK_DGRAM));
+  ASSERT_EQ(0, sender->Bind(SocketAddress(loopback, 0)));
+  UdpPacketCounter counter;
+  receiver->SignalReadPacket.connect(&counter,
+                                     &UdpPacketCounter::OnReadPacket);
+
+  char payload[kPacketSize] = {0};
+  SocketAddress dest = receiver->GetLocalAddress();
+  int sent = 0;
+  int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumBursts; ++i) {
+    for (int j = 0; j < kBurstSize; ++j) {
+      if (sender->SendTo(payload, kPacketSize, dest) > 0)
+        ++sent;
+    }
+    int64_t deadline_ms = TimeMillis() + 1000;
+    while (counter.packets() < sent && TimeMillis() < deadline_ms) {
+      ss->Wait(0, true);
+    }
+  }
+  int64_t elapsed_us = std::max<int64_t>(TimeMicros() - start_us, 1);
+  RTC_LOG(LS_INFO) << "Batch size " << batch_size << ": "
+                   << counter.packets() << " packets in " << elapsed_us / 1000
+                   << " ms, "
+                   << counter.packets() * kNumMicrosecsPerSec / elapsed_us
+                   << " packets/s";
+}
+
+// Compares per-packet recvfrom() against batched recvmmsg() reads. Disabled
+// by default since it only reports numbers and takes several seconds.
+TEST_F(PhysicalSocketTest, DISABLED_UdpLoopbackReceiveThroughput) {
+  MAYBE_SKIP_IPV4;
+  RunUdpLoopbackThroughput(server_.get(), kIPv4Loopback, 1);
+  RunUdpLoopbackThroughput(server_.get(), kIPv4Loopback, 8);
+  RunUdpLoopbackThroughput(server_.get(), kIPv4Loopback, 32);
+}
+
+// Sends bursts of packets of |packet_size| bytes from one AsyncTCPSocket to
+// another over loopback and measures the throughput.
+static void RunTcpLoopbackThroughput(SocketServer* ss,
+                                     const IPAddress& loopback,
+                                     size_t packet_size) {
+  static const int kBurstSize = 32;
+  static const int kNumBursts = 10000;
+
+  TcpPacketSink sink;
+  std::unique_ptr<AsyncTCPSocket> listener;
+  std::unique_ptr<AsyncTCPSocket> sender;
+  ConnectAsyncTcpSockets(ss, loopback, &sink, &listener, &sender);
+  ASSERT_TRUE(sink.connected());
+
+  std::vector<char> payload(packet_size);
+  int sent = 0;
+  int64_t start_us = TimeMicros();
+  for (int i = 0; i < kNumBursts; ++i) {
+    for (int j = 0; j < kBurstSize; ++j) {
+      if (sender->Send(payload.data(), packet_size, PacketOptions()) > 0)
+        ++sent;
+    }
+    int64_t deadline_ms = TimeMillis() + 1000;
+    while (sink.packets() < sent && TimeMillis() < deadline_ms) {
+      ss->Wait(0, true);
+    }
+  }
+  int64_t elapsed_us = std::max<int64_t>(TimeMicros() - start_us, 1);
+  RTC_LOG(LS_INFO) << "Packet size " << packet_size << ": " << sink.packets()
+                   << " of " << sent << " packets in " << elapsed_us / 1000
+                   << " ms, "
+                   << sink.packets() * packet_size * 8 / elapsed_us
+                   << " Mbps";
+}
+
+// Disabled by default since it only reports numbers and takes several seconds.
+TEST_F(PhysicalSocketTest, DISABLED_TcpLoopbackThroughput) {
+  MAYBE_SKIP_IPV4;
+  RunTcpLoopbackThroughput(server_.get(), kIPv4Loopback, 200);
+  RunTcpLoopbackThroughput(server_.get(), kIPv4Loopback, 1200);
+  RunTcpLoopbackThroughput(server_.get(), kIPv4Loopback, 16000);
+}
+
 // Verify that if the socket was unable to be bound to a real network interface
 // (not loopback), Bind will return an error.
 TEST_F(PhysicalSocketTest,
@@ -19,6 +19,7 @@
 #include <algorithm>
 
 #include "rtc_base/checks.h"
+#include "rtc_base/thread_cpu_usage.h"
 
 namespace rtc {
 namespace {
@@ -126,6 +127,7 @@ void PlatformThread::Run() {
   // Attach the worker thread checker to this thread.
   RTC_DCHECK(spawned_thread_checker_.IsCurrent());
   rtc::SetCurrentThreadName(name_.c_str());
+  ScopedRegisterThreadCpuUsage cpu_usage(name_);
   SetPriority(priority_);
   run_function_(obj_);
 }
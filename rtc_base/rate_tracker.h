@@ -43,6 +43,10 @@ class RateTracker {
   // The total number of samples added.
   size_t TotalSampleCount() const;
 
+  // The number of bytes allocated for the sample buckets, which are allocated
+  // when the first sample is added.
+  size_t AllocatedBytes() const;
+
   // Reads the current time in order to determine the appropriate bucket for
   // these samples, and increments the count for that bucket by sample_count.
   void AddSamples(size_t sample_count);
@@ -166,4 +166,15 @@ TEST(RateTrackerTest, TestGetUnitSecondsAfterInitialValue) {
   EXPECT_DOUBLE_EQ(1234.0, tracker.ComputeRateForInterval(1000));
 }
 
+TEST(RateTrackerTest, AllocatesBucketsWithFirstSample) {
+  RateTrackerForTest tracker;
+  EXPECT_EQ(0u, tracker.AllocatedBytes());
+  EXPECT_DOUBLE_EQ(0.0, tracker.ComputeRate());
+  EXPECT_DOUBLE_EQ(0.0, tracker.ComputeTotalRate());
+  EXPECT_EQ(0u, tracker.TotalSampleCount());
+
+  tracker.AddSamples(1);
+  EXPECT_EQ(11 * sizeof(size_t), tracker.AllocatedBytes());
+}
+
 }  // namespace rtc
@@ -18,10 +18,12 @@
 
 #include "rtc_base/checks.h"
 #include "rtc_base/location.h"
+#include "rtc_base/logging.h"
 #include "rtc_base/message_handler.h"
 #include "rtc_base/message_queue.h"
 #include "rtc_base/ref_counted_object.h"
 #include "rtc_base/ssl_identity.h"
+#include "rtc_base/time_utils.h"
 
 namespace rtc {
 
@@ -30,6 +32,10 @@ namespace {
 // A certificates' subject and issuer name.
 const char kIdentityName[] = "WebRTC";
 const uint64_t kYearInSeconds = 365 * 24 * 60 * 60;
+// Pooled certificates that expire sooner than this are replaced rather than
+// handed out, half the default lifetime.
+const uint64_t kMinPooledLifetimeMs =
+    kDefaultCertificateLifetimeInSeconds * 1000ull / 2;
 
 enum {
   MSG_GENERATE,
@@ -60,6 +66,11 @@ class RTCCertificateGenerationTask : public RefCountInterface,
   }
   ~RTCCertificateGenerationTask() override {}
 
+  // For a request served from a pool, which only needs |MSG_GENERATE_DONE|.
+  void set_certificate(const scoped_refptr<RTCCertificate>& certificate) {
+    certificate_ = certificate;
+  }
+
   // Handles |MSG_GENERATE| and its follow-up |MSG_GENERATE_DONE|.
   void OnMessage(Message* msg) override {
     switch (msg->message_id) {
@@ -100,8 +111,122 @@ class RTCCertificateGenerationTask : public RefCountInterface,
   scoped_refptr<RTCCertificate> certificate_;
 };
 
+bool SameKeyParams(const KeyParams& a, const KeyParams& b) {
+  if (a.type() != b.type())
+    return false;
+  if (a.type() == KT_RSA) {
+    return a.rsa_params().mod_size == b.rsa_params().mod_size &&
+           a.rsa_params().pub_exp == b.rsa_params().pub_exp;
+  }
+  return a.ec_curve() == b.ec_curve();
+}
+
 }  // namespace
 
+RTCCertificatePool::Entry::Entry(const KeyParams& key_params)
+    : key_params(key_params) {}
+
+RTCCertificatePool::Entry::Entry(Entry&&) = default;
+
+RTCCertificatePool::Entry::~Entry() = default;
+
+// static
+scoped_refptr<RTCCertificatePool> RTCCertificatePool::Create(
+    size_t size,
+    const std::vector<KeyParams>& key_params) {
+  return new RefCountedObject<RTCCertificatePool>(size, key_params);
+}
+
+RTCCertificatePool::RTCCertificatePool(size_t size,
+                                       const std::vector<KeyParams>& key_params)
+    : size_(size), thread_(Thread::Create()) {
+  RTC_DCHECK_GT(size_, 0);
+  thread_->SetName("cert_pool_thread", nullptr);
+  thread_->Start();
+  CritScope cs(&crit_);
+  for (const KeyParams& params : key_params) {
+    if (params.IsValid())
+      Refill(FindOrAddEntry(params));
+  }
+}
+
+RTCCertificatePool::~RTCCertificatePool() {
+  // Waits for the certificate being generated, and drops the pending tasks.
+  thread_->Stop();
+}
+
+scoped_refptr<RTCCertificate> RTCCertificatePool::Take(
+    const KeyParams& key_params) {
+  if (!key_params.IsValid())
+    return nullptr;
+  uint64_t now_ms = static_cast<uint64_t>(TimeUTCMillis());
+  CritScope cs(&crit_);
+  Entry* entry = FindOrAddEntry(key_params);
+  scoped_refptr<RTCCertificate> certificate;
+  while (!certificate && !entry->ready.empty()) {
+    certificate = entry->ready.front();
+    entry->ready.erase(entry->ready.begin());
+    if (certificate->Expires() < now_ms + kMinPooledLifetimeMs)
+      certificate = nullptr;
+  }
+  if (certificate) {
+    ++stats_.hits;
+  } else {
+    ++stats_.misses;
+  }
+  Refill(entry);
+  return certificate;
+}
+
+size_t RTCCertificatePool::ReadyCount(const KeyParams& key_params) const {
+  CritScope cs(&crit_);
+  for (const Entry& entry : entries_) {
+    if (SameKeyParams(entry.key_params, key_params))
+      return entry.ready.size();
+  }
+  return 0;
+}
+
+RTCCertificatePool::Stats RTCCertificatePool::GetStats() const {
+  CritScope cs(&crit_);
+  return stats_;
+}
+
+RTCCertificatePool::Entry* RTCCertificatePool::FindOrAddEntry(
+    const KeyParams& key_params) {
+  for (Entry& entry : entries_) {
+    if (SameKeyParams(entry.key_params, key_params))
+      return &entry;
+  }
+  entries_.emplace_back(key_params);
+  return &entries_.back();
+}
+
+void RTCCertificatePool::Refill(Entry* entry) {
+  while (entry->ready.size() + entry->pending < size_) {
+    ++entry->pending;
+    KeyParams key_params = entry->key_params;
+    thread_->PostTask(RTC_FROM_HERE,
+                      [this, key_params] { Generate(key_params); });
+  }
+}
+
+void RTCCertificatePool::Generate(const KeyParams& key_params) {
+  RTC_DCHECK(thread_->IsCurrent());
+  scoped_refptr<RTCCertificate> certificate =
+      RTCCertificateGenerator::GenerateCertificate(key_params, absl::nullopt);
+  CritScope cs(&crit_);
+  Entry* entry = FindOrAddEntry(key_params);
+  --entry->pending;
+  if (!certificate) {
+    // Retried on the next miss.
+    RTC_LOG(LS_WARNING) << "Failed to generate a pooled certificate.";
+    return;
+  }
+  ++stats_.generated;
+  entry->ready.push_back(certificate);
+}
+
 // static
 scoped_refptr<RTCCertificate> RTCCertificateGenerator::GenerateCertificate(
     const KeyParams& key_params,
@@ -136,11 +261,21 @@ scoped_refptr<RTCCertificate> RTCCertificateGenerator::GenerateCertificate(
 
 RTCCertificateGenerator::RTCCertificateGenerator(Thread* signaling_thread,
                                                  Thread* worker_thread)
-    : signaling_thread_(signaling_thread), worker_thread_(worker_thread) {
+    : RTCCertificateGenerator(signaling_thread, worker_thread, nullptr) {}
+
+RTCCertificateGenerator::RTCCertificateGenerator(
+    Thread* signaling_thread,
+    Thread* worker_thread,
+    scoped_refptr<RTCCertificatePool> pool)
+    : signaling_thread_(signaling_thread),
+      worker_thread_(worker_thread),
+      pool_(std::move(pool)) {
   RTC_DCHECK(signaling_thread_);
   RTC_DCHECK(worker_thread_);
 }
 
+RTCCertificateGenerator::~RTCCertificateGenerator() = default;
+
 void RTCCertificateGenerator::GenerateCertificateAsync(
     const KeyParams& key_params,
     const absl::optional<uint64_t>& expires_ms,
@@ -156,6 +291,16 @@ void RTCCertificateGenerator::GenerateCertificateAsync(
           new RefCountedObject<RTCCertificateGenerationTask>(
               signaling_thread_, worker_thread_, key_params, expires_ms,
               callback));
+  if (pool_ && !expires_ms) {
+    scoped_refptr<RTCCertificate> certificate = pool_->Take(key_params);
+    if (certificate) {
+      // Still completes asynchronously, like a generated certificate.
+      msg_data->data()->set_certificate(certificate);
+      signaling_thread_->Post(RTC_FROM_HERE, msg_data->data().get(),
+                              MSG_GENERATE_DONE, msg_data);
+      return;
+    }
+  }
   worker_thread_->Post(RTC_FROM_HERE, msg_data->data().get(), MSG_GENERATE,
                        msg_data);
 }
@@ -11,15 +11,21 @@
 #ifndef RTC_BASE_RTC_CERTIFICATE_GENERATOR_H_
 #define RTC_BASE_RTC_CERTIFICATE_GENERATOR_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <memory>
+#include <vector>
+
 #include "absl/types/optional.h"
 #include "api/scoped_refptr.h"
+#include "rtc_base/critical_section.h"
 #include "rtc_base/ref_count.h"
 #include "rtc_base/rtc_certificate.h"
 #include "rtc_base/ssl_identity.h"
 #include "rtc_base/system/rtc_export.h"
 #include "rtc_base/thread.h"
+#include "rtc_base/thread_annotations.h"
 
 namespace rtc {
 
@@ -50,6 +56,66 @@ class RTCCertificateGeneratorInterface {
       const scoped_refptr<RTCCertificateGeneratorCallback>& callback) = 0;
 };
 
+// Keeps certificates with the default expiration ready, so that requests
+// for them do not pay for key generation. For each KeyParams it was created
+// with or that has been asked for since, the pool holds up to |size|
+// certificates, and generates replacements for the ones taken on a background
+// thread. Can be shared between |RTCCertificateGenerator|s. Thread safe.
+class RTC_EXPORT RTCCertificatePool : public RefCountInterface {
+ public:
+  struct Stats {
+    // Certificates handed out by Take().
+    int64_t hits = 0;
+    // Calls to Take() that found no certificate ready.
+    int64_t misses = 0;
+    // Certificates the background thread has generated.
+    int64_t generated = 0;
+  };
+
+  static scoped_refptr<RTCCertificatePool> Create(
+      size_t size,
+      const std::vector<KeyParams>& key_params);
+
+  // Returns a certificate of |key_params|, or null if none is ready or
+  // |key_params| is not valid. Either way, the pool is refilled for
+  // |key_params| in the background.
+  scoped_refptr<RTCCertificate> Take(const KeyParams& key_params);
+
+  // Returns the number of certificates of |key_params| ready to be taken.
+  size_t ReadyCount(const KeyParams& key_params) const;
+
+  Stats GetStats() const;
+
+ protected:
+  RTCCertificatePool(size_t size, const std::vector<KeyParams>& key_params);
+  ~RTCCertificatePool() override;
+
+ private:
+  struct Entry {
+    explicit Entry(const KeyParams& key_params);
+    Entry(Entry&&);
+    ~Entry();
+
+    KeyParams key_params;
+    std::vector<scoped_refptr<RTCCertificate>> ready;
+    // Certificates being generated.
+    size_t pending = 0;
+  };
+
+  Entry* FindOrAddEntry(const KeyParams& key_params)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Starts generating the certificates missing in |entry|.
+  void Refill(Entry* entry) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Runs on |thread_|.
+  void Generate(const KeyParams& key_params);
+
+  const size_t size_;
+  const std::unique_ptr<Thread> thread_;
+  CriticalSection crit_;
+  std::vector<Entry> entries_ RTC_GUARDED_BY(crit_);
+  Stats stats_ RTC_GUARDED_BY(crit_);
+};
+
 // Standard implementation of |RTCCertificateGeneratorInterface|.
 // The static function |GenerateCertificate| generates a certificate on the
 // current thread. The |RTCCertificateGenerator| instance generates certificates
@@ -67,7 +133,12 @@ class RTC_EXPORT RTCCertificateGenerator
       const absl::optional<uint64_t>& expires_ms);
 
   RTCCertificateGenerator(Thread* signaling_thread, Thread* worker_thread);
-  ~RTCCertificateGenerator() override {}
+  // Requests without |expires_ms| are served from |pool| when it has a
+  // certificate ready, instead of generating one on the worker thread.
+  RTCCertificateGenerator(Thread* signaling_thread,
+                          Thread* worker_thread,
+                          scoped_refptr<RTCCertificatePool> pool);
+  ~RTCCertificateGenerator() override;
 
   // |RTCCertificateGeneratorInterface| overrides.
   // If |expires_ms| is specified, the certificate will expire in approximately
@@ -82,6 +153,7 @@ class RTC_EXPORT RTCCertificateGenerator
  private:
   Thread* const signaling_thread_;
   Thread* const worker_thread_;
+  const scoped_refptr<RTCCertificatePool> pool_;
 };
 
 }  // namespace rtc
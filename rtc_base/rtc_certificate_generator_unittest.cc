@@ -141,4 +141,55 @@ TEST_F(RTCCertificateGeneratorTest, GenerateWithInvalidParamsShouldFail) {
   EXPECT_FALSE(fixture_->certificate());
 }
 
+TEST_F(RTCCertificateGeneratorTest, PoolRefillsInBackground) {
+  scoped_refptr<RTCCertificatePool> pool =
+      RTCCertificatePool::Create(2, {KeyParams::ECDSA()});
+  EXPECT_EQ_WAIT(2u, pool->ReadyCount(KeyParams::ECDSA()),
+                 kGenerationTimeoutMs);
+  EXPECT_TRUE(pool->Take(KeyParams::ECDSA()));
+  EXPECT_EQ_WAIT(2u, pool->ReadyCount(KeyParams::ECDSA()),
+                 kGenerationTimeoutMs);
+  RTCCertificatePool::Stats stats = pool->GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(0, stats.misses);
+  EXPECT_EQ(3, stats.generated);
+
+  // Other key params are pooled from their first miss on.
+  KeyParams rsa = KeyParams::RSA(1024);
+  EXPECT_FALSE(pool->Take(rsa));
+  EXPECT_EQ(1, pool->GetStats().misses);
+  EXPECT_EQ_WAIT(2u, pool->ReadyCount(rsa), kGenerationTimeoutMs);
+  EXPECT_EQ(2u, pool->ReadyCount(KeyParams::ECDSA()));
+
+  EXPECT_FALSE(pool->Take(KeyParams::RSA(0, 0)));
+  EXPECT_EQ(1, pool->GetStats().misses);
+}
+
+TEST_F(RTCCertificateGeneratorTest, GenerateAsyncFromPool) {
+  scoped_refptr<RTCCertificatePool> pool =
+      RTCCertificatePool::Create(1, {KeyParams::ECDSA()});
+  EXPECT_EQ_WAIT(1u, pool->ReadyCount(KeyParams::ECDSA()),
+                 kGenerationTimeoutMs);
+  std::unique_ptr<Thread> worker_thread = Thread::Create();
+  worker_thread->Start();
+  RTCCertificateGenerator generator(Thread::Current(), worker_thread.get(),
+                                    pool);
+
+  generator.GenerateCertificateAsync(KeyParams::ECDSA(), absl::nullopt,
+                                     fixture_);
+  // Completes asynchronously even when served from the pool.
+  EXPECT_FALSE(fixture_->GenerateAsyncCompleted());
+  EXPECT_TRUE_WAIT(fixture_->GenerateAsyncCompleted(), kGenerationTimeoutMs);
+  EXPECT_TRUE(fixture_->certificate());
+  EXPECT_EQ(1, pool->GetStats().hits);
+
+  // Requests for a specific expiration bypass the pool.
+  generator.GenerateCertificateAsync(KeyParams::ECDSA(), 60000, fixture_);
+  EXPECT_TRUE_WAIT(fixture_->GenerateAsyncCompleted(), kGenerationTimeoutMs);
+  EXPECT_TRUE(fixture_->certificate());
+  RTCCertificatePool::Stats stats = pool->GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(0, stats.misses);
+}
+
 }  // namespace rtc
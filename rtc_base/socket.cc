@@ -10,4 +10,52 @@
 
 #include "rtc_base/socket.h"
 
-namespace rtc {}  // namespace rtc
+#include "rtc_base/buffer.h"
+
+namespace rtc {
+
+int Socket::SendToBatch(const SendBatchEntry* entries, size_t count) {
+  size_t sent = 0;
+  for (; sent < count; ++sent) {
+    if (SendTo(entries[sent].data, entries[sent].length, entries[sent].addr) <
+        0) {
+      break;
+    }
+  }
+  if (sent == 0 && count > 0)
+    return SOCKET_ERROR;
+  return static_cast<int>(sent);
+}
+
+int Socket::SendV(const SendSegment* segments, size_t count) {
+  if (count == 1)
+    return Send(segments[0].data, segments[0].length);
+  Buffer buffer;
+  for (size_t i = 0; i < count; ++i)
+    buffer.AppendData(segments[i].data, segments[i].length);
+  return Send(buffer.data(), buffer.size());
+}
+
+int Socket::SendToV(const SendSegment* segments,
+                    size_t count,
+                    const SocketAddress& addr) {
+  if (count == 1)
+    return SendTo(segments[0].data, segments[0].length, addr);
+  Buffer buffer;
+  for (size_t i = 0; i < count; ++i)
+    buffer.AppendData(segments[i].data, segments[i].length);
+  return SendTo(buffer.data(), buffer.size(), addr);
+}
+
+int Socket::RecvFromBatch(RecvBatchEntry* entries, size_t count) {
+  if (count == 0)
+    return 0;
+  int len = RecvFrom(entries[0].buffer, entries[0].capacity, &entries[0].addr,
+                     &entries[0].timestamp);
+  if (len < 0)
+    return SOCKET_ERROR;
+  entries[0].length = static_cast<size_t>(len);
+  return 1;
+}
+
+}  // namespace rtc
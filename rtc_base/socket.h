@@ -122,6 +122,30 @@ inline bool IsBlockingError(int e) {
   return (e == EWOULDBLOCK) || (e == EAGAIN) || (e == EINPROGRESS);
 }
 
+// One datagram slot for Socket::RecvFromBatch(). The caller owns |buffer|;
+// the remaining fields are filled in for each datagram that was read.
+struct RecvBatchEntry {
+  char* buffer = nullptr;
+  size_t capacity = 0;
+  size_t length = 0;
+  SocketAddress addr;
+  // In units of microseconds, -1 if not available.
+  int64_t timestamp = -1;
+};
+
+// One datagram for Socket::SendToBatch().
+struct SendBatchEntry {
+  const char* data = nullptr;
+  size_t length = 0;
+  SocketAddress addr;
+};
+
+// One piece of the data passed to Socket::SendV().
+struct SendSegment {
+  const char* data = nullptr;
+  size_t length = 0;
+};
+
 // General interface for the socket implementations of various networks.  The
 // methods match those of normal UNIX sockets very closely.
 class Socket {
@@ -140,12 +164,34 @@ class Socket {
   virtual int Connect(const SocketAddress& addr) = 0;
   virtual int Send(const void* pv, size_t cb) = 0;
   virtual int SendTo(const void* pv, size_t cb, const SocketAddress& addr) = 0;
+  // Sends |count| datagrams with as few system calls as the implementation
+  // allows. Returns the number of leading entries that were sent, or
+  // SOCKET_ERROR if none could be sent. The default implementation calls
+  // SendTo() for each entry.
+  virtual int SendToBatch(const SendBatchEntry* entries, size_t count);
+  // Sends the |count| segments as if they were one buffer passed to Send(),
+  // with a single gathered write where the implementation allows. Returns
+  // what Send() would. The default implementation copies the segments into
+  // one buffer, so that sockets that transform the data, such as TLS
+  // adapters, still see it in one piece.
+  virtual int SendV(const SendSegment* segments, size_t count);
+  // Sends the |count| segments to |addr| as if they were one buffer passed to
+  // SendTo(), so that they form a single datagram on UDP sockets. The default
+  // implementation copies the segments into one buffer.
+  virtual int SendToV(const SendSegment* segments,
+                      size_t count,
+                      const SocketAddress& addr);
   // |timestamp| is in units of microseconds.
   virtual int Recv(void* pv, size_t cb, int64_t* timestamp) = 0;
   virtual int RecvFrom(void* pv,
                        size_t cb,
                        SocketAddress* paddr,
                        int64_t* timestamp) = 0;
+  // Reads up to |count| datagrams into |entries| with as few system calls as
+  // the implementation allows. Returns the number of entries filled in, or
+  // SOCKET_ERROR if not even the first datagram could be read. The default
+  // implementation reads a single datagram using RecvFrom().
+  virtual int RecvFromBatch(RecvBatchEntry* entries, size_t count);
   virtual int Listen(int backlog) = 0;
   virtual Socket* Accept(SocketAddress* paddr) = 0;
   virtual int Close() = 0;
@@ -166,6 +212,11 @@ class Socket {
     OPT_RTP_SENDTIME_EXTN_ID,  // This is a non-traditional socket option param.
                                // This is specific to libjingle and will be used
                                // if SendTime option is needed at socket level.
+    OPT_RECV_TIMESTAMP,        // Whether received datagrams are timestamped by
+                               // the kernel rather than when they are read.
+    OPT_REUSEPORT,             // Whether the socket may share its port with
+                               // other sockets that set this option, with the
+                               // kernel spreading incoming traffic among them.
   };
   virtual int GetOption(Option opt, int* value) = 0;
   virtual int SetOption(Option opt, int value) = 0;
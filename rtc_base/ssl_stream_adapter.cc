@@ -98,10 +98,16 @@ SSLStreamAdapter::SSLStreamAdapter(StreamInterface* stream)
 
 SSLStreamAdapter::~SSLStreamAdapter() {}
 
+void SSLStreamAdapter::EnableSessionResumption() {}
+
 bool SSLStreamAdapter::GetSslCipherSuite(int* cipher_suite) {
   return false;
 }
 
+bool SSLStreamAdapter::GetHandshakeStats(SSLHandshakeStats* stats) const {
+  return false;
+}
+
 bool SSLStreamAdapter::ExportKeyingMaterial(const std::string& label,
                                             const uint8_t* context,
                                             size_t context_len,
@@ -110,6 +110,20 @@ enum { SSE_MSG_TRUNC = 0xff0001 };
 // Used to send back UMA histogram value. Logged when Dtls handshake fails.
 enum class SSLHandshakeError { UNKNOWN, INCOMPATIBLE_CIPHERSUITE, MAX_VALUE };
 
+// Describes a completed handshake.
+struct SSLHandshakeStats {
+  // True if a previous session was resumed with an abbreviated handshake.
+  bool resumed = false;
+  // Number of handshake flights sent, not counting retransmissions.
+  int flights_sent = 0;
+  // Number of flights retransmitted after a DTLS timeout.
+  int retransmissions = 0;
+  // Time from the start of the handshake until it completed.
+  int64_t duration_ms = 0;
+  // CPU time this end spent in the handshake.
+  int64_t cpu_time_us = 0;
+};
+
 class SSLStreamAdapter : public StreamAdapterInterface {
  public:
   // Instantiate an SSLStreamAdapter wrapping the given stream,
@@ -147,6 +161,14 @@ class SSLStreamAdapter : public StreamAdapterInterface {
   // This should only be called before StartSSL().
   virtual void SetInitialRetransmissionTimeout(int timeout_ms) = 0;
 
+  // Lets DTLS associations resume the session of an earlier association with
+  // the same peer, and offer their own sessions for later resumption. Both
+  // ends must enable it. A session is only resumed if the peer presents the
+  // certificate of the signaled digest; as the client, the digest must be
+  // known when the handshake starts.
+  // This should only be called before StartSSL().
+  virtual void EnableSessionResumption();
+
   // StartSSL starts negotiation with a peer, whose certificate is verified
   // using the certificate digest. Generally, SetIdentity() and possibly
   // SetServerRole() should have been called before this.
@@ -189,6 +211,9 @@ class SSLStreamAdapter : public StreamAdapterInterface {
 
   virtual int GetSslVersion() const = 0;
 
+  // Retrieves statistics on the handshake, once it has completed.
+  virtual bool GetHandshakeStats(SSLHandshakeStats* stats) const;
+
   // Key Exporter interface from RFC 5705
   // Arguments are:
   // label               -- the exporter label.
@@ -883,6 +883,29 @@ class SSLStreamAdapterTestDTLS
     }
   }
 
+  // Replaces the streams with a new association between the given
+  // identities, as when a peer reconnects.
+  void Reconnect(rtc::SSLIdentity* client_identity,
+                 rtc::SSLIdentity* server_identity) {
+    client_ssl_.reset(nullptr);
+    server_ssl_.reset(nullptr);
+    // Drops what the old association sent when it was closed.
+    client_buffer_.Clear();
+    server_buffer_.Clear();
+
+    CreateStreams();
+    client_ssl_.reset(rtc::SSLStreamAdapter::Create(client_stream_));
+    server_ssl_.reset(rtc::SSLStreamAdapter::Create(server_stream_));
+    SSLStreamAdapterTestBase* base = this;
+    client_ssl_->SignalEvent.connect(base, &SSLStreamAdapterTestBase::OnEvent);
+    server_ssl_->SignalEvent.connect(base, &SSLStreamAdapterTestBase::OnEvent);
+    client_identity_ = client_identity;
+    server_identity_ = server_identity;
+    client_ssl_->SetIdentity(client_identity_);
+    server_ssl_->SetIdentity(server_identity_);
+    identities_set_ = false;
+  }
+
  private:
   BufferQueueStream client_buffer_;
   BufferQueueStream server_buffer_;
@@ -1332,6 +1355,61 @@ TEST_P(SSLStreamAdapterTestDTLS, TestDTLSExporter) {
   ASSERT_TRUE(!memcmp(client_out, server_out, sizeof(client_out)));
 }
 
+// Test that a reconnection resumes the session of the first association.
+TEST_P(SSLStreamAdapterTestDTLS, TestDTLSSessionResumption) {
+  SetupProtocolVersions(rtc::SSL_PROTOCOL_DTLS_12, rtc::SSL_PROTOCOL_DTLS_12);
+  client_ssl_->EnableSessionResumption();
+  server_ssl_->EnableSessionResumption();
+  TestHandshake();
+
+  rtc::SSLHandshakeStats client_stats;
+  rtc::SSLHandshakeStats server_stats;
+  ASSERT_TRUE(client_ssl_->GetHandshakeStats(&client_stats));
+  ASSERT_TRUE(server_ssl_->GetHandshakeStats(&server_stats));
+  EXPECT_FALSE(client_stats.resumed);
+  EXPECT_FALSE(server_stats.resumed);
+  // ClientHello, then Certificate to Finished; ServerHello to
+  // ServerHelloDone, then NewSessionTicket to Finished.
+  EXPECT_EQ(2, client_stats.flights_sent);
+  EXPECT_EQ(2, server_stats.flights_sent);
+  EXPECT_EQ(0, client_stats.retransmissions);
+
+  Reconnect(client_identity_->GetReference(),
+            server_identity_->GetReference());
+  SetupProtocolVersions(rtc::SSL_PROTOCOL_DTLS_12, rtc::SSL_PROTOCOL_DTLS_12);
+  client_ssl_->EnableSessionResumption();
+  server_ssl_->EnableSessionResumption();
+  TestHandshake();
+
+  ASSERT_TRUE(client_ssl_->GetHandshakeStats(&client_stats));
+  ASSERT_TRUE(server_ssl_->GetHandshakeStats(&server_stats));
+  EXPECT_TRUE(client_stats.resumed);
+  EXPECT_TRUE(server_stats.resumed);
+  // The peer certificates come from the resumed session.
+  EXPECT_TRUE(GetPeerCertificate(true));
+  EXPECT_TRUE(GetPeerCertificate(false));
+  TestTransfer(100);
+}
+
+// Test that a session is not resumed with a peer of another certificate.
+TEST_P(SSLStreamAdapterTestDTLS, TestDTLSSessionNotResumedWithOtherPeer) {
+  client_ssl_->EnableSessionResumption();
+  server_ssl_->EnableSessionResumption();
+  TestHandshake();
+
+  // A new server identity changes the expected fingerprint.
+  rtc::SSLIdentity* server_identity =
+      rtc::SSLIdentity::Generate("server", ::testing::get<1>(GetParam()));
+  Reconnect(client_identity_->GetReference(), server_identity);
+  client_ssl_->EnableSessionResumption();
+  server_ssl_->EnableSessionResumption();
+  TestHandshake();
+
+  rtc::SSLHandshakeStats client_stats;
+  ASSERT_TRUE(client_ssl_->GetHandshakeStats(&client_stats));
+  EXPECT_FALSE(client_stats.resumed);
+}
+
 // Test not yet valid certificates are not rejected.
 TEST_P(SSLStreamAdapterTestDTLS, TestCertNotYetValid) {
   long one_day = 60 * 60 * 24;
@@ -0,0 +1,306 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_latency_stats.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+
+namespace rtc {
+namespace {
+
+// Number of queues, tasks and blocking call sites listed in a report.
+constexpr size_t kMaxReportedQueues = 10;
+constexpr size_t kMaxReportedTasks = 10;
+constexpr size_t kMaxReportedInvokes = 10;
+
+std::atomic<int64_t> report_interval_us{0};
+std::atomic<int64_t> next_report_us{0};
+
+// All live instances, so that reports can cover every queue.
+struct Registry {
+  CriticalSection lock;
+  std::vector<TaskLatencyStats*> stats RTC_GUARDED_BY(lock);
+  std::map<std::string, TaskLatencyStats::Histogram> blocking_invokes
+      RTC_GUARDED_BY(lock);
+};
+
+Registry* GetRegistry() {
+  static Registry* const registry = new Registry();
+  return registry;
+}
+
+int64_t CombinedUs(const TaskLatencyStats::Offender& offender) {
+  return offender.wait_us + offender.run_us;
+}
+
+class TrackedTask : public webrtc::QueuedTask {
+ public:
+  TrackedTask(std::unique_ptr<webrtc::QueuedTask> task,
+              TaskLatencyStats* stats,
+              int64_t ready_us)
+      : task_(std::move(task)), stats_(stats), ready_us_(ready_us) {}
+
+ private:
+  bool Run() override {
+    int64_t started_us = TimeMicros();
+    webrtc::QueuedTask* task = task_.release();
+    if (task->Run())
+      delete task;
+    stats_->RecordTask(ready_us_, started_us, TimeMicros(), nullptr);
+    return true;
+  }
+
+  std::unique_ptr<webrtc::QueuedTask> task_;
+  // The task runs on the queue owning |stats_|, so it outlives the task.
+  TaskLatencyStats* const stats_;
+  const int64_t ready_us_;
+};
+
+// Logs the call sites that blocked their threads the longest in total.
+void LogBlockingInvokes(
+    std::vector<TaskLatencyStats::BlockingInvoke>* invokes) {
+  if (invokes->empty())
+    return;
+  size_t reported = std::min(invokes->size(), kMaxReportedInvokes);
+  std::partial_sort(invokes->begin(), invokes->begin() + reported,
+                    invokes->end(),
+                    [](const TaskLatencyStats::BlockingInvoke& a,
+                       const TaskLatencyStats::BlockingInvoke& b) {
+                      return a.blocked.sum_us > b.blocked.sum_us;
+                    });
+  RTC_LOG(LS_INFO) << "Blocking invokes from " << invokes->size()
+                   << " call sites, p50/p99/max in us:";
+  for (size_t i = 0; i < reported; ++i) {
+    const TaskLatencyStats::Histogram& blocked = (*invokes)[i].blocked;
+    RTC_LOG(LS_INFO) << "  " << (*invokes)[i].posted_from << ": "
+                     << blocked.count << " calls, blocked "
+                     << blocked.sum_us << " us, " << blocked.Percentile(50)
+                     << "/" << blocked.Percentile(99) << "/"
+                     << blocked.max_us;
+  }
+}
+
+}  // namespace
+
+std::atomic<bool> TaskLatencyStats::enabled_{false};
+
+void TaskLatencyStats::Histogram::Add(int64_t value_us) {
+  int bucket = 0;
+  while (bucket < kNumBuckets - 1 && (int64_t{1} << bucket) <= value_us)
+    ++bucket;
+  ++buckets[bucket];
+  ++count;
+  sum_us += value_us;
+  max_us = std::max(max_us, value_us);
+}
+
+int64_t TaskLatencyStats::Histogram::Percentile(int percentile) const {
+  RTC_DCHECK_GE(percentile, 0);
+  RTC_DCHECK_LE(percentile, 100);
+  if (count == 0)
+    return 0;
+  int64_t rank = std::max<int64_t>(1, (count * percentile + 99) / 100);
+  int64_t seen = 0;
+  for (int i = 0; i < kNumBuckets - 1; ++i) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return std::min(int64_t{1} << i, max_us);
+  }
+  return max_us;
+}
+
+// static
+void TaskLatencyStats::Enable(int64_t report_interval_ms) {
+  RTC_DCHECK_GE(report_interval_ms, 0);
+  report_interval_us.store(report_interval_ms * kNumMicrosecsPerMillisec);
+  next_report_us.store(TimeMicros() +
+                       report_interval_ms * kNumMicrosecsPerMillisec);
+  enabled_.store(true);
+}
+
+// static
+void TaskLatencyStats::Disable() {
+  enabled_.store(false);
+}
+
+// static
+void TaskLatencyStats::LogReport() {
+  std::vector<Snapshot> snapshots;
+  std::vector<BlockingInvoke> invokes;
+  {
+    Registry* registry = GetRegistry();
+    CritScope lock(&registry->lock);
+    for (TaskLatencyStats* stats : registry->stats) {
+      Snapshot snapshot = stats->TakeSnapshot();
+      if (snapshot.wait.count > 0)
+        snapshots.push_back(std::move(snapshot));
+    }
+    for (auto& entry : registry->blocking_invokes)
+      invokes.push_back({entry.first, entry.second});
+    registry->blocking_invokes.clear();
+  }
+  LogBlockingInvokes(&invokes);
+  if (snapshots.empty())
+    return;
+
+  std::sort(snapshots.begin(), snapshots.end(),
+            [](const Snapshot& a, const Snapshot& b) {
+              return a.wait.Percentile(99) > b.wait.Percentile(99);
+            });
+  RTC_LOG(LS_INFO) << "Task latency of " << snapshots.size()
+                   << " busy queues, p50/p99/max in us:";
+  for (size_t i = 0; i < std::min(snapshots.size(), kMaxReportedQueues); ++i) {
+    const Snapshot& s = snapshots[i];
+    RTC_LOG(LS_INFO) << "  " << s.queue_name << ": " << s.wait.count
+                     << " tasks, waited " << s.wait.Percentile(50) << "/"
+                     << s.wait.Percentile(99) << "/" << s.wait.max_us
+                     << ", ran " << s.run.Percentile(50) << "/"
+                     << s.run.Percentile(99) << "/" << s.run.max_us;
+  }
+
+  std::vector<std::pair<const Snapshot*, Offender>> offenders;
+  for (const Snapshot& s : snapshots) {
+    for (const Offender& offender : s.offenders)
+      offenders.emplace_back(&s, offender);
+  }
+  size_t reported = std::min(offenders.size(), kMaxReportedTasks);
+  std::partial_sort(
+      offenders.begin(), offenders.begin() + reported, offenders.end(),
+      [](const std::pair<const Snapshot*, Offender>& a,
+         const std::pair<const Snapshot*, Offender>& b) {
+        return CombinedUs(a.second) > CombinedUs(b.second);
+      });
+  RTC_LOG(LS_INFO) << "Slowest tasks:";
+  for (size_t i = 0; i < reported; ++i) {
+    const Offender& offender = offenders[i].second;
+    RTC_LOG(LS_INFO) << "  " << offenders[i].first->queue_name << " "
+                     << (offender.posted_from ? offender.posted_from : "-")
+                     << ": waited " << offender.wait_us << " us, ran "
+                     << offender.run_us << " us";
+  }
+}
+
+// static
+void TaskLatencyStats::RecordBlockingInvoke(const char* posted_from,
+                                            int64_t blocked_us) {
+  if (!IsEnabled())
+    return;
+  {
+    Registry* registry = GetRegistry();
+    CritScope lock(&registry->lock);
+    registry->blocking_invokes[posted_from].Add(blocked_us);
+  }
+  MaybeLogReport(TimeMicros());
+}
+
+// static
+std::vector<TaskLatencyStats::BlockingInvoke>
+TaskLatencyStats::GetBlockingInvokes() {
+  std::vector<BlockingInvoke> invokes;
+  Registry* registry = GetRegistry();
+  CritScope lock(&registry->lock);
+  for (const auto& entry : registry->blocking_invokes)
+    invokes.push_back({entry.first, entry.second});
+  return invokes;
+}
+
+TaskLatencyStats::TaskLatencyStats(absl::string_view queue_name) {
+  stats_.queue_name = std::string(queue_name);
+  Registry* registry = GetRegistry();
+  CritScope lock(&registry->lock);
+  registry->stats.push_back(this);
+}
+
+TaskLatencyStats::~TaskLatencyStats() {
+  Registry* registry = GetRegistry();
+  CritScope lock(&registry->lock);
+  auto it = std::find(registry->stats.begin(), registry->stats.end(), this);
+  RTC_DCHECK(it != registry->stats.end());
+  registry->stats.erase(it);
+}
+
+void TaskLatencyStats::set_queue_name(absl::string_view queue_name) {
+  CritScope lock(&lock_);
+  stats_.queue_name = std::string(queue_name);
+}
+
+void TaskLatencyStats::RecordTask(int64_t ready_us,
+                                  int64_t started_us,
+                                  int64_t finished_us,
+                                  const char* posted_from) {
+  if (ready_us == 0 || !IsEnabled())
+    return;
+  Offender task;
+  task.posted_from = posted_from;
+  // A message posted for a time that has passed is due at once.
+  task.wait_us = std::max<int64_t>(0, started_us - ready_us);
+  task.run_us = finished_us - started_us;
+  {
+    CritScope lock(&lock_);
+    stats_.wait.Add(task.wait_us);
+    stats_.run.Add(task.run_us);
+    std::vector<Offender>& offenders = stats_.offenders;
+    if (offenders.size() < kMaxOffenders ||
+        CombinedUs(task) > CombinedUs(offenders.back())) {
+      if (offenders.size() == kMaxOffenders)
+        offenders.pop_back();
+      offenders.insert(
+          std::upper_bound(offenders.begin(), offenders.end(), task,
+                           [](const Offender& a, const Offender& b) {
+                             return CombinedUs(a) > CombinedUs(b);
+                           }),
+          task);
+    }
+  }
+  MaybeLogReport(finished_us);
+}
+
+TaskLatencyStats::Snapshot TaskLatencyStats::GetSnapshot() const {
+  CritScope lock(&lock_);
+  return stats_;
+}
+
+std::unique_ptr<webrtc::QueuedTask> TaskLatencyStats::WrapTask(
+    std::unique_ptr<webrtc::QueuedTask> task,
+    uint32_t delay_ms) {
+  return std::make_unique<TrackedTask>(
+      std::move(task), this,
+      TimeMicros() + int64_t{delay_ms} * kNumMicrosecsPerMillisec);
+}
+
+TaskLatencyStats::Snapshot TaskLatencyStats::TakeSnapshot() {
+  CritScope lock(&lock_);
+  Snapshot snapshot = std::move(stats_);
+  stats_ = Snapshot();
+  stats_.queue_name = snapshot.queue_name;
+  return snapshot;
+}
+
+// static
+void TaskLatencyStats::MaybeLogReport(int64_t now_us) {
+  int64_t interval_us = report_interval_us.load(std::memory_order_relaxed);
+  if (interval_us == 0)
+    return;
+  int64_t next_us = next_report_us.load(std::memory_order_relaxed);
+  if (now_us < next_us)
+    return;
+  // Only the thread that moves the deadline reports.
+  if (!next_report_us.compare_exchange_strong(next_us, now_us + interval_us))
+    return;
+  LogReport();
+}
+
+}  // namespace rtc
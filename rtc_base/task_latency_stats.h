@@ -0,0 +1,148 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_TASK_LATENCY_STATS_H_
+#define RTC_BASE_TASK_LATENCY_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "api/task_queue/queued_task.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace rtc {
+
+// Opt-in accounting of how long tasks wait on a task queue or thread before
+// they run, and how long they run. Every TaskQueueBase implementation and
+// MessageQueue own one instance. Recording is off by default; while it is
+// off, posting a task costs one relaxed atomic load more, so that it can be
+// left compiled in, and turned on in production.
+//
+// Recorded samples go into per-queue histograms with power of two buckets,
+// and the slowest tasks of every queue are kept along with where they were
+// posted from, when known. The time threads spend blocked in
+// Thread::Invoke() is recorded per call site as well. Once per report
+// interval the queues whose tasks waited the longest, the slowest tasks and
+// the most costly blocking invokes are logged, and the statistics start
+// over.
+class TaskLatencyStats {
+ public:
+  // Bucket i counts samples below 2^i us, the last bucket all larger ones.
+  static constexpr int kNumBuckets = 25;
+  // Number of slowest tasks kept per queue and interval.
+  static constexpr size_t kMaxOffenders = 5;
+
+  struct Histogram {
+    int64_t count = 0;
+    int64_t sum_us = 0;
+    int64_t max_us = 0;
+    int64_t buckets[kNumBuckets] = {};
+
+    void Add(int64_t value_us);
+    // Returns an upper bound of the |percentile|th percentile, in us, or 0
+    // if there are no samples.
+    int64_t Percentile(int percentile) const;
+  };
+
+  struct Offender {
+    // "file:line" of the posting site, or null for tasks posted through
+    // TaskQueueBase, whose API does not carry one.
+    const char* posted_from = nullptr;
+    int64_t wait_us = 0;
+    int64_t run_us = 0;
+  };
+
+  struct Snapshot {
+    std::string queue_name;
+    Histogram wait;
+    Histogram run;
+    // Slowest first, by wait and run time combined.
+    std::vector<Offender> offenders;
+  };
+
+  struct BlockingInvoke {
+    // "file:line" of the Thread::Invoke() call.
+    std::string posted_from;
+    Histogram blocked;
+  };
+
+  // Turns recording on for all queues. Unless |report_interval_ms| is 0, a
+  // report is logged whenever a task finishes and the previous one is more
+  // than |report_interval_ms| old, on the thread that ran the task.
+  static void Enable(int64_t report_interval_ms);
+  static void Disable();
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Logs the statistics of all queues since the last report, and starts
+  // over.
+  static void LogReport();
+
+  // Records that a thread was blocked for |blocked_us| in a synchronous call
+  // to another thread, made at |posted_from|.
+  static void RecordBlockingInvoke(const char* posted_from,
+                                   int64_t blocked_us);
+  // Returns the blocking invokes since the last report, by call site.
+  static std::vector<BlockingInvoke> GetBlockingInvokes();
+
+  explicit TaskLatencyStats(absl::string_view queue_name);
+  ~TaskLatencyStats();
+
+  void set_queue_name(absl::string_view queue_name);
+
+  // Returns |task|, or while recording is enabled, a task that runs it and
+  // records into this object. |delay_ms| is the delay the task is posted
+  // with; the time it waits is counted from when it is due.
+  std::unique_ptr<webrtc::QueuedTask> TrackTask(
+      std::unique_ptr<webrtc::QueuedTask> task,
+      uint32_t delay_ms = 0) {
+    if (!IsEnabled())
+      return task;
+    return WrapTask(std::move(task), delay_ms);
+  }
+
+  // Records a task that became ready to run at |ready_us|, and ran from
+  // |started_us| to |finished_us|. Samples with a |ready_us| of 0, taken
+  // while recording was disabled, are ignored. Must be called on the queue's
+  // thread.
+  void RecordTask(int64_t ready_us,
+                  int64_t started_us,
+                  int64_t finished_us,
+                  const char* posted_from);
+
+  // Returns the statistics since the last report.
+  Snapshot GetSnapshot() const;
+
+ private:
+  std::unique_ptr<webrtc::QueuedTask> WrapTask(
+      std::unique_ptr<webrtc::QueuedTask> task,
+      uint32_t delay_ms);
+  Snapshot TakeSnapshot();
+  static void MaybeLogReport(int64_t now_us);
+
+  static std::atomic<bool> enabled_;
+
+  CriticalSection lock_;
+  Snapshot stats_ RTC_GUARDED_BY(lock_);
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(TaskLatencyStats);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_TASK_LATENCY_STATS_H_
@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_latency_stats.h"
+
+#include <memory>
+#include <vector>
+
+#include "api/task_queue/queued_task.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+class ScopedEnableLatencyStats {
+ public:
+  ScopedEnableLatencyStats() { TaskLatencyStats::Enable(0); }
+  ~ScopedEnableLatencyStats() { TaskLatencyStats::Disable(); }
+};
+
+TEST(TaskLatencyStatsTest, HistogramPercentiles) {
+  TaskLatencyStats::Histogram histogram;
+  EXPECT_EQ(0, histogram.Percentile(50));
+  for (int i = 0; i < 99; ++i)
+    histogram.Add(3);
+  histogram.Add(1000);
+  EXPECT_EQ(100, histogram.count);
+  EXPECT_EQ(1000, histogram.max_us);
+  EXPECT_EQ(4, histogram.Percentile(50));
+  EXPECT_EQ(4, histogram.Percentile(99));
+  EXPECT_EQ(1000, histogram.Percentile(100));
+}
+
+TEST(TaskLatencyStatsTest, RecordsNothingWhileDisabled) {
+  TaskLatencyStats stats("Queue");
+  stats.RecordTask(/*ready_us=*/10, /*started_us=*/20, /*finished_us=*/30,
+                   "file.cc:1");
+
+  std::unique_ptr<webrtc::QueuedTask> task =
+      webrtc::ToQueuedTask([] {});
+  webrtc::QueuedTask* raw_task = task.get();
+  EXPECT_EQ(raw_task, stats.TrackTask(std::move(task)).get());
+  EXPECT_EQ(0, stats.GetSnapshot().wait.count);
+}
+
+TEST(TaskLatencyStatsTest, KeepsSlowestTasks) {
+  ScopedEnableLatencyStats enable;
+  TaskLatencyStats stats("Queue");
+  for (int i = 1; i <= 10; ++i) {
+    stats.RecordTask(/*ready_us=*/1000, /*started_us=*/1000 + i * 10,
+                     /*finished_us=*/1000 + i * 11, "file.cc:1");
+  }
+  // Skipped, since it was posted while recording was disabled.
+  stats.RecordTask(/*ready_us=*/0, 1000, 2000, "file.cc:2");
+
+  TaskLatencyStats::Snapshot snapshot = stats.GetSnapshot();
+  EXPECT_EQ("Queue", snapshot.queue_name);
+  EXPECT_EQ(10, snapshot.wait.count);
+  EXPECT_EQ(100, snapshot.wait.max_us);
+  EXPECT_EQ(10, snapshot.run.max_us);
+  ASSERT_EQ(TaskLatencyStats::kMaxOffenders, snapshot.offenders.size());
+  EXPECT_EQ(100, snapshot.offenders.front().wait_us);
+  EXPECT_EQ(60, snapshot.offenders.back().wait_us);
+  EXPECT_STREQ("file.cc:1", snapshot.offenders.front().posted_from);
+}
+
+TEST(TaskLatencyStatsTest, TrackedTaskRecordsWhenRun) {
+  ScopedEnableLatencyStats enable;
+  TaskLatencyStats stats("Queue");
+  bool ran = false;
+  std::unique_ptr<webrtc::QueuedTask> task =
+      stats.TrackTask(webrtc::ToQueuedTask([&ran] { ran = true; }));
+  EXPECT_EQ(0, stats.GetSnapshot().wait.count);
+
+  // Queues delete tasks whose Run() returns true.
+  EXPECT_TRUE(task->Run());
+  EXPECT_TRUE(ran);
+  TaskLatencyStats::Snapshot snapshot = stats.GetSnapshot();
+  EXPECT_EQ(1, snapshot.wait.count);
+  ASSERT_EQ(1u, snapshot.offenders.size());
+  EXPECT_EQ(nullptr, snapshot.offenders[0].posted_from);
+}
+
+TEST(TaskLatencyStatsTest, ReportStartsOver) {
+  ScopedEnableLatencyStats enable;
+  TaskLatencyStats stats("Queue");
+  stats.RecordTask(/*ready_us=*/1000, /*started_us=*/1500,
+                   /*finished_us=*/1600, "file.cc:1");
+  TaskLatencyStats::LogReport();
+  TaskLatencyStats::Snapshot snapshot = stats.GetSnapshot();
+  EXPECT_EQ("Queue", snapshot.queue_name);
+  EXPECT_EQ(0, snapshot.wait.count);
+  EXPECT_TRUE(snapshot.offenders.empty());
+}
+
+TEST(TaskLatencyStatsTest, RecordsBlockingInvokesPerCallSite) {
+  TaskLatencyStats::RecordBlockingInvoke("file.cc:1", 100);
+  EXPECT_TRUE(TaskLatencyStats::GetBlockingInvokes().empty());
+
+  ScopedEnableLatencyStats enable;
+  TaskLatencyStats::RecordBlockingInvoke("file.cc:1", 100);
+  TaskLatencyStats::RecordBlockingInvoke("file.cc:1", 300);
+  TaskLatencyStats::RecordBlockingInvoke("file.cc:2", 50);
+  std::vector<TaskLatencyStats::BlockingInvoke> invokes =
+      TaskLatencyStats::GetBlockingInvokes();
+  ASSERT_EQ(2u, invokes.size());
+  EXPECT_EQ("file.cc:1", invokes[0].posted_from);
+  EXPECT_EQ(2, invokes[0].blocked.count);
+  EXPECT_EQ(400, invokes[0].blocked.sum_us);
+  EXPECT_EQ(300, invokes[0].blocked.max_us);
+  EXPECT_EQ("file.cc:2", invokes[1].posted_from);
+
+  TaskLatencyStats::LogReport();
+  EXPECT_TRUE(TaskLatencyStats::GetBlockingInvokes().empty());
+}
+
+}  // namespace
+}  // namespace rtc
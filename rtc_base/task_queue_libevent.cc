@@ -33,6 +33,7 @@
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/platform_thread.h"
 #include "rtc_base/platform_thread_types.h"
+#include "rtc_base/task_latency_stats.h"
 #include "rtc_base/thread_annotations.h"
 #include "rtc_base/time_utils.h"
 
@@ -133,6 +134,7 @@ class TaskQueueLibevent final : public TaskQueueBase {
   std::list<std::unique_ptr<QueuedTask>> pending_ RTC_GUARDED_BY(pending_lock_);
   // Holds a list of events pending timers for cleanup when the loop exits.
   std::list<TimerEvent*> pending_timers_;
+  rtc::TaskLatencyStats latency_stats_;
 };
 
 struct TaskQueueLibevent::TimerEvent {
@@ -171,7 +173,8 @@ class TaskQueueLibevent::SetTimerTask : public QueuedTask {
 TaskQueueLibevent::TaskQueueLibevent(absl::string_view queue_name,
                                      rtc::ThreadPriority priority)
     : event_base_(event_base_new()),
-      thread_(&TaskQueueLibevent::ThreadMain, this, queue_name, priority) {
+      thread_(&TaskQueueLibevent::ThreadMain, this, queue_name, priority),
+      latency_stats_(queue_name) {
   int fds[2];
   RTC_CHECK(pipe(fds) == 0);
   SetNonBlocking(fds[0]);
@@ -213,6 +216,7 @@ void TaskQueueLibevent::Delete() {
 }
 
 void TaskQueueLibevent::PostTask(std::unique_ptr<QueuedTask> task) {
+  task = latency_stats_.TrackTask(std::move(task));
   QueuedTask* task_id = task.get();  // Only used for comparison.
   {
     rtc::CritScope lock(&pending_lock_);
@@ -231,7 +235,10 @@ void TaskQueueLibevent::PostTask(std::unique_ptr<QueuedTask> task) {
 void TaskQueueLibevent::PostDelayedTask(std::unique_ptr<QueuedTask> task,
                                         uint32_t milliseconds) {
   if (IsCurrent()) {
-    TimerEvent* timer = new TimerEvent(this, std::move(task));
+    // Tasks posted from other threads get here through SetTimerTask, and are
+    // tracked from here on, with the remaining delay.
+    TimerEvent* timer = new TimerEvent(
+        this, latency_stats_.TrackTask(std::move(task), milliseconds));
     EventAssign(&timer->ev, event_base_, -1, 0, &TaskQueueLibevent::RunTimer,
                 timer);
     pending_timers_.push_back(timer);
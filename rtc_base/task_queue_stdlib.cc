@@ -13,9 +13,9 @@
 #include <string.h>
 
 #include <algorithm>
-#include <map>
+#include <atomic>
+#include <deque>
 #include <memory>
-#include <queue>
 #include <utility>
 
 #include "absl/strings/string_view.h"
@@ -25,9 +25,12 @@
 #include "rtc_base/critical_section.h"
 #include "rtc_base/event.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/mpsc_queue.h"
 #include "rtc_base/platform_thread.h"
+#include "rtc_base/task_latency_stats.h"
 #include "rtc_base/thread_annotations.h"
 #include "rtc_base/time_utils.h"
+#include "rtc_base/timer_wheel.h"
 
 namespace webrtc {
 namespace {
@@ -50,7 +53,7 @@ rtc::ThreadPriority TaskQueuePriorityToThreadPriority(
 class TaskQueueStdlib final : public TaskQueueBase {
  public:
   TaskQueueStdlib(absl::string_view queue_name, rtc::ThreadPriority priority);
-  ~TaskQueueStdlib() override = default;
+  ~TaskQueueStdlib() override;
 
   void Delete() override;
   void PostTask(std::unique_ptr<QueuedTask> task) override;
@@ -60,14 +63,9 @@ class TaskQueueStdlib final : public TaskQueueBase {
  private:
   using OrderId = uint64_t;
 
-  struct DelayedEntryTimeout {
-    int64_t next_fire_at_ms_{};
+  struct PendingTask : public rtc::MpscQueue<PendingTask>::Node {
     OrderId order_{};
-
-    bool operator<(const DelayedEntryTimeout& o) const {
-      return std::tie(next_fire_at_ms_, order_) <
-             std::tie(o.next_fire_at_ms_, o.order_);
-    }
+    std::unique_ptr<QueuedTask> run_task_;
   };
 
   struct NextTask {
@@ -104,21 +102,32 @@ class TaskQueueStdlib final : public TaskQueueBase {
 
   // Holds the next order to use for the next task to be
   // put into one of the pending queues.
-  OrderId thread_posting_order_ RTC_GUARDED_BY(pending_lock_){};
+  std::atomic<OrderId> thread_posting_order_{0};
 
   // The list of all pending tasks that need to be processed in the
-  // FIFO queue ordering on the worker thread.
-  std::queue<std::pair<OrderId, std::unique_ptr<QueuedTask>>> pending_queue_
-      RTC_GUARDED_BY(pending_lock_);
+  // FIFO queue ordering on the worker thread. Posted to without a lock.
+  rtc::MpscQueue<PendingTask> pending_queue_;
+
+  // The task taken off |pending_queue_| that is next in line. Only used on
+  // the worker thread.
+  std::unique_ptr<PendingTask> next_pending_task_;
+
+  // Set while the worker thread waits on |flag_notify_|, or is about to.
+  // PostTask() only signals |flag_notify_| when it is set.
+  std::atomic<bool> thread_sleeping_{false};
 
   // The list of all pending tasks that need to be processed at a future
   // time based upon a delay. On the off change the delayed task should
   // happen at exactly the same time interval as another task then the
-  // task is processed based on FIFO ordering. std::priority_queue was
-  // considered but rejected due to its inability to extract the
-  // std::unique_ptr out of the queue without the presence of a hack.
-  std::map<DelayedEntryTimeout, std::unique_ptr<QueuedTask>> delayed_queue_
-      RTC_GUARDED_BY(pending_lock_);
+  // task is processed based on FIFO ordering.
+  rtc::TimerWheel<std::pair<OrderId, std::unique_ptr<QueuedTask>>>
+      delayed_queue_ RTC_GUARDED_BY(pending_lock_);
+
+  // Delayed tasks whose time has come, in the order they are to run.
+  std::deque<std::pair<OrderId, std::unique_ptr<QueuedTask>>>
+      expired_delayed_queue_ RTC_GUARDED_BY(pending_lock_);
+
+  rtc::TaskLatencyStats latency_stats_;
 };
 
 TaskQueueStdlib::TaskQueueStdlib(absl::string_view queue_name,
@@ -126,11 +135,18 @@ TaskQueueStdlib::TaskQueueStdlib(absl::string_view queue_name,
     : started_(/*manual_reset=*/false, /*initially_signaled=*/false),
       stopped_(/*manual_reset=*/false, /*initially_signaled=*/false),
       flag_notify_(/*manual_reset=*/false, /*initially_signaled=*/false),
-      thread_(&TaskQueueStdlib::ThreadMain, this, queue_name, priority) {
+      thread_(&TaskQueueStdlib::ThreadMain, this, queue_name, priority),
+      latency_stats_(queue_name) {
   thread_.Start();
   started_.Wait(rtc::Event::kForever);
 }
 
+TaskQueueStdlib::~TaskQueueStdlib() {
+  // The worker thread has stopped, so this thread may act as the consumer.
+  while (PendingTask* pending = pending_queue_.Pop())
+    delete pending;
+}
+
 void TaskQueueStdlib::Delete() {
   RTC_DCHECK(!IsCurrent());
 
@@ -147,28 +163,32 @@ void TaskQueueStdlib::Delete() {
 }
 
 void TaskQueueStdlib::PostTask(std::unique_ptr<QueuedTask> task) {
-  {
-    rtc::CritScope lock(&pending_lock_);
-    OrderId order = thread_posting_order_++;
-
-    pending_queue_.push(std::pair<OrderId, std::unique_ptr<QueuedTask>>(
-        order, std::move(task)));
-  }
-
-  NotifyWake();
+  PendingTask* pending = new PendingTask();
+  pending->order_ =
+      thread_posting_order_.fetch_add(1, std::memory_order_relaxed);
+  pending->run_task_ = latency_stats_.TrackTask(std::move(task));
+  pending_queue_.Push(pending);
+
+  // A busy worker thread picks the task up without being woken, which saves
+  // locking and signaling |flag_notify_|. Only the first poster to see the
+  // thread asleep wakes it.
+  if (thread_sleeping_.exchange(false))
+    NotifyWake();
 }
 
 void TaskQueueStdlib::PostDelayedTask(std::unique_ptr<QueuedTask> task,
                                       uint32_t milliseconds) {
-  auto fire_at = rtc::TimeMillis() + milliseconds;
-
-  DelayedEntryTimeout delay;
-  delay.next_fire_at_ms_ = fire_at;
+  auto now = rtc::TimeMillis();
+  auto fire_at = now + milliseconds;
 
   {
     rtc::CritScope lock(&pending_lock_);
-    delay.order_ = ++thread_posting_order_;
-    delayed_queue_[delay] = std::move(task);
+    OrderId order =
+        thread_posting_order_.fetch_add(1, std::memory_order_relaxed);
+    delayed_queue_.Insert(
+        now, fire_at,
+        std::pair<OrderId, std::unique_ptr<QueuedTask>>(
+            order, latency_stats_.TrackTask(std::move(task), milliseconds)));
   }
 
   NotifyWake();
@@ -186,34 +206,32 @@ TaskQueueStdlib::NextTask TaskQueueStdlib::GetNextTask() {
     return result;
   }
 
-  if (delayed_queue_.size() > 0) {
-    auto delayed_entry = delayed_queue_.begin();
-    const auto& delay_info = delayed_entry->first;
-    auto& delay_run = delayed_entry->second;
-    if (tick >= delay_info.next_fire_at_ms_) {
-      if (pending_queue_.size() > 0) {
-        auto& entry = pending_queue_.front();
-        auto& entry_order = entry.first;
-        auto& entry_run = entry.second;
-        if (entry_order < delay_info.order_) {
-          result.run_task_ = std::move(entry_run);
-          pending_queue_.pop();
-          return result;
-        }
-      }
+  if (!next_pending_task_)
+    next_pending_task_.reset(pending_queue_.Pop());
+
+  delayed_queue_.Advance(tick, &expired_delayed_queue_);
 
-      result.run_task_ = std::move(delay_run);
-      delayed_queue_.erase(delayed_entry);
-      return result;
+  if (expired_delayed_queue_.size() > 0) {
+    auto& delayed_entry = expired_delayed_queue_.front();
+    if (next_pending_task_) {
+      if (next_pending_task_->order_ < delayed_entry.first) {
+        result.run_task_ = std::move(next_pending_task_->run_task_);
+        next_pending_task_.reset();
+        return result;
+      }
     }
 
-    result.sleep_time_ms_ = delay_info.next_fire_at_ms_ - tick;
+    result.run_task_ = std::move(delayed_entry.second);
+    expired_delayed_queue_.pop_front();
+    return result;
   }
 
-  if (pending_queue_.size() > 0) {
-    auto& entry = pending_queue_.front();
-    result.run_task_ = std::move(entry.second);
-    pending_queue_.pop();
+  if (delayed_queue_.size() > 0)
+    result.sleep_time_ms_ = delayed_queue_.EarliestTrigger() - tick;
+
+  if (next_pending_task_) {
+    result.run_task_ = std::move(next_pending_task_->run_task_);
+    next_pending_task_.reset();
   }
 
   return result;
@@ -245,10 +263,20 @@ void TaskQueueStdlib::ProcessTasks() {
       continue;
     }
 
+    // Tell posters to wake this thread before looking at the queue a last
+    // time. A task posted in between is either seen here, or its poster sees
+    // |thread_sleeping_| and signals |flag_notify_|.
+    thread_sleeping_.store(true);
+    if (!pending_queue_.empty()) {
+      thread_sleeping_.store(false, std::memory_order_relaxed);
+      continue;
+    }
+
     if (0 == task.sleep_time_ms_)
       flag_notify_.Wait(rtc::Event::kForever);
     else
       flag_notify_.Wait(task.sleep_time_ms_);
+    thread_sleeping_.store(false, std::memory_order_relaxed);
   }
 
   stopped_.Set();
@@ -265,8 +293,10 @@ void TaskQueueStdlib::NotifyWake() {
   // wait on flag_notify_ until signaled that a task has been added (or the
   // thread to be told to shutdown).
 
-  // In all cases, when a new immediate task, delayed task, or request to
-  // shutdown the thread is added the flag_notify_ is signaled after. If the
+  // When a new delayed task or request to shutdown the thread is added the
+  // flag_notify_ is always signaled after. A new immediate task only signals
+  // it if the thread has announced through thread_sleeping_ that it is about
+  // to wait, since a running thread polls the queue anyway. If the
   // thread was waiting then the thread will wake up immediately and re-assess
   // what task needs to be run next (i.e. run a task now, wait for the nearest
   // timed delayed task, or shutdown the thread). If the thread was not waiting
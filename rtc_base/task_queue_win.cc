@@ -38,6 +38,7 @@
 #include "rtc_base/logging.h"
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/platform_thread.h"
+#include "rtc_base/task_latency_stats.h"
 #include "rtc_base/time_utils.h"
 
 namespace webrtc {
@@ -205,12 +206,14 @@ class TaskQueueWin : public TaskQueueBase {
   std::queue<std::unique_ptr<QueuedTask>> pending_
       RTC_GUARDED_BY(pending_lock_);
   HANDLE in_queue_;
+  rtc::TaskLatencyStats latency_stats_;
 };
 
 TaskQueueWin::TaskQueueWin(absl::string_view queue_name,
                            rtc::ThreadPriority priority)
     : thread_(&TaskQueueWin::ThreadMain, this, queue_name, priority),
-      in_queue_(::CreateEvent(nullptr, true, false, nullptr)) {
+      in_queue_(::CreateEvent(nullptr, true, false, nullptr)),
+      latency_stats_(queue_name) {
   RTC_DCHECK(in_queue_);
   thread_.Start();
   rtc::Event event(false, false);
@@ -231,6 +234,7 @@ void TaskQueueWin::Delete() {
 }
 
 void TaskQueueWin::PostTask(std::unique_ptr<QueuedTask> task) {
+  task = latency_stats_.TrackTask(std::move(task));
   rtc::CritScope lock(&pending_lock_);
   pending_.push(std::move(task));
   ::SetEvent(in_queue_);
@@ -247,7 +251,8 @@ void TaskQueueWin::PostDelayedTask(std::unique_ptr<QueuedTask> task,
   // the timestamp stored in the task info object, is a 64bit timestamp
   // and WPARAM is 32bits in 32bit builds.  Otherwise, we could pass the
   // task pointer and timestamp as LPARAM and WPARAM.
-  auto* task_info = new DelayedTaskInfo(milliseconds, std::move(task));
+  auto* task_info = new DelayedTaskInfo(
+      milliseconds, latency_stats_.TrackTask(std::move(task), milliseconds));
   if (!::PostThreadMessage(thread_.GetThreadRef(), WM_QUEUE_DELAYED_TASK, 0,
                            reinterpret_cast<LPARAM>(task_info))) {
     delete task_info;
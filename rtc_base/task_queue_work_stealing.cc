@@ -0,0 +1,478 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_work_stealing.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/attributes.h"
+#include "absl/base/config.h"
+#include "absl/strings/string_view.h"
+#include "api/scoped_refptr.h"
+#include "api/task_queue/queued_task.h"
+#include "api/task_queue/task_queue_base.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/mpsc_queue.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/ref_count.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/task_latency_stats.h"
+#include "rtc_base/thread_annotations.h"
+#include "rtc_base/time_utils.h"
+#include "rtc_base/timer_wheel.h"
+
+namespace webrtc {
+namespace {
+
+// Number of tasks a worker runs from one queue before it moves on to the
+// next queue, so that a busy queue can not starve the others.
+constexpr int kMaxTasksPerRun = 64;
+
+constexpr int64_t kNoWakeUp = std::numeric_limits<int64_t>::max();
+
+class WorkStealingPool;
+
+class PooledTaskQueue : public TaskQueueBase, public rtc::RefCountInterface {
+ public:
+  PooledTaskQueue(WorkStealingPool* pool, absl::string_view name)
+      : pool_(pool), latency_stats_(name) {}
+
+  void Delete() override;
+  void PostTask(std::unique_ptr<QueuedTask> task) override;
+  void PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds) override;
+
+  // Queues a task that is already tracked by |latency_stats_|, if needed.
+  void Enqueue(std::unique_ptr<QueuedTask> task);
+
+  // Called by a worker thread. Runs up to kMaxTasksPerRun tasks, and returns
+  // true if the queue may have more and stays scheduled.
+  bool RunTasks();
+
+ protected:
+  ~PooledTaskQueue() override;
+
+ private:
+  struct PendingTask : public rtc::MpscQueue<PendingTask>::Node {
+    std::unique_ptr<QueuedTask> task;
+  };
+
+  void DeletePendingTasks() RTC_EXCLUSIVE_LOCKS_REQUIRED(run_lock_);
+
+  WorkStealingPool* const pool_;
+  // Tasks are popped only while |run_lock_| is held.
+  rtc::MpscQueue<PendingTask> pending_;
+  // Set from the time the queue is handed to the pool until a worker finds
+  // it empty. Only the poster that sets it schedules the queue.
+  std::atomic<bool> scheduled_{false};
+  std::atomic<bool> deleted_{false};
+  // Held by the worker that runs tasks of this queue, and by Delete().
+  rtc::CriticalSection run_lock_;
+  rtc::TaskLatencyStats latency_stats_;
+};
+
+struct DelayedTask {
+  rtc::scoped_refptr<PooledTaskQueue> queue;
+  std::unique_ptr<QueuedTask> task;
+};
+
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(size_t num_threads);
+  ~WorkStealingPool();
+
+  // Hands a queue with pending tasks to a worker. A worker scheduling a
+  // queue keeps it for itself; other threads spread queues round-robin.
+  void Schedule(rtc::scoped_refptr<PooledTaskQueue> queue);
+
+  void PostDelayedTask(rtc::scoped_refptr<PooledTaskQueue> queue,
+                       std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds);
+
+  void AddQueue() { ++num_queues_; }
+  void RemoveQueue() { --num_queues_; }
+
+ private:
+  struct Worker {
+    WorkStealingPool* pool = nullptr;
+    size_t index = 0;
+    rtc::CriticalSection lock;
+    std::deque<rtc::scoped_refptr<PooledTaskQueue>> ready RTC_GUARDED_BY(lock);
+    rtc::Event wake_up;
+    std::unique_ptr<rtc::PlatformThread> thread;
+  };
+
+  static void WorkerMain(void* context);
+  static void TimerMain(void* context);
+
+  void RunWorker(Worker* worker);
+  // Takes a queue from the worker's own list, or steals one from another
+  // worker. Returns null if there is no queue ready to run.
+  rtc::scoped_refptr<PooledTaskQueue> FindWork(Worker* worker);
+  // Sleeps until woken. Returns false if the pool is shutting down.
+  bool WaitForWork(Worker* worker);
+  bool HasWork();
+  void WakeUpIdleWorker();
+  void RunTimer();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_worker_{0};
+  std::atomic<int> num_queues_{0};
+
+  rtc::CriticalSection idle_lock_;
+  std::vector<Worker*> idle_workers_ RTC_GUARDED_BY(idle_lock_);
+  // Number of entries in |idle_workers_|, readable without the lock.
+  std::atomic<int> num_idle_workers_{0};
+  bool stopping_ RTC_GUARDED_BY(idle_lock_) = false;
+
+  rtc::CriticalSection timer_lock_;
+  rtc::TimerWheel<DelayedTask> delayed_tasks_ RTC_GUARDED_BY(timer_lock_);
+  // When the timer thread wakes up next, or kNoWakeUp.
+  int64_t next_timer_wake_up_ms_ RTC_GUARDED_BY(timer_lock_) = kNoWakeUp;
+  bool timer_stopping_ RTC_GUARDED_BY(timer_lock_) = false;
+  rtc::Event timer_wake_up_;
+  rtc::PlatformThread timer_thread_;
+};
+
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+// The worker running on the current thread, if any.
+ABSL_CONST_INIT thread_local void* current_worker = nullptr;
+void* CurrentWorker() {
+  return current_worker;
+}
+void SetCurrentWorker(void* worker) {
+  current_worker = worker;
+}
+#else
+// Without thread locals every queue is scheduled round-robin.
+void* CurrentWorker() {
+  return nullptr;
+}
+void SetCurrentWorker(void* worker) {}
+#endif
+
+PooledTaskQueue::~PooledTaskQueue() {
+  // Nothing else refers to the queue any more.
+  while (PendingTask* pending = pending_.Pop())
+    delete pending;
+}
+
+void PooledTaskQueue::Delete() {
+  RTC_DCHECK(!IsCurrent());
+  deleted_.store(true);
+  {
+    // Waits for a running task to finish.
+    rtc::CritScope lock(&run_lock_);
+    DeletePendingTasks();
+  }
+  pool_->RemoveQueue();
+  // Drops the reference of the owner. Workers and the timer may hold more.
+  Release();
+}
+
+void PooledTaskQueue::PostTask(std::unique_ptr<QueuedTask> task) {
+  Enqueue(latency_stats_.TrackTask(std::move(task)));
+}
+
+void PooledTaskQueue::Enqueue(std::unique_ptr<QueuedTask> task) {
+  if (deleted_.load(std::memory_order_relaxed))
+    return;
+  PendingTask* pending = new PendingTask();
+  pending->task = std::move(task);
+  pending_.Push(pending);
+  if (!scheduled_.exchange(true))
+    pool_->Schedule(this);
+}
+
+void PooledTaskQueue::PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                                      uint32_t milliseconds) {
+  if (milliseconds == 0) {
+    PostTask(std::move(task));
+    return;
+  }
+  pool_->PostDelayedTask(
+      this, latency_stats_.TrackTask(std::move(task), milliseconds),
+      milliseconds);
+}
+
+bool PooledTaskQueue::RunTasks() {
+  rtc::CritScope lock(&run_lock_);
+  if (deleted_.load(std::memory_order_acquire)) {
+    DeletePendingTasks();
+    return false;
+  }
+  CurrentTaskQueueSetter set_current(this);
+  for (int i = 0; i < kMaxTasksPerRun; ++i) {
+    if (deleted_.load(std::memory_order_acquire))
+      return false;
+    PendingTask* pending = pending_.Pop();
+    if (!pending) {
+      // Stop being scheduled, then look once more: a task pushed in between
+      // is either seen here, or its poster sees |scheduled_| cleared and
+      // schedules the queue again.
+      scheduled_.store(false);
+      if (pending_.empty() || scheduled_.exchange(true))
+        return false;
+      continue;
+    }
+    QueuedTask* task = pending->task.release();
+    delete pending;
+    if (task->Run())
+      delete task;
+  }
+  return true;
+}
+
+void PooledTaskQueue::DeletePendingTasks() {
+  while (PendingTask* pending = pending_.Pop())
+    delete pending;
+}
+
+WorkStealingPool::WorkStealingPool(size_t num_threads)
+    : timer_thread_(&WorkStealingPool::TimerMain,
+                    this,
+                    "TaskQueuePoolTimer",
+                    rtc::kHighPriority) {
+  RTC_DCHECK_GT(num_threads, 0);
+  for (size_t i = 0; i < num_threads; ++i) {
+    auto worker = std::make_unique<Worker>();
+    worker->pool = this;
+    worker->index = i;
+    worker->thread = std::make_unique<rtc::PlatformThread>(
+        &WorkStealingPool::WorkerMain, worker.get(),
+        "TaskQueuePool" + std::to_string(i));
+    workers_.push_back(std::move(worker));
+  }
+  for (auto& worker : workers_)
+    worker->thread->Start();
+  timer_thread_.Start();
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  RTC_DCHECK_EQ(num_queues_.load(), 0);
+  {
+    rtc::CritScope lock(&idle_lock_);
+    stopping_ = true;
+  }
+  for (auto& worker : workers_) {
+    worker->wake_up.Set();
+    worker->thread->Stop();
+  }
+  {
+    rtc::CritScope lock(&timer_lock_);
+    timer_stopping_ = true;
+  }
+  timer_wake_up_.Set();
+  timer_thread_.Stop();
+}
+
+void WorkStealingPool::Schedule(rtc::scoped_refptr<PooledTaskQueue> queue) {
+  Worker* worker = static_cast<Worker*>(CurrentWorker());
+  if (!worker || worker->pool != this) {
+    worker = workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                      workers_.size()]
+                 .get();
+  }
+  {
+    rtc::CritScope lock(&worker->lock);
+    worker->ready.push_back(std::move(queue));
+  }
+  // An idle worker takes the queue, or steals it if it went to another
+  // worker's list.
+  if (num_idle_workers_.load() > 0)
+    WakeUpIdleWorker();
+}
+
+void WorkStealingPool::PostDelayedTask(
+    rtc::scoped_refptr<PooledTaskQueue> queue,
+    std::unique_ptr<QueuedTask> task,
+    uint32_t milliseconds) {
+  int64_t now_ms = rtc::TimeMillis();
+  int64_t trigger_ms = now_ms + milliseconds;
+  bool wake_up = false;
+  {
+    rtc::CritScope lock(&timer_lock_);
+    DelayedTask delayed;
+    delayed.queue = std::move(queue);
+    delayed.task = std::move(task);
+    delayed_tasks_.Insert(now_ms, trigger_ms, std::move(delayed));
+    if (trigger_ms < next_timer_wake_up_ms_) {
+      next_timer_wake_up_ms_ = trigger_ms;
+      wake_up = true;
+    }
+  }
+  if (wake_up)
+    timer_wake_up_.Set();
+}
+
+// static
+void WorkStealingPool::WorkerMain(void* context) {
+  Worker* worker = static_cast<Worker*>(context);
+  SetCurrentWorker(worker);
+  worker->pool->RunWorker(worker);
+}
+
+// static
+void WorkStealingPool::TimerMain(void* context) {
+  static_cast<WorkStealingPool*>(context)->RunTimer();
+}
+
+void WorkStealingPool::RunWorker(Worker* worker) {
+  while (true) {
+    rtc::scoped_refptr<PooledTaskQueue> queue = FindWork(worker);
+    if (queue) {
+      if (queue->RunTasks()) {
+        // More tasks are pending. Go to the back of the line.
+        rtc::CritScope lock(&worker->lock);
+        worker->ready.push_back(std::move(queue));
+      }
+      continue;
+    }
+    if (!WaitForWork(worker))
+      return;
+  }
+}
+
+rtc::scoped_refptr<PooledTaskQueue> WorkStealingPool::FindWork(
+    Worker* worker) {
+  rtc::scoped_refptr<PooledTaskQueue> queue;
+  {
+    rtc::CritScope lock(&worker->lock);
+    if (!worker->ready.empty()) {
+      queue = std::move(worker->ready.front());
+      worker->ready.pop_front();
+      return queue;
+    }
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    Worker* victim = workers_[(worker->index + i) % workers_.size()].get();
+    rtc::CritScope lock(&victim->lock);
+    if (!victim->ready.empty()) {
+      // Steal from the back, away from where the victim takes its next
+      // queue.
+      queue = std::move(victim->ready.back());
+      victim->ready.pop_back();
+      return queue;
+    }
+  }
+  return queue;
+}
+
+bool WorkStealingPool::WaitForWork(Worker* worker) {
+  {
+    rtc::CritScope lock(&idle_lock_);
+    if (stopping_)
+      return false;
+    idle_workers_.push_back(worker);
+    ++num_idle_workers_;
+  }
+  // A queue scheduled before this worker was listed as idle is found here.
+  // One scheduled after finds the worker on the list and wakes it.
+  if (HasWork()) {
+    rtc::CritScope lock(&idle_lock_);
+    auto it = std::find(idle_workers_.begin(), idle_workers_.end(), worker);
+    if (it != idle_workers_.end()) {
+      idle_workers_.erase(it);
+      --num_idle_workers_;
+    }
+    return true;
+  }
+  worker->wake_up.Wait(rtc::Event::kForever);
+  return true;
+}
+
+bool WorkStealingPool::HasWork() {
+  for (auto& worker : workers_) {
+    rtc::CritScope lock(&worker->lock);
+    if (!worker->ready.empty())
+      return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::WakeUpIdleWorker() {
+  Worker* worker = nullptr;
+  {
+    rtc::CritScope lock(&idle_lock_);
+    if (idle_workers_.empty())
+      return;
+    worker = idle_workers_.back();
+    idle_workers_.pop_back();
+    --num_idle_workers_;
+  }
+  worker->wake_up.Set();
+}
+
+void WorkStealingPool::RunTimer() {
+  std::vector<DelayedTask> expired;
+  while (true) {
+    int wait_ms = rtc::Event::kForever;
+    {
+      rtc::CritScope lock(&timer_lock_);
+      if (timer_stopping_)
+        break;
+      int64_t now_ms = rtc::TimeMillis();
+      delayed_tasks_.Advance(now_ms, &expired);
+      if (delayed_tasks_.empty()) {
+        next_timer_wake_up_ms_ = kNoWakeUp;
+      } else {
+        next_timer_wake_up_ms_ = delayed_tasks_.EarliestTrigger();
+        wait_ms = static_cast<int>(
+            std::min<int64_t>(next_timer_wake_up_ms_ - now_ms,
+                              std::numeric_limits<int>::max()));
+      }
+    }
+    // Posting outside the lock; a queue deleted meanwhile drops the task.
+    for (DelayedTask& delayed : expired)
+      delayed.queue->Enqueue(std::move(delayed.task));
+    expired.clear();
+    timer_wake_up_.Wait(wait_ms);
+  }
+}
+
+class TaskQueueWorkStealingFactory final : public TaskQueueFactory {
+ public:
+  explicit TaskQueueWorkStealingFactory(size_t num_threads)
+      : pool_(std::make_unique<WorkStealingPool>(num_threads)) {}
+
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
+      absl::string_view name,
+      Priority priority) const override {
+    PooledTaskQueue* queue =
+        new rtc::RefCountedObject<PooledTaskQueue>(pool_.get(), name);
+    // Owned by the caller until Delete().
+    queue->AddRef();
+    pool_->AddQueue();
+    return std::unique_ptr<TaskQueueBase, TaskQueueDeleter>(queue);
+  }
+
+ private:
+  const std::unique_ptr<WorkStealingPool> pool_;
+};
+
+}  // namespace
+
+std::unique_ptr<TaskQueueFactory> CreateTaskQueueWorkStealingFactory(
+    size_t num_threads) {
+  return std::make_unique<TaskQueueWorkStealingFactory>(num_threads);
+}
+
+}  // namespace webrtc
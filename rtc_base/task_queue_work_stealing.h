@@ -0,0 +1,42 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_TASK_QUEUE_WORK_STEALING_H_
+#define RTC_BASE_TASK_QUEUE_WORK_STEALING_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+#include "api/task_queue/task_queue_factory.h"
+
+namespace webrtc {
+
+// Creates a factory whose task queues are lightweight serial queues that share
+// a fixed pool of |num_threads| worker threads, plus one timer thread for
+// delayed tasks, instead of getting a thread each. Meant for processes that
+// host many calls, where most task queues are idle most of the time; a pool
+// the size of the core count (see CpuInfo::DetectNumberOfCores()) is a good
+// start.
+//
+// A task queue with pending tasks is handed to one worker at a time, which
+// runs a batch of its tasks with TaskQueueBase::Current() set to it. Tasks of
+// one queue therefore never overlap and run in posting order, like on any
+// other task queue. Idle workers steal queues that are ready to run from busy
+// ones. Queue priorities are ignored, and a task that blocks also blocks the
+// queues waiting behind it on that worker until another worker steals them.
+//
+// The factory must outlive the task queues it creates.
+std::unique_ptr<TaskQueueFactory> CreateTaskQueueWorkStealingFactory(
+    size_t num_threads);
+
+}  // namespace webrtc
+
+#endif  // RTC_BASE_TASK_QUEUE_WORK_STEALING_H_
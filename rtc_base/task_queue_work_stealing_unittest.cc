@@ -0,0 +1,117 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/task_queue_work_stealing.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "api/task_queue/task_queue_base.h"
+#include "api/task_queue/task_queue_factory.h"
+#include "api/task_queue/task_queue_test.h"
+#include "rtc_base/event.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+std::unique_ptr<TaskQueueFactory> CreateFactory() {
+  return CreateTaskQueueWorkStealingFactory(4);
+}
+
+INSTANTIATE_TEST_SUITE_P(WorkStealing,
+                         TaskQueueTest,
+                         ::testing::Values(CreateFactory));
+
+// Per queue state, only touched by tasks running on that queue.
+struct QueueState {
+  std::unique_ptr<TaskQueueBase, TaskQueueDeleter> queue;
+  int next = 0;
+  bool in_order = true;
+  bool current = true;
+};
+
+TEST(TaskQueueWorkStealingTest, KeepsOrderOfManyQueuesOnFewThreads) {
+  static const int kNumQueues = 1000;
+  static const int kTasksPerQueue = 50;
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueWorkStealingFactory(2);
+  std::vector<QueueState> states(kNumQueues);
+  for (QueueState& state : states) {
+    state.queue = factory->CreateTaskQueue(
+        "Queue", TaskQueueFactory::Priority::NORMAL);
+  }
+
+  std::atomic<int> remaining(kNumQueues * kTasksPerQueue);
+  rtc::Event done;
+  for (int i = 0; i < kTasksPerQueue; ++i) {
+    for (QueueState& state : states) {
+      QueueState* s = &state;
+      state.queue->PostTask(ToQueuedTask([s, i, &remaining, &done] {
+        s->in_order &= s->next == i;
+        s->current &= s->queue->IsCurrent();
+        ++s->next;
+        if (remaining.fetch_sub(1) == 1)
+          done.Set();
+      }));
+    }
+  }
+  ASSERT_TRUE(done.Wait(10000));
+
+  for (const QueueState& state : states) {
+    EXPECT_EQ(kTasksPerQueue, state.next);
+    EXPECT_TRUE(state.in_order);
+    EXPECT_TRUE(state.current);
+  }
+}
+
+TEST(TaskQueueWorkStealingTest, TasksOfOneQueueDoNotOverlap) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueWorkStealingFactory(4);
+  auto queue =
+      factory->CreateTaskQueue("Queue", TaskQueueFactory::Priority::NORMAL);
+
+  static const int kNumTasks = 10000;
+  std::atomic<int> running(0);
+  std::atomic<bool> overlapped(false);
+  rtc::Event done;
+  for (int i = 0; i < kNumTasks; ++i) {
+    queue->PostTask(ToQueuedTask([&, i] {
+      if (running.fetch_add(1) != 0)
+        overlapped = true;
+      running.fetch_sub(1);
+      if (i == kNumTasks - 1)
+        done.Set();
+    }));
+  }
+  ASSERT_TRUE(done.Wait(10000));
+  EXPECT_FALSE(overlapped.load());
+}
+
+TEST(TaskQueueWorkStealingTest, BlockedQueueDoesNotHoldUpOthers) {
+  std::unique_ptr<TaskQueueFactory> factory =
+      CreateTaskQueueWorkStealingFactory(2);
+  auto blocked =
+      factory->CreateTaskQueue("Blocked", TaskQueueFactory::Priority::NORMAL);
+  auto other =
+      factory->CreateTaskQueue("Other", TaskQueueFactory::Priority::NORMAL);
+
+  rtc::Event unblock;
+  rtc::Event ran;
+  blocked->PostTask(ToQueuedTask([&unblock] { unblock.Wait(10000); }));
+  other->PostTask(ToQueuedTask([&ran] { ran.Set(); }));
+  EXPECT_TRUE(ran.Wait(1000));
+  unblock.Set();
+}
+
+}  // namespace
+}  // namespace webrtc
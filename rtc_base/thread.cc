@@ -32,6 +32,8 @@
 #include "rtc_base/critical_section.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/null_socket_server.h"
+#include "rtc_base/task_latency_stats.h"
+#include "rtc_base/thread_cpu_usage.h"
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
 
@@ -227,6 +229,7 @@ bool Thread::SetName(const std::string& name, const void* obj) {
     snprintf(buf, sizeof(buf), " 0x%p", obj);
     name_ += buf;
   }
+  latency_stats_.set_queue_name(name_);
   return true;
 }
 
@@ -338,7 +341,10 @@ void* Thread::PreRun(void* pv) {
 #if defined(WEBRTC_MAC)
   ScopedAutoReleasePool pool;
 #endif
-  thread->Run();
+  {
+    ScopedRegisterThreadCpuUsage cpu_usage(thread->name_);
+    thread->Run();
+  }
 
   ThreadManager::Instance()->SetCurrentThread(nullptr);
 #ifdef WEBRTC_WIN
@@ -381,6 +387,8 @@ void Thread::Send(const Location& posted_from,
     phandler->OnMessage(&msg);
     return;
   }
+  if (TaskLatencyStats::IsEnabled())
+    msg.ready_us = TimeMicros();
 
   AssertBlockingIsAllowedOnCurrentThread();
 
@@ -472,7 +480,14 @@ void Thread::InvokeInternal(const Location& posted_from,
   TRACE_EVENT2("webrtc", "Thread::Invoke", "src_file_and_line",
                posted_from.file_and_line(), "src_func",
                posted_from.function_name());
+  if (!TaskLatencyStats::IsEnabled() || IsCurrent()) {
+    Send(posted_from, handler);
+    return;
+  }
+  int64_t start_us = TimeMicros();
   Send(posted_from, handler);
+  TaskLatencyStats::RecordBlockingInvoke(posted_from.file_and_line(),
+                                         TimeMicros() - start_us);
 }
 
 bool Thread::IsProcessingMessagesForTesting() {
@@ -0,0 +1,239 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/thread_cpu_usage.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "rtc_base/critical_section.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/thread_annotations.h"
+#include "rtc_base/time_utils.h"
+
+#if defined(WEBRTC_LINUX)
+#include <pthread.h>
+#include <time.h>
+#elif defined(WEBRTC_MAC)
+#include <mach/mach_init.h>
+#include <mach/mach_port.h>
+#include <mach/thread_act.h>
+#include <mach/thread_info.h>
+#elif defined(WEBRTC_WIN)
+#include <windows.h>
+#endif
+
+namespace rtc {
+
+// Holds what is needed to read the CPU time of the registered thread from
+// other threads, as the calling thread variants in rtc_base/cpu_time.h cannot
+// be used for that.
+struct ScopedRegisterThreadCpuUsage::Entry {
+  std::string name;
+  uint64_t id = 0;
+  PlatformThreadId thread_id = 0;
+#if defined(WEBRTC_LINUX)
+  clockid_t clock_id;
+#elif defined(WEBRTC_MAC)
+  mach_port_t thread_port;
+#elif defined(WEBRTC_WIN)
+  HANDLE thread_handle;
+#endif
+};
+
+namespace {
+
+using Entry = ScopedRegisterThreadCpuUsage::Entry;
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_MAC) || defined(WEBRTC_WIN)
+constexpr bool kSupported = true;
+#else
+constexpr bool kSupported = false;
+#endif
+
+struct Registry {
+  CriticalSection lock;
+  uint64_t next_id RTC_GUARDED_BY(lock) = 1;
+  std::vector<Entry*> threads RTC_GUARDED_BY(lock);
+  // CPU time of the exited threads, by name.
+  std::map<std::string, int64_t> exited RTC_GUARDED_BY(lock);
+};
+
+Registry* GetRegistry() {
+  static Registry* const registry = new Registry();
+  return registry;
+}
+
+// Returns false if the CPU time of the calling thread cannot be read through
+// |entry|.
+bool OpenThreadClock(Entry* entry) {
+#if defined(WEBRTC_LINUX)
+  return pthread_getcpuclockid(pthread_self(), &entry->clock_id) == 0;
+#elif defined(WEBRTC_MAC)
+  entry->thread_port = mach_thread_self();
+  return true;
+#elif defined(WEBRTC_WIN)
+  return DuplicateHandle(GetCurrentProcess(), GetCurrentThread(),
+                         GetCurrentProcess(), &entry->thread_handle,
+                         THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0) != 0;
+#else
+  return false;
+#endif
+}
+
+void CloseThreadClock(Entry* entry) {
+#if defined(WEBRTC_MAC)
+  mach_port_deallocate(mach_task_self(), entry->thread_port);
+#elif defined(WEBRTC_WIN)
+  CloseHandle(entry->thread_handle);
+#endif
+}
+
+// Returns the CPU time of the thread of |entry|, or 0 if it cannot be read.
+// The thread must not have exited.
+int64_t ReadThreadClock(const Entry& entry) {
+#if defined(WEBRTC_LINUX)
+  struct timespec ts;
+  if (clock_gettime(entry.clock_id, &ts) == 0)
+    return ts.tv_sec * kNumNanosecsPerSec + ts.tv_nsec;
+  RTC_LOG_ERR(LS_ERROR) << "clock_gettime() failed.";
+#elif defined(WEBRTC_MAC)
+  thread_basic_info_data_t info;
+  mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+  if (thread_info(entry.thread_port, THREAD_BASIC_INFO,
+                  reinterpret_cast<thread_info_t>(&info),
+                  &count) == KERN_SUCCESS) {
+    return (info.user_time.seconds + info.system_time.seconds) *
+               kNumNanosecsPerSec +
+           (info.user_time.microseconds + info.system_time.microseconds) *
+               kNumNanosecsPerMicrosec;
+  }
+  RTC_LOG(LS_ERROR) << "thread_info() failed.";
+#elif defined(WEBRTC_WIN)
+  FILETIME create_time;
+  FILETIME exit_time;
+  FILETIME kernel_time;
+  FILETIME user_time;
+  if (GetThreadTimes(entry.thread_handle, &create_time, &exit_time,
+                     &kernel_time, &user_time) != 0) {
+    // FILETIME resolution is 100 nanosecs.
+    return ((static_cast<uint64_t>(user_time.dwHighDateTime) << 32) +
+            user_time.dwLowDateTime +
+            (static_cast<uint64_t>(kernel_time.dwHighDateTime) << 32) +
+            kernel_time.dwLowDateTime) *
+           100;
+  }
+  RTC_LOG_ERR(LS_ERROR) << "GetThreadTimes() failed.";
+#endif
+  return 0;
+}
+
+void SortByCpuTime(std::vector<ThreadCpuUsage>* usage) {
+  std::sort(usage->begin(), usage->end(),
+            [](const ThreadCpuUsage& a, const ThreadCpuUsage& b) {
+              return a.cpu_time_ns > b.cpu_time_ns;
+            });
+}
+
+}  // namespace
+
+ScopedRegisterThreadCpuUsage::ScopedRegisterThreadCpuUsage(
+    absl::string_view name)
+    : entry_(kSupported ? new Entry() : nullptr) {
+  if (!entry_)
+    return;
+  entry_->name = std::string(name);
+  entry_->thread_id = CurrentThreadId();
+  // Left out of the accounting if its CPU time cannot be read.
+  if (!OpenThreadClock(entry_))
+    return;
+  Registry* registry = GetRegistry();
+  CritScope lock(&registry->lock);
+  entry_->id = registry->next_id++;
+  registry->threads.push_back(entry_);
+}
+
+ScopedRegisterThreadCpuUsage::~ScopedRegisterThreadCpuUsage() {
+  if (!entry_)
+    return;
+  Registry* registry = GetRegistry();
+  {
+    CritScope lock(&registry->lock);
+    if (entry_->id != 0) {
+      registry->exited[entry_->name] += ReadThreadClock(*entry_);
+      registry->threads.erase(std::find(registry->threads.begin(),
+                                        registry->threads.end(), entry_));
+      CloseThreadClock(entry_);
+    }
+  }
+  delete entry_;
+}
+
+std::vector<ThreadCpuUsage> GetThreadCpuUsage() {
+  std::vector<ThreadCpuUsage> usage;
+  if (!kSupported)
+    return usage;
+  Registry* registry = GetRegistry();
+  CritScope lock(&registry->lock);
+  usage.reserve(registry->threads.size() + registry->exited.size());
+  for (const Entry* entry : registry->threads) {
+    ThreadCpuUsage thread;
+    thread.thread_name = entry->name;
+    thread.id = entry->id;
+    thread.thread_id = entry->thread_id;
+    thread.cpu_time_ns = ReadThreadClock(*entry);
+    usage.push_back(std::move(thread));
+  }
+  for (const auto& exited : registry->exited) {
+    ThreadCpuUsage threads;
+    threads.thread_name = exited.first;
+    threads.cpu_time_ns = exited.second;
+    usage.push_back(std::move(threads));
+  }
+  SortByCpuTime(&usage);
+  return usage;
+}
+
+std::vector<ThreadCpuUsage> GetThreadCpuUsageSince(
+    const std::vector<ThreadCpuUsage>& baseline) {
+  std::vector<ThreadCpuUsage> usage = GetThreadCpuUsage();
+  std::map<uint64_t, int64_t> running;
+  for (const ThreadCpuUsage& thread : usage) {
+    if (thread.id != 0)
+      running[thread.id] = 0;
+  }
+  // The baseline of the exited threads of a name includes what the threads
+  // that have exited since had used back then.
+  std::map<std::string, int64_t> exited_baseline;
+  for (const ThreadCpuUsage& thread : baseline) {
+    auto it = running.find(thread.id);
+    if (thread.id != 0 && it != running.end())
+      it->second = thread.cpu_time_ns;
+    else
+      exited_baseline[thread.thread_name] += thread.cpu_time_ns;
+  }
+  std::vector<ThreadCpuUsage> since;
+  since.reserve(usage.size());
+  for (ThreadCpuUsage& thread : usage) {
+    if (thread.id != 0) {
+      thread.cpu_time_ns -= running[thread.id];
+    } else {
+      thread.cpu_time_ns -= exited_baseline[thread.thread_name];
+      if (thread.cpu_time_ns <= 0)
+        continue;
+    }
+    since.push_back(std::move(thread));
+  }
+  SortByCpuTime(&since);
+  return since;
+}
+
+}  // namespace rtc
@@ -0,0 +1,71 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_THREAD_CPU_USAGE_H_
+#define RTC_BASE_THREAD_CPU_USAGE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/platform_thread_types.h"
+
+namespace rtc {
+
+// CPU time, user and system time combined, consumed by a thread that WebRTC
+// owns. PlatformThread and rtc::Thread register the threads they start, so
+// that this covers the network, worker and signaling threads as well as the
+// task queues, process threads and audio and decoder threads.
+struct ThreadCpuUsage {
+  std::string thread_name;
+  // Identifies one registration of a thread. Unlike |thread_id|, it is never
+  // reused. 0 for the entry that sums up the exited threads of
+  // |thread_name|.
+  uint64_t id = 0;
+  // 0 for the exited threads.
+  PlatformThreadId thread_id = 0;
+  int64_t cpu_time_ns = 0;
+};
+
+// Registers the calling thread under |name| for the lifetime of the object.
+// Must be destroyed on the thread that created it.
+class ScopedRegisterThreadCpuUsage {
+ public:
+  explicit ScopedRegisterThreadCpuUsage(absl::string_view name);
+  ~ScopedRegisterThreadCpuUsage();
+
+  // The registration of the thread, kept by the registry while the thread
+  // runs.
+  struct Entry;
+
+ private:
+  Entry* const entry_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ScopedRegisterThreadCpuUsage);
+};
+
+// Returns an entry for every registered thread that runs, and one per thread
+// name with the CPU time of the threads of that name that have exited, most
+// CPU time first. Empty on platforms where the CPU time of other threads
+// cannot be read. Thread safe.
+std::vector<ThreadCpuUsage> GetThreadCpuUsage();
+
+// Like GetThreadCpuUsage(), but counts only the CPU time consumed since
+// |baseline|, an earlier result of GetThreadCpuUsage(). Exited threads
+// without CPU time since then are left out.
+std::vector<ThreadCpuUsage> GetThreadCpuUsageSince(
+    const std::vector<ThreadCpuUsage>& baseline);
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_THREAD_CPU_USAGE_H_
@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/thread_cpu_usage.h"
+
+#include <vector>
+
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+#if defined(WEBRTC_LINUX) || defined(WEBRTC_MAC) || defined(WEBRTC_WIN)
+
+// Keeps a thread busy for a while, then lets it wait until it is released.
+struct BusyThread {
+  static void Run(void* obj) {
+    BusyThread* busy = static_cast<BusyThread*>(obj);
+    int64_t end_ms = TimeMillis() + 50;
+    volatile int counter = 0;
+    while (TimeMillis() < end_ms)
+      counter = counter + 1;
+    busy->spun.Set();
+    busy->release.Wait(Event::kForever);
+  }
+
+  Event spun;
+  Event release;
+};
+
+const ThreadCpuUsage* Find(const std::vector<ThreadCpuUsage>& usage,
+                           const char* name,
+                           bool exited) {
+  for (const ThreadCpuUsage& thread : usage) {
+    if (thread.thread_name == name && (thread.id == 0) == exited)
+      return &thread;
+  }
+  return nullptr;
+}
+
+TEST(ThreadCpuUsageTest, AccountsRunningAndExitedThreads) {
+  std::vector<ThreadCpuUsage> baseline = GetThreadCpuUsage();
+  EXPECT_EQ(nullptr, Find(baseline, "CpuUsageBusy", false));
+
+  BusyThread busy;
+  PlatformThread thread(&BusyThread::Run, &busy, "CpuUsageBusy");
+  thread.Start();
+  busy.spun.Wait(Event::kForever);
+
+  std::vector<ThreadCpuUsage> running = GetThreadCpuUsage();
+  const ThreadCpuUsage* busy_usage = Find(running, "CpuUsageBusy", false);
+  ASSERT_NE(nullptr, busy_usage);
+  EXPECT_NE(0u, busy_usage->thread_id);
+  // Leaves room for a coarse clock and a preempted thread.
+  EXPECT_GT(busy_usage->cpu_time_ns, 10 * kNumNanosecsPerMillisec);
+  int64_t running_cpu_time_ns = busy_usage->cpu_time_ns;
+
+  busy.release.Set();
+  thread.Stop();
+  std::vector<ThreadCpuUsage> exited = GetThreadCpuUsage();
+  EXPECT_EQ(nullptr, Find(exited, "CpuUsageBusy", false));
+  const ThreadCpuUsage* exited_usage = Find(exited, "CpuUsageBusy", true);
+  ASSERT_NE(nullptr, exited_usage);
+  EXPECT_GE(exited_usage->cpu_time_ns, running_cpu_time_ns);
+
+  // Only what the thread used after |running| was taken is left.
+  std::vector<ThreadCpuUsage> since = GetThreadCpuUsageSince(running);
+  const ThreadCpuUsage* since_usage = Find(since, "CpuUsageBusy", true);
+  if (since_usage) {
+    EXPECT_EQ(exited_usage->cpu_time_ns - running_cpu_time_ns,
+              since_usage->cpu_time_ns);
+  }
+  EXPECT_EQ(nullptr, Find(GetThreadCpuUsageSince(exited), "CpuUsageBusy",
+                          true));
+}
+
+TEST(ThreadCpuUsageTest, SortsByCpuTime) {
+  ScopedRegisterThreadCpuUsage registration("CpuUsageTest");
+  std::vector<ThreadCpuUsage> usage = GetThreadCpuUsage();
+  ASSERT_NE(nullptr, Find(usage, "CpuUsageTest", false));
+  for (size_t i = 1; i < usage.size(); ++i)
+    EXPECT_GE(usage[i - 1].cpu_time_ns, usage[i].cpu_time_ns);
+}
+
+#endif
+
+}  // namespace
+}  // namespace rtc
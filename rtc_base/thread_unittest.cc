@@ -471,6 +471,38 @@ TEST_F(AsyncInvokeTest, NonCopyableFunctor) {
   thread->Stop();
 }
 
+TEST_F(AsyncInvokeTest, WithCallback) {
+  AsyncInvoker invoker;
+  // Create and start the thread.
+  auto thread = Thread::CreateWithSocketServer();
+  thread->Start();
+  // Try calling functor.
+  SetExpectedThreadForIntCallback(Thread::Current());
+  invoker.AsyncInvoke<int>(RTC_FROM_HERE, RTC_FROM_HERE, thread.get(),
+                           FunctorA(), &AsyncInvokeTest::IntCallback,
+                           static_cast<AsyncInvokeTest*>(this));
+  EXPECT_EQ_WAIT(42, int_value_, kWaitTimeout);
+  thread->Stop();
+}
+
+TEST_F(AsyncInvokeTest, KillInvokerBeforeCallback) {
+  auto thread = Thread::CreateWithSocketServer();
+  thread->Start();
+  SetExpectedThreadForIntCallback(Thread::Current());
+  {
+    AsyncInvoker invoker;
+    invoker.AsyncInvoke<int>(RTC_FROM_HERE, RTC_FROM_HERE, thread.get(),
+                             FunctorA(), &AsyncInvokeTest::IntCallback,
+                             static_cast<AsyncInvokeTest*>(this));
+    // Run the functor, which posts the callback to the current thread.
+    invoker.Flush(thread.get());
+  }
+  // The callback was cancelled along with the invoker.
+  Thread::Current()->ProcessMessages(0);
+  EXPECT_EQ(0, int_value_);
+  thread->Stop();
+}
+
 TEST_F(AsyncInvokeTest, KillInvokerDuringExecute) {
   // Use these events to get in a state where the functor is in the middle of
   // executing, and then to wait for it to finish, ensuring the "EXPECT_FALSE"
@@ -0,0 +1,344 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_TIMER_WHEEL_H_
+#define RTC_BASE_TIMER_WHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/constructor_magic.h"
+
+namespace rtc {
+
+// Holds values until their trigger time, in milliseconds, has passed.
+// Insert() and Cancel() take constant time, and neither allocates once the
+// wheel has grown to its working size. Advance() takes constant time per
+// expired value, plus at most one step per level for every value scheduled
+// far ahead.
+//
+// The wheel is hierarchical: level L has 64 slots, each 64^L ms wide, and the
+// slots of level L together span one slot of level L + 1. A value sits on the
+// lowest level where it shares its level L + 1 slot with the wheel's current
+// time, and moves one or more levels down whenever the wheel's time enters
+// its slot. Empty slots are skipped, so advancing far ahead costs nothing
+// extra.
+//
+// Advance() hands out values in trigger time order, and values with the same
+// trigger time in insertion order, like a priority queue ordered by (trigger
+// time, insertion order) would.
+//
+// Not thread safe. T must be default constructible and movable.
+template <typename T>
+class TimerWheel {
+ private:
+  static constexpr int kBitsPerLevel = 6;
+  static constexpr int kSlotsPerLevel = 1 << kBitsPerLevel;
+  // Enough levels to cover all 64 bits of a time.
+  static constexpr int kNumLevels = (64 + kBitsPerLevel - 1) / kBitsPerLevel;
+  static constexpr int kNumSlots = kNumLevels * kSlotsPerLevel;
+  // List of values whose trigger time is at or before the wheel's time.
+  static constexpr uint16_t kDueList = kNumSlots;
+  static constexpr uint16_t kFree = 0xffff;
+  static constexpr uint32_t kNoNode = 0xffffffff;
+
+ public:
+  // Identifies an inserted value for Cancel(). It is safe to keep a handle
+  // after its value has expired or been cancelled.
+  struct Handle {
+    uint32_t index = kNoNode;
+    uint32_t generation = 0;
+  };
+
+  TimerWheel() {
+    heads_.fill(kNoNode);
+    occupied_.fill(0);
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // Schedules |value| to expire at |trigger_ms|. |now_ms| is the current time;
+  // it is only used while the wheel is empty, which lets a wheel follow a
+  // clock that was swapped out, like a fake clock in tests.
+  Handle Insert(int64_t now_ms, int64_t trigger_ms, T value) {
+    if (size_ == 0)
+      now_ms_ = now_ms;
+    uint32_t index = AllocateNode();
+    Node& node = nodes_[index];
+    node.trigger_ms = trigger_ms;
+    node.seq = next_seq_++;
+    node.value = std::move(value);
+    Link(index);
+    ++size_;
+    return Handle{index, node.generation};
+  }
+
+  // Drops the value identified by |handle|. Returns false if the value has
+  // already expired or been cancelled.
+  bool Cancel(const Handle& handle) {
+    if (handle.index >= nodes_.size())
+      return false;
+    const Node& node = nodes_[handle.index];
+    if (node.location == kFree || node.generation != handle.generation)
+      return false;
+    Unlink(handle.index);
+    FreeNode(handle.index);
+    return true;
+  }
+
+  // Drops every value for which |predicate| returns true. The predicate gets
+  // a mutable reference, so it may move the value out. Takes time linear in
+  // the size of the wheel.
+  template <typename Predicate>
+  void RemoveIf(Predicate predicate) {
+    for (uint32_t index = 0; index < nodes_.size(); ++index) {
+      if (nodes_[index].location != kFree && predicate(nodes_[index].value)) {
+        Unlink(index);
+        FreeNode(index);
+      }
+    }
+  }
+
+  // Moves the wheel's time forward to |now_ms|, and appends every value with
+  // a trigger time at or before |now_ms| to |expired| with push_back().
+  template <typename Container>
+  void Advance(int64_t now_ms, Container* expired) {
+    while (true) {
+      TakeDue(now_ms, expired);
+      int level = LowestOccupiedLevel();
+      if (level == kNumLevels)
+        break;
+      int slot = LowestBit(occupied_[level]);
+      int64_t slot_start_ms = SlotStart(level, slot);
+      if (slot_start_ms > now_ms)
+        break;
+      // Entering the slot. Its values move to lower levels, or to the due
+      // list once their trigger time is reached.
+      now_ms_ = slot_start_ms;
+      uint32_t index = TakeList(level * kSlotsPerLevel + slot);
+      while (index != kNoNode) {
+        uint32_t next = nodes_[index].next;
+        Link(index);
+        index = next;
+      }
+    }
+    // Every remaining value triggers after |now_ms|, so it stays in place.
+    if (now_ms > now_ms_)
+      now_ms_ = now_ms;
+  }
+
+  // Returns a time at or before the earliest trigger time in the wheel. It is
+  // exact unless the value with the earliest trigger time was cancelled or
+  // removed. Must not be called on an empty wheel.
+  int64_t EarliestTrigger() const {
+    RTC_DCHECK(!empty());
+    if (heads_[kDueList] != kNoNode)
+      return due_min_ms_;
+    int level = LowestOccupiedLevel();
+    RTC_DCHECK(level < kNumLevels);
+    return slot_min_ms_[level * kSlotsPerLevel + LowestBit(occupied_[level])];
+  }
+
+ private:
+  struct Node {
+    int64_t trigger_ms = 0;
+    uint64_t seq = 0;
+    uint32_t prev = kNoNode;
+    uint32_t next = kNoNode;
+    uint32_t generation = 0;
+    uint16_t location = kFree;
+    T value;
+  };
+
+  // Maps times to unsigned values with the same order, so that slots can be
+  // computed with shifts and masks.
+  static uint64_t ToWheelTime(int64_t ms) {
+    return static_cast<uint64_t>(ms) ^ (uint64_t{1} << 63);
+  }
+  static int64_t FromWheelTime(uint64_t time) {
+    return static_cast<int64_t>(time ^ (uint64_t{1} << 63));
+  }
+
+  static int LowestBit(uint64_t mask) {
+    RTC_DCHECK_NE(mask, 0);
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int bit = 0;
+    while ((mask & 1) == 0) {
+      mask >>= 1;
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+
+  int LowestOccupiedLevel() const {
+    int level = 0;
+    while (level < kNumLevels && occupied_[level] == 0)
+      ++level;
+    return level;
+  }
+
+  int64_t SlotStart(int level, int slot) const {
+    int shift = level * kBitsPerLevel;
+    int upper_shift = shift + kBitsPerLevel;
+    uint64_t now = ToWheelTime(now_ms_);
+    uint64_t upper =
+        upper_shift >= 64 ? 0 : (now >> upper_shift) << upper_shift;
+    return FromWheelTime(upper | (static_cast<uint64_t>(slot) << shift));
+  }
+
+  uint32_t AllocateNode() {
+    if (!free_nodes_.empty()) {
+      uint32_t index = free_nodes_.back();
+      free_nodes_.pop_back();
+      return index;
+    }
+    RTC_CHECK(nodes_.size() < kNoNode);
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  void FreeNode(uint32_t index) {
+    Node& node = nodes_[index];
+    node.value = T();
+    node.location = kFree;
+    ++node.generation;
+    free_nodes_.push_back(index);
+    --size_;
+  }
+
+  // Puts the node on the due list or on the slot matching its trigger time.
+  void Link(uint32_t index) {
+    Node& node = nodes_[index];
+    if (node.trigger_ms <= now_ms_) {
+      if (heads_[kDueList] == kNoNode || node.trigger_ms < due_min_ms_)
+        due_min_ms_ = node.trigger_ms;
+      PushFront(kDueList, index);
+      return;
+    }
+    uint64_t trigger = ToWheelTime(node.trigger_ms);
+    uint64_t diff = trigger ^ ToWheelTime(now_ms_);
+    int level = 0;
+    while (level + 1 < kNumLevels &&
+           (diff >> ((level + 1) * kBitsPerLevel)) != 0) {
+      ++level;
+    }
+    int slot = static_cast<int>((trigger >> (level * kBitsPerLevel)) &
+                                (kSlotsPerLevel - 1));
+    int list = level * kSlotsPerLevel + slot;
+    if (heads_[list] == kNoNode) {
+      occupied_[level] |= uint64_t{1} << slot;
+      slot_min_ms_[list] = node.trigger_ms;
+    } else {
+      slot_min_ms_[list] = std::min(slot_min_ms_[list], node.trigger_ms);
+    }
+    PushFront(list, index);
+  }
+
+  void PushFront(int list, uint32_t index) {
+    Node& node = nodes_[index];
+    node.location = static_cast<uint16_t>(list);
+    node.prev = kNoNode;
+    node.next = heads_[list];
+    if (node.next != kNoNode)
+      nodes_[node.next].prev = index;
+    heads_[list] = index;
+  }
+
+  void Unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    int list = node.location;
+    if (node.prev != kNoNode)
+      nodes_[node.prev].next = node.next;
+    else
+      heads_[list] = node.next;
+    if (node.next != kNoNode)
+      nodes_[node.next].prev = node.prev;
+    if (heads_[list] == kNoNode && list != kDueList)
+      ClearOccupied(list);
+  }
+
+  // Detaches all nodes of a slot and returns the first one.
+  uint32_t TakeList(int list) {
+    uint32_t head = heads_[list];
+    heads_[list] = kNoNode;
+    ClearOccupied(list);
+    return head;
+  }
+
+  void ClearOccupied(int list) {
+    occupied_[list / kSlotsPerLevel] &=
+        ~(uint64_t{1} << (list % kSlotsPerLevel));
+  }
+
+  // Moves the values on the due list that trigger at or before |now_ms| to
+  // |expired|, in (trigger time, insertion order) order.
+  template <typename Container>
+  void TakeDue(int64_t now_ms, Container* expired) {
+    if (heads_[kDueList] == kNoNode)
+      return;
+    due_scratch_.clear();
+    for (uint32_t index = heads_[kDueList]; index != kNoNode;
+         index = nodes_[index].next) {
+      if (nodes_[index].trigger_ms <= now_ms)
+        due_scratch_.push_back(index);
+    }
+    std::sort(due_scratch_.begin(), due_scratch_.end(),
+              [this](uint32_t a, uint32_t b) {
+                const Node& node_a = nodes_[a];
+                const Node& node_b = nodes_[b];
+                if (node_a.trigger_ms != node_b.trigger_ms)
+                  return node_a.trigger_ms < node_b.trigger_ms;
+                return node_a.seq < node_b.seq;
+              });
+    for (uint32_t index : due_scratch_) {
+      Unlink(index);
+      expired->push_back(std::move(nodes_[index].value));
+      FreeNode(index);
+    }
+    // Only values ahead of |now_ms| are left, which happens if time went
+    // backwards.
+    for (uint32_t index = heads_[kDueList]; index != kNoNode;
+         index = nodes_[index].next) {
+      if (index == heads_[kDueList] || nodes_[index].trigger_ms < due_min_ms_)
+        due_min_ms_ = nodes_[index].trigger_ms;
+    }
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> free_nodes_;
+  std::vector<uint32_t> due_scratch_;
+  // Heads of the doubly linked lists of the slots, followed by the due list.
+  std::array<uint32_t, kNumSlots + 1> heads_;
+  // Bit N of occupied_[L] is set when slot N of level L is not empty.
+  std::array<uint64_t, kNumLevels> occupied_;
+  // The earliest trigger time of each non-empty slot, or an earlier time if
+  // that value has been removed.
+  std::array<int64_t, kNumSlots> slot_min_ms_;
+  int64_t due_min_ms_ = 0;
+  int64_t now_ms_ = 0;
+  uint64_t next_seq_ = 0;
+  size_t size_ = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+};
+
+}  // namespace rtc
+
+#endif  // RTC_BASE_TIMER_WHEEL_H_
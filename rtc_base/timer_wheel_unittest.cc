@@ -0,0 +1,254 @@
+/*
+ *  Copyright 2019 The WebRTC Project Authors. All rights reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/timer_wheel.h"
+
+#include <stdint.h>
+
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "rtc_base/logging.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
+#include "test/gmock.h"
+#include "test/gtest.h"
+
+namespace rtc {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(TimerWheelTest, ExpiresInTriggerTimeOrder) {
+  TimerWheel<int> wheel;
+  wheel.Insert(1000, 1300, 3);
+  wheel.Insert(1000, 1001, 1);
+  wheel.Insert(1000, 1070, 2);
+  EXPECT_EQ(3u, wheel.size());
+  EXPECT_EQ(1001, wheel.EarliestTrigger());
+
+  std::vector<int> expired;
+  wheel.Advance(1000, &expired);
+  EXPECT_TRUE(expired.empty());
+  wheel.Advance(1069, &expired);
+  EXPECT_THAT(expired, ElementsAre(1));
+  wheel.Advance(5000, &expired);
+  EXPECT_THAT(expired, ElementsAre(1, 2, 3));
+  EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimerWheelTest, KeepsInsertionOrderForEqualTriggerTimes) {
+  TimerWheel<int> wheel;
+  // Inserted at different times, so they end up on different levels before
+  // meeting in the same slot.
+  wheel.Insert(0, 100000, 1);
+  wheel.Insert(0, 100001, 3);
+  std::vector<int> expired;
+  wheel.Advance(99990, &expired);
+  wheel.Insert(99990, 100000, 2);
+  wheel.Advance(100001, &expired);
+  EXPECT_THAT(expired, ElementsAre(1, 2, 3));
+}
+
+TEST(TimerWheelTest, ExpiresValuesInThePastOnNextAdvance) {
+  TimerWheel<int> wheel;
+  wheel.Insert(1000, 2000, 3);
+  wheel.Insert(1000, 995, 2);
+  wheel.Insert(1000, 990, 1);
+  EXPECT_EQ(990, wheel.EarliestTrigger());
+  std::vector<int> expired;
+  wheel.Advance(1000, &expired);
+  EXPECT_THAT(expired, ElementsAre(1, 2));
+  EXPECT_EQ(2000, wheel.EarliestTrigger());
+}
+
+TEST(TimerWheelTest, CancelsValues) {
+  TimerWheel<int> wheel;
+  TimerWheel<int>::Handle first = wheel.Insert(0, 10, 1);
+  TimerWheel<int>::Handle second = wheel.Insert(0, 5000000, 2);
+  wheel.Insert(0, 20, 3);
+  EXPECT_TRUE(wheel.Cancel(first));
+  EXPECT_FALSE(wheel.Cancel(first));
+  EXPECT_TRUE(wheel.Cancel(second));
+  EXPECT_EQ(1u, wheel.size());
+
+  std::vector<int> expired;
+  wheel.Advance(10000000, &expired);
+  EXPECT_THAT(expired, ElementsAre(3));
+  // The handle stays harmless after its node is reused.
+  wheel.Insert(10000000, 10000010, 4);
+  EXPECT_FALSE(wheel.Cancel(first));
+  EXPECT_EQ(1u, wheel.size());
+  EXPECT_FALSE(wheel.Cancel(TimerWheel<int>::Handle()));
+}
+
+TEST(TimerWheelTest, RemovesMatchingValues) {
+  TimerWheel<int> wheel;
+  for (int i = 0; i < 10; ++i)
+    wheel.Insert(0, i * 1000, i);
+  std::vector<int> removed;
+  wheel.RemoveIf([&removed](int& value) {
+    if (value % 2 == 0)
+      return false;
+    removed.push_back(value);
+    return true;
+  });
+  EXPECT_EQ(5u, removed.size());
+  std::vector<int> expired;
+  wheel.Advance(100000, &expired);
+  EXPECT_THAT(expired, ElementsAre(0, 2, 4, 6, 8));
+}
+
+TEST(TimerWheelTest, HoldsMoveOnlyValues) {
+  TimerWheel<std::unique_ptr<int>> wheel;
+  wheel.Insert(0, 100, std::make_unique<int>(7));
+  std::vector<std::unique_ptr<int>> expired;
+  wheel.Advance(100, &expired);
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(7, *expired[0]);
+}
+
+TEST(TimerWheelTest, HandlesNegativeAndLargeTimes) {
+  TimerWheel<int> wheel;
+  wheel.Insert(-5000, -10, 1);
+  wheel.Insert(-5000, 10, 2);
+  wheel.Insert(-5000, int64_t{1} << 50, 3);
+  std::vector<int> expired;
+  wheel.Advance(0, &expired);
+  EXPECT_THAT(expired, ElementsAre(1));
+  wheel.Advance(int64_t{1} << 50, &expired);
+  EXPECT_THAT(expired, ElementsAre(1, 2, 3));
+}
+
+TEST(TimerWheelTest, FollowsTimeGoingBackwardsWhenEmpty) {
+  TimerWheel<int> wheel;
+  std::vector<int> expired;
+  wheel.Advance(1000000, &expired);
+  // A fake clock starting over at a lower time.
+  wheel.Insert(1000, 1100, 1);
+  wheel.Advance(1099, &expired);
+  EXPECT_TRUE(expired.empty());
+  wheel.Advance(1100, &expired);
+  EXPECT_THAT(expired, ElementsAre(1));
+}
+
+// Checks the wheel against an ordered map with random inserts, cancels and
+// advances.
+TEST(TimerWheelTest, MatchesOrderedMap) {
+  webrtc::Random random(1234);
+  TimerWheel<int> wheel;
+  std::map<std::pair<int64_t, int>, TimerWheel<int>::Handle> reference;
+  int64_t now_ms = 0;
+  int next_value = 0;
+  for (int round = 0; round < 2000; ++round) {
+    int inserts = random.Rand(0, 20);
+    for (int i = 0; i < inserts; ++i) {
+      int64_t trigger_ms = now_ms + random.Rand(0, 1) * random.Rand(0, 100) +
+                           random.Rand(0, 3) * random.Rand(0, 300000) - 5;
+      int value = next_value++;
+      reference[std::make_pair(trigger_ms, value)] =
+          wheel.Insert(now_ms, trigger_ms, value);
+    }
+    if (!reference.empty() && random.Rand(0, 3) == 0) {
+      auto it = reference.begin();
+      int index = random.Rand(0, static_cast<int>(reference.size()) - 1);
+      std::advance(it, index);
+      EXPECT_TRUE(wheel.Cancel(it->second));
+      reference.erase(it);
+    }
+    ASSERT_EQ(reference.size(), wheel.size());
+    if (!reference.empty()) {
+      EXPECT_LE(wheel.EarliestTrigger(), reference.begin()->first.first);
+    }
+
+    now_ms += random.Rand(0, 1) * random.Rand(0, 50) +
+              random.Rand(0, 7) / 7 * random.Rand(0, 100000);
+    std::vector<int> expired;
+    wheel.Advance(now_ms, &expired);
+    std::vector<int> expected;
+    while (!reference.empty() && reference.begin()->first.first <= now_ms) {
+      expected.push_back(reference.begin()->first.second);
+      reference.erase(reference.begin());
+    }
+    ASSERT_EQ(expected, expired);
+  }
+}
+
+// Schedules 100k timers spread over a minute, with a tenth of them cancelled,
+// and runs them all to expiry at 1 ms resolution. Compares against the
+// std::priority_queue and std::map the message and task queues used before.
+// Disabled by default since it only reports numbers.
+TEST(TimerWheelTest, DISABLED_PendingTimersBenchmark) {
+  static const int kNumTimers = 100000;
+  static const int kSpanMs = 60000;
+  webrtc::Random random(42);
+  std::vector<int64_t> triggers;
+  for (int i = 0; i < kNumTimers; ++i)
+    triggers.push_back(random.Rand(1, kSpanMs));
+
+  {
+    int64_t start_us = TimeMicros();
+    TimerWheel<int> wheel;
+    std::vector<TimerWheel<int>::Handle> handles;
+    for (int i = 0; i < kNumTimers; ++i)
+      handles.push_back(wheel.Insert(0, triggers[i], i));
+    int64_t insert_us = TimeMicros() - start_us;
+    for (int i = 0; i < kNumTimers; i += 10)
+      wheel.Cancel(handles[i]);
+    std::vector<int> expired;
+    for (int64_t now_ms = 0; now_ms <= kSpanMs; ++now_ms) {
+      wheel.Advance(now_ms, &expired);
+      expired.clear();
+    }
+    RTC_LOG(LS_INFO) << "TimerWheel: insert " << insert_us << " us, total "
+                     << TimeMicros() - start_us << " us";
+  }
+  {
+    int64_t start_us = TimeMicros();
+    std::priority_queue<std::tuple<int64_t, int, int>,
+                        std::vector<std::tuple<int64_t, int, int>>,
+                        std::greater<std::tuple<int64_t, int, int>>>
+        heap;
+    for (int i = 0; i < kNumTimers; ++i)
+      heap.emplace(triggers[i], i, i);
+    int64_t insert_us = TimeMicros() - start_us;
+    for (int64_t now_ms = 0; now_ms <= kSpanMs; ++now_ms) {
+      while (!heap.empty() && std::get<0>(heap.top()) <= now_ms)
+        heap.pop();
+    }
+    RTC_LOG(LS_INFO) << "std::priority_queue (no cancel): insert "
+                     << insert_us << " us, total " << TimeMicros() - start_us
+                     << " us";
+  }
+  {
+    int64_t start_us = TimeMicros();
+    std::map<std::pair<int64_t, int>, int> map;
+    for (int i = 0; i < kNumTimers; ++i)
+      map[std::make_pair(triggers[i], i)] = i;
+    int64_t insert_us = TimeMicros() - start_us;
+    for (int i = 0; i < kNumTimers; i += 10)
+      map.erase(std::make_pair(triggers[i], i));
+    for (int64_t now_ms = 0; now_ms <= kSpanMs; ++now_ms) {
+      while (!map.empty() && map.begin()->first.first <= now_ms)
+        map.erase(map.begin());
+    }
+    RTC_LOG(LS_INFO) << "std::map: insert " << insert_us << " us, total "
+                     << TimeMicros() - start_us << " us";
+  }
+}
+
+}  // namespace
+}  // namespace rtc
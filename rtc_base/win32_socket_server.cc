@@ -565,6 +565,11 @@ int Win32Socket::TranslateOption(Option opt, int* slevel, int* sopt) {
     case OPT_DSCP:
       RTC_LOG(LS_WARNING) << "Socket::OPT_DSCP not supported.";
       return -1;
+    case OPT_RECV_TIMESTAMP:
+      return -1;
+    case OPT_REUSEPORT:
+      RTC_LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+      return -1;
     default:
       RTC_NOTREACHED();
       return -1;
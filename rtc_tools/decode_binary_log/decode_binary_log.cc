@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "rtc_base/async_logging.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/system/file_wrapper.h"
+
+ABSL_FLAG(std::string, input, "", "Binary log written by rtc::AsyncLogger");
+ABSL_FLAG(std::string, output, "", "Where to write the text log, or stdout");
+ABSL_FLAG(int,
+          min_severity,
+          rtc::LS_VERBOSE,
+          "Lowest severity to decode, from 0 (verbose) to 3 (error)");
+
+int main(int argc, char* argv[]) {
+  absl::SetProgramUsageMessage(
+      "Converts a log written by rtc::AsyncLogger::StartBinary() to text.\n"
+      "Example Usage:\n"
+      "./decode_binary_log --input=webrtc.blog --output=webrtc.log\n");
+  absl::ParseCommandLine(argc, argv);
+
+  const std::string input_path = absl::GetFlag(FLAGS_input);
+  const std::string output_path = absl::GetFlag(FLAGS_output);
+  const int min_severity = absl::GetFlag(FLAGS_min_severity);
+  if (input_path.empty() || min_severity < rtc::LS_VERBOSE ||
+      min_severity > rtc::LS_ERROR) {
+    return EXIT_FAILURE;
+  }
+
+  webrtc::FileWrapper input = webrtc::FileWrapper::OpenReadOnly(input_path);
+  if (!input.is_open()) {
+    fprintf(stderr, "Cannot open %s\n", input_path.c_str());
+    return EXIT_FAILURE;
+  }
+  std::string data;
+  char buffer[64 * 1024];
+  while (size_t read = input.Read(buffer, sizeof(buffer)))
+    data.append(buffer, read);
+
+  std::string text;
+  bool complete = rtc::DecodeBinaryLog(
+      data, static_cast<rtc::LoggingSeverity>(min_severity), &text);
+
+  if (output_path.empty()) {
+    fwrite(text.data(), 1, text.size(), stdout);
+  } else {
+    webrtc::FileWrapper output = webrtc::FileWrapper::OpenWriteOnly(output_path);
+    if (!output.is_open() || !output.Write(text.data(), text.size())) {
+      fprintf(stderr, "Cannot write %s\n", output_path.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!complete) {
+    // A log whose writer did not stop cleanly ends in a partial message.
+    fprintf(stderr, "%s is truncated or corrupt\n", input_path.c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
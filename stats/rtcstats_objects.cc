@@ -911,4 +911,32 @@ RTCTransportStats::RTCTransportStats(const RTCTransportStats& other)
 
 RTCTransportStats::~RTCTransportStats() {}
 
+// clang-format off
+WEBRTC_RTCSTATS_IMPL(RTCThreadCpuStats, RTCStats, "thread-cpu",
+    &thread_name,
+    &thread_id,
+    &exited,
+    &cpu_time)
+// clang-format on
+
+RTCThreadCpuStats::RTCThreadCpuStats(const std::string& id,
+                                     int64_t timestamp_us)
+    : RTCThreadCpuStats(std::string(id), timestamp_us) {}
+
+RTCThreadCpuStats::RTCThreadCpuStats(std::string&& id, int64_t timestamp_us)
+    : RTCStats(std::move(id), timestamp_us),
+      thread_name("threadName"),
+      thread_id("threadId"),
+      exited("exited"),
+      cpu_time("cpuTime") {}
+
+RTCThreadCpuStats::RTCThreadCpuStats(const RTCThreadCpuStats& other)
+    : RTCStats(other.id(), other.timestamp_us()),
+      thread_name(other.thread_name),
+      thread_id(other.thread_id),
+      exited(other.exited),
+      cpu_time(other.cpu_time) {}
+
+RTCThreadCpuStats::~RTCThreadCpuStats() {}
+
 }  // namespace webrtc
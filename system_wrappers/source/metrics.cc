@@ -10,8 +10,13 @@
 #include "system_wrappers/include/metrics.h"
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 
+#include "absl/base/attributes.h"
+#include "absl/base/config.h"
 #include "rtc_base/critical_section.h"
+#include "rtc_base/platform_thread_types.h"
 #include "rtc_base/thread_annotations.h"
 
 // Default implementation of histogram methods for WebRTC clients that do not
@@ -22,40 +27,153 @@ namespace metrics {
 class Histogram;
 
 namespace {
-// Limit for the maximum number of sample values that can be stored.
+// Limit for the maximum number of sample values that can be stored per shard.
 // TODO(asapersson): Consider using bucket count (and set up
 // linearly/exponentially spaced buckets) if samples are logged more frequently.
 const int kMaxSampleMapSize = 300;
 
+// Counts saturate here, to fit the int of SampleInfo::samples.
+const uint64_t kMaxSampleCount = std::numeric_limits<int>::max();
+
+// Samples are recorded into one of these shards, picked per thread, and merged
+// on read. Threads spread over the shards, so concurrent Add() calls rarely
+// write to the same cache lines.
+const size_t kNumShards = 8;
+
+// Picks the shard of the calling thread, round robin on first use.
+size_t CurrentShard() {
+#if defined(ABSL_HAVE_THREAD_LOCAL)
+  ABSL_CONST_INIT static std::atomic<size_t> next_shard{0};
+  ABSL_CONST_INIT thread_local size_t shard = kNumShards;
+  if (shard == kNumShards)
+    shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shard;
+#else
+  return static_cast<size_t>(rtc::CurrentThreadId()) % kNumShards;
+#endif
+}
+
+// Open addressed table of sample counts. Each slot holds a sample value in its
+// upper and the count in its lower 32 bits, so that a slot is claimed,
+// incremented and harvested by single atomic operations without a lock. Zero
+// marks a free slot, since used slots have a count of at least one.
+class HistogramShard {
+ public:
+  // Power of two above kMaxSampleMapSize, so that probe sequences stay short.
+  static const size_t kNumSlots = 512;
+
+  HistogramShard() {
+    for (std::atomic<uint64_t>& slot : slots_)
+      slot.store(0, std::memory_order_relaxed);
+  }
+
+  void Add(int sample) {
+    const uint64_t key = static_cast<uint32_t>(sample);
+    size_t index = (key * 0x9E3779B1u) % kNumSlots;
+    for (size_t probe = 0; probe < kNumSlots; ++probe) {
+      std::atomic<uint64_t>& slot = slots_[index];
+      uint64_t value = slot.load(std::memory_order_relaxed);
+      while (true) {
+        if (value == 0) {
+          // Too many different values in this shard; the sample is dropped.
+          if (!ReserveSlot())
+            return;
+          if (slot.compare_exchange_weak(value, (key << 32) | 1,
+                                         std::memory_order_relaxed)) {
+            return;
+          }
+          num_used_slots_.fetch_sub(1, std::memory_order_relaxed);
+        } else if ((value >> 32) == key) {
+          // Saturates rather than overflowing the int of the merged count.
+          if ((value & 0xFFFFFFFF) >= kMaxSampleCount)
+            return;
+          // Fails, and retries, if CollectAndReset() took the slot meanwhile.
+          if (slot.compare_exchange_weak(value, value + 1,
+                                         std::memory_order_relaxed)) {
+            return;
+          }
+        } else {
+          break;
+        }
+      }
+      index = (index + 1) % kNumSlots;
+    }
+  }
+
+  // Adds the counts to |samples|.
+  void Collect(std::map<int, int>* samples) const {
+    for (const std::atomic<uint64_t>& slot : slots_)
+      AddCount(slot.load(std::memory_order_relaxed), samples);
+  }
+
+  // Adds the counts to |samples| and clears them. Clearing may break probe
+  // sequences, after which a value can take a second slot; the counts of
+  // both are summed here.
+  void CollectAndReset(std::map<int, int>* samples) {
+    for (std::atomic<uint64_t>& slot : slots_) {
+      uint64_t value = slot.exchange(0, std::memory_order_relaxed);
+      if (value != 0) {
+        num_used_slots_.fetch_sub(1, std::memory_order_relaxed);
+        AddCount(value, samples);
+      }
+    }
+  }
+
+ private:
+  // Takes one of the kMaxSampleMapSize slots that may be used at a time.
+  bool ReserveSlot() {
+    if (num_used_slots_.fetch_add(1, std::memory_order_relaxed) <
+        kMaxSampleMapSize) {
+      return true;
+    }
+    num_used_slots_.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  static void AddCount(uint64_t value, std::map<int, int>* samples) {
+    if (value == 0)
+      return;
+    const int sample = static_cast<int>(static_cast<uint32_t>(value >> 32));
+    int& count = (*samples)[sample];
+    count = static_cast<int>(std::min(
+        static_cast<uint64_t>(count) + (value & 0xFFFFFFFF), kMaxSampleCount));
+  }
+
+  std::atomic<uint64_t> slots_[kNumSlots];
+  // Slots that hold a value, or are about to be claimed.
+  std::atomic<int> num_used_slots_{0};
+};
+
 class RtcHistogram {
  public:
   RtcHistogram(const std::string& name, int min, int max, int bucket_count)
       : min_(min), max_(max), info_(name, min, max, bucket_count) {
     RTC_DCHECK_GT(bucket_count, 0);
+    for (std::atomic<HistogramShard*>& shard : shards_)
+      shard.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~RtcHistogram() {
+    for (std::atomic<HistogramShard*>& shard : shards_)
+      delete shard.load(std::memory_order_relaxed);
   }
 
   void Add(int sample) {
     sample = std::min(sample, max_);
     sample = std::max(sample, min_ - 1);  // Underflow bucket.
-
-    rtc::CritScope cs(&crit_);
-    if (info_.samples.size() == kMaxSampleMapSize &&
-        info_.samples.find(sample) == info_.samples.end()) {
-      return;
-    }
-    ++info_.samples[sample];
+    GetOrCreateShard(CurrentShard())->Add(sample);
   }
 
   // Returns a copy (or nullptr if there are no samples) and clears samples.
   std::unique_ptr<SampleInfo> GetAndReset() {
-    rtc::CritScope cs(&crit_);
-    if (info_.samples.empty())
+    std::map<int, int> samples = CollectAndReset();
+    if (samples.empty())
       return nullptr;
 
     SampleInfo* copy =
         new SampleInfo(info_.name, info_.min, info_.max, info_.bucket_count);
 
-    std::swap(info_.samples, copy->samples);
+    std::swap(samples, copy->samples);
 
     return std::unique_ptr<SampleInfo>(copy);
   }
@@ -63,41 +181,71 @@ class RtcHistogram {
   const std::string& name() const { return info_.name; }
 
   // Functions only for testing.
-  void Reset() {
-    rtc::CritScope cs(&crit_);
-    info_.samples.clear();
-  }
+  void Reset() { CollectAndReset(); }
 
   int NumEvents(int sample) const {
-    rtc::CritScope cs(&crit_);
-    const auto it = info_.samples.find(sample);
-    return (it == info_.samples.end()) ? 0 : it->second;
+    const std::map<int, int> samples = Collect();
+    const auto it = samples.find(sample);
+    return (it == samples.end()) ? 0 : it->second;
   }
 
   int NumSamples() const {
     int num_samples = 0;
-    rtc::CritScope cs(&crit_);
-    for (const auto& sample : info_.samples) {
+    for (const auto& sample : Collect()) {
       num_samples += sample.second;
     }
     return num_samples;
   }
 
   int MinSample() const {
-    rtc::CritScope cs(&crit_);
-    return (info_.samples.empty()) ? -1 : info_.samples.begin()->first;
+    const std::map<int, int> samples = Collect();
+    return (samples.empty()) ? -1 : samples.begin()->first;
   }
 
-  std::map<int, int> Samples() const {
-    rtc::CritScope cs(&crit_);
-    return info_.samples;
-  }
+  std::map<int, int> Samples() const { return Collect(); }
 
  private:
-  rtc::CriticalSection crit_;
+  HistogramShard* GetOrCreateShard(size_t index) {
+    HistogramShard* shard = shards_[index].load(std::memory_order_acquire);
+    if (shard)
+      return shard;
+    HistogramShard* new_shard = new HistogramShard();
+    if (shards_[index].compare_exchange_strong(shard, new_shard,
+                                               std::memory_order_acq_rel)) {
+      return new_shard;
+    }
+    // Another thread of the same shard won the race.
+    delete new_shard;
+    return shard;
+  }
+
+  // Merges the shards. Samples added concurrently may or may not be included.
+  std::map<int, int> Collect() const {
+    std::map<int, int> samples;
+    for (const std::atomic<HistogramShard*>& shard : shards_) {
+      const HistogramShard* shard_ptr = shard.load(std::memory_order_acquire);
+      if (shard_ptr)
+        shard_ptr->Collect(&samples);
+    }
+    return samples;
+  }
+
+  // Same, and clears the shards.
+  std::map<int, int> CollectAndReset() {
+    std::map<int, int> samples;
+    for (std::atomic<HistogramShard*>& shard : shards_) {
+      HistogramShard* shard_ptr = shard.load(std::memory_order_acquire);
+      if (shard_ptr)
+        shard_ptr->CollectAndReset(&samples);
+    }
+    return samples;
+  }
+
   const int min_;
   const int max_;
-  SampleInfo info_ RTC_GUARDED_BY(crit_);
+  // Name, range and bucket count; the samples live in |shards_|.
+  const SampleInfo info_;
+  std::atomic<HistogramShard*> shards_[kNumShards];
 
   RTC_DISALLOW_COPY_AND_ASSIGN(RtcHistogram);
 };
@@ -12,8 +12,10 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rtc_base/checks.h"
+#include "rtc_base/platform_thread.h"
 #include "system_wrappers/include/metrics.h"
 #include "test/gtest.h"
 
@@ -52,6 +54,13 @@ int NumEvents(const std::string& name,
 
   return it_sample->second;
 }
+
+// Adds |kSamplesPerThread| samples, spread over ten values.
+template <int kSamplesPerThread>
+void AddSamples(void* /*obj*/) {
+  for (int i = 0; i < kSamplesPerThread; ++i)
+    RTC_HISTOGRAM_COUNTS_10000(kName, 1 + i % 10);
+}
 }  // namespace
 
 class MetricsDefaultTest : public ::testing::Test {
@@ -163,4 +172,54 @@ TEST_F(MetricsDefaultTest, TestMinMaxBucket) {
   EXPECT_EQ(1u, histograms.begin()->second->samples.size());
 }
 
+TEST_F(MetricsDefaultTest, LimitsNumberOfDistinctValues) {
+  const std::string kName = "DistinctValues";
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 1; i <= 400; ++i)
+      RTC_HISTOGRAM_COUNTS_10000(kName, i);
+    // All samples of this thread go to one shard, which holds 300 values.
+    std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+    metrics::GetAndReset(&histograms);
+    EXPECT_EQ(300u, histograms[kName]->samples.size());
+  }
+}
+
+TEST_F(MetricsDefaultTest, SamplesFromManyThreads) {
+  constexpr int kSamplesPerThread = 10000;
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < 10; ++i) {
+    threads.push_back(std::make_unique<rtc::PlatformThread>(
+        &AddSamples<kSamplesPerThread>, nullptr, "Metrics"));
+  }
+  for (auto& thread : threads)
+    thread->Start();
+  for (auto& thread : threads)
+    thread->Stop();
+
+  EXPECT_EQ(10 * kSamplesPerThread, metrics::NumSamples(kName));
+  EXPECT_EQ(kSamplesPerThread, metrics::NumEvents(kName, 1));
+  std::map<std::string, std::unique_ptr<metrics::SampleInfo>> histograms;
+  metrics::GetAndReset(&histograms);
+  EXPECT_EQ(10u, histograms[kName]->samples.size());
+  EXPECT_EQ(0, metrics::NumSamples(kName));
+}
+
+// Adds 80M samples from 8 threads to one histogram, to measure the cost of
+// HistogramAdd() under contention. Run it with --gtest_also_run_disabled_tests.
+// The test is disabled by default to avoid unnecessarily loading the bots.
+TEST_F(MetricsDefaultTest, DISABLED_Performance) {
+  constexpr int kSamplesPerThread = 10000000;
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.push_back(std::make_unique<rtc::PlatformThread>(
+        &AddSamples<kSamplesPerThread>, nullptr, "Metrics"));
+  }
+  for (auto& thread : threads)
+    thread->Start();
+  for (auto& thread : threads)
+    thread->Stop();
+
+  EXPECT_EQ(8 * kSamplesPerThread, metrics::NumSamples(kName));
+}
+
 }  // namespace webrtc